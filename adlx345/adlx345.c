@@ -7,7 +7,7 @@
 
 #include "adlx345.h"
 
-#define ADLX345_GRAVITY                 (9.81)
+#define ADLX345_GRAVITY                 IMU_GRAVITY
 
 void Adlx345_Register(Adlx345 *m, Adlx345_I2cMemFunc read, Adlx345_I2cMemFunc write)
 {   
@@ -18,75 +18,86 @@ void Adlx345_Register(Adlx345 *m, Adlx345_I2cMemFunc read, Adlx345_I2cMemFunc wr
     }
 }
 
+// 左对齐输出时, 无论是否 full-res, 量程的满刻度都对应 32768
+static void Adlx345_UpdateScale(Adlx345 *m)
+{
+    m->full_scale_rate = IMU_REAL(32768.0) / ((2 << (m->range & 0x03)) * ADLX345_GRAVITY);
+    m->scale = IMU_REAL(1.0) / m->full_scale_rate;
+}
+
+static uint8_t Adlx345_DataFormat(Adlx345 *m)
+{
+    // 0B-0-0-0-0-1-1-11, left-justify, full-res 由 fix_resolution 决定
+    return ADLX345_FORMAT_JUSTIFY | (m->fix_resolution ? 0 : ADLX345_FORMAT_FULL_RES) | (m->range & 0x03);
+}
+
+// 将缓存中的脏寄存器按连续地址分段突发写入
+bool Adlx345_Sync(Adlx345 *m)
+{
+    uint8_t reg, length;
+    while (ImuRegCache_NextDirty(&m->cache, &reg, &length))
+    {
+        if (!m->write(m->addr, reg, ImuRegCache_Data(&m->cache, reg), length))
+        {
+            return false;
+        }
+        ImuRegCache_Clean(&m->cache, reg, length);
+    }
+    return true;
+}
+
+/**
+ * 读回配置寄存器与缓存核对, 返回不一致的个数, 总线错误返回 -1.
+ * resync 为 true 时把缓存值重新写入器件, 否则以器件值为准.
+ * 只读的 ACT_TAP_STATUS(0x2B) 随事件变化, INT_SOURCE 读取会清中断, 都不在核对范围内,
+ * 因此 THRESH_TAP ~ INT_MAP 分 0x1D ~ 0x2A 与 0x2C ~ 0x2F 两段读取, 0x2B 在缓存中始终无效.
+ */
+int32_t Adlx345_Verify(Adlx345 *m, bool resync)
+{
+    uint8_t low[ADLX345_REG_ACT_TAP_STATUS - ADLX345_SHADOW_BASE];
+    uint8_t high[ADLX345_REG_INT_MAP - ADLX345_REG_BW_RATE + 1];
+    uint8_t format, fifo_ctl;
+    int32_t mismatch = 0;
+    if (!m || !m->inited)
+    {
+        return -1;
+    }
+    if (!m->read(m->addr, ADLX345_SHADOW_BASE, low, sizeof(low)) ||
+        !m->read(m->addr, ADLX345_REG_BW_RATE, high, sizeof(high)) ||
+        !m->read(m->addr, ADLX345_REG_DATAFORMAT, &format, 1) ||
+        !m->read(m->addr, ADLX345_REG_FIFO_CTL, &fifo_ctl, 1))
+    {
+        return -1;
+    }
+    mismatch += ImuRegCache_Fill(&m->cache, ADLX345_SHADOW_BASE, low, sizeof(low), resync);
+    mismatch += ImuRegCache_Fill(&m->cache, ADLX345_REG_BW_RATE, high, sizeof(high), resync);
+    mismatch += ImuRegCache_Fill(&m->cache, ADLX345_REG_DATAFORMAT, &format, 1, resync);
+    mismatch += ImuRegCache_Fill(&m->cache, ADLX345_REG_FIFO_CTL, &fifo_ctl, 1, resync);
+    if (resync && mismatch > 0 && !Adlx345_Sync(m))
+    {
+        return -1;
+    }
+    return mismatch;
+}
+
 void Adlx345_Init(Adlx345 *m)
 {
     if (m && m->read && m->write)
     {
         uint8_t dev_id;
-        if (m->read(m->addr, ADLX345_REG_DEVID, &dev_id, 1))     // check device id
+        if (m->read(m->addr, ADLX345_REG_DEVID, &dev_id, 1) && ADLX345_DEVID == dev_id)   // check device id
         {
-            // set resolution & range
-            Adlx345RegDataFormat format;
-            m->read(m->addr, ADLX345_REG_DATAFORMAT, (uint8_t *)&format, 1);
-            if (m->fix_resolution)                                      // no use fix resolution
-            {
-                format.full_res = 0;
-                
-                switch(m->range)
-                {
-                    case Adlx345Range_2g:
-                        m->full_scale_rate = 1024.0 * 1024.0 / (4.0 * ADLX345_GRAVITY);
-                        break;
-                    case Adlx345Range_4g:
-                        m->full_scale_rate = 1024.0 * 1024.0 / (8.0 * ADLX345_GRAVITY);
-                        break;
-                    case Adlx345Range_8g:
-                        m->full_scale_rate = 1024.0 * 1024.0 / (16.0 * ADLX345_GRAVITY);
-                        break;
-                    case Adlx345Range_16g:
-                        m->full_scale_rate = 1024.0 * 1024.0 / (32.0 * ADLX345_GRAVITY);
-                        break;
-                    default:
-                        m->full_scale_rate = 1024.0 * 1024.0 / (4.0 * ADLX345_GRAVITY);
-                }
-            }
-            else
-            {
-                format.full_res = 1;
-                switch(m->range)
-                {
-                    case Adlx345Range_2g:
-                        m->full_scale_rate = 64.0 * 256.0 / ADLX345_GRAVITY;
-                        break;
-                    case Adlx345Range_4g:
-                        m->full_scale_rate = 32.0 * 256.0 / ADLX345_GRAVITY;
-                        break;
-                    case Adlx345Range_8g:
-                        m->full_scale_rate = 16.0 * 256.0 / ADLX345_GRAVITY;
-                        break;
-                    case Adlx345Range_16g:
-                        m->full_scale_rate = 8.0 * 256.0 / ADLX345_GRAVITY;
-                        break;
-                    default:
-                        m->full_scale_rate = 64.0 * 256.0 / ADLX345_GRAVITY;
-                }
-            }
-            format.range = m->range;
-
-            uint8_t bw_rate = m->sample_rate;
-            uint8_t power_ctrl = 0x08;                  //0B-00-0-0-1-0-00 
-            uint8_t data_format = 0x0c | m->range;     // 0B-0-0-0-0-1-1-11     //full-res, left-justify
-            m->write(m->addr, ADLX345_REG_POWER_CTL, &power_ctrl, 1);
-
-            if (m->write(m->addr, ADLX345_REG_DATAFORMAT, &data_format, 1) && \
-                    m->write(m->addr, ADLX345_REG_BW_RATE, (uint8_t *)&bw_rate, 1))
-            {
-                m->inited = true;
-            }
-            else
-            {
-                m->inited = false;
-            }
+            // 器件状态未知, 所有配置都重新写入
+            ImuRegCache_Init(&m->cache, ADLX345_SHADOW_BASE, ADLX345_SHADOW_SIZE, m->shadow);
+            Adlx345_UpdateScale(m);
+
+            ImuRegCache_Set(&m->cache, ADLX345_REG_OFFSETX, (uint8_t)m->offset[0]);   // 保持与上层记录的硬件偏置一致
+            ImuRegCache_Set(&m->cache, ADLX345_REG_OFFSETY, (uint8_t)m->offset[1]);
+            ImuRegCache_Set(&m->cache, ADLX345_REG_OFFSETZ, (uint8_t)m->offset[2]);
+            ImuRegCache_Set(&m->cache, ADLX345_REG_BW_RATE, m->sample_rate | (m->low_power ? ADLX345_BW_LOW_POWER : 0));
+            ImuRegCache_Set(&m->cache, ADLX345_REG_POWER_CTL, ADLX345_POWER_MEASURE);   //0B-00-0-0-1-0-00 
+            ImuRegCache_Set(&m->cache, ADLX345_REG_DATAFORMAT, Adlx345_DataFormat(m));
+            m->inited = Adlx345_Sync(m);
         }
         else
         {
@@ -99,34 +110,40 @@ void Adlx345_Init(Adlx345 *m)
     }
 }
 
-bool Adlx345_Read(Adlx345 *m, Adlx345Axes *axes)
+void Adlx345_UnpackRaw(const uint8_t *bytes, int16_t raw[3])
 {
-    int ret = false;
-    if (m && m->inited)
+    raw[0] = (int16_t)((bytes[1] << 8) | bytes[0]);
+    raw[1] = (int16_t)((bytes[3] << 8) | bytes[2]);
+    raw[2] = (int16_t)((bytes[5] << 8) | bytes[4]);
+}
+
+// 只读取原始计数, 不做浮点换算, 换算见 ImuConvert_RawToFloat
+bool Adlx345_ReadRaw(Adlx345 *m, int16_t raw[3])
+{
+    uint8_t raw_bytes[6];
+    if (m && m->inited && m->read(m->addr, ADLX345_REG_DATA, raw_bytes, 6))
     {
-        uint8_t raw_bytes[6];
-        if (m->read(m->addr, ADLX345_REG_DATA, raw_bytes, 6))
-        {
-            m->raw_data[0] = (raw_bytes[1] << 8) | raw_bytes[0];
-            m->raw_data[1] = (raw_bytes[3] << 8) | raw_bytes[2];
-            m->raw_data[2] = (raw_bytes[5] << 8) | raw_bytes[4];
-            m->axes.x = 1.0 * m->raw_data[0];
-            m->axes.y = 1.0 * m->raw_data[1];
-            m->axes.z = 1.0 * m->raw_data[2];
-            m->axes.x /= m->full_scale_rate;
-            m->axes.y /= m->full_scale_rate;
-            m->axes.z /= m->full_scale_rate; 
-            ret = true;
-        }
-        else
-        {   
-            ret = false;
-        }
-        
+        Adlx345_UnpackRaw(raw_bytes, m->raw_data);
+        raw[0] = m->raw_data[0];
+        raw[1] = m->raw_data[1];
+        raw[2] = m->raw_data[2];
+        return true;
     }
     else
     {
-        ret = false;
+        return false;
+    }
+}
+
+bool Adlx345_Read(Adlx345 *m, Adlx345Axes *axes)
+{
+    int16_t raw[3];
+    bool ret = Adlx345_ReadRaw(m, raw);
+    if (ret)
+    {
+        m->axes.x = raw[0] * m->scale;
+        m->axes.y = raw[1] * m->scale;
+        m->axes.z = raw[2] * m->scale;
     }
 
     axes->x = m->axes.x;
@@ -135,6 +152,11 @@ bool Adlx345_Read(Adlx345 *m, Adlx345Axes *axes)
     return ret;
 }
 
+imu_real_t Adlx345_GetScale(Adlx345 *m)
+{
+    return m->scale;
+}
+
 void Adlx345_GetSampleRate(Adlx345 *m, Adlx345SampleRate *sample_rate)
 {
     if (m && sample_rate)
@@ -143,3 +165,204 @@ void Adlx345_GetSampleRate(Adlx345 *m, Adlx345SampleRate *sample_rate)
     }
 }
 
+// 低功耗只在 12.5Hz ~ 400Hz 有效, 其他速率芯片忽略该位
+bool Adlx345_SetSampleRate(Adlx345 *m, Adlx345SampleRate sample_rate, bool low_power)
+{
+    if (m && m->inited)
+    {
+        ImuRegCache_Set(&m->cache, ADLX345_REG_BW_RATE, sample_rate | (low_power ? ADLX345_BW_LOW_POWER : 0));
+        if (Adlx345_Sync(m))
+        {
+            m->sample_rate = sample_rate;
+            m->low_power = low_power;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Adlx345_SetRange(Adlx345 *m, Adlx345Range range)
+{
+    if (m && m->inited)
+    {
+        m->range = range;
+        ImuRegCache_Set(&m->cache, ADLX345_REG_DATAFORMAT, Adlx345_DataFormat(m));
+        Adlx345_UpdateScale(m);
+        return Adlx345_Sync(m);
+    }
+    return false;
+}
+
+/**
+ * 配置活动/静止检测. 数据手册要求修改 link/auto_sleep 时先进入待机, 且先配置 INT_MAP 再使能中断,
+ * 因此分 待机 -> 阈值与中断映射 -> 使能中断与测量 三段写入, 与缓存相同的寄存器不会重复写.
+ */
+bool Adlx345_SetActivity(Adlx345 *m, const Adlx345Activity *activity)
+{
+    if (!m || !m->inited || !activity)
+    {
+        return false;
+    }
+
+    uint8_t act_inact_ctl = ((activity->act_axes & ADLX345_AXIS_ALL) << 4) | (activity->inact_axes & ADLX345_AXIS_ALL);
+    uint8_t int_enable = 0;
+    uint8_t power_ctl = ADLX345_POWER_MEASURE | (activity->wakeup & 0x03);
+    uint8_t old_power_ctl = 0;
+
+    if (activity->ac_coupled)
+    {
+        act_inact_ctl |= ADLX345_ACT_AC_COUPLED | ADLX345_INACT_AC_COUPLED;
+    }
+    if (activity->act_axes)
+    {
+        int_enable |= ADLX345_INT_ACTIVITY;
+    }
+    if (activity->inact_axes)
+    {
+        int_enable |= ADLX345_INT_INACTIVITY;
+    }
+    if (activity->auto_sleep)
+    {
+        power_ctl |= ADLX345_POWER_LINK | ADLX345_POWER_AUTO_SLEEP;
+    }
+
+    if (!ImuRegCache_Get(&m->cache, ADLX345_REG_POWER_CTL, &old_power_ctl) ||
+        ((old_power_ctl ^ power_ctl) & (ADLX345_POWER_LINK | ADLX345_POWER_AUTO_SLEEP)))
+    {
+        ImuRegCache_Set(&m->cache, ADLX345_REG_POWER_CTL, 0);
+        if (!Adlx345_Sync(m))
+        {
+            return false;
+        }
+    }
+
+    ImuRegCache_Set(&m->cache, ADLX345_REG_THRESH_ACT, activity->act_threshold);
+    ImuRegCache_Set(&m->cache, ADLX345_REG_THRESH_INACT, activity->inact_threshold);
+    ImuRegCache_Set(&m->cache, ADLX345_REG_TIME_INACT, activity->inact_time);
+    ImuRegCache_Set(&m->cache, ADLX345_REG_ACT_INACT_CTL, act_inact_ctl);
+    ImuRegCache_Set(&m->cache, ADLX345_REG_INT_MAP, activity->int_map);
+    bool ret = Adlx345_Sync(m);
+
+    // 无论前面是否成功都尽量恢复测量, 避免停在待机; 数据/FIFO 中断位保持不变
+    ImuRegCache_Update(&m->cache, ADLX345_REG_INT_ENABLE, ADLX345_INT_ACTIVITY | ADLX345_INT_INACTIVITY,
+                       ret ? int_enable : 0);
+    ImuRegCache_Set(&m->cache, ADLX345_REG_POWER_CTL, ret ? power_ctl : (old_power_ctl | ADLX345_POWER_MEASURE));
+    return Adlx345_Sync(m) && ret;
+}
+
+// 读取 INT_SOURCE 同时清除活动/静止中断标志
+bool Adlx345_ReadIntSource(Adlx345 *m, uint8_t *source)
+{
+    if (m && m->inited && source)
+    {
+        return m->read(m->addr, ADLX345_REG_INT_SOURCE, source, 1);
+    }
+    return false;
+}
+
+// 置位或清除 INT_ENABLE 中 mask 对应的中断, 其他中断不变; 输出引脚由 INT_MAP 决定
+bool Adlx345_SetInterrupt(Adlx345 *m, uint8_t mask, bool enable)
+{
+    if (m && m->inited)
+    {
+        ImuRegCache_Update(&m->cache, ADLX345_REG_INT_ENABLE, mask, enable ? 0xFF : 0);
+        return Adlx345_Sync(m);
+    }
+    return false;
+}
+
+// 条目数达到 watermark 时置位 WATERMARK 中断, 切换到 Bypass 会清空 FIFO
+bool Adlx345_SetFifo(Adlx345 *m, Adlx345FifoMode mode, uint8_t watermark)
+{
+    if (m && m->inited)
+    {
+        ImuRegCache_Set(&m->cache, ADLX345_REG_FIFO_CTL, ((mode & 0x03) << 6) | (watermark & ADLX345_FIFO_SAMPLES_MASK));
+        return Adlx345_Sync(m);
+    }
+    return false;
+}
+
+/**
+ * 读出 FIFO 中最多 max 个样本, 按时间先后存入 raw, 返回个数, 总线错误且一个都没读到时返回 -1.
+ * 每次 6 字节突发读取弹出一个条目, 条目数在开始时取一次, 读取期间新到的样本留给下次.
+ */
+int32_t Adlx345_ReadFifo(Adlx345 *m, int16_t (*raw)[3], int32_t max)
+{
+    uint8_t status;
+    uint8_t bytes[6];
+    int32_t n;
+    if (!m || !m->inited || !raw || !m->read(m->addr, ADLX345_REG_FIFO_STATUS, &status, 1))
+    {
+        return -1;
+    }
+
+    n = status & ADLX345_FIFO_ENTRIES_MASK;
+    n = (n > max) ? max : n;
+    for (int32_t i = 0; i < n; i++)
+    {
+        if (!m->read(m->addr, ADLX345_REG_DATA, bytes, 6))
+        {
+            return (i > 0) ? i : -1;
+        }
+        Adlx345_UnpackRaw(bytes, raw[i]);
+    }
+    if (n > 0)
+    {
+        m->raw_data[0] = raw[n - 1][0];
+        m->raw_data[1] = raw[n - 1][1];
+        m->raw_data[2] = raw[n - 1][2];
+    }
+    return n;
+}
+
+bool Adlx345_WriteOffset(Adlx345 *m, const int8_t offset[3])
+{
+    if (m && m->inited && offset)
+    {
+        ImuRegCache_Set(&m->cache, ADLX345_REG_OFFSETX, (uint8_t)offset[0]);
+        ImuRegCache_Set(&m->cache, ADLX345_REG_OFFSETY, (uint8_t)offset[1]);
+        ImuRegCache_Set(&m->cache, ADLX345_REG_OFFSETZ, (uint8_t)offset[2]);
+        if (Adlx345_Sync(m))
+        {
+            m->offset[0] = offset[0];
+            m->offset[1] = offset[1];
+            m->offset[2] = offset[2];
+            return true;
+        }
+    }
+    return false;
+}
+static int8_t Adlx345_OffsetLsb(imu_real_t bias)
+{
+    // 偏置寄存器的值叠加到输出上, 抵消 bias 需写入其相反数, 四舍五入并限幅到 int8
+    imu_real_t lsb = -bias * IMU_REAL(1000.0) / (ADLX345_OFFSET_MG_PER_LSB * ADLX345_GRAVITY);
+    lsb += (lsb >= IMU_REAL(0.0)) ? IMU_REAL(0.5) : -IMU_REAL(0.5);
+    return (lsb > IMU_REAL(127.0)) ? 127 : (lsb < -IMU_REAL(128.0)) ? -128 : (int8_t)lsb;
+}
+
+/**
+ * 将偏置(m/s2, Ameas = Atrue + bias)的整数 LSB 部分写入芯片,
+ * applied 返回芯片实际抵消的偏置, bias - applied 为需要软件继续扣除的残差.
+ * bias 必须是总偏置, 即已写入芯片的部分加上在当前寄存器值下新测得的部分.
+ */
+bool Adlx345_SetOffset(Adlx345 *m, const Adlx345Axes *bias, Adlx345Axes *applied)
+{
+    int8_t offset[3];
+    imu_real_t k = ADLX345_OFFSET_MG_PER_LSB * ADLX345_GRAVITY / IMU_REAL(1000.0);
+    if (!bias)
+    {
+        return false;
+    }
+
+    offset[0] = Adlx345_OffsetLsb(bias->x);
+    offset[1] = Adlx345_OffsetLsb(bias->y);
+    offset[2] = Adlx345_OffsetLsb(bias->z);
+    bool ret = Adlx345_WriteOffset(m, offset);
+    if (applied && m)
+    {
+        applied->x = -m->offset[0] * k;
+        applied->y = -m->offset[1] * k;
+        applied->z = -m->offset[2] * k;
+    }
+    return ret;
+}
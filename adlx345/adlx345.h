@@ -14,16 +14,73 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "imu_types.h"
+#include "imu_regcache.h"
 
-#define ADLX345_REG_DEVID       0X00
-#define ADLX345_REG_OFFSETX     0x1E
-#define ADLX345_REG_OFFSETY     0x1F
-#define ADLX345_REG_OFFSETZ     0x20
-#define ADLX345_REG_BW_RATE     0x2C
-#define ADLX345_REG_POWER_CTL   0x2D
-#define ADLX345_REG_DATAFORMAT  0x31
-#define ADLX345_REG_DATA        0x32
-#define ADLX345_REG_FIFO_CTL    0x38
+#define ADLX345_REG_DEVID         0X00
+#define ADLX345_REG_OFFSETX       0x1E
+#define ADLX345_REG_OFFSETY       0x1F
+#define ADLX345_REG_OFFSETZ       0x20
+#define ADLX345_REG_THRESH_ACT    0x24
+#define ADLX345_REG_THRESH_INACT  0x25
+#define ADLX345_REG_TIME_INACT    0x26
+#define ADLX345_REG_ACT_INACT_CTL 0x27
+#define ADLX345_REG_ACT_TAP_STATUS 0x2B
+#define ADLX345_REG_BW_RATE       0x2C
+#define ADLX345_REG_POWER_CTL     0x2D
+#define ADLX345_REG_INT_ENABLE    0x2E
+#define ADLX345_REG_INT_MAP       0x2F
+#define ADLX345_REG_INT_SOURCE    0x30
+#define ADLX345_REG_DATAFORMAT    0x31
+#define ADLX345_REG_DATA          0x32
+#define ADLX345_REG_FIFO_CTL      0x38
+#define ADLX345_REG_FIFO_STATUS   0x39
+
+#define ADLX345_DEVID             0xE5
+
+// 影子缓存覆盖 THRESH_TAP(0x1D) ~ FIFO_CTL(0x38)
+#define ADLX345_SHADOW_BASE         0x1D
+#define ADLX345_SHADOW_SIZE         (ADLX345_REG_FIFO_CTL - ADLX345_SHADOW_BASE + 1)
+
+// BW_RATE
+#define ADLX345_BW_LOW_POWER        0x10
+
+// DATA_FORMAT
+#define ADLX345_FORMAT_FULL_RES     0x08
+#define ADLX345_FORMAT_JUSTIFY      0x04
+
+// POWER_CTL
+#define ADLX345_POWER_LINK          0x20
+#define ADLX345_POWER_AUTO_SLEEP    0x10
+#define ADLX345_POWER_MEASURE       0x08
+#define ADLX345_POWER_SLEEP         0x04
+
+// INT_ENABLE / INT_MAP / INT_SOURCE
+#define ADLX345_INT_DATA_READY      0x80
+#define ADLX345_INT_SINGLE_TAP      0x40
+#define ADLX345_INT_DOUBLE_TAP      0x20
+#define ADLX345_INT_ACTIVITY        0x10
+#define ADLX345_INT_INACTIVITY      0x08
+#define ADLX345_INT_FREE_FALL       0x04
+#define ADLX345_INT_WATERMARK       0x02
+#define ADLX345_INT_OVERRUN         0x01
+
+// FIFO_CTL 低 5 位为水位, FIFO_STATUS 低 6 位为当前条目数
+#define ADLX345_FIFO_TRIGGER_INT2   0x20
+#define ADLX345_FIFO_SAMPLES_MASK   0x1F
+#define ADLX345_FIFO_ENTRIES_MASK   0x3F
+#define ADLX345_FIFO_DEPTH          32
+
+// ACT_INACT_CTL 轴使能, 活动检测在高 4 位, 静止检测在低 4 位
+#define ADLX345_AXIS_X              0x04
+#define ADLX345_AXIS_Y              0x02
+#define ADLX345_AXIS_Z              0x01
+#define ADLX345_AXIS_ALL            0x07
+#define ADLX345_ACT_AC_COUPLED      0x80
+#define ADLX345_INACT_AC_COUPLED    0x08
+
+#define ADLX345_THRESH_MG_PER_LSB   IMU_REAL(62.5)
+#define ADLX345_OFFSET_MG_PER_LSB   IMU_REAL(15.6)
 
 typedef enum {
     Adlx345SampleRate_0_1  = 0,
@@ -51,6 +108,20 @@ typedef enum {
     Adlx345Range_16g,               // 13-bit max
 }Adlx345Range;
 
+typedef enum {
+    Adlx345Fifo_Bypass  = 0,        // 不使用 FIFO, 数据寄存器只保存最新样本
+    Adlx345Fifo_Fifo    = 1,        // 满后停止采集
+    Adlx345Fifo_Stream  = 2,        // 满后丢弃最旧样本
+    Adlx345Fifo_Trigger = 3,
+}Adlx345FifoMode;
+
+typedef enum {
+    Adlx345Wakeup_8hz = 0,          // 休眠时的采样频率
+    Adlx345Wakeup_4hz = 1,
+    Adlx345Wakeup_2hz = 2,
+    Adlx345Wakeup_1hz = 3,
+}Adlx345Wakeup;
+
 typedef enum {
     Adlx345Addr_High = 0x1D,        // ALT ADDRESS HIGH
     Adlx345Addr_Low  = 0x53,        // ALT ADDRESS LOW
@@ -73,11 +144,24 @@ typedef struct Adlx345RegDataFormat_ {
 }Adlx345RegDataFormat;
 
 typedef struct Adlx345Axes_ {
-    float x;
-    float y;
-    float z;
+    imu_real_t x;
+    imu_real_t y;
+    imu_real_t z;
 }Adlx345Axes;
 
+// 活动/静止检测配置
+typedef struct Adlx345Activity_ {
+    uint8_t act_threshold;              // 62.5 mg/LSB
+    uint8_t inact_threshold;            // 62.5 mg/LSB
+    uint8_t inact_time;                 // 1 s/LSB, 持续低于阈值多久判定为静止
+    uint8_t act_axes;                   // ADLX345_AXIS_*
+    uint8_t inact_axes;
+    bool ac_coupled;                    // 交流耦合, 只看相对变化, 与安装姿态无关
+    bool auto_sleep;                    // 静止后自动进入休眠, 需同时 link
+    Adlx345Wakeup wakeup;
+    uint8_t int_map;                    // 置位的中断输出到 INT2 引脚, 其余到 INT1
+}Adlx345Activity;
+
 typedef bool (*Adlx345_I2cMemFunc)(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length);
 
 typedef struct Adlx345_ {
@@ -88,15 +172,34 @@ typedef struct Adlx345_ {
     Adlx345_I2cMemFunc write;
 
     bool fix_resolution;                 // determine by full-res & range
+    bool low_power;                      // BW_RATE.LOW_POWER, 12.5~400Hz 下降低功耗, 噪声略大
+    int8_t offset[3];                    // OFSX/OFSY/OFSZ, 15.6 mg/LSB, 初始化时重新写入
     int16_t raw_data[3];
     Adlx345Axes axes;
     bool inited;
-    float full_scale_rate;
+    imu_real_t full_scale_rate;
+    imu_real_t scale;                   // 1 / full_scale_rate, m/s2 per LSB
+    ImuRegCache cache;                  // 配置寄存器影子, 只写与器件不同的寄存器
+    uint8_t shadow[ADLX345_SHADOW_SIZE];
 }Adlx345;
 
 void Adlx345_Init(Adlx345 *m);
 void Adlx345_Register(Adlx345 *m, Adlx345_I2cMemFunc read, Adlx345_I2cMemFunc write);
 bool Adlx345_Read(Adlx345 *m, Adlx345Axes *axes);
+bool Adlx345_ReadRaw(Adlx345 *m, int16_t raw[3]);
+void Adlx345_UnpackRaw(const uint8_t *bytes, int16_t raw[3]);
+imu_real_t Adlx345_GetScale(Adlx345 *m);
+bool Adlx345_SetActivity(Adlx345 *m, const Adlx345Activity *activity);
+bool Adlx345_SetSampleRate(Adlx345 *m, Adlx345SampleRate sample_rate, bool low_power);
+bool Adlx345_SetRange(Adlx345 *m, Adlx345Range range);
+bool Adlx345_Sync(Adlx345 *m);
+int32_t Adlx345_Verify(Adlx345 *m, bool resync);
+bool Adlx345_ReadIntSource(Adlx345 *m, uint8_t *source);
+bool Adlx345_SetInterrupt(Adlx345 *m, uint8_t mask, bool enable);
+bool Adlx345_SetFifo(Adlx345 *m, Adlx345FifoMode mode, uint8_t watermark);
+int32_t Adlx345_ReadFifo(Adlx345 *m, int16_t (*raw)[3], int32_t max);
+bool Adlx345_WriteOffset(Adlx345 *m, const int8_t offset[3]);
+bool Adlx345_SetOffset(Adlx345 *m, const Adlx345Axes *bias, Adlx345Axes *applied);
 void Adlx345_GetSampleRate(Adlx345 *m, Adlx345SampleRate *sample_rate);
 
 #ifdef __cplusplus
@@ -0,0 +1,194 @@
+/**
+ * @file sensor_adlx345.c
+ * @author Wyatt Yu
+ * @brief ADXL345 的 RT-Thread 传感器框架设备, 支持轮询/中断/FIFO 三种接收模式
+ * @copyright Copyright (c) 2025
+ */
+#include "sensor_adlx345.h"
+#include "imu_sensor.h"
+#include "imu_convert.h"
+
+#define ADLX345_SENSOR_DATA_INT     (ADLX345_INT_DATA_READY | ADLX345_INT_WATERMARK | ADLX345_INT_OVERRUN)
+
+static struct rt_i2c_bus_device *adlx345_bus = RT_NULL;
+static Adlx345 adlx345_dev;
+
+static bool Adlx345Sensor_I2cRead(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    return ImuSensor_I2cRead(adlx345_bus, addr, reg, data, length);
+}
+
+static bool Adlx345Sensor_I2cWrite(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    return ImuSensor_I2cWrite(adlx345_bus, addr, reg, data, length);
+}
+
+// 取输出速率不低于 odr 的最低档, 3200Hz >> (15 - rate)
+static Adlx345SampleRate Adlx345Sensor_Rate(rt_uint32_t odr)
+{
+    int32_t rate = Adlx345SampleRate_6_25;
+    while (rate < Adlx345SampleRate_3600 && (320000u >> (15 - rate)) < odr * 100u)
+    {
+        rate++;
+    }
+    return (Adlx345SampleRate)rate;
+}
+
+static Adlx345Range Adlx345Sensor_Range(rt_int32_t range)
+{
+    return (range <= 2000) ? Adlx345Range_2g : (range <= 4000) ? Adlx345Range_4g :
+           (range <= 8000) ? Adlx345Range_8g : Adlx345Range_16g;
+}
+
+static rt_err_t Adlx345Sensor_SetMode(rt_uint8_t mode)
+{
+    bool ret;
+    switch (mode)
+    {
+        case RT_SENSOR_MODE_POLLING:
+            ret = Adlx345_SetInterrupt(&adlx345_dev, ADLX345_SENSOR_DATA_INT, false) &&
+                  Adlx345_SetFifo(&adlx345_dev, Adlx345Fifo_Bypass, 0);
+            break;
+        case RT_SENSOR_MODE_INT:
+            ret = Adlx345_SetInterrupt(&adlx345_dev, ADLX345_SENSOR_DATA_INT, false) &&
+                  Adlx345_SetFifo(&adlx345_dev, Adlx345Fifo_Bypass, 0) &&
+                  Adlx345_SetInterrupt(&adlx345_dev, ADLX345_INT_DATA_READY, true);
+            break;
+        case RT_SENSOR_MODE_FIFO:
+            // 流模式下 FIFO 满后丢弃最旧样本, 读取不及时也不会停止采集
+            ret = Adlx345_SetInterrupt(&adlx345_dev, ADLX345_SENSOR_DATA_INT, false) &&
+                  Adlx345_SetFifo(&adlx345_dev, Adlx345Fifo_Stream, ADLX345_SENSOR_WATERMARK) &&
+                  Adlx345_SetInterrupt(&adlx345_dev, ADLX345_INT_WATERMARK, true);
+            break;
+        default:
+            return -RT_EINVAL;
+    }
+    return ret ? RT_EOK : -RT_EIO;
+}
+
+static rt_size_t Adlx345Sensor_FetchData(struct rt_sensor_device *sensor, void *buf, rt_size_t len)
+{
+    struct rt_sensor_data *data = (struct rt_sensor_data *)buf;
+    int16_t raw[ADLX345_FIFO_DEPTH][3];
+    float mg[ADLX345_FIFO_DEPTH][3];
+    int32_t n;
+
+    if (RT_SENSOR_MODE_FIFO == sensor->config.mode)
+    {
+        n = Adlx345_ReadFifo(&adlx345_dev, raw, (len > ADLX345_FIFO_DEPTH) ? ADLX345_FIFO_DEPTH : (int32_t)len);
+    }
+    else
+    {
+        n = Adlx345_ReadRaw(&adlx345_dev, raw[0]) ? 1 : 0;
+    }
+    if (n <= 0)
+    {
+        return 0;
+    }
+
+    // 整个突发一次换算为 mg
+    ImuConvert_RawToFloat(raw[0], (float)(Adlx345_GetScale(&adlx345_dev) * IMU_REAL(1000.0) / IMU_GRAVITY), mg[0],
+                          n * 3);
+    rt_uint32_t now = rt_sensor_get_ts();
+    for (int32_t i = 0; i < n; i++)
+    {
+        data[i].type = RT_SENSOR_CLASS_ACCE;
+        data[i].timestamp = ImuSensor_Backdate(now, n - 1 - i, sensor->config.odr);
+        data[i].data.acce.x = ImuSensor_Round(mg[i][0]);
+        data[i].data.acce.y = ImuSensor_Round(mg[i][1]);
+        data[i].data.acce.z = ImuSensor_Round(mg[i][2]);
+    }
+    return (rt_size_t)n;
+}
+
+static rt_err_t Adlx345Sensor_Control(struct rt_sensor_device *sensor, int cmd, void *args)
+{
+    rt_err_t ret = RT_EOK;
+    (void)sensor;
+    switch (cmd)
+    {
+        case RT_SENSOR_CTRL_GET_ID:
+            ret = adlx345_dev.read(adlx345_dev.addr, ADLX345_REG_DEVID, (uint8_t *)args, 1) ? RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_RANGE:
+            ret = Adlx345_SetRange(&adlx345_dev, Adlx345Sensor_Range((rt_int32_t)(rt_base_t)args)) ? RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_ODR:
+            ret = Adlx345_SetSampleRate(&adlx345_dev, Adlx345Sensor_Rate((rt_uint32_t)(rt_base_t)args & 0xFFFF),
+                                        adlx345_dev.low_power) ? RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_MODE:
+            ret = Adlx345Sensor_SetMode((rt_uint8_t)(rt_base_t)args);
+            break;
+        case RT_SENSOR_CTRL_SET_POWER:
+            // 只支持 BW_RATE 的低功耗位, 待机由 Imu 的 set_idle 回调处理
+            switch ((rt_uint8_t)(rt_base_t)args)
+            {
+                case RT_SENSOR_POWER_LOW:
+                case RT_SENSOR_POWER_NORMAL:
+                case RT_SENSOR_POWER_HIGH:
+                    ret = Adlx345_SetSampleRate(&adlx345_dev, adlx345_dev.sample_rate,
+                                                RT_SENSOR_POWER_LOW == (rt_uint8_t)(rt_base_t)args) ? RT_EOK : -RT_EIO;
+                    break;
+                default:
+                    ret = -RT_ENOSYS;
+                    break;
+            }
+            break;
+        default:
+            ret = -RT_ENOSYS;
+            break;
+    }
+    return ret;
+}
+
+static const struct rt_sensor_ops adlx345_ops = {
+    Adlx345Sensor_FetchData,
+    Adlx345Sensor_Control,
+};
+
+int rt_hw_adlx345_init(const char *name, struct rt_sensor_config *cfg)
+{
+    rt_sensor_t sensor;
+    adlx345_bus = rt_i2c_bus_device_find(cfg->intf.dev_name);
+    if (RT_NULL == adlx345_bus)
+    {
+        return -RT_ERROR;
+    }
+
+    adlx345_dev.addr = cfg->intf.user_data ? (Adlx345Addr)(rt_base_t)cfg->intf.user_data : Adlx345Addr_Low;
+    adlx345_dev.range = cfg->range ? Adlx345Sensor_Range(cfg->range) : Adlx345Range_16g;
+    adlx345_dev.sample_rate = cfg->odr ? Adlx345Sensor_Rate(cfg->odr) : Adlx345SampleRate_100;
+    Adlx345_Register(&adlx345_dev, Adlx345Sensor_I2cRead, Adlx345Sensor_I2cWrite);
+    Adlx345_Init(&adlx345_dev);
+    if (!adlx345_dev.inited)
+    {
+        return -RT_EIO;
+    }
+
+    sensor = (rt_sensor_t)rt_calloc(1, sizeof(struct rt_sensor_device));
+    if (RT_NULL == sensor)
+    {
+        return -RT_ENOMEM;
+    }
+    sensor->info.type       = RT_SENSOR_CLASS_ACCE;
+    sensor->info.vendor     = RT_SENSOR_VENDOR_UNKNOWN;
+    sensor->info.model      = "adxl345";
+    sensor->info.unit       = RT_SENSOR_UNIT_MG;
+    sensor->info.intf_type  = RT_SENSOR_INTF_I2C;
+    sensor->info.range_max  = 16000;
+    sensor->info.range_min  = 2000;
+    sensor->info.period_min = 1;
+    sensor->info.fifo_max   = ADLX345_FIFO_DEPTH;
+    rt_memcpy(&sensor->config, cfg, sizeof(struct rt_sensor_config));
+    sensor->config.odr = (rt_uint16_t)((320000u >> (15 - adlx345_dev.sample_rate)) / 100u);
+    sensor->ops = &adlx345_ops;
+
+    if (RT_EOK != rt_hw_sensor_register(sensor, name, RT_DEVICE_FLAG_RDONLY | RT_DEVICE_FLAG_INT_RX | RT_DEVICE_FLAG_FIFO_RX,
+                                        RT_NULL))
+    {
+        rt_free(sensor);
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
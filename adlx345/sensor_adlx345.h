@@ -0,0 +1,23 @@
+/**
+ * @file sensor_adlx345.h
+ * @author Wyatt Yu
+ * @brief ADXL345 的 RT-Thread 传感器框架设备 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __SENSOR_ADLX345_H__
+#define __SENSOR_ADLX345_H__
+#include "sensor.h"
+#include "adlx345.h"
+
+#define ADLX345_SENSOR_WATERMARK    16          // FIFO 模式水位, 取深度的一半给读取留出余量
+
+/**
+ * cfg->intf.dev_name 为 I2C 总线名, cfg->intf.user_data 为 7 位地址 (0 时取 Adlx345Addr_Low),
+ * cfg->range 单位 mg, cfg->odr 单位 Hz, 为 0 时保持默认 16g / 100Hz.
+ * FIFO 与中断模式需要配置 cfg->irq_pin, 中断从 INT_MAP 指定的引脚输出, 默认 INT1.
+ * 驱动回调不带上下文, 只支持一个实例.
+ */
+int rt_hw_adlx345_init(const char *name, struct rt_sensor_config *cfg);
+
+#endif
@@ -1,39 +1,108 @@
 /**
  * @file imu_complementaryf_filter.c
  * @author Wyatt Yu
- * @brief IMU 互补滤波算法的实现, 互补滤波算法必须包含磁力计数据
+ * @brief IMU 互补滤波算法的实现, 在四元数上做陀螺积分与线性融合, 每个样本不调用三角函数
+ *
+ * 每个周期陀螺仪积分得到预测姿态, 加速度计测得的重力方向与预测重力方向的叉积作为倾角误差,
+ * 按 (1 - alpha) 的比例把姿态朝测量值旋转; 有磁力计时, 把磁场转到地理系, 用其水平分量的
+ * 方向误差只修正偏航. 小角度下旋转量与误差角成线性关系, 与欧拉角版本的
+ * angle = alpha * (angle + gyro * dt) + (1 - alpha) * measured 等价.
  * @copyright Copyright (c) 2025
  */
 #include "app_common.h"
 #include "imu.h"
 
-void ImuComplementaryFilter_AlgorithmUpdate(Imu *imu)
+void ImuComplementaryFilter_AlgorithmUpdate(Imu *imu, const ImuSource *source)
 {
-    float gyro_pitch = imu->source.gyro.x * imu->comple_filter_alpha;
-    float gyro_roll = imu->source.gyro.y * imu->comple_filter_alpha;
-    float gyro_yaw = imu->source.gyro.z * imu->comple_filter_alpha; 
-
-    float accel_pitch = atan2f(imu->source.accel.y, imu->source.accel.z);
-    float accel_roll = atan2f(-imu->source.accel.x, \
-                sqrtf(imu->source.accel.y * imu->source.accel.y + \
-                imu->source.accel.z * imu->source.accel.z));
-    imu->raw_euler.pitch = imu->comple_filter_alpha * (imu->raw_euler.pitch + gyro_pitch) + \
-                    (1 - imu->comple_filter_alpha) * accel_roll;
-    imu->raw_euler.roll = imu->comple_filter_alpha * (imu->raw_euler.roll + gyro_roll) + \
-                    (1 - imu->comple_filter_alpha) * accel_pitch;
-    if (imu->source.use_magic)
+    imu_real_t q0 = imu->quaternion.q0;
+    imu_real_t q1 = imu->quaternion.q1;
+    imu_real_t q2 = imu->quaternion.q2;
+    imu_real_t q3 = imu->quaternion.q3;
+    imu_real_t ax = source->accel.x;
+    imu_real_t ay = source->accel.y;
+    imu_real_t az = source->accel.z;
+    imu_real_t halfdt = IMU_REAL(0.5) / imu->samp_freq;
+    imu_real_t k = IMU_REAL(1.0) - imu->comple_filter_alpha;  // 测量值权重
+    imu_real_t recipNorm;
+
+    imu_real_t q0q0 = q0 * q0;
+    imu_real_t q0q1 = q0 * q1;
+    imu_real_t q0q2 = q0 * q2;
+    imu_real_t q0q3 = q0 * q3;
+    imu_real_t q1q1 = q1 * q1;
+    imu_real_t q1q2 = q1 * q2;
+    imu_real_t q1q3 = q1 * q3;
+    imu_real_t q2q2 = q2 * q2;
+    imu_real_t q2q3 = q2 * q3;
+    imu_real_t q3q3 = q3 * q3;
+
+    // 机体系旋转增量的一半: 陀螺积分 + 倾角修正
+    imu_real_t hx = source->gyro.x * halfdt;
+    imu_real_t hy = source->gyro.y * halfdt;
+    imu_real_t hz = source->gyro.z * halfdt;
+
+    if (imu->accel_valid)
+    {
+        recipNorm = IMU_INVSQRT(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        // 预测的重力方向 (机体系), 误差 e = a x v 的模为误差角的正弦
+        imu_real_t vx = IMU_REAL(2.0) * (q1q3 - q0q2);
+        imu_real_t vy = IMU_REAL(2.0) * (q0q1 + q2q3);
+        imu_real_t vz = IMU_REAL(2.0) * (q0q0 + q3q3) - IMU_REAL(1.0);
+        imu_real_t halfk = IMU_REAL(0.5) * k;
+        hx += halfk * (ay * vz - az * vy);
+        hy += halfk * (az * vx - ax * vz);
+        hz += halfk * (ax * vy - ay * vx);
+    }
+    else
+    {
+        // do nothing
+    }
+
+    // q = q * (1, h)
+    imu_real_t p0 = q0 - q1 * hx - q2 * hy - q3 * hz;
+    imu_real_t p1 = q1 + q0 * hx + q2 * hz - q3 * hy;
+    imu_real_t p2 = q2 + q0 * hy - q1 * hz + q3 * hx;
+    imu_real_t p3 = q3 + q0 * hz + q1 * hy - q2 * hx;
+
+    if (IMU_HAS_MAGIC(imu->magic_valid))
     {
-        float mag_x = imu->source.magic.x * cosf(imu->raw_euler.pitch) + imu->source.magic.z * sinf(imu->raw_euler.pitch);
-        float mag_y = imu->source.magic.x * sinf(imu->raw_euler.roll) * sinf(imu->raw_euler.pitch) +
-                        imu->source.magic.y * cosf(imu->raw_euler.roll) -
-                        imu->source.magic.z * sinf(imu->raw_euler.roll) * cosf(imu->raw_euler.pitch);
-        float accel_yaw = atan2f(-mag_y, mag_x);  // 基于磁力计的偏航角
-
-        imu->raw_euler.yaw = imu->comple_filter_alpha * (imu->raw_euler.yaw + gyro_yaw) + \
-                        (1 - imu->comple_filter_alpha) * accel_yaw;
+        imu_real_t mx = source->magic.x;
+        imu_real_t my = source->magic.y;
+        imu_real_t mz = source->magic.z;
+        // 磁场在地理系的水平分量, 参考方向为 x 轴 (磁北)
+        imu_real_t ex = mx * (IMU_REAL(1.0) - IMU_REAL(2.0) * (q2q2 + q3q3)) + IMU_REAL(2.0) * (my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+        imu_real_t ey = IMU_REAL(2.0) * (mx * (q1q2 + q0q3) + mz * (q2q3 - q0q1)) + my * (IMU_REAL(1.0) - IMU_REAL(2.0) * (q1q1 + q3q3));
+        imu_real_t norm2 = ex * ex + ey * ey;
+        if (norm2 > IMU_REAL(0.0))
+        {
+            // 绕地理系 z 轴旋转, 只改变偏航, 不影响倾角: q = (1, 0, 0, hz) * q
+            imu_real_t halfyaw = -IMU_REAL(0.5) * k * ey * IMU_INVSQRT(norm2);
+            imu_real_t r0 = p0 - halfyaw * p3;
+            imu_real_t r1 = p1 - halfyaw * p2;
+            imu_real_t r2 = p2 + halfyaw * p1;
+            imu_real_t r3 = p3 + halfyaw * p0;
+            p0 = r0;
+            p1 = r1;
+            p2 = r2;
+            p3 = r3;
+        }
+        else
+        {
+            // do nothing
+        }
     }
     else
     {
-        imu->raw_euler.yaw = 0;
+        // do nothing
     }
-}
\ No newline at end of file
+
+    recipNorm = IMU_INVSQRT(p0 * p0 + p1 * p1 + p2 * p2 + p3 * p3);
+    imu->quaternion.q0 = p0 * recipNorm;
+    imu->quaternion.q1 = p1 * recipNorm;
+    imu->quaternion.q2 = p2 * recipNorm;
+    imu->quaternion.q3 = p3 * recipNorm;
+}
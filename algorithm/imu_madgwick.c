@@ -7,167 +7,174 @@
 #include "app_common.h"
 #include "imu.h"
 
-void ImuMadgwick_AlgorithmUpdate(Imu *imu)
+void ImuMadgwick_AlgorithmUpdate(Imu *imu, const ImuSource *source)
 {
-    float recipNorm;
-    float s0, s1, s2, s3;
-    float qDot1, qDot2, qDot3, qDot4;
-    float _2q0, _2q1, _2q2, _2q3;
-
-    if (imu->source.use_magic) 
+    imu_real_t recipNorm;
+    imu_real_t s0, s1, s2, s3;
+    imu_real_t qDot1, qDot2, qDot3, qDot4;
+    imu_real_t _2q0, _2q1, _2q2, _2q3;
+
+    // Local copies, the volatile members are read once and written back once
+    imu_real_t q0 = imu->quaternion.q0;
+    imu_real_t q1 = imu->quaternion.q1;
+    imu_real_t q2 = imu->quaternion.q2;
+    imu_real_t q3 = imu->quaternion.q3;
+    imu_real_t gx = source->gyro.x;
+    imu_real_t gy = source->gyro.y;
+    imu_real_t gz = source->gyro.z;
+    imu_real_t ax = source->accel.x;
+    imu_real_t ay = source->accel.y;
+    imu_real_t az = source->accel.z;
+    imu_real_t beta = imu->ki_gain;
+    imu_real_t dt = IMU_REAL(1.0) / imu->samp_freq;
+
+    // Rate of change of quaternion from gyroscope
+    qDot1 = IMU_REAL(0.5) * (-q1 * gx - q2 * gy - q3 * gz);
+    qDot2 = IMU_REAL(0.5) * (q0 * gx + q2 * gz - q3 * gy);
+    qDot3 = IMU_REAL(0.5) * (q0 * gy - q1 * gz + q3 * gx);
+    qDot4 = IMU_REAL(0.5) * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (IMU_HAS_MAGIC(imu->magic_valid))
     {
-        float hx, hy;
-        float _2q0mx, _2q0my, _2q0mz, _2q1mx;
-        float _2bx, _2bz;
-        float _4bx, _4bz;
-        float _2q0q2, _2q2q3;
-        float q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
-        // Rate of change of quaternion from gyroscope
-        qDot1 = 0.5f * (imu->quaternion.q1 * imu->source.gyro.x - imu->quaternion.q2 * imu->source.gyro.y - imu->quaternion.q3 * imu->source.gyro.z);
-        qDot2 = 0.5f * (imu->quaternion.q0 * imu->source.gyro.x + imu->quaternion.q2 * imu->source.gyro.z - imu->quaternion.q3 * imu->source.gyro.y);
-        qDot3 = 0.5f * (imu->quaternion.q0 * imu->source.gyro.y - imu->quaternion.q1 * imu->source.gyro.z + imu->quaternion.q3 * imu->source.gyro.x);
-        qDot4 = 0.5f * (imu->quaternion.q0 * imu->source.gyro.z + imu->quaternion.q1 * imu->source.gyro.y - imu->quaternion.q2 * imu->source.gyro.x);
+        imu_real_t mx = source->magic.x;
+        imu_real_t my = source->magic.y;
+        imu_real_t mz = source->magic.z;
+        imu_real_t hx, hy;
+        imu_real_t _2bx, _2bz;
+        imu_real_t _2bxq0, _2bxq1, _2bxq2, _2bxq3;
+        imu_real_t _2bzq0, _2bzq1, _2bzq2, _2bzq3;
+        imu_real_t q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+        imu_real_t f1, f2, f3, f4, f5, f6;
 
         // Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
-        if(!((imu->source.accel.x == 0.0f) && (imu->source.accel.y == 0.0f) && (imu->source.accel.z == 0.0f))) {
+        if (imu->accel_valid) {
 
             // Normalise accelerometer measurement
-            recipNorm = InvSqrt(imu->source.accel.x * imu->source.accel.x + imu->source.accel.y * imu->source.accel.y + imu->source.accel.z * imu->source.accel.z);
-            imu->source.accel.x *= recipNorm;
-            imu->source.accel.y *= recipNorm;
-            imu->source.accel.z *= recipNorm;   
+            recipNorm = IMU_INVSQRT(ax * ax + ay * ay + az * az);
+            ax *= recipNorm;
+            ay *= recipNorm;
+            az *= recipNorm;
 
             // Normalise magnetometer measurement
-            recipNorm = InvSqrt(imu->source.magic.x * imu->source.magic.x + imu->source.magic.y * imu->source.magic.y + imu->source.magic.z * imu->source.magic.z);
-            imu->source.magic.x *= recipNorm;
-            imu->source.magic.y *= recipNorm;
-            imu->source.magic.z *= recipNorm;
+            recipNorm = IMU_INVSQRT(mx * mx + my * my + mz * mz);
+            mx *= recipNorm;
+            my *= recipNorm;
+            mz *= recipNorm;
 
             // Auxiliary variables to avoid repeated arithmetic
-            _2q0mx = 2.0f * imu->quaternion.q0 * imu->source.magic.x;
-            _2q0my = 2.0f * imu->quaternion.q0 * imu->source.magic.y;
-            _2q0mz = 2.0f * imu->quaternion.q0 * imu->source.magic.z;
-            _2q1mx = 2.0f * imu->quaternion.q1 * imu->source.magic.x;
-            _2q0 = 2.0f * imu->quaternion.q0;
-            _2q1 = 2.0f * imu->quaternion.q1;
-            _2q2 = 2.0f * imu->quaternion.q2;
-            _2q3 = 2.0f * imu->quaternion.q3;
-            _2q0q2 = 2.0f * imu->quaternion.q0 * imu->quaternion.q2;
-            _2q2q3 = 2.0f * imu->quaternion.q2 * imu->quaternion.q3;
-            q0q0 = imu->quaternion.q0 * imu->quaternion.q0;
-            q0q1 = imu->quaternion.q0 * imu->quaternion.q1;
-            q0q2 = imu->quaternion.q0 * imu->quaternion.q2;
-            q0q3 = imu->quaternion.q0 * imu->quaternion.q3;
-            q1q1 = imu->quaternion.q1 * imu->quaternion.q1;
-            q1q2 = imu->quaternion.q1 * imu->quaternion.q2;
-            q1q3 = imu->quaternion.q1 * imu->quaternion.q3;
-            q2q2 = imu->quaternion.q2 * imu->quaternion.q2;
-            q2q3 = imu->quaternion.q2 * imu->quaternion.q3;
-            q3q3 = imu->quaternion.q3 * imu->quaternion.q3;
-
-            // Reference direction of Earth's magnetic field
-            hx = imu->source.magic.x * q0q0 - _2q0my * imu->quaternion.q3 + _2q0mz * imu->quaternion.q2 + imu->source.magic.x * q1q1 + _2q1 * imu->source.magic.y * imu->quaternion.q2 + _2q1 * imu->source.magic.z * imu->quaternion.q3 - imu->source.magic.x * q2q2 - imu->source.magic.x * q3q3;
-            hy = _2q0mx * imu->quaternion.q3 + imu->source.magic.y * q0q0 - _2q0mz * imu->quaternion.q1 + _2q1mx * imu->quaternion.q2 - imu->source.magic.y * q1q1 + imu->source.magic.y * q2q2 + _2q2 * imu->source.magic.z * imu->quaternion.q3 - imu->source.magic.y * q3q3;
-            _2bx = sqrt(hx * hx + hy * hy);
-            _2bz = -_2q0mx * imu->quaternion.q2 + _2q0my * imu->quaternion.q1 + imu->source.magic.z * q0q0 + _2q1mx * imu->quaternion.q3 - imu->source.magic.z * q1q1 + _2q2 * imu->source.magic.y * imu->quaternion.q3 - imu->source.magic.z * q2q2 + imu->source.magic.z * q3q3;
-            _4bx = 2.0f * _2bx;
-            _4bz = 2.0f * _2bz;
-
-            // Gradient decent algorithm corrective step
-            s0 = -_2q2 * (2.0f * q1q3 - _2q0q2 - imu->source.accel.x) + _2q1 * (2.0f * q0q1 + _2q2q3 - imu->source.accel.y) - _2bz * imu->quaternion.q2 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - imu->source.magic.x) + (-_2bx * imu->quaternion.q3 + _2bz * imu->quaternion.q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - imu->source.magic.y) + _2bx * imu->quaternion.q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - imu->source.magic.z);
-            s1 = _2q3 * (2.0f * q1q3 - _2q0q2 - imu->source.accel.x) + _2q0 * (2.0f * q0q1 + _2q2q3 - imu->source.accel.y) - 4.0f * imu->quaternion.q1 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - imu->source.accel.z) + _2bz * imu->quaternion.q3 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - imu->source.magic.x) + (_2bx * imu->quaternion.q2 + _2bz * imu->quaternion.q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - imu->source.magic.y) + (_2bx * imu->quaternion.q3 - _4bz * imu->quaternion.q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - imu->source.magic.z);
-            s2 = -_2q0 * (2.0f * q1q3 - _2q0q2 - imu->source.accel.x) + _2q3 * (2.0f * q0q1 + _2q2q3 - imu->source.accel.y) - 4.0f * imu->quaternion.q2 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - imu->source.accel.z) + (-_4bx * imu->quaternion.q2 - _2bz * imu->quaternion.q0) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - imu->source.magic.x) + (_2bx * imu->quaternion.q1 + _2bz * imu->quaternion.q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - imu->source.magic.y) + (_2bx * imu->quaternion.q0 - _4bz * imu->quaternion.q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - imu->source.magic.z);
-            s3 = _2q1 * (2.0f * q1q3 - _2q0q2 - imu->source.accel.x) + _2q2 * (2.0f * q0q1 + _2q2q3 - imu->source.accel.y) + (-_4bx * imu->quaternion.q3 + _2bz * imu->quaternion.q1) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - imu->source.magic.x) + (-_2bx * imu->quaternion.q0 + _2bz * imu->quaternion.q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - imu->source.magic.y) + _2bx * imu->quaternion.q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - imu->source.magic.z);
-            recipNorm = InvSqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3); // normalise step magnitude
-            s0 *= recipNorm;
-            s1 *= recipNorm;
-            s2 *= recipNorm;
-            s3 *= recipNorm;
+            _2q0 = IMU_REAL(2.0) * q0;
+            _2q1 = IMU_REAL(2.0) * q1;
+            _2q2 = IMU_REAL(2.0) * q2;
+            _2q3 = IMU_REAL(2.0) * q3;
+            q0q0 = q0 * q0;
+            q0q1 = q0 * q1;
+            q0q2 = q0 * q2;
+            q0q3 = q0 * q3;
+            q1q1 = q1 * q1;
+            q1q2 = q1 * q2;
+            q1q3 = q1 * q3;
+            q2q2 = q2 * q2;
+            q2q3 = q2 * q3;
+            q3q3 = q3 * q3;
+
+            // Reference direction of Earth's magnetic field, h = q * m * q'
+            hx = mx * (q0q0 + q1q1 - q2q2 - q3q3) + IMU_REAL(2.0) * (my * (q1q2 - q0q3) + mz * (q0q2 + q1q3));
+            hy = my * (q0q0 - q1q1 + q2q2 - q3q3) + IMU_REAL(2.0) * (mx * (q0q3 + q1q2) + mz * (q2q3 - q0q1));
+            _2bz = mz * (q0q0 - q1q1 - q2q2 + q3q3) + IMU_REAL(2.0) * (mx * (q1q3 - q0q2) + my * (q0q1 + q2q3));
+            _2bx = IMU_SQRT(hx * hx + hy * hy);
+
+            // Objective function: estimated minus measured gravity (f1..f3) and field (f4..f6)
+            f1 = IMU_REAL(2.0) * (q1q3 - q0q2) - ax;
+            f2 = IMU_REAL(2.0) * (q0q1 + q2q3) - ay;
+            f3 = IMU_REAL(1.0) - IMU_REAL(2.0) * (q1q1 + q2q2) - az;
+            f4 = _2bx * (IMU_REAL(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+            f5 = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+            f6 = _2bx * (q0q2 + q1q3) + _2bz * (IMU_REAL(0.5) - q1q1 - q2q2) - mz;
+
+            // Jacobian entries of the field terms are all 2b * q products
+            _2bxq0 = _2bx * q0;
+            _2bxq1 = _2bx * q1;
+            _2bxq2 = _2bx * q2;
+            _2bxq3 = _2bx * q3;
+            _2bzq0 = _2bz * q0;
+            _2bzq1 = _2bz * q1;
+            _2bzq2 = _2bz * q2;
+            _2bzq3 = _2bz * q3;
+
+            // Gradient decent algorithm corrective step, s = J' * f
+            s0 = -_2q2 * f1 + _2q1 * f2 - _2bzq2 * f4 + (_2bzq1 - _2bxq3) * f5 + _2bxq2 * f6;
+            s1 = _2q3 * f1 + _2q0 * f2 - IMU_REAL(2.0) * _2q1 * f3 + _2bzq3 * f4 + (_2bxq2 + _2bzq0) * f5 + (_2bxq3 - IMU_REAL(2.0) * _2bzq1) * f6;
+            s2 = -_2q0 * f1 + _2q3 * f2 - IMU_REAL(2.0) * _2q2 * f3 - (IMU_REAL(2.0) * _2bxq2 + _2bzq0) * f4 + (_2bxq1 + _2bzq3) * f5 + (_2bxq0 - IMU_REAL(2.0) * _2bzq2) * f6;
+            s3 = _2q1 * f1 + _2q2 * f2 + (_2bzq1 - IMU_REAL(2.0) * _2bxq3) * f4 + (_2bzq2 - _2bxq0) * f5 + _2bxq1 * f6;
+            recipNorm = IMU_INVSQRT(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3); // normalise step magnitude
 
             // Apply feedback step
-            qDot1 -= imu->ki_gain * s0;
-            qDot2 -= imu->ki_gain * s1;
-            qDot3 -= imu->ki_gain * s2;
-            qDot4 -= imu->ki_gain * s3;
+            recipNorm *= beta;
+            qDot1 -= recipNorm * s0;
+            qDot2 -= recipNorm * s1;
+            qDot3 -= recipNorm * s2;
+            qDot4 -= recipNorm * s3;
         }
-
-        // Integrate rate of change of quaternion to yield quaternion
-        imu->quaternion.q0 += qDot1 * (1.0f / imu->samp_freq);
-        imu->quaternion.q1 += qDot2 * (1.0f / imu->samp_freq);
-        imu->quaternion.q2 += qDot3 * (1.0f / imu->samp_freq);
-        imu->quaternion.q3 += qDot4 * (1.0f / imu->samp_freq);
-
-        // Normalise quaternion
-        recipNorm = InvSqrt(imu->quaternion.q0 * imu->quaternion.q0 + imu->quaternion.q1 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q2 + imu->quaternion.q3 * imu->quaternion.q3);
-        imu->quaternion.q0 *= recipNorm;
-        imu->quaternion.q1 *= recipNorm;
-        imu->quaternion.q2 *= recipNorm;
-        imu->quaternion.q3 *= recipNorm;
     }
     else
     {
-        float _4q0, _4q1, _4q2;
-        float _8q1, _8q2;
-        float q0q0, q1q1, q2q2, q3q3;
-        // Rate of change of quaternion from gyroscope
-        qDot1 = 0.5f * (imu->quaternion.q1 * imu->source.gyro.x - imu->quaternion.q2 * imu->source.gyro.y - imu->quaternion.q3 * imu->source.gyro.z);
-        qDot2 = 0.5f * (imu->quaternion.q0 * imu->source.gyro.x + imu->quaternion.q2 * imu->source.gyro.z - imu->quaternion.q3 * imu->source.gyro.y);
-        qDot3 = 0.5f * (imu->quaternion.q0 * imu->source.gyro.y - imu->quaternion.q1 * imu->source.gyro.z + imu->quaternion.q3 * imu->source.gyro.x);
-        qDot4 = 0.5f * (imu->quaternion.q0 * imu->source.gyro.z + imu->quaternion.q1 * imu->source.gyro.y - imu->quaternion.q2 * imu->source.gyro.x);
+        imu_real_t _4q0, _4q1, _4q2;
+        imu_real_t _8q1, _8q2;
+        imu_real_t q0q0, q1q1, q2q2, q3q3;
 
         // Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
-        if(!((imu->source.accel.x == 0.0f) && (imu->source.accel.y == 0.0f) && (imu->source.accel.z == 0.0f))) {
+        if (imu->accel_valid) {
 
             // Normalise accelerometer measurement
-            recipNorm = InvSqrt(imu->source.accel.x * imu->source.accel.x + imu->source.accel.y * imu->source.accel.y + imu->source.accel.z * imu->source.accel.z);
-            imu->source.accel.x *= recipNorm;
-            imu->source.accel.y *= recipNorm;
-            imu->source.accel.z *= recipNorm;   
+            recipNorm = IMU_INVSQRT(ax * ax + ay * ay + az * az);
+            ax *= recipNorm;
+            ay *= recipNorm;
+            az *= recipNorm;
 
             // Auxiliary variables to avoid repeated arithmetic
-            _2q0 = 2.0f * imu->quaternion.q0;
-            _2q1 = 2.0f * imu->quaternion.q1;
-            _2q2 = 2.0f * imu->quaternion.q2;
-            _2q3 = 2.0f * imu->quaternion.q3;
-            _4q0 = 4.0f * imu->quaternion.q0;
-            _4q1 = 4.0f * imu->quaternion.q1;
-            _4q2 = 4.0f * imu->quaternion.q2;
-            _8q1 = 8.0f * imu->quaternion.q1;
-            _8q2 = 8.0f * imu->quaternion.q2;
-            q0q0 = imu->quaternion.q0 * imu->quaternion.q0;
-            q1q1 = imu->quaternion.q1 * imu->quaternion.q1;
-            q2q2 = imu->quaternion.q2 * imu->quaternion.q2;
-            q3q3 = imu->quaternion.q3 * imu->quaternion.q3;
+            _2q0 = IMU_REAL(2.0) * q0;
+            _2q1 = IMU_REAL(2.0) * q1;
+            _2q2 = IMU_REAL(2.0) * q2;
+            _2q3 = IMU_REAL(2.0) * q3;
+            _4q0 = IMU_REAL(4.0) * q0;
+            _4q1 = IMU_REAL(4.0) * q1;
+            _4q2 = IMU_REAL(4.0) * q2;
+            _8q1 = IMU_REAL(8.0) * q1;
+            _8q2 = IMU_REAL(8.0) * q2;
+            q0q0 = q0 * q0;
+            q1q1 = q1 * q1;
+            q2q2 = q2 * q2;
+            q3q3 = q3 * q3;
 
             // Gradient decent algorithm corrective step
-            s0 = _4q0 * q2q2 + _2q2 * imu->source.accel.x + _4q0 * q1q1 - _2q1 * imu->source.accel.y;
-            s1 = _4q1 * q3q3 - _2q3 * imu->source.accel.x + 4.0f * q0q0 * imu->quaternion.q1 - _2q0 * imu->source.accel.y - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * imu->source.accel.z;
-            s2 = 4.0f * q0q0 * imu->quaternion.q2 + _2q0 * imu->source.accel.x + _4q2 * q3q3 - _2q3 * imu->source.accel.y - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * imu->source.accel.z;
-            s3 = 4.0f * q1q1 * imu->quaternion.q3 - _2q1 * imu->source.accel.x + 4.0f * q2q2 * imu->quaternion.q3 - _2q2 * imu->source.accel.y;
-            recipNorm = InvSqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3); // normalise step magnitude
+            s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+            s1 = _4q1 * q3q3 - _2q3 * ax + IMU_REAL(4.0) * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+            s2 = IMU_REAL(4.0) * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+            s3 = IMU_REAL(4.0) * q1q1 * q3 - _2q1 * ax + IMU_REAL(4.0) * q2q2 * q3 - _2q2 * ay;
+            recipNorm = IMU_INVSQRT(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3); // normalise step magnitude
             s0 *= recipNorm;
             s1 *= recipNorm;
             s2 *= recipNorm;
             s3 *= recipNorm;
 
             // Apply feedback step
-            qDot1 -= imu->ki_gain * s0;
-            qDot2 -= imu->ki_gain * s1;
-            qDot3 -= imu->ki_gain * s2;
-            qDot4 -= imu->ki_gain * s3;
+            qDot1 -= beta * s0;
+            qDot2 -= beta * s1;
+            qDot3 -= beta * s2;
+            qDot4 -= beta * s3;
         }
-
-        // Integrate rate of change of quaternion to yield quaternion
-        imu->quaternion.q0 += qDot1 * (1.0f / imu->samp_freq);
-        imu->quaternion.q1 += qDot2 * (1.0f / imu->samp_freq);
-        imu->quaternion.q2 += qDot3 * (1.0f / imu->samp_freq);
-        imu->quaternion.q3 += qDot4 * (1.0f / imu->samp_freq);
-
-        // Normalise quaternion
-        recipNorm = InvSqrt(imu->quaternion.q0 * imu->quaternion.q0 + imu->quaternion.q1 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q2 + imu->quaternion.q3 * imu->quaternion.q3);
-        imu->quaternion.q0 *= recipNorm;
-        imu->quaternion.q1 *= recipNorm;
-        imu->quaternion.q2 *= recipNorm;
-        imu->quaternion.q3 *= recipNorm;
     }
-}
\ No newline at end of file
+
+    // Integrate rate of change of quaternion to yield quaternion
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    // Normalise quaternion
+    recipNorm = IMU_INVSQRT(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    imu->quaternion.q0 = q0 * recipNorm;
+    imu->quaternion.q1 = q1 * recipNorm;
+    imu->quaternion.q2 = q2 * recipNorm;
+    imu->quaternion.q3 = q3 * recipNorm;
+}
@@ -8,165 +8,146 @@
 #include "app_common.h"
 #include "imu.h"
 
-void ImuMahony_AlgorithmUpdate(Imu *imu)
+void ImuMahony_AlgorithmUpdate(Imu *imu, const ImuSource *source)
 {
-    float recipNorm;
-    float halfvx, halfvy, halfvz;
-    float halfex, halfey, halfez;
-    float qa, qb, qc;
-    float integralFBx = 0.0f,  integralFBy = 0.0f, integralFBz = 0.0f;
-
-    if (imu->source.use_magic)
+    imu_real_t recipNorm;
+    imu_real_t halfvx, halfvy, halfvz;
+    imu_real_t halfex, halfey, halfez;
+    imu_real_t qa, qb, qc;
+    imu_real_t dt = IMU_REAL(1.0) / imu->samp_freq;
+
+    // Local copies, the input sample is never modified; integral feedback persists in the instance
+    imu_real_t q0 = imu->quaternion.q0;
+    imu_real_t q1 = imu->quaternion.q1;
+    imu_real_t q2 = imu->quaternion.q2;
+    imu_real_t q3 = imu->quaternion.q3;
+    imu_real_t gx = source->gyro.x;
+    imu_real_t gy = source->gyro.y;
+    imu_real_t gz = source->gyro.z;
+    imu_real_t ax = source->accel.x;
+    imu_real_t ay = source->accel.y;
+    imu_real_t az = source->accel.z;
+    imu_real_t integralFBx = imu->integral_fb.x;
+    imu_real_t integralFBy = imu->integral_fb.y;
+    imu_real_t integralFBz = imu->integral_fb.z;
+
+    // Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
+    if (imu->accel_valid)
     {
-        float q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;  
-        float hx, hy, bx, bz;
-        float halfwx, halfwy, halfwz;
-
-        // Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
-        if(!((imu->source.accel.x == 0.0f) && (imu->source.accel.y == 0.0f) && (imu->source.accel.z == 0.0f))) {
-
-            // Normalise accelerometer measurement
-            recipNorm = InvSqrt(imu->source.accel.x * imu->source.accel.x + imu->source.accel.y * imu->source.accel.y + imu->source.accel.z * imu->source.accel.z);
-            imu->source.accel.x *= recipNorm;
-            imu->source.accel.y *= recipNorm;
-            imu->source.accel.z *= recipNorm;     
+        // Normalise accelerometer measurement
+        recipNorm = IMU_INVSQRT(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        if (IMU_HAS_MAGIC(imu->magic_valid))
+        {
+            imu_real_t q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+            imu_real_t hx, hy, bx, bz;
+            imu_real_t halfwx, halfwy, halfwz;
+            imu_real_t mx = source->magic.x;
+            imu_real_t my = source->magic.y;
+            imu_real_t mz = source->magic.z;
 
             // Normalise magnetometer measurement
-            recipNorm = InvSqrt(imu->source.magic.x * imu->source.magic.x + imu->source.magic.y * imu->source.magic.y + imu->source.magic.z * imu->source.magic.z);
-            imu->source.magic.x *= recipNorm;
-            imu->source.magic.y *= recipNorm;
-            imu->source.magic.z *= recipNorm;   
+            recipNorm = IMU_INVSQRT(mx * mx + my * my + mz * mz);
+            mx *= recipNorm;
+            my *= recipNorm;
+            mz *= recipNorm;
 
             // Auxiliary variables to avoid repeated arithmetic
-            q0q0 = imu->quaternion.q0 * imu->quaternion.q0;
-            q0q1 = imu->quaternion.q0 * imu->quaternion.q1;
-            q0q2 = imu->quaternion.q0 * imu->quaternion.q2;
-            q0q3 = imu->quaternion.q0 * imu->quaternion.q3;
-            q1q1 = imu->quaternion.q1 * imu->quaternion.q1;
-            q1q2 = imu->quaternion.q1 * imu->quaternion.q2;
-            q1q3 = imu->quaternion.q1 * imu->quaternion.q3;
-            q2q2 = imu->quaternion.q2 * imu->quaternion.q2;
-            q2q3 = imu->quaternion.q2 * imu->quaternion.q3;
-            q3q3 = imu->quaternion.q3 * imu->quaternion.q3;   
+            q0q0 = q0 * q0;
+            q0q1 = q0 * q1;
+            q0q2 = q0 * q2;
+            q0q3 = q0 * q3;
+            q1q1 = q1 * q1;
+            q1q2 = q1 * q2;
+            q1q3 = q1 * q3;
+            q2q2 = q2 * q2;
+            q2q3 = q2 * q3;
+            q3q3 = q3 * q3;
 
             // Reference direction of Earth's magnetic field
-            hx = 2.0f * (imu->source.magic.x * (0.5f - q2q2 - q3q3) + imu->source.magic.y * (q1q2 - q0q3) + imu->source.magic.z * (q1q3 + q0q2));
-            hy = 2.0f * (imu->source.magic.x * (q1q2 + q0q3) + imu->source.magic.y * (0.5f - q1q1 - q3q3) + imu->source.magic.z * (q2q3 - q0q1));
-            bx = sqrt(hx * hx + hy * hy);
-            bz = 2.0f * (imu->source.magic.x * (q1q3 - q0q2) + imu->source.magic.y * (q2q3 + q0q1) + imu->source.magic.z * (0.5f - q1q1 - q2q2));
+            hx = IMU_REAL(2.0) * (mx * (IMU_REAL(0.5) - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            hy = IMU_REAL(2.0) * (mx * (q1q2 + q0q3) + my * (IMU_REAL(0.5) - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+            bx = IMU_SQRT(hx * hx + hy * hy);
+            bz = IMU_REAL(2.0) * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (IMU_REAL(0.5) - q1q1 - q2q2));
 
             // Estimated direction of gravity and magnetic field
             halfvx = q1q3 - q0q2;
             halfvy = q0q1 + q2q3;
-            halfvz = q0q0 - 0.5f + q3q3;
-            halfwx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+            halfvz = q0q0 - IMU_REAL(0.5) + q3q3;
+            halfwx = bx * (IMU_REAL(0.5) - q2q2 - q3q3) + bz * (q1q3 - q0q2);
             halfwy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
-            halfwz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);  
+            halfwz = bx * (q0q2 + q1q3) + bz * (IMU_REAL(0.5) - q1q1 - q2q2);
 
             // Error is sum of cross product between estimated direction and measured direction of field vectors
-            halfex = (imu->source.accel.y * halfvz - imu->source.accel.z * halfvy) + (imu->source.magic.y * halfwz - imu->source.magic.z * halfwy);
-            halfey = (imu->source.accel.z * halfvx - imu->source.accel.x * halfvz) + (imu->source.magic.z * halfwx - imu->source.magic.x * halfwz);
-            halfez = (imu->source.accel.x * halfvy - imu->source.accel.y * halfvx) + (imu->source.magic.x * halfwy - imu->source.magic.y * halfwx);
-
-            // Compute and apply integral feedback if enabled
-            if(imu->ki_gain > 0.0f) {
-                integralFBx        += imu->ki_gain * halfex * (1.0f / imu->samp_freq);  // integral error scaled by Ki
-                integralFBy        += imu->ki_gain * halfey * (1.0f / imu->samp_freq);
-                integralFBz        += imu->ki_gain * halfez * (1.0f / imu->samp_freq);
-                imu->source.gyro.x += integralFBx;                                      // apply integral feedback
-                imu->source.gyro.y += integralFBy;
-                imu->source.gyro.z += integralFBz;
-            }
-            else {
-                integralFBx = 0.0f;	// prevent integral windup
-                integralFBy = 0.0f;
-                integralFBz = 0.0f;
-            }
-
-            // Apply proportional feedback
-            imu->source.gyro.x += imu->kp_gain * halfex;
-            imu->source.gyro.y += imu->kp_gain * halfey;
-            imu->source.gyro.z += imu->kp_gain * halfez;
+            halfex = (ay * halfvz - az * halfvy) + (my * halfwz - mz * halfwy);
+            halfey = (az * halfvx - ax * halfvz) + (mz * halfwx - mx * halfwz);
+            halfez = (ax * halfvy - ay * halfvx) + (mx * halfwy - my * halfwx);
         }
-
-        // Integrate rate of change of quaternion
-        imu->source.gyro.x *= (0.5f * (1.0f / imu->samp_freq));                                                                // pre-multiply common factors
-        imu->source.gyro.y *= (0.5f * (1.0f / imu->samp_freq));
-        imu->source.gyro.z *= (0.5f * (1.0f / imu->samp_freq));
-        qa                  = imu->quaternion.q0;
-        qb                  = imu->quaternion.q1;
-        qc                  = imu->quaternion.q2;
-        imu->quaternion.q0 += (-qb * imu->source.gyro.x - qc * imu->source.gyro.y - imu->quaternion.q3 * imu->source.gyro.z);
-        imu->quaternion.q1 += (qa * imu->source.gyro.x + qc * imu->source.gyro.z - imu->quaternion.q3 * imu->source.gyro.y);
-        imu->quaternion.q2 += (qa * imu->source.gyro.y - qb * imu->source.gyro.z + imu->quaternion.q3 * imu->source.gyro.x);
-        imu->quaternion.q3 += (qa * imu->source.gyro.z + qb * imu->source.gyro.y - qc * imu->source.gyro.x);
-
-          // Normalise quaternion
-        recipNorm           = InvSqrt(imu->quaternion.q0 * imu->quaternion.q0 + imu->quaternion.q1 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q2 + imu->quaternion.q3 * imu->quaternion.q3);
-        imu->quaternion.q0 *= recipNorm;
-        imu->quaternion.q1 *= recipNorm;
-        imu->quaternion.q2 *= recipNorm;
-        imu->quaternion.q3 *= recipNorm;
-    }
-    else 
-    {
-        if(!((imu->source.accel.x == 0.0f) && (imu->source.accel.y == 0.0f) && (imu->source.accel.z == 0.0f))) {
-            // Normalise accelerometer measurement
-            recipNorm            = InvSqrt(imu->source.accel.x * imu->source.accel.x + imu->source.accel.y * imu->source.accel.y + imu->source.accel.z * imu->source.accel.z);
-            imu->source.accel.x *= recipNorm;
-            imu->source.accel.y *= recipNorm;
-            imu->source.accel.z *= recipNorm;
-
-            // Estimated direction of gravity and vector perpendicular to magnetic flux
-            halfvx = imu->quaternion.q1 * imu->quaternion.q3 - imu->quaternion.q0 * imu->quaternion.q2;
-            halfvy = imu->quaternion.q0 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q3;
-            halfvz = imu->quaternion.q0 * imu->quaternion.q0 - 0.5f + imu->quaternion.q3 * imu->quaternion.q3;
+        else
+        {
+            // Estimated direction of gravity
+            halfvx = q1 * q3 - q0 * q2;
+            halfvy = q0 * q1 + q2 * q3;
+            halfvz = q0 * q0 - IMU_REAL(0.5) + q3 * q3;
 
             // Error is sum of cross product between estimated and measured direction of gravity
-            halfex = (imu->source.accel.y * halfvz - imu->source.accel.z * halfvy);
-            halfey = (imu->source.accel.z * halfvx - imu->source.accel.x * halfvz);
-            halfez = (imu->source.accel.x * halfvy - imu->source.accel.y * halfvx);
-
-            // Compute and apply integral feedback if enabled
-            if(imu->ki_gain > 0.0f) {
-                integralFBx        += imu->ki_gain * halfex * (1.0f / imu->samp_freq);  // integral error scaled by Ki
-                integralFBy        += imu->ki_gain * halfey * (1.0f / imu->samp_freq);
-                integralFBz        += imu->ki_gain * halfez * (1.0f / imu->samp_freq);
-                imu->source.gyro.x += integralFBx;                                      // apply integral feedback
-                imu->source.gyro.y += integralFBy;
-                imu->source.gyro.z += integralFBz;
-            }
-            else {
-                integralFBx = 0.0f;	// prevent integral windup
-                integralFBy = 0.0f;
-                integralFBz = 0.0f;
-            }
-
-            // Apply proportional feedback
-            imu->source.gyro.x += imu->kp_gain * halfex;
-            imu->source.gyro.y += imu->kp_gain * halfey;
-            imu->source.gyro.z += imu->kp_gain * halfez;
+            halfex = (ay * halfvz - az * halfvy);
+            halfey = (az * halfvx - ax * halfvz);
+            halfez = (ax * halfvy - ay * halfvx);
         }
 
-                                                                 // Integrate rate of change of quaternion
-        imu->source.gyro.x *= (0.5f * (1.0f / imu->samp_freq));  // pre-multiply common factors
-        imu->source.gyro.y *= (0.5f * (1.0f / imu->samp_freq));
-        imu->source.gyro.z *= (0.5f * (1.0f / imu->samp_freq));
-        qa                  = imu->quaternion.q0;
-        qb                  = imu->quaternion.q1;
-        qc                  = imu->quaternion.q2;
-        imu->quaternion.q0 += (-qb * imu->source.gyro.x - qc * imu->source.gyro.y - imu->quaternion.q3 * imu->source.gyro.z);
-        imu->quaternion.q1 += (qa * imu->source.gyro.x + qc * imu->source.gyro.z - imu->quaternion.q3 * imu->source.gyro.y);
-        imu->quaternion.q2 += (qa * imu->source.gyro.y - qb * imu->source.gyro.z + imu->quaternion.q3 * imu->source.gyro.x);
-        imu->quaternion.q3 += (qa * imu->source.gyro.z + qb * imu->source.gyro.y - qc * imu->source.gyro.x);
+        // Compute and apply integral feedback if enabled
+        if (imu->ki_gain > IMU_REAL(0.0))
+        {
+            integralFBx += imu->ki_gain * halfex * dt;  // integral error scaled by Ki
+            integralFBy += imu->ki_gain * halfey * dt;
+            integralFBz += imu->ki_gain * halfez * dt;
+            gx += integralFBx;                          // apply integral feedback
+            gy += integralFBy;
+            gz += integralFBz;
+        }
+        else
+        {
+            integralFBx = IMU_REAL(0.0);                // prevent integral windup
+            integralFBy = IMU_REAL(0.0);
+            integralFBz = IMU_REAL(0.0);
+        }
 
-        // Normalise quaternion
-        recipNorm = InvSqrt(imu->quaternion.q0 * imu->quaternion.q0 + imu->quaternion.q1 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q2 + imu->quaternion.q3 * imu->quaternion.q3);
-        imu->quaternion.q0 *= recipNorm;
-        imu->quaternion.q1 *= recipNorm;
-        imu->quaternion.q2 *= recipNorm;
-        imu->quaternion.q3 *= recipNorm;
+        // Apply proportional feedback
+        gx += imu->kp_gain * halfex;
+        gy += imu->kp_gain * halfey;
+        gz += imu->kp_gain * halfez;
+    }
+    else
+    {
+        // 没有修正时保留积分项, 继续补偿陀螺残余零偏
+        gx += integralFBx;
+        gy += integralFBy;
+        gz += integralFBz;
     }
-}
-
 
+    // Integrate rate of change of quaternion
+    gx *= (IMU_REAL(0.5) * dt);                         // pre-multiply common factors
+    gy *= (IMU_REAL(0.5) * dt);
+    gz *= (IMU_REAL(0.5) * dt);
+    qa = q0;
+    qb = q1;
+    qc = q2;
+    q0 += (-qb * gx - qc * gy - q3 * gz);
+    q1 += (qa * gx + qc * gz - q3 * gy);
+    q2 += (qa * gy - qb * gz + q3 * gx);
+    q3 += (qa * gz + qb * gy - qc * gx);
+
+    // Normalise quaternion
+    recipNorm = IMU_INVSQRT(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    imu->quaternion.q0 = q0 * recipNorm;
+    imu->quaternion.q1 = q1 * recipNorm;
+    imu->quaternion.q2 = q2 * recipNorm;
+    imu->quaternion.q3 = q3 * recipNorm;
+    imu->integral_fb.x = integralFBx;
+    imu->integral_fb.y = integralFBy;
+    imu->integral_fb.z = integralFBz;
+}
@@ -6,89 +6,393 @@
  */
 #include <string.h>
 #include "imu.h"
+#ifdef IMU_USING_HISTORY
+#include "imu_history.h"
+#endif
+
+#ifdef IMU_USING_PROFILING
+#define IMU_PATH_COUNT(imu, name)   ((imu)->path.name++)
+#else
+#define IMU_PATH_COUNT(imu, name)   ((void)0)
+#endif
 
-static inline double Imu_NormalizeAngle(float_t angle)
+static inline imu_real_t Imu_NormalizeAngle(imu_real_t angle)
 {
-    return (angle > MATH_PI) ? angle - MATH_2PI : (angle < -MATH_PI) ? angle + MATH_2PI : angle;
+    return (angle > IMU_PI) ? angle - IMU_2PI : (angle < -IMU_PI) ? angle + IMU_2PI : angle;
 }
 
-static void Imu_ConvertEuler(Imu *imu)
+// 由 raw_euler 计算角度制与相对零点的输出, 只在应用读取前调用, 不占用融合周期
+void Imu_UpdateEuler(Imu *imu)
 {
-    imu->raw_euler_degree.roll  = (float)imu->raw_euler.roll * 180 / MATH_PI;
-    imu->raw_euler_degree.pitch = (float)imu->raw_euler.pitch * 180 / MATH_PI;
-    imu->raw_euler_degree.yaw   = (float)imu->raw_euler.yaw * 180 / MATH_PI;
+    ImuContext *ctx = imu->ctx;
+    ctx->raw_euler_degree.roll  = RAD2DEGREE(imu->raw_euler.roll);
+    ctx->raw_euler_degree.pitch = RAD2DEGREE(imu->raw_euler.pitch);
+    ctx->raw_euler_degree.yaw   = RAD2DEGREE(imu->raw_euler.yaw);
+
+//    ctx->euler.pitch = Imu_NormalizeAngle(imu->raw_euler.pitch - ctx->zero_euler.pitch);
+//    ctx->euler.roll = Imu_NormalizeAngle(imu->raw_euler.roll - ctx->zero_euler.roll);
+//    ctx->euler.yaw = Imu_NormalizeAngle(imu->raw_euler.yaw - ctx->zero_euler.yaw);
+    ctx->euler.pitch = imu->raw_euler.pitch - ctx->zero_euler.pitch;
+    ctx->euler.roll = imu->raw_euler.roll - ctx->zero_euler.roll;
+    ctx->euler.yaw = imu->raw_euler.yaw - ctx->zero_euler.yaw;
 
-//    imu->euler.pitch = (float)Imu_NormalizeAngle(imu->raw_euler.pitch - imu->zero_euler.pitch);
-//    imu->euler.roll = (float)Imu_NormalizeAngle(imu->raw_euler.roll - imu->zero_euler.roll);
-//    imu->euler.yaw = (float)Imu_NormalizeAngle(imu->raw_euler.yaw - imu->zero_euler.yaw);
-    imu->euler.pitch = imu->raw_euler.pitch - imu->zero_euler.pitch;
-    imu->euler.roll = imu->raw_euler.roll - imu->zero_euler.roll;
-    imu->euler.yaw = imu->raw_euler.yaw - imu->zero_euler.yaw;
+    ctx->euler_degree.roll = RAD2DEGREE(ctx->euler.roll);
+    ctx->euler_degree.pitch = RAD2DEGREE(ctx->euler.pitch);
+    ctx->euler_degree.yaw = RAD2DEGREE(ctx->euler.yaw);
+}
+
+static void Imu_UpdateDcm(Imu *imu)
+{
+    imu_real_t q0 = imu->quaternion.q0;
+    imu_real_t q1 = imu->quaternion.q1;
+    imu_real_t q2 = imu->quaternion.q2;
+    imu_real_t q3 = imu->quaternion.q3;
+    imu_real_t q0q1 = q0 * q1;
+    imu_real_t q0q2 = q0 * q2;
+    imu_real_t q0q3 = q0 * q3;
+    imu_real_t q1q1 = q1 * q1;
+    imu_real_t q1q2 = q1 * q2;
+    imu_real_t q1q3 = q1 * q3;
+    imu_real_t q2q2 = q2 * q2;
+    imu_real_t q2q3 = q2 * q3;
+    imu_real_t q3q3 = q3 * q3;
+    imu_real_t (*m)[3] = imu->dcm.m;
 
-    imu->euler_degree.roll = (float)(imu->euler.roll * 180 / MATH_PI);
-    imu->euler_degree.pitch = (float)(imu->euler.pitch * 180 / MATH_PI);
-    imu->euler_degree.yaw = (float)(imu->euler.yaw * 180 / MATH_PI);
+    m[0][0] = IMU_REAL(1.0) - IMU_REAL(2.0) * (q2q2 + q3q3);
+    m[0][1] = IMU_REAL(2.0) * (q1q2 - q0q3);
+    m[0][2] = IMU_REAL(2.0) * (q1q3 + q0q2);
+    m[1][0] = IMU_REAL(2.0) * (q1q2 + q0q3);
+    m[1][1] = IMU_REAL(1.0) - IMU_REAL(2.0) * (q1q1 + q3q3);
+    m[1][2] = IMU_REAL(2.0) * (q2q3 - q0q1);
+    m[2][0] = IMU_REAL(2.0) * (q1q3 - q0q2);
+    m[2][1] = IMU_REAL(2.0) * (q2q3 + q0q1);
+    m[2][2] = IMU_REAL(1.0) - IMU_REAL(2.0) * (q1q1 + q2q2);
 }
 
 static void Imu_ConvertQuatToEuler(Imu *imu)
 {
-    imu->raw_euler.roll = atan2(2 * (imu->quaternion.q0 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q3), \
-            1 - 2 * (imu->quaternion.q1 * imu->quaternion.q1 + imu->quaternion.q2 * imu->quaternion.q2));
-    imu->raw_euler.pitch = asin(2 * (imu->quaternion.q0 * imu->quaternion.q2 - imu->quaternion.q3 * imu->quaternion.q1));
-    imu->raw_euler.yaw = atan2(2 * (imu->quaternion.q0 * imu->quaternion.q3 + imu->quaternion.q1 * imu->quaternion.q2), \
-            1 - 2 * (imu->quaternion.q2 * imu->quaternion.q2 + imu->quaternion.q3 * imu->quaternion.q3));
+    imu_real_t (*m)[3] = imu->dcm.m;
+    imu_real_t s = -m[2][0];
+    s = (s > IMU_REAL(1.0)) ? IMU_REAL(1.0) : (s < -IMU_REAL(1.0)) ? -IMU_REAL(1.0) : s;  // 归一化误差可能略超出 asin 定义域
+    imu->raw_euler.roll = IMU_ATAN2(m[2][1], m[2][2]);
+    imu->raw_euler.pitch = IMU_ASIN(s);
+    imu->raw_euler.yaw = IMU_ATAN2(m[1][0], m[0][0]);
+}
+
+// 融合前的加速度与磁场转到地理系, 得到线性加速度与倾角补偿航向
+static void Imu_UpdateEarthFrame(Imu *imu, const ImuSource *measured)
+{
+    imu_real_t (*m)[3] = imu->dcm.m;
+    imu_real_t ax = measured->accel.x;
+    imu_real_t ay = measured->accel.y;
+    imu_real_t az = measured->accel.z;
+
+    imu->linear_accel.x = m[0][0] * ax + m[0][1] * ay + m[0][2] * az;
+    imu->linear_accel.y = m[1][0] * ax + m[1][1] * ay + m[1][2] * az;
+    imu->linear_accel.z = m[2][0] * ax + m[2][1] * ay + m[2][2] * az - GRAVITY;
+
+    if (IMU_HAS_MAGIC(measured->use_magic))
+    {
+        imu_real_t mx = measured->magic.x;
+        imu_real_t my = measured->magic.y;
+        imu_real_t mz = measured->magic.z;
+        // 地理系下磁场水平分量偏离 x 轴的角度即为融合偏航相对磁北的误差
+        imu_real_t hx = m[0][0] * mx + m[0][1] * my + m[0][2] * mz;
+        imu_real_t hy = m[1][0] * mx + m[1][1] * my + m[1][2] * mz;
+        imu->heading = Imu_NormalizeAngle(imu->raw_euler.yaw - IMU_ATAN2(hy, hx));
+    }
+    else
+    {
+        imu->heading = imu->raw_euler.yaw;
+    }
+}
+
+/**
+ * 由当前一帧加速度计 (与磁力计) 直接解出姿态, 上电后不必等滤波从单位四元数收敛.
+ * 要求载体近似静止, 没有磁力计时航向取 0. 加速度为零时不修改姿态, 返回 false.
+ */
+bool Imu_Align(Imu *imu)
+{
+    const ImuSource *s = &imu->source;
+    imu_real_t ax = s->accel.x;
+    imu_real_t ay = s->accel.y;
+    imu_real_t az = s->accel.z;
+    if (ax * ax + ay * ay + az * az <= IMU_REAL(0.0))
+    {
+        return false;
+    }
+
+    imu_real_t roll = IMU_ATAN2(ay, az);
+    imu_real_t pitch = IMU_ATAN2(-ax, IMU_SQRT(ay * ay + az * az));
+    imu_real_t yaw = IMU_REAL(0.0);
+    if (IMU_HAS_MAGIC(s->use_magic))
+    {
+        // 只按横滚/俯仰把磁场转到水平面, 航向取使水平分量指向 x 轴的角度, 与融合算法的参考方向一致
+        imu_real_t sin_r = IMU_SIN(roll), cos_r = IMU_COS(roll);
+        imu_real_t sin_p = IMU_SIN(pitch), cos_p = IMU_COS(pitch);
+        imu_real_t hx = cos_p * s->magic.x + sin_p * sin_r * s->magic.y + sin_p * cos_r * s->magic.z;
+        imu_real_t hy = cos_r * s->magic.y - sin_r * s->magic.z;
+        yaw = IMU_ATAN2(-hy, hx);
+    }
+
+    imu_real_t sr = IMU_SIN(roll * IMU_REAL(0.5)), cr = IMU_COS(roll * IMU_REAL(0.5));
+    imu_real_t sp = IMU_SIN(pitch * IMU_REAL(0.5)), cp = IMU_COS(pitch * IMU_REAL(0.5));
+    imu_real_t sy = IMU_SIN(yaw * IMU_REAL(0.5)), cy = IMU_COS(yaw * IMU_REAL(0.5));
+    imu->quaternion.q0 = cr * cp * cy + sr * sp * sy;
+    imu->quaternion.q1 = sr * cp * cy - cr * sp * sy;
+    imu->quaternion.q2 = cr * sp * cy + sr * cp * sy;
+    imu->quaternion.q3 = cr * cp * sy - sr * sp * cy;
+    Imu_UpdateDcm(imu);
+    Imu_ConvertQuatToEuler(imu);
+    return true;
 }
 
 void Imu_SetZero(Imu *imu)
 {
-    imu->zero_euler.roll = imu->raw_euler.roll;
-    imu->zero_euler.pitch = imu->raw_euler.pitch;
-    imu->zero_euler.yaw = imu->raw_euler.yaw;
+    imu->ctx->zero_euler.roll = imu->raw_euler.roll;
+    imu->ctx->zero_euler.pitch = imu->raw_euler.pitch;
+    imu->ctx->zero_euler.yaw = imu->raw_euler.yaw;
 }
 
-void Imu_Update(Imu *imu)
+/**
+ * 清零实例并关联冷数据, 四元数为单位四元数, 加速度计比例为 1.
+ * 静态定义的 Imu 与 ImuContext 用它初始化, 需要多个实例时用 Imu_Create.
+ */
+void Imu_Init(Imu *imu, ImuContext *ctx)
 {
-    // read source
-    imu->source.accel.x = imu->bias.accel_s.x * (imu->source.accel.x - imu->bias.accel_offset.x);
-    imu->source.accel.y = imu->bias.accel_s.y * (imu->source.accel.y - imu->bias.accel_offset.y);
-    imu->source.accel.z = imu->bias.accel_s.z * (imu->source.accel.z - imu->bias.accel_offset.z);
-    imu->source.gyro.x  -= imu->bias.gyro.x;
-    imu->source.gyro.y  -= imu->bias.gyro.y;
-    imu->source.gyro.z  -= imu->bias.gyro.z;
-    imu->source.magic.x -= imu->bias.magic.x;
-    imu->source.magic.y -= imu->bias.magic.y;
-    imu->source.magic.z -= imu->bias.magic.z;
-#if 1
-    if (ImuMadgwick == imu->method)
+    memset((void *)imu, 0, sizeof(Imu));
+    memset((void *)ctx, 0, sizeof(ImuContext));
+    imu->ctx = ctx;
+    imu->quaternion.q0 = IMU_REAL(1.0);
+    imu->bias.accel_s.x = IMU_REAL(1.0);
+    imu->bias.accel_s.y = IMU_REAL(1.0);
+    imu->bias.accel_s.z = IMU_REAL(1.0);
+}
+
+void ImuArena_Init(ImuArena *arena, void *buffer, size_t size)
+{
+    uintptr_t addr = (uintptr_t)buffer;
+    uintptr_t first = (addr + IMU_ARENA_ALIGN - 1u) & ~(uintptr_t)(IMU_ARENA_ALIGN - 1u);
+
+    arena->base = (uint8_t *)buffer;
+    arena->size = size;
+    arena->head = (first - addr < size) ? (size_t)(first - addr) : size;
+    arena->tail = size;
+}
+
+// count 个 Imu 连续排列, 内存不足时不分配任何实例, 返回 NULL
+Imu *Imu_CreateArray(ImuArena *arena, int32_t count)
+{
+    size_t hot = (size_t)count * sizeof(Imu);
+    size_t cold = IMU_ARENA_ROUND((size_t)count * sizeof(ImuContext));
+    uintptr_t lo = (uintptr_t)arena->base + arena->head + hot;
+    uintptr_t hi = (uintptr_t)arena->base + arena->tail;
+    if (count <= 0 || lo > hi || hi - lo < cold)
     {
-        ImuMadgwick_AlgorithmUpdate(imu);
-            }
-    else if (ImuMahony == imu->method)
+        return NULL;
+    }
+
+    uintptr_t cold_addr = (hi - cold) & ~(uintptr_t)(IMU_ARENA_ALIGN - 1u);
+    if (cold_addr < lo)
     {
-        ImuMahony_AlgorithmUpdate(imu);
-            }
-    else if (ImuComplementaryFilter == imu->method)
+        return NULL;
+    }
+
+    Imu *imu = (Imu *)(void *)(arena->base + arena->head);
+    ImuContext *ctx = (ImuContext *)cold_addr;
+    for (int32_t i = 0; i < count; i++)
+    {
+        Imu_Init(&imu[i], &ctx[i]);
+    }
+    arena->head += hot;
+    arena->tail = (size_t)(cold_addr - (uintptr_t)arena->base);
+    return imu;
+}
+
+Imu *Imu_Create(ImuArena *arena)
+{
+    return Imu_CreateArray(arena, 1);
+}
+
+// 判断本周期加速度计与磁力计是否可信, 只比较模长平方, 夹角余弦用一次 InvSqrt
+static void Imu_Gate(Imu *imu, const ImuSource *s)
+{
+    imu_real_t a2 = s->accel.x * s->accel.x + s->accel.y * s->accel.y + s->accel.z * s->accel.z;
+
+    imu->accel_valid = a2 > IMU_REAL(0.0);
+    if (imu->accel_valid && imu->accel_gate > IMU_REAL(0.0))
     {
-        ImuComplementaryFilter_AlgorithmUpdate(imu);
+        // 剧烈运动时比力不再指向重力, 修正会把姿态拉偏;
+        // 连续超限 1s 后纯积分误差已不可忽略, 暂停门限直到模长回到范围内
+        imu_real_t lo = (IMU_REAL(1.0) - imu->accel_gate) * GRAVITY;
+        imu_real_t hi = (IMU_REAL(1.0) + imu->accel_gate) * GRAVITY;
+        if (a2 >= lo * lo && a2 <= hi * hi)
+        {
+            imu->accel_reject_run = 0;
+        }
+        else if (imu->accel_reject_run < imu->samp_freq)
+        {
+            imu->accel_valid = false;
+            imu->accel_reject_run++;
+            IMU_PATH_COUNT(imu, accel_reject);
+        }
+        else
+        {
+            // do nothing
+        }
     }
     else
     {
         // do nothing
     }
+
+    // 9 轴修正依赖重力方向, 加速度计不可用时磁力计也不使用
+    imu->magic_valid = IMU_HAS_MAGIC(s->use_magic) && imu->accel_valid;
+    if (imu->magic_valid && (imu->magic_gate > IMU_REAL(0.0) || imu->dip_gate > IMU_REAL(0.0)))
+    {
+        imu_real_t m2 = s->magic.x * s->magic.x + s->magic.y * s->magic.y + s->magic.z * s->magic.z;
+        imu_real_t dip = IMU_REAL(0.0);
+        bool ok = m2 > IMU_REAL(0.0);
+        if (ok)
+        {
+            dip = (s->accel.x * s->magic.x + s->accel.y * s->magic.y + s->accel.z * s->magic.z) * IMU_INVSQRT(a2 * m2);
+            if (imu->magic_norm2_ref <= IMU_REAL(0.0) || imu->magic_reject_run > imu->samp_freq * 10)
+            {
+                imu->magic_norm2_ref = m2;
+                imu->magic_dip_ref = dip;
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+        else
+        {
+            // do nothing
+        }
+        if (ok && imu->magic_gate > IMU_REAL(0.0))
+        {
+            imu_real_t lo = IMU_REAL(1.0) - imu->magic_gate;
+            imu_real_t hi = IMU_REAL(1.0) + imu->magic_gate;
+            ok = m2 >= lo * lo * imu->magic_norm2_ref && m2 <= hi * hi * imu->magic_norm2_ref;
+        }
+        if (ok && imu->dip_gate > IMU_REAL(0.0))
+        {
+            ok = IMU_FABS(dip - imu->magic_dip_ref) <= imu->dip_gate;
+        }
+        if (ok)
+        {
+            imu->magic_reject_run = 0;
+        }
+        else
+        {
+            imu->magic_valid = false;
+            imu->magic_reject_run++;
+            IMU_PATH_COUNT(imu, magic_reject);
+        }
+    }
+    else
+    {
+        // do nothing
+    }
+
+    if (imu->magic_valid)
+    {
+        IMU_PATH_COUNT(imu, full);
+    }
+    else if (imu->accel_valid)
+    {
+        IMU_PATH_COUNT(imu, accel_only);
+    }
+    else
+    {
+        IMU_PATH_COUNT(imu, gyro_only);
+    }
+}
+
+void Imu_Update(Imu *imu)
+{
+    if (ImuStateIdle == imu->state)
+    {
+        return;                 // 静止期间姿态不变, 跳过融合
+    }
+
+    // 修正后的样本只存在于本次调用, source 保持原始读数, 重放或批处理同一样本得到相同结果
+    ImuSource measured;
+    Imu_CorrectSource(imu, &measured);
+    Imu_Gate(imu, &measured);
+    // 未编译的方法不做融合, 姿态保持不变
+#ifdef IMU_USING_MADGWICK
+    if (ImuMadgwick == imu->method)
+    {
+        ImuMadgwick_AlgorithmUpdate(imu, &measured);
+    }
 #endif
+#ifdef IMU_USING_MAHONY
+    if (ImuMahony == imu->method)
+    {
+        ImuMahony_AlgorithmUpdate(imu, &measured);
+    }
+#endif
+#ifdef IMU_USING_COMPLEMENTARY
+    if (ImuComplementaryFilter == imu->method)
+    {
+        ImuComplementaryFilter_AlgorithmUpdate(imu, &measured);
+    }
+#endif
+    Imu_UpdateDcm(imu);
     Imu_ConvertQuatToEuler(imu);
-    Imu_ConvertEuler(imu);
+    Imu_UpdateEarthFrame(imu, &measured);
+#ifdef IMU_USING_HISTORY
+    if (imu->history)
+    {
+        imu_real_t gyro[3] = {measured.gyro.x, measured.gyro.y, measured.gyro.z};
+        ImuHistory_Push(imu->history, measured.timestamp_us, &imu->quaternion, gyro);
+    }
+#endif
+}
+
+/**
+ * 由活动/静止中断驱动, 静止时不再融合并通知应用降低采样率,
+ * 检测到活动后恢复原状态, 四元数保持进入静止前的值.
+ */
+void Imu_SetActivity(Imu *imu, bool active)
+{
+    ImuContext *ctx = imu->ctx;
+    if (!active && ImuStateIdle != imu->state)
+    {
+        ctx->resume_state = imu->state;
+        imu->state = ImuStateIdle;
+        if (ctx->set_idle)
+        {
+            ctx->set_idle(imu, true);
+        }
+    }
+    else if (active && ImuStateIdle == imu->state)
+    {
+        imu->state = ctx->resume_state;
+        if (ctx->set_idle)
+        {
+            ctx->set_idle(imu, false);
+        }
+    }
+}
+
+// 应用按此频率调度 read_source 与 Imu_Update
+int32_t Imu_GetSampleFreq(Imu *imu)
+{
+    return (ImuStateIdle == imu->state && imu->ctx->idle_samp_freq > 0) ? imu->ctx->idle_samp_freq : imu->samp_freq;
 }
 
 void Imu_CalibrateGyro(Imu *imu)
 {
-    if (imu->calibrate_count < IMU_CALIBRATE_TIMES)
+    if (imu->ctx->calibrate_count < IMU_CALIBRATE_TIMES)
     {
         imu->bias.gyro.x  += imu->source.gyro.x;
         imu->bias.gyro.y  += imu->source.gyro.y;
         imu->bias.gyro.z  += imu->source.gyro.z;
     }
-    else if (imu->calibrate_count == IMU_CALIBRATE_TIMES)
+    else if (imu->ctx->calibrate_count == IMU_CALIBRATE_TIMES)
     {
         imu->bias.gyro.x  /= IMU_CALIBRATE_TIMES;
         imu->bias.gyro.y  /= IMU_CALIBRATE_TIMES;
@@ -101,91 +405,114 @@ void Imu_CalibrateMagic(Imu *imu)
     // TODO
 }
 
-// IMU 误差模型 Ameas = S * (Atrue + OFFSET)
-void Imu_CalibrateAccelBias(ImuAxes *src, int32_t samples, ImuAxes *bias)
+#ifdef IMU_USING_ACCEL_CALIB
+// IMU 误差模型 Ameas = S * (Atrue + OFFSET), 只需要各轴的和与平方和, 不保存样本
+static void Imu_CalibrateAccelBias(const ImuAxes *sum, int32_t samples, ImuAxes *bias)
 {
-    ImuAxes sum = {0.0, 0.0, 0.0};
-    for (int32_t i = 0; i < samples; i++)
-    {
-        sum.x += src[i].x;
-        sum.y += src[i].y;
-        sum.z += src[i].z;
-    }
+    bias->x = sum->x / samples;
+    bias->y = sum->y / samples;
+    bias->z = sum->z / samples - GRAVITY;
+}
 
-    bias->x = sum.x / samples;
-    bias->y = sum.y / samples;
-    bias->z = sum.z / samples - GRAVITY;
+static void Imu_CalibrateAccelScale(const ImuAxes *sum2, int32_t samples, ImuAxes *scale)
+{
+    imu_real_t norm = IMU_SQRT(sum2->x + sum2->y + sum2->z);
+    scale->x = GRAVITY * GRAVITY / (IMU_SQRT(sum2->x / samples) * norm);
+    scale->y = GRAVITY * GRAVITY / (IMU_SQRT(sum2->y / samples) * norm);
+    scale->z = GRAVITY * GRAVITY / (IMU_SQRT(sum2->z / samples) * norm);
 }
 
-void Imu_CalibrateAccelScale(ImuAxes *src, int32_t samples, ImuAxes *scale)
+/**
+ * 校准样本是在芯片已加载 accel_hw_offset 的情况下采集的, 测得的只是相对现有硬件偏置的部分,
+ * 总偏置 = accel_hw_offset + 测量值. 整数部分交给硬件, 软件只扣除残差.
+ */
+static void Imu_ApplyAccelHwOffset(Imu *imu)
 {
-    ImuAxes sum = {0.0, 0.0, 0.0};
-    for (int32_t i = 0; i < samples; i++)
+    ImuAxes total, applied;
+    total.x = imu->ctx->accel_hw_offset.x + imu->bias.accel_offset.x;
+    total.y = imu->ctx->accel_hw_offset.y + imu->bias.accel_offset.y;
+    total.z = imu->ctx->accel_hw_offset.z + imu->bias.accel_offset.z;
+    if (imu->ctx->write_accel_offset(imu, &total, &applied))
     {
-        sum.x += src[i].x * src[i].x;
-        sum.y += src[i].y * src[i].y;
-        sum.z += src[i].z * src[i].z;
+        imu->ctx->accel_hw_offset = applied;
+        imu->bias.accel_offset.x = total.x - applied.x;
+        imu->bias.accel_offset.y = total.y - applied.y;
+        imu->bias.accel_offset.z = total.z - applied.z;
     }
-
-    float norm = sqrt(sum.x + sum.y + sum.z);
-    scale->x = GRAVITY * GRAVITY / (sqrt(sum.x / samples) * norm);
-    scale->y = GRAVITY * GRAVITY / (sqrt(sum.y / samples) * norm);
-    scale->z = GRAVITY * GRAVITY / (sqrt(sum.z / samples) * norm);
 }
 
 void Imu_CalibrateAccel(Imu *imu)
 {
-    if (imu->calibrate_count == 0)
+    ImuAxes *sum = &imu->ctx->acc_sum;
+    ImuAxes *sum2 = &imu->ctx->acc_sum2;
+    if (imu->ctx->calibrate_count == 0)
     {
-        // do nothing
+        sum->x = sum->y = sum->z = IMU_REAL(0.0);
+        sum2->x = sum2->y = sum2->z = IMU_REAL(0.0);
     }
 
-    if (imu->calibrate_count < IMU_CALIBRATE_TIMES) // in case of overflow
+    if (imu->ctx->calibrate_count < IMU_CALIBRATE_TIMES) // in case of overflow
     {
-        imu->bias.acc_src[imu->calibrate_count].x = imu->source.accel.x;
-        imu->bias.acc_src[imu->calibrate_count].y = imu->source.accel.y;
-        imu->bias.acc_src[imu->calibrate_count].z = imu->source.accel.z;
+        sum->x += imu->source.accel.x;
+        sum->y += imu->source.accel.y;
+        sum->z += imu->source.accel.z;
+        sum2->x += imu->source.accel.x * imu->source.accel.x;
+        sum2->y += imu->source.accel.y * imu->source.accel.y;
+        sum2->z += imu->source.accel.z * imu->source.accel.z;
     }
-    else if (imu->calibrate_count == IMU_CALIBRATE_TIMES)
+    else if (imu->ctx->calibrate_count == IMU_CALIBRATE_TIMES)
     {
-        Imu_CalibrateAccelBias(imu->bias.acc_src, IMU_CALIBRATE_TIMES, &imu->bias.accel_offset);
-        Imu_CalibrateAccelScale(imu->bias.acc_src, IMU_CALIBRATE_TIMES, &imu->bias.accel_s);
+        Imu_CalibrateAccelBias(sum, IMU_CALIBRATE_TIMES, &imu->bias.accel_offset);
+        Imu_CalibrateAccelScale(sum2, IMU_CALIBRATE_TIMES, &imu->bias.accel_s);
+        if (imu->ctx->write_accel_offset)
+        {
+            Imu_ApplyAccelHwOffset(imu);
+        }
     }
 }
+#endif
 
 void Imu_InitCalibrate(Imu *imu)
 {
 //    memset((void *)&imu->bias, 0, sizeof(ImuCalib));
-    imu->calibrate_count = 0;
+    imu->ctx->calibrate_count = 0;
     imu->state = ImuStateCalib;
-    imu->bias.gyro.x = 0.0;
-    imu->bias.gyro.y = 0.0;
-    imu->bias.gyro.z = 0.0;
-    imu->bias.magic.x = 0.0;
-    imu->bias.magic.y = 0.0;
-    imu->bias.magic.z = 0.0;
-    imu->bias.accel_offset.x = 0.0;
-    imu->bias.accel_offset.y = 0.0;
-    imu->bias.accel_offset.z = 0.0;
-    imu->bias.accel_s.x = 1.0;
-    imu->bias.accel_s.y = 1.0;
-    imu->bias.accel_s.z = 1.0;
+    imu->bias.gyro.x = IMU_REAL(0.0);
+    imu->bias.gyro.y = IMU_REAL(0.0);
+    imu->bias.gyro.z = IMU_REAL(0.0);
+    imu->bias.magic.x = IMU_REAL(0.0);
+    imu->bias.magic.y = IMU_REAL(0.0);
+    imu->bias.magic.z = IMU_REAL(0.0);
+    imu->bias.accel_offset.x = IMU_REAL(0.0);
+    imu->bias.accel_offset.y = IMU_REAL(0.0);
+    imu->bias.accel_offset.z = IMU_REAL(0.0);
+    imu->bias.accel_s.x = IMU_REAL(1.0);
+    imu->bias.accel_s.y = IMU_REAL(1.0);
+    imu->bias.accel_s.z = IMU_REAL(1.0);
+    imu->integral_fb.x = IMU_REAL(0.0);     // 积分项是相对旧零偏的残差, 重新校准后清零
+    imu->integral_fb.y = IMU_REAL(0.0);
+    imu->integral_fb.z = IMU_REAL(0.0);
 }
 
 void Imu_Calibrate(Imu *imu)
 {
-// TODO   Imu_CalibrateAccel(imu);
+#ifdef IMU_USING_ACCEL_CALIB
+    if (imu->ctx->accel_calib)
+    {
+        Imu_CalibrateAccel(imu);
+    }
+#endif
     Imu_CalibrateGyro(imu);
-    if (imu->source.use_magic == true)
+    if (IMU_HAS_MAGIC(imu->source.use_magic))
     {
         Imu_CalibrateMagic(imu);
     }
     
-    imu->calibrate_count++;
+    imu->ctx->calibrate_count++;
     
-    if (imu->calibrate_count > IMU_CALIBRATE_TIMES) // wait one tick for caculate results
+    if (imu->ctx->calibrate_count > IMU_CALIBRATE_TIMES) // wait one tick for caculate results
     {
-        imu->calibrate_count = 0;
+        imu->ctx->calibrate_count = 0;
         imu->state = ImuStateStart;
 #if 0
         LOG_D("Calibrate results: \n accel_bias: %f, %f, %f\n accel_scale: %f, %f, %f\n, gyro: %f, %f, %f", \
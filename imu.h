@@ -9,14 +9,16 @@
 #define __IMU_H__
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <math.h>
 #include "rtdevice.h"
 #include "app_common.h"
+#include "imu_types.h"
+#include "imu_config.h"
 
-#define GRAVITY                 (9.81)
-#define DEGREE2RAD(x)           ((x) * MATH_PI / 180.0)
-#define RAD2DEGREE(x)           ((x) * 180.0 / MATH_PI)
-#define IMU_CALIBRATE_TIMES     500
+#define GRAVITY                 IMU_GRAVITY
+#define DEGREE2RAD(x)           ((x) * (IMU_PI / IMU_REAL(180.0)))
+#define RAD2DEGREE(x)           ((x) * (IMU_REAL(180.0) / IMU_PI))
 
 typedef enum {
     ImuMadgwick = 1,
@@ -28,73 +30,173 @@ typedef enum {
     ImuStateStart      = 1,
     ImuStateRuning     = 2,
     ImuStateStartCalib = 3,
-    ImuStateCalib      = 4
+    ImuStateCalib      = 4,
+    ImuStateIdle       = 5,     // 静止休眠, 不做融合
 }ImuState;
 
 typedef struct ImuAxes_ {
-    volatile float x;
-    volatile float y;
-    volatile float z;
+    volatile imu_real_t x;
+    volatile imu_real_t y;
+    volatile imu_real_t z;
 }ImuAxes;
 
 typedef struct ImuSource_ {
     ImuAxes accel;         // m/s2
     ImuAxes gyro;          // rad/s
     ImuAxes magic;         // Gauss
-    float accel_temperature;
-    float gyro_temperature;
-    float magic_temperature;
+    imu_real_t accel_temperature;
+    imu_real_t gyro_temperature;
+    imu_real_t magic_temperature;
     bool use_magic;
+    uint32_t timestamp_us;      // 采样时刻, 用于姿态历史查询
 }ImuSource;
 
 typedef struct ImuEuler_ {
-    float roll;
-    float pitch;
-    float yaw;
+    imu_real_t roll;
+    imu_real_t pitch;
+    imu_real_t yaw;
 }ImuEuler;
 
 typedef struct ImuQuaternion_ {
-    volatile float q0;
-    volatile float q1;
-    volatile float q2;
-    volatile float q3;
+    volatile imu_real_t q0;
+    volatile imu_real_t q1;
+    volatile imu_real_t q2;
+    volatile imu_real_t q3;
 }ImuQuaternion;
 
-// Ameas = S * (Atrue + OFFSET), 静止条件下最小二乘法校准参数
+// 机体系到地理系的旋转矩阵, v_earth = m * v_body, 第 2 行为重力方向在机体系的投影
+typedef struct ImuDcm_ {
+    imu_real_t m[3][3];
+}ImuDcm;
+
+// Ameas = S * (Atrue + OFFSET), 静止条件下最小二乘法校准参数, 每周期用于修正源数据
 typedef struct ImuCalib_ {
-    ImuAxes acc_src[IMU_CALIBRATE_TIMES];
     ImuAxes accel_s;
-    ImuAxes accel_offset;
+    ImuAxes accel_offset;  // 软件扣除的偏置, 启用硬件偏置时只剩残差
     ImuAxes gyro;          // rad/s
     ImuAxes magic;         // Gauss
 }ImuCalib;
 
+// 各融合路径的执行次数, 用于评估门限设置
+typedef struct ImuPathStats_ {
+    uint32_t full;              // 加速度计 + 磁力计修正
+    uint32_t accel_only;        // 只有加速度计修正
+    uint32_t gyro_only;         // 纯陀螺积分
+    uint32_t accel_reject;      // 加速度计被门限拒绝
+    uint32_t magic_reject;      // 磁力计被门限拒绝
+}ImuPathStats;
+
+typedef struct ImuHistory_ ImuHistory;
 typedef struct Imu_ Imu;
-struct Imu_ {
-    volatile ImuState state;
-    ImuMethod method;           // 滤波方法
-    ImuSource source;           // 源数据
-    ImuCalib bias;              //初始值校准
-    ImuQuaternion quaternion;   // 四元数
-    ImuEuler raw_euler;         // 欧拉角 rad
-    ImuEuler raw_euler_degree;  // 欧拉角 degree
+
+/**
+ * 冷数据: 只在校准, 设置零点, 进出静止或应用读取时访问, Imu_Update 不读写.
+ * 与 Imu 分开存放, 多个 Imu 可以紧密排列, 见 ImuArena.
+ */
+typedef struct ImuContext_ {
     ImuEuler zero_euler;        // 用户定义的零点位置, rad
+    ImuEuler raw_euler_degree;  // 以下三组由 Imu_UpdateEuler 按需计算, 欧拉角 degree
     ImuEuler euler;             // 相对零点位置的角度, rad
     ImuEuler euler_degree;      // 相对零点位置的角度, degree
-    int32_t samp_freq;          // 采样频率
-    float kp_gain;              // 比例增益 Kp
-    float ki_gain;              // Ki for mahony, beta for madgwick
-    float comple_filter_alpha;  // 互补滤波算法系数， 即陀螺仪权重
-    void (*read_source)(Imu *imu);
     volatile int32_t calibrate_count;
-};
+    bool accel_calib;           // 校准加速度计, 要求水平静止且 z 轴朝上
+#ifdef IMU_USING_ACCEL_CALIB
+    ImuAxes acc_sum;            // 校准期间的累加和与平方和
+    ImuAxes acc_sum2;
+#endif
+    ImuAxes accel_hw_offset;    // 已写入传感器偏置寄存器的部分, 重新校准时不清零
+    int32_t idle_samp_freq;     // 静止时的采样频率, 0 表示不降频
+    ImuState resume_state;      // 退出静止后恢复的状态
+    void (*read_source)(Imu *imu);
+    void (*set_idle)(Imu *imu, bool idle);  // 进入/退出静止时回调, 用于切换传感器功耗模式
+    // 可选, 把加速度计总偏置写入传感器硬件, applied 返回硬件实际抵消的部分
+    bool (*write_accel_offset)(Imu *imu, const ImuAxes *bias, ImuAxes *applied);
+}ImuContext;
+
+/**
+ * 热数据: Imu_Update 每周期读写的全部状态, 按访问顺序排列并按缓存行对齐,
+ * 同时处理多个实例时各实例互不共享缓存行.
+ */
+struct Imu_ {
+    ImuQuaternion quaternion;   // 四元数
+    imu_real_t kp_gain;         // 比例增益 Kp
+    imu_real_t ki_gain;         // Ki for mahony, beta for madgwick
+    imu_real_t comple_filter_alpha;  // 互补滤波算法系数， 即陀螺仪权重
+    int32_t samp_freq;          // 采样频率
+    ImuMethod method;           // 滤波方法
+    volatile ImuState state;
+    bool accel_valid;           // 本周期是否做加速度计修正, 由 Imu_Update 设置
+    bool magic_valid;           // 本周期是否做磁力计修正, 由 Imu_Update 设置
+    ImuSource source;           // 源数据, Imu_Update 只读, 修正后的样本不写回
+    ImuCalib bias;              //初始值校准
+    ImuAxes integral_fb;        // Mahony 积分反馈, 即估计的陀螺残余零偏 rad/s
+    // 量测一致性门限, 0 表示不启用; 超出门限时跳过对应修正, 只做陀螺积分
+    imu_real_t accel_gate;      // |a| 相对 GRAVITY 的允许偏差比例, 如 0.1
+    imu_real_t magic_gate;      // |m| 相对参考模长的允许偏差比例
+    imu_real_t dip_gate;        // a 与 m 夹角余弦相对参考值的允许偏差
+    imu_real_t magic_norm2_ref; // 参考模长平方, 0 时取第一个通过的样本
+    imu_real_t magic_dip_ref;   // 参考夹角余弦
+    int32_t accel_reject_run;   // 加速度计连续超限次数, 超过 1s 暂停门限
+    int32_t magic_reject_run;   // 连续拒绝次数, 超过 10s 认为环境已改变, 重新取参考
+#ifdef IMU_USING_PROFILING
+    ImuPathStats path;          // 各路径执行次数, 每周期写入, 与门限计数放在一起
+#endif
+    ImuDcm dcm;                 // 由四元数计算, 每次 Imu_Update 更新一次
+    ImuEuler raw_euler;         // 欧拉角 rad
+    ImuAxes linear_accel;       // 地理系线性加速度, 已扣除重力, m/s2
+    imu_real_t heading;         // 倾角补偿后的磁航向 rad, 无磁力计时等于 yaw
+    ImuHistory *history;        // 可选, 姿态历史缓存, 见 imu_history.h
+    ImuContext *ctx;            // 冷数据, 不能为空
+} IMU_ALIGNED(IMU_CACHE_LINE);
+
+/**
+ * 由调用者提供的内存中创建实例: Imu 从低地址向上连续排列, ImuContext 从高地址向下排列,
+ * 连续创建的 Imu 可以按数组访问. 不需要释放, 整块内存不再使用即可.
+ */
+typedef struct ImuArena_ {
+    uint8_t *base;
+    size_t size;
+    size_t head;                // 下一个 Imu 的偏移
+    size_t tail;                // 已分配 ImuContext 的最低偏移
+}ImuArena;
+
+// Imu 起始地址与 ImuContext 块都按 IMU_ARENA_ALIGN 对齐 (至少 8 字节), ImuContext 不与 Imu 共享缓存行
+#define IMU_ARENA_ALIGN         ((IMU_CACHE_LINE > 8u) ? (size_t)IMU_CACHE_LINE : (size_t)8u)
+#define IMU_ARENA_ROUND(x)      (((size_t)(x) + IMU_ARENA_ALIGN - 1u) & ~(IMU_ARENA_ALIGN - 1u))
+// n 个实例所需的内存: 每块大小向上取整到对齐单位, 另加 Imu 起始与 ImuContext 块各一个单位的对齐余量
+#define IMU_ARENA_SIZE(n)       ((size_t)(n) * (IMU_ARENA_ROUND(sizeof(Imu)) + IMU_ARENA_ROUND(sizeof(ImuContext))) + \
+                                 2u * IMU_ARENA_ALIGN)
+
+void ImuArena_Init(ImuArena *arena, void *buffer, size_t size);
+Imu *Imu_Create(ImuArena *arena);
+Imu *Imu_CreateArray(ImuArena *arena, int32_t count);
+void Imu_Init(Imu *imu, ImuContext *ctx);
+void Imu_UpdateEuler(Imu *imu);
+// 按当前校准参数修正 source, 结果写到 measured; Imu_Update 与遥测共用, source 本身不修改
+static inline void Imu_CorrectSource(const Imu *imu, ImuSource *measured)
+{
+    const ImuSource *raw = &imu->source;
+    *measured = *raw;
+    measured->accel.x = imu->bias.accel_s.x * (raw->accel.x - imu->bias.accel_offset.x);
+    measured->accel.y = imu->bias.accel_s.y * (raw->accel.y - imu->bias.accel_offset.y);
+    measured->accel.z = imu->bias.accel_s.z * (raw->accel.z - imu->bias.accel_offset.z);
+    measured->gyro.x  = raw->gyro.x - imu->bias.gyro.x;
+    measured->gyro.y  = raw->gyro.y - imu->bias.gyro.y;
+    measured->gyro.z  = raw->gyro.z - imu->bias.gyro.z;
+    measured->magic.x = raw->magic.x - imu->bias.magic.x;
+    measured->magic.y = raw->magic.y - imu->bias.magic.y;
+    measured->magic.z = raw->magic.z - imu->bias.magic.z;
+}
 
-void ImuMadgwick_AlgorithmUpdate(Imu *imu);
-void ImuMahony_AlgorithmUpdate(Imu *imu);
+void ImuMadgwick_AlgorithmUpdate(Imu *imu, const ImuSource *source);
+void ImuMahony_AlgorithmUpdate(Imu *imu, const ImuSource *source);
 void Imu_SetZero(Imu *imu);
+bool Imu_Align(Imu *imu);
 void Imu_Update(Imu *imu);
 void Imu_InitCalibrate(Imu *imu);
 void Imu_Calibrate(Imu *imu);
-void ImuComplementaryFilter_AlgorithmUpdate(Imu *imu);
+void ImuComplementaryFilter_AlgorithmUpdate(Imu *imu, const ImuSource *source);
+void Imu_SetActivity(Imu *imu, bool active);
+int32_t Imu_GetSampleFreq(Imu *imu);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,435 @@
+/**
+ * @file imu_array.c
+ * @author Wyatt Yu
+ * @brief 多传感器冗余阵列融合: 独立校准, 逆方差加权, 野值剔除与故障切换
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_array.h"
+
+typedef enum {
+    ImuArrayKind_Accel = 0,
+    ImuArrayKind_Gyro  = 1,
+    ImuArrayKind_Magic = 2,
+}ImuArrayKind;
+
+static ImuAxes *ImuArray_Axes(ImuSource *source, ImuArrayKind kind)
+{
+    return (ImuArrayKind_Accel == kind) ? &source->accel : (ImuArrayKind_Gyro == kind) ? &source->gyro : &source->magic;
+}
+
+static imu_real_t *ImuArray_Var(ImuArrayMember *m, ImuArrayKind kind)
+{
+    return (ImuArrayKind_Accel == kind) ? &m->accel_var : (ImuArrayKind_Gyro == kind) ? &m->gyro_var : &m->magic_var;
+}
+
+static imu_real_t ImuArray_Dist2(ImuAxes *a, ImuAxes *b)
+{
+    imu_real_t dx = a->x - b->x;
+    imu_real_t dy = a->y - b->y;
+    imu_real_t dz = a->z - b->z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static imu_real_t ImuArray_Median3(imu_real_t a, imu_real_t b, imu_real_t c)
+{
+    return (a > b) ? ((b > c) ? b : (a > c) ? c : a) : ((a > c) ? a : (b > c) ? c : b);
+}
+
+static imu_real_t ImuArray_Median(imu_real_t *v, int32_t n)
+{
+    // n <= IMU_ARRAY_MAX_MEMBERS, insertion sort is enough
+    for (int32_t i = 1; i < n; i++)
+    {
+        imu_real_t key = v[i];
+        int32_t j = i - 1;
+        while (j >= 0 && v[j] > key)
+        {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+    return (n & 1) ? v[n / 2] : IMU_REAL(0.5) * (v[n / 2 - 1] + v[n / 2]);
+}
+
+void ImuArray_Init(ImuArray *arr)
+{
+    memset((void *)arr, 0, sizeof(ImuArray));
+    arr->outlier_sigma = IMU_ARRAY_OUTLIER_SIGMA;
+    arr->fail_limit = IMU_ARRAY_FAIL_LIMIT;
+    arr->var_alpha = IMU_ARRAY_VAR_ALPHA;
+}
+
+int32_t ImuArray_Add(ImuArray *arr, ImuArray_ReadFunc read, void *ctx, bool use_magic)
+{
+    if (arr && read && arr->count < IMU_ARRAY_MAX_MEMBERS)
+    {
+        ImuArrayMember *m = &arr->member[arr->count];
+        memset((void *)m, 0, sizeof(ImuArrayMember));
+        m->read = read;
+        m->ctx = ctx;
+        m->use_magic = use_magic;
+        m->accel_var = IMU_REAL(1.0);
+        m->gyro_var = IMU_REAL(1.0);
+        m->magic_var = IMU_REAL(1.0);
+        m->healthy = true;
+        return arr->count++;
+    }
+    else
+    {
+        return -1;
+    }
+}
+
+void ImuArray_SetBusLock(ImuArray *arr, ImuArray_BusFunc lock, ImuArray_BusFunc unlock, void *bus)
+{
+    if (arr)
+    {
+        arr->lock = lock;
+        arr->unlock = unlock;
+        arr->bus = bus;
+    }
+}
+
+int32_t ImuArray_HealthyCount(ImuArray *arr)
+{
+    int32_t n = 0;
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        n += arr->member[i].healthy ? 1 : 0;
+    }
+    return n;
+}
+
+void ImuArray_InitCalibrate(ImuArray *arr)
+{
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        ImuArrayMember *m = &arr->member[i];
+        memset((void *)&m->accel_offset, 0, sizeof(ImuAxes));
+        memset((void *)&m->gyro_bias, 0, sizeof(ImuAxes));
+        memset((void *)&m->accel_sum, 0, sizeof(ImuAxes));
+        memset((void *)&m->gyro_sum, 0, sizeof(ImuAxes));
+        m->accel_diff2 = IMU_REAL(0.0);
+        m->gyro_diff2 = IMU_REAL(0.0);
+        m->magic_diff2 = IMU_REAL(0.0);
+        m->calib_count = 0;
+        m->diff_count = 0;
+        m->last_valid = false;
+    }
+    arr->calibrate_count = 0;
+    arr->calibrating = true;
+    arr->fused_valid = false;
+}
+
+static void ImuArray_AxesAccumulate(ImuAxes *sum, ImuAxes *value)
+{
+    sum->x += value->x;
+    sum->y += value->y;
+    sum->z += value->z;
+}
+
+/**
+ * 静止条件下逐个传感器校准, 与 Imu_Calibrate 使用相同的周期数.
+ * 各成员只统计自己的有效样本: 偏置按有效样本数平均, 差分只取相邻两个周期都有效的样本对,
+ * 读失败的周期既不计入均值也不会与更早的样本做差分.
+ */
+static void ImuArray_Calibrate(ImuArray *arr)
+{
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        ImuArrayMember *m = &arr->member[i];
+        if (!m->valid)
+        {
+            m->last_valid = false;
+            continue;
+        }
+        if (m->last_valid)
+        {
+            m->accel_diff2 += ImuArray_Dist2(&m->sample.accel, &m->last.accel);
+            m->gyro_diff2  += ImuArray_Dist2(&m->sample.gyro, &m->last.gyro);
+            m->magic_diff2 += ImuArray_Dist2(&m->sample.magic, &m->last.magic);
+            m->diff_count++;
+        }
+        ImuArray_AxesAccumulate(&m->accel_sum, &m->sample.accel);
+        ImuArray_AxesAccumulate(&m->gyro_sum, &m->sample.gyro);
+        m->calib_count++;
+        m->last = m->sample;
+        m->last_valid = true;
+    }
+
+    arr->calibrate_count++;
+    if (arr->calibrate_count >= IMU_CALIBRATE_TIMES)
+    {
+        for (int32_t i = 0; i < arr->count; i++)
+        {
+            ImuArrayMember *m = &arr->member[i];
+            if (m->calib_count > 0)
+            {
+                imu_real_t n = (imu_real_t)m->calib_count;
+                m->accel_offset.x = m->accel_sum.x / n;
+                m->accel_offset.y = m->accel_sum.y / n;
+                m->accel_offset.z = m->accel_sum.z / n - GRAVITY;
+                m->gyro_bias.x = m->gyro_sum.x / n;
+                m->gyro_bias.y = m->gyro_sum.y / n;
+                m->gyro_bias.z = m->gyro_sum.z / n;
+            }
+            if (m->diff_count > 0)
+            {
+                // 每轴方差, 3 轴合计后除以 2 * 3 * 差分对数
+                imu_real_t d = IMU_REAL(6.0) * (imu_real_t)m->diff_count;
+                m->accel_var = m->accel_diff2 / d + IMU_ARRAY_VAR_MIN;
+                m->gyro_var  = m->gyro_diff2 / d + IMU_ARRAY_VAR_MIN;
+                m->magic_var = m->magic_diff2 / d + IMU_ARRAY_VAR_MIN;
+            }
+        }
+        arr->calibrating = false;
+    }
+}
+
+static void ImuArray_Correct(ImuArrayMember *m)
+{
+    m->sample.accel.x -= m->accel_offset.x;
+    m->sample.accel.y -= m->accel_offset.y;
+    m->sample.accel.z -= m->accel_offset.z;
+    m->sample.gyro.x  -= m->gyro_bias.x;
+    m->sample.gyro.y  -= m->gyro_bias.y;
+    m->sample.gyro.z  -= m->gyro_bias.z;
+}
+
+/**
+ * 单一物理量的融合:
+ * 1. 参考值: 成员 >= 3 时取逐轴中位数; 2 个成员且互相矛盾时, 以上一次融合结果判定哪个离群
+ * 2. 偏离参考值超过 outlier_sigma 倍标准差的成员不参与本次融合
+ * 3. 剩余成员按 1/var 加权平均, 并用残差更新各成员的噪声方差
+ */
+static bool ImuArray_Fuse(ImuArray *arr, ImuArrayKind kind, ImuAxes *out)
+{
+    ImuArrayMember *list[IMU_ARRAY_MAX_MEMBERS];
+    bool accept[IMU_ARRAY_MAX_MEMBERS];
+    int32_t n = 0;
+    imu_real_t k2 = arr->outlier_sigma * arr->outlier_sigma;
+
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        ImuArrayMember *m = &arr->member[i];
+        if (m->valid && (ImuArrayKind_Magic != kind || m->use_magic))
+        {
+            accept[n] = true;
+            list[n++] = m;
+        }
+    }
+    if (0 == n)
+    {
+        return false;
+    }
+
+    if (n >= 3)
+    {
+        ImuAxes ref;
+        imu_real_t vx[IMU_ARRAY_MAX_MEMBERS], vy[IMU_ARRAY_MAX_MEMBERS], vz[IMU_ARRAY_MAX_MEMBERS];
+        imu_real_t vv[IMU_ARRAY_MAX_MEMBERS];
+        for (int32_t i = 0; i < n; i++)
+        {
+            ImuAxes *a = ImuArray_Axes(&list[i]->sample, kind);
+            vx[i] = a->x;
+            vy[i] = a->y;
+            vz[i] = a->z;
+            vv[i] = *ImuArray_Var(list[i], kind);
+        }
+        imu_real_t ref_var = ImuArray_Median(vv, n);  // 中位数本身的噪声, 近似取成员方差的中位数
+        if (3 == n)
+        {
+            ref.x = ImuArray_Median3(vx[0], vx[1], vx[2]);
+            ref.y = ImuArray_Median3(vy[0], vy[1], vy[2]);
+            ref.z = ImuArray_Median3(vz[0], vz[1], vz[2]);
+        }
+        else
+        {
+            ref.x = ImuArray_Median(vx, n);
+            ref.y = ImuArray_Median(vy, n);
+            ref.z = ImuArray_Median(vz, n);
+        }
+        for (int32_t i = 0; i < n; i++)
+        {
+            imu_real_t var = *ImuArray_Var(list[i], kind) + ref_var;
+            accept[i] = ImuArray_Dist2(ImuArray_Axes(&list[i]->sample, kind), &ref) <= k2 * IMU_REAL(3.0) * var;
+        }
+    }
+    else if (2 == n)
+    {
+        ImuAxes *a = ImuArray_Axes(&list[0]->sample, kind);
+        ImuAxes *b = ImuArray_Axes(&list[1]->sample, kind);
+        imu_real_t var = *ImuArray_Var(list[0], kind) + *ImuArray_Var(list[1], kind);
+        if (arr->fused_valid && ImuArray_Dist2(a, b) > k2 * IMU_REAL(3.0) * var)
+        {
+            ImuAxes *last = ImuArray_Axes(&arr->fused, kind);
+            if (ImuArray_Dist2(a, last) <= ImuArray_Dist2(b, last))
+            {
+                accept[1] = false;
+            }
+            else
+            {
+                accept[0] = false;
+            }
+        }
+    }
+
+    imu_real_t wsum = IMU_REAL(0.0);
+    ImuAxes sum = {IMU_REAL(0.0), IMU_REAL(0.0), IMU_REAL(0.0)};
+    for (int32_t i = 0; i < n; i++)
+    {
+        if (accept[i])
+        {
+            ImuAxes *a = ImuArray_Axes(&list[i]->sample, kind);
+            imu_real_t w = IMU_REAL(1.0) / *ImuArray_Var(list[i], kind);
+            sum.x += w * a->x;
+            sum.y += w * a->y;
+            sum.z += w * a->z;
+            wsum += w;
+        }
+        else
+        {
+            list[i]->outlier_count++;
+        }
+    }
+    if (wsum <= IMU_REAL(0.0))
+    {
+        return false;
+    }
+    out->x = sum.x / wsum;
+    out->y = sum.y / wsum;
+    out->z = sum.z / wsum;
+
+    // 只有冗余时残差才有意义. 残差取相对其余成员加权均值(留一法), 避免权重大的成员方差自我收缩:
+    // E[|x_i - mean_others|^2] / 3 = var_i + 1 / sum(w_others)
+    if (n > 1)
+    {
+        for (int32_t i = 0; i < n; i++)
+        {
+            imu_real_t w = IMU_REAL(1.0) / *ImuArray_Var(list[i], kind);
+            if (accept[i] && wsum - w > IMU_REAL(0.0))
+            {
+                imu_real_t *var = ImuArray_Var(list[i], kind);
+                ImuAxes *a = ImuArray_Axes(&list[i]->sample, kind);
+                ImuAxes others;
+                others.x = (sum.x - w * a->x) / (wsum - w);
+                others.y = (sum.y - w * a->y) / (wsum - w);
+                others.z = (sum.z - w * a->z) / (wsum - w);
+                imu_real_t d2 = ImuArray_Dist2(a, &others) / IMU_REAL(3.0) - IMU_REAL(1.0) / (wsum - w);
+                *var += arr->var_alpha * (d2 - *var);
+                if (*var < IMU_ARRAY_VAR_MIN)
+                {
+                    *var = IMU_ARRAY_VAR_MIN;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool ImuArray_Read(ImuArray *arr, ImuSource *source)
+{
+    if (!arr || !source || arr->count <= 0)
+    {
+        return false;
+    }
+
+    // 所有成员在同一次总线锁内连续读取
+    if (arr->lock)
+    {
+        arr->lock(arr->bus);
+    }
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        ImuArrayMember *m = &arr->member[i];
+        m->valid = m->read(m->ctx, &m->sample);
+    }
+    if (arr->unlock)
+    {
+        arr->unlock(arr->bus);
+    }
+
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        ImuArrayMember *m = &arr->member[i];
+        if (m->valid)
+        {
+            m->fail_count = 0;
+            if (!m->healthy && ++m->recover_count >= arr->fail_limit)
+            {
+                m->healthy = true;      // 读取稳定恢复后重新加入, 避免时好时坏的成员反复切入
+            }
+        }
+        else
+        {
+            m->recover_count = 0;
+            if (++m->fail_count >= arr->fail_limit)
+            {
+                m->healthy = false;     // 故障切换
+            }
+        }
+        // 完成过校准但期间没有有效样本的成员没有偏置参数, 不参与融合
+        m->valid = m->valid && m->healthy && (arr->calibrating || 0 == arr->calibrate_count || m->calib_count > 0);
+    }
+
+    if (arr->calibrating)
+    {
+        ImuArray_Calibrate(arr);
+    }
+    else
+    {
+        for (int32_t i = 0; i < arr->count; i++)
+        {
+            if (arr->member[i].valid)
+            {
+                ImuArray_Correct(&arr->member[i]);
+            }
+        }
+    }
+
+    ImuSource fused = arr->fused;
+    fused.use_magic = false;
+    imu_real_t accel_temperature = IMU_REAL(0.0), gyro_temperature = IMU_REAL(0.0), magic_temperature = IMU_REAL(0.0);
+    int32_t valid = 0, magic_valid = 0;
+    for (int32_t i = 0; i < arr->count; i++)
+    {
+        ImuArrayMember *m = &arr->member[i];
+        if (m->valid)
+        {
+            if (0 == valid)
+            {
+                fused.timestamp_us = m->sample.timestamp_us;    // 同一次锁内读取, 取第一个有效成员的时刻
+            }
+            accel_temperature += m->sample.accel_temperature;
+            gyro_temperature += m->sample.gyro_temperature;
+            valid++;
+            if (m->use_magic)
+            {
+                magic_temperature += m->sample.magic_temperature;
+                magic_valid++;
+            }
+        }
+    }
+    if (0 == valid)
+    {
+        return false;
+    }
+    fused.accel_temperature = accel_temperature / valid;
+    fused.gyro_temperature = gyro_temperature / valid;
+    if (magic_valid > 0)
+    {
+        fused.magic_temperature = magic_temperature / magic_valid;
+    }
+
+    bool ret = ImuArray_Fuse(arr, ImuArrayKind_Accel, &fused.accel) && ImuArray_Fuse(arr, ImuArrayKind_Gyro, &fused.gyro);
+    if (ret)
+    {
+        fused.use_magic = ImuArray_Fuse(arr, ImuArrayKind_Magic, &fused.magic);
+        arr->fused = fused;
+        arr->fused_valid = true;
+        *source = fused;
+    }
+    return ret;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file imu_array.h
+ * @author Wyatt Yu
+ * @brief 多传感器冗余阵列融合 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_ARRAY_H__
+#define __IMU_ARRAY_H__
+#include "imu.h"
+
+#define IMU_ARRAY_MAX_MEMBERS       4
+#define IMU_ARRAY_OUTLIER_SIGMA     IMU_REAL(4.0)   // 偏离参考值超过 k 倍标准差视为野值
+#define IMU_ARRAY_FAIL_LIMIT        3               // 连续读失败次数, 超过后切除该传感器
+#define IMU_ARRAY_VAR_ALPHA         IMU_REAL(0.01)  // 运行期噪声方差的指数平滑系数
+#define IMU_ARRAY_VAR_MIN           IMU_REAL(1e-8)
+
+// 读取一组原始数据(未校准), ctx 为用户传入的设备句柄
+typedef bool (*ImuArray_ReadFunc)(void *ctx, ImuSource *source);
+typedef void (*ImuArray_BusFunc)(void *bus);
+
+typedef struct ImuArrayMember_ {
+    ImuArray_ReadFunc read;
+    void *ctx;
+    bool use_magic;             // 该成员是否提供磁力计数据
+
+    // 每个传感器独立的校准参数, Ameas = Atrue + OFFSET
+    // 磁力计的硬铁偏置需要转动校准, 静止时无法估计, 这里不做扣除
+    ImuAxes accel_offset;
+    ImuAxes gyro_bias;
+
+    // 噪声方差, 校准时初始化, 运行中按残差更新
+    imu_real_t accel_var;
+    imu_real_t gyro_var;
+    imu_real_t magic_var;
+
+    // 校准累加量, 噪声方差由相邻样本差分估计: var = E[(x[k] - x[k-1])^2] / 2
+    ImuAxes accel_sum;
+    ImuAxes gyro_sum;
+    imu_real_t accel_diff2;
+    imu_real_t gyro_diff2;
+    imu_real_t magic_diff2;
+    int32_t calib_count;        // 参与校准的有效样本数, 为 0 时校准结束后不参与融合
+    int32_t diff_count;         // 差分对数, 只统计相邻两个周期都有效的样本
+    bool last_valid;            // 上一周期是否有效, last 是否可用于差分
+    ImuSource last;             // 上一次的原始数据
+
+    ImuSource sample;           // 本次读取并校准后的数据
+    bool valid;                 // 本次数据参与融合
+    bool healthy;               // 连续读失败 fail_limit 次后为 false, 再连续成功 fail_limit 次才恢复
+    int32_t fail_count;
+    int32_t recover_count;      // 不健康期间连续读成功的次数
+    uint32_t outlier_count;
+}ImuArrayMember;
+
+typedef struct ImuArray_ {
+    ImuArrayMember member[IMU_ARRAY_MAX_MEMBERS];
+    int32_t count;
+
+    // 总线锁, 所有成员在一次加锁内连续采样以减小传感器间的时间差
+    ImuArray_BusFunc lock;
+    ImuArray_BusFunc unlock;
+    void *bus;
+
+    imu_real_t outlier_sigma;
+    int32_t fail_limit;
+    imu_real_t var_alpha;
+
+    ImuSource fused;            // 上一次融合结果, 成员不足 3 个时作为野值判决参考
+    bool fused_valid;
+    volatile int32_t calibrate_count;
+    bool calibrating;
+}ImuArray;
+
+void ImuArray_Init(ImuArray *arr);
+int32_t ImuArray_Add(ImuArray *arr, ImuArray_ReadFunc read, void *ctx, bool use_magic);
+void ImuArray_SetBusLock(ImuArray *arr, ImuArray_BusFunc lock, ImuArray_BusFunc unlock, void *bus);
+bool ImuArray_Read(ImuArray *arr, ImuSource *source);
+void ImuArray_InitCalibrate(ImuArray *arr);
+int32_t ImuArray_HealthyCount(ImuArray *arr);
+
+#endif
@@ -0,0 +1,296 @@
+/**
+ * @file imu_bus.c
+ * @author Wyatt Yu
+ * @brief 共享 I2C 总线的周期读取调度
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_bus.h"
+
+void ImuBus_Init(ImuBus *bus, ImuBus_TransferFunc transfer, void *ctx, ImuBus_ClockFunc now_us)
+{
+    if (bus)
+    {
+        memset(bus, 0, sizeof(ImuBus));
+        bus->transfer = transfer;
+        bus->ctx = ctx;
+        bus->now_us = now_us;
+    }
+}
+
+void ImuBus_SetLock(ImuBus *bus, ImuBus_LockFunc lock, ImuBus_LockFunc unlock)
+{
+    if (bus)
+    {
+        bus->lock = lock;
+        bus->unlock = unlock;
+    }
+}
+
+/**
+ * 登记一个周期读取, rate_hz 为 0 时每次 Poll 都读取, 返回槽位序号, 失败返回 -1.
+ * 执行顺序按周期从短到长, 快速传感器总是排在前面, 与节拍的时间差最小.
+ */
+int32_t ImuBus_Add(ImuBus *bus, uint8_t addr, uint8_t reg, uint8_t length, uint32_t rate_hz)
+{
+    if (!bus || !bus->transfer || !bus->now_us || bus->count >= IMU_BUS_MAX_SLOTS || length > IMU_BUS_MAX_READ)
+    {
+        return -1;
+    }
+
+    int32_t index = bus->count;
+    ImuBusSlot *slot = &bus->slot[index];
+    memset(slot, 0, sizeof(ImuBusSlot));
+    slot->addr = addr;
+    slot->reg = reg;
+    slot->length = length;
+    slot->period_us = rate_hz ? 1000000u / rate_hz : 0;
+    slot->due_us = bus->now_us();
+
+    int32_t i = bus->count;
+    while (i > 0 && bus->slot[bus->order[i - 1]].period_us > slot->period_us)
+    {
+        bus->order[i] = bus->order[i - 1];
+        i--;
+    }
+    bus->order[i] = (uint8_t)index;
+    bus->count++;
+    return index;
+}
+
+static bool ImuBus_Due(const ImuBusSlot *slot, uint32_t now)
+{
+    // 提前 1/4 周期也算到期, 避免调用节拍的抖动让慢速槽位错过一拍
+    return 0 == slot->period_us || (int32_t)(now + slot->period_us / 4 - slot->due_us) >= 0;
+}
+
+static void ImuBus_Complete(ImuBusSlot *slot, bool ok, uint32_t t_us)
+{
+    if (ok)
+    {
+        slot->fresh = true;
+        slot->timestamp_us = t_us;
+    }
+    else
+    {
+        slot->errors++;
+    }
+    // 失败也按周期顺延, 不在同一节拍内反复重试; 落后超过一个周期时不补读
+    slot->due_us += slot->period_us;
+    if ((int32_t)(t_us - slot->due_us) >= 0)
+    {
+        slot->due_us = t_us + slot->period_us;
+    }
+}
+
+static void ImuBus_SetMsgs(ImuBus *bus, ImuBusMsg *msgs, int32_t index)
+{
+    ImuBusSlot *slot = &bus->slot[index];
+    bus->reg[index] = slot->reg;
+    msgs[0].addr = slot->addr;
+    msgs[0].flags = 0;
+    msgs[0].length = 1;
+    msgs[0].data = &bus->reg[index];
+    msgs[1].addr = slot->addr;
+    msgs[1].flags = IMU_BUS_RD;
+    msgs[1].length = slot->length;
+    msgs[1].data = slot->data;
+}
+
+/**
+ * 在一次加锁内执行所有到期的读取, 返回成功读取的槽位数.
+ * 合并传输时只能得到整次传输的起止时刻, 各槽位的时间戳按已传输字节数在其间插值.
+ */
+int32_t ImuBus_Poll(ImuBus *bus)
+{
+    uint8_t due[IMU_BUS_MAX_SLOTS];
+    int32_t n = 0;
+    int32_t read = 0;
+    uint32_t now = bus->now_us();
+
+    for (int32_t i = 0; i < bus->count; i++)
+    {
+        ImuBusSlot *slot = &bus->slot[bus->order[i]];
+        slot->fresh = false;
+        if (ImuBus_Due(slot, now))
+        {
+            due[n++] = bus->order[i];
+        }
+    }
+    if (0 == n)
+    {
+        return 0;
+    }
+
+    if (bus->lock)
+    {
+        bus->lock(bus->ctx);
+    }
+    uint32_t start = bus->now_us();
+    if (bus->combined)
+    {
+        uint32_t total = 0;
+        uint32_t done = 0;
+        for (int32_t i = 0; i < n; i++)
+        {
+            ImuBus_SetMsgs(bus, &bus->msgs[i * 2], due[i]);
+            total += bus->slot[due[i]].length + 3u;     // 两次地址字节 + 寄存器地址 + 数据
+        }
+        bool ok = bus->transfer(bus->ctx, bus->msgs, n * 2);
+        uint32_t end = bus->now_us();
+        for (int32_t i = 0; i < n; i++)
+        {
+            done += bus->slot[due[i]].length + 3u;
+            ImuBus_Complete(&bus->slot[due[i]], ok, start + (uint32_t)((uint64_t)(end - start) * done / total));
+            read += ok ? 1 : 0;
+        }
+    }
+    else
+    {
+        for (int32_t i = 0; i < n; i++)
+        {
+            ImuBus_SetMsgs(bus, bus->msgs, due[i]);
+            bool ok = bus->transfer(bus->ctx, bus->msgs, 2);
+            ImuBus_Complete(&bus->slot[due[i]], ok, bus->now_us());
+            read += ok ? 1 : 0;
+        }
+    }
+    bus->busy_us = bus->now_us() - start;
+    if (bus->unlock)
+    {
+        bus->unlock(bus->ctx);
+    }
+    return read;
+}
+
+bool ImuBusSource_Init(ImuBusSource *s, ImuBus *bus, Adlx345 *accel, uint32_t accel_hz, Itg3205 *gyro,
+                       Qmc5883l *magic, uint32_t magic_hz)
+{
+    if (!s || !bus || !accel || !gyro)
+    {
+        return false;
+    }
+
+    memset((void *)s, 0, sizeof(ImuBusSource));
+    s->bus = bus;
+    s->accel = accel;
+    s->gyro = gyro;
+    s->magic = magic;
+    // 陀螺仪决定节拍, 每次都读取
+    s->gyro_slot = ImuBus_Add(bus, gyro->addr, ITG3205_REG_DATA, 8, 0);
+    s->accel_slot = ImuBus_Add(bus, accel->addr, ADLX345_REG_DATA, 6, accel_hz);
+    s->magic_slot = magic ? ImuBus_Add(bus, QMC5883L_ADDR, QMC5883L_REG_DATA, 6, magic_hz) : -1;
+    return s->gyro_slot >= 0 && s->accel_slot >= 0 && (!magic || s->magic_slot >= 0);
+}
+
+// 槽位最近一次成功读取距 now 是否仍在失效时间之内; 同一次 Poll 中排在陀螺仪之后的读取可能略晚于 now
+static bool ImuBusSource_Alive(const ImuBusSlot *slot, bool read, uint32_t now)
+{
+    uint32_t limit = IMU_BUS_STALE_PERIODS * slot->period_us;
+    limit = (limit > IMU_BUS_STALE_MIN_US) ? limit : IMU_BUS_STALE_MIN_US;
+    return read && (int32_t)(now - slot->timestamp_us) <= (int32_t)limit;
+}
+
+bool ImuBusSource_Read(void *ctx, ImuSource *source)
+{
+    ImuBusSource *s = (ImuBusSource *)ctx;
+    ImuBusSlot *slot;
+    int16_t raw[4];
+
+    ImuBus_Poll(s->bus);
+    slot = &s->bus->slot[s->gyro_slot];
+    if (!slot->fresh)
+    {
+        return false;
+    }
+    imu_real_t k = Itg3205_GetScale(s->gyro);
+    Itg3205_UnpackRaw(slot->data, raw);
+    s->last.gyro.x = raw[1] * k;
+    s->last.gyro.y = raw[2] * k;
+    s->last.gyro.z = raw[3] * k;
+    s->last.gyro_temperature = Itg3205_RawToTemperature(raw[0]);
+    s->last.timestamp_us = slot->timestamp_us;
+    uint32_t now = slot->timestamp_us;
+
+    slot = &s->bus->slot[s->accel_slot];
+    if (slot->fresh)
+    {
+        k = Adlx345_GetScale(s->accel);
+        Adlx345_UnpackRaw(slot->data, raw);
+        s->last.accel.x = raw[0] * k;
+        s->last.accel.y = raw[1] * k;
+        s->last.accel.z = raw[2] * k;
+        s->accel_read = true;
+    }
+    else if (!ImuBusSource_Alive(slot, s->accel_read, now))
+    {
+        // 加速度计持续读失败, 清零后 Imu_Update 跳过加速度计修正, 只做陀螺积分
+        s->last.accel.x = IMU_REAL(0.0);
+        s->last.accel.y = IMU_REAL(0.0);
+        s->last.accel.z = IMU_REAL(0.0);
+    }
+    else
+    {
+        // do nothing
+    }
+
+    if (s->magic_slot >= 0 && s->bus->slot[s->magic_slot].fresh)
+    {
+        slot = &s->bus->slot[s->magic_slot];
+        k = Qmc5883l_GetScale(s->magic);
+        Qmc5883l_UnpackRaw(slot->data, raw);
+        s->last.magic.x = raw[0] * k;
+        s->last.magic.y = raw[1] * k;
+        s->last.magic.z = raw[2] * k;
+        s->magic_read = true;
+    }
+    else
+    {
+        // do nothing
+    }
+    // 每个节拍重新判断, 磁力计持续读失败时退回 6 轴融合, 恢复后再启用
+    s->last.use_magic = s->magic_slot >= 0 && ImuBusSource_Alive(&s->bus->slot[s->magic_slot], s->magic_read, now);
+
+    *source = s->last;
+    return true;
+}
+
+#ifdef RT_USING_I2C
+static bool ImuBus_RttTransfer(void *ctx, ImuBusMsg *msgs, int32_t count)
+{
+    struct rt_i2c_msg rt_msgs[IMU_BUS_MAX_SLOTS * 2];
+    for (int32_t i = 0; i < count; i++)
+    {
+        rt_msgs[i].addr  = msgs[i].addr;
+        rt_msgs[i].flags = (msgs[i].flags & IMU_BUS_RD) ? RT_I2C_RD : RT_I2C_WR;
+        rt_msgs[i].len   = msgs[i].length;
+        rt_msgs[i].buf   = msgs[i].data;
+    }
+    return (rt_size_t)count == rt_i2c_transfer((struct rt_i2c_bus_device *)ctx, rt_msgs, (rt_uint32_t)count);
+}
+
+static void ImuBus_RttLock(void *ctx)
+{
+    rt_mutex_take(&((struct rt_i2c_bus_device *)ctx)->lock, RT_WAITING_FOREVER);
+}
+
+static void ImuBus_RttUnlock(void *ctx)
+{
+    rt_mutex_release(&((struct rt_i2c_bus_device *)ctx)->lock);
+}
+
+static uint32_t ImuBus_RttTick(void)
+{
+    return rt_tick_get() * (1000000u / RT_TICK_PER_SECOND);
+}
+
+/**
+ * rt_i2c_transfer 内部也会获取总线锁, RT-Thread 的互斥量允许同一线程嵌套获取.
+ * 默认逐个槽位传输, 确认控制器驱动能处理不同地址的连续消息后可置 combined.
+ */
+void ImuBus_InitRtt(ImuBus *bus, struct rt_i2c_bus_device *i2c, ImuBus_ClockFunc now_us)
+{
+    ImuBus_Init(bus, ImuBus_RttTransfer, i2c, now_us ? now_us : ImuBus_RttTick);
+    ImuBus_SetLock(bus, ImuBus_RttLock, ImuBus_RttUnlock);
+}
+#endif
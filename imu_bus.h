@@ -0,0 +1,92 @@
+/**
+ * @file imu_bus.h
+ * @author Wyatt Yu
+ * @brief 共享 I2C 总线的周期读取调度 头文件
+ *
+ * 各芯片的数据寄存器读取登记为槽位, ImuBus_Poll 在一次加锁内按周期从短到长
+ * 连续执行所有到期的读取, 控制器支持时合并为一次多消息传输, 减少加锁与起停开销,
+ * 也避免其他总线用户插入到同一节拍的读取之间. 配置寄存器的写入仍走驱动自己的回调.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_BUS_H__
+#define __IMU_BUS_H__
+#include "imu.h"
+#include "adlx345.h"
+#include "itg3205.h"
+#include "qmc5883l.h"
+
+#define IMU_BUS_MAX_SLOTS           6
+#define IMU_BUS_MAX_READ            8           // ITG3205 温度 + 三轴
+#define IMU_BUS_RD                  0x01        // 读消息, 否则为写
+#define IMU_BUS_STALE_PERIODS       3u          // 槽位超过这么多个周期没有读到数据时视为失效
+#define IMU_BUS_STALE_MIN_US        20000u      // 失效时间下限, 周期为 0 (每次 Poll 都读取) 的槽位按此判断
+
+typedef struct ImuBusMsg_ {
+    uint8_t addr;               // 7-bit i2c address
+    uint8_t flags;              // IMU_BUS_RD
+    uint16_t length;
+    uint8_t *data;
+}ImuBusMsg;
+
+// 按顺序执行 count 条消息, 消息之间为重复起始, 最后一条之后停止
+typedef bool (*ImuBus_TransferFunc)(void *ctx, ImuBusMsg *msgs, int32_t count);
+typedef void (*ImuBus_LockFunc)(void *ctx);
+typedef uint32_t (*ImuBus_ClockFunc)(void);
+
+typedef struct ImuBusSlot_ {
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t length;
+    uint32_t period_us;         // 0 表示每次 Poll 都读取
+    uint32_t due_us;            // 下次到期时刻
+    uint32_t timestamp_us;      // 最近一次读取完成时刻
+    bool fresh;                 // 最近一次 Poll 读到了新数据
+    uint32_t errors;
+    uint8_t data[IMU_BUS_MAX_READ];
+}ImuBusSlot;
+
+typedef struct ImuBus_ {
+    ImuBus_TransferFunc transfer;
+    ImuBus_LockFunc lock;       // 可选, 持有总线直到本次 Poll 的读取全部完成
+    ImuBus_LockFunc unlock;
+    ImuBus_ClockFunc now_us;
+    void *ctx;
+    bool combined;              // 控制器能在一次传输中处理不同地址的多条消息
+    ImuBusSlot slot[IMU_BUS_MAX_SLOTS];
+    int32_t count;
+    uint8_t order[IMU_BUS_MAX_SLOTS];   // 按周期从短到长排列的槽位序号
+    uint8_t reg[IMU_BUS_MAX_SLOTS];     // 合并传输时各槽位的寄存器地址消息
+    ImuBusMsg msgs[IMU_BUS_MAX_SLOTS * 2];
+    uint32_t busy_us;           // 最近一次 Poll 占用总线的时间
+}ImuBus;
+
+// 三个芯片的原始数据读取登记在同一个 ImuBus 上, 读出后换算为 ImuSource
+typedef struct ImuBusSource_ {
+    ImuBus *bus;
+    Adlx345 *accel;
+    Itg3205 *gyro;
+    Qmc5883l *magic;            // 可选
+    int32_t accel_slot;
+    int32_t gyro_slot;
+    int32_t magic_slot;
+    bool accel_read;            // 已经读到过加速度计数据
+    bool magic_read;
+    ImuSource last;             // 槽位本次未到期时沿用上次的值, 失效后加速度清零, 磁力计不再参与融合
+}ImuBusSource;
+
+void ImuBus_Init(ImuBus *bus, ImuBus_TransferFunc transfer, void *ctx, ImuBus_ClockFunc now_us);
+void ImuBus_SetLock(ImuBus *bus, ImuBus_LockFunc lock, ImuBus_LockFunc unlock);
+int32_t ImuBus_Add(ImuBus *bus, uint8_t addr, uint8_t reg, uint8_t length, uint32_t rate_hz);
+int32_t ImuBus_Poll(ImuBus *bus);
+
+bool ImuBusSource_Init(ImuBusSource *s, ImuBus *bus, Adlx345 *accel, uint32_t accel_hz, Itg3205 *gyro,
+                       Qmc5883l *magic, uint32_t magic_hz);
+bool ImuBusSource_Read(void *ctx, ImuSource *source);  // 与 ImuArray_ReadFunc 兼容, 输出未校准数据
+
+#ifdef RT_USING_I2C
+// now_us 为 RT_NULL 时按系统节拍计时, 分辨率只有一个 tick
+void ImuBus_InitRtt(ImuBus *bus, struct rt_i2c_bus_device *i2c, ImuBus_ClockFunc now_us);
+#endif
+
+#endif
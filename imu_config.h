@@ -0,0 +1,65 @@
+/**
+ * @file imu_config.h
+ * @author Wyatt Yu
+ * @brief 功能裁剪开关
+ *
+ * 在 RT-Thread 中由 Kconfig 生成到 rtconfig.h, SConscript 按同样的选项选择源文件.
+ * 没有定义任何 IMU_USING_* 功能选项时 (主机端工具, 直接拷贝源码集成, 没有运行 menuconfig 的工程)
+ * 打开全部功能, 与裁剪前一致; IMU_USING_DOUBLE 只选择精度, 不算功能选项.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_CONFIG_H__
+#define __IMU_CONFIG_H__
+
+#if !defined(IMU_USING_ADXL345) && !defined(IMU_USING_ITG3205) && !defined(IMU_USING_QMC5883L) && \
+    !defined(IMU_USING_MADGWICK) && !defined(IMU_USING_MAHONY) && !defined(IMU_USING_COMPLEMENTARY) && \
+    !defined(IMU_USING_MAGIC) && !defined(IMU_USING_ACCEL_CALIB) && !defined(IMU_USING_PROFILING) && \
+    !defined(IMU_USING_HISTORY) && !defined(IMU_USING_ARRAY) && !defined(IMU_USING_BUS) && \
+    !defined(IMU_USING_STARTUP) && !defined(IMU_USING_TELEMETRY) && !defined(IMU_USING_VIBRATION) && \
+    !defined(IMU_USING_DECIMATE)
+#define IMU_USING_ADXL345
+#define IMU_USING_ITG3205
+#define IMU_USING_QMC5883L
+#define IMU_USING_MADGWICK
+#define IMU_USING_MAHONY
+#define IMU_USING_COMPLEMENTARY
+#define IMU_USING_MAGIC
+#define IMU_USING_ACCEL_CALIB
+#define IMU_USING_PROFILING
+#define IMU_USING_HISTORY
+#define IMU_USING_ARRAY
+#define IMU_USING_BUS
+#define IMU_USING_STARTUP
+#define IMU_USING_TELEMETRY
+#define IMU_USING_VIBRATION
+#define IMU_USING_DECIMATE
+#endif
+
+#ifndef IMU_CALIBRATE_TIMES
+#define IMU_CALIBRATE_TIMES     500
+#endif
+
+// 热数据 Imu 的对齐, Cortex-M7 的 D-Cache 行为 32 字节, 主机为 64 字节; 没有缓存的内核可设为 4 以节省 RAM
+#ifndef IMU_CACHE_LINE
+#if defined(__x86_64__) || defined(__aarch64__)
+#define IMU_CACHE_LINE          64
+#else
+#define IMU_CACHE_LINE          32
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__CC_ARM)
+#define IMU_ALIGNED(n)          __attribute__((aligned(n)))
+#else
+#define IMU_ALIGNED(n)
+#endif
+
+// 关闭磁力计融合时为常量 false, 各算法的 9 轴分支由编译器直接去掉
+#ifdef IMU_USING_MAGIC
+#define IMU_HAS_MAGIC(x)        (x)
+#else
+#define IMU_HAS_MAGIC(x)        (false)
+#endif
+
+#endif
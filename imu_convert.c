@@ -0,0 +1,54 @@
+/**
+ * @file imu_convert.c
+ * @author Wyatt Yu
+ * @brief 原始计数批量换算, 主机端 SSE2 / Cortex-A NEON 向量化, 其余平台 4 路展开
+ * @copyright Copyright (c) 2025
+ */
+#include "imu_convert.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void ImuConvert_RawToFloat(const int16_t *raw, float scale, float *out, int32_t count)
+{
+    int32_t i = 0;
+
+#if defined(__SSE2__)
+    __m128 k = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v  = _mm_loadu_si128((const __m128i *)&raw[i]);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);     // 符号扩展到 32 位
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), k));
+        _mm_storeu_ps(&out[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), k));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        int16x8_t v = vld1q_s16(&raw[i]);
+        vst1q_f32(&out[i], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(&out[i + 4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+#else
+    // Cortex-M4F 没有浮点 SIMD, 展开后 VCVT/VMUL 可以流水
+    for (; i + 4 <= count; i += 4)
+    {
+        float a = raw[i];
+        float b = raw[i + 1];
+        float c = raw[i + 2];
+        float d = raw[i + 3];
+        out[i]     = a * scale;
+        out[i + 1] = b * scale;
+        out[i + 2] = c * scale;
+        out[i + 3] = d * scale;
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = raw[i] * scale;
+    }
+}
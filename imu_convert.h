@@ -0,0 +1,26 @@
+/**
+ * @file imu_convert.h
+ * @author Wyatt Yu
+ * @brief 原始计数批量换算 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_CONVERT_H__
+#define __IMU_CONVERT_H__
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * out[i] = raw[i] * scale, count 为 int16 个数 (样本数 * 3).
+ * scale 取各驱动的 *_GetScale(), 已在初始化时求好倒数, 换算只有乘法.
+ * raw 与 out 可以任意对齐, 不允许重叠.
+ */
+void ImuConvert_RawToFloat(const int16_t *raw, float scale, float *out, int32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,227 @@
+/**
+ * @file imu_decimate.c
+ * @author Wyatt Yu
+ * @brief 抗混叠抽取滤波
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_decimate.h"
+
+#define IMU_DECIMATE_HB_MID         (IMU_DECIMATE_HB_TAPS / 2)
+#define IMU_DECIMATE_HB_SIDE        ((IMU_DECIMATE_HB_MID + 1) / 2)
+
+/**
+ * 19 抽头半带 Kaiser 窗 (beta = 7), Q15, 只列出中心左侧的非零抽头 (下标 0, 2, 4, 6, 8), 中心为 0.5.
+ * 通带 0 ~ 0.125 fs 纹波 0.004dB, 阻带 0.375 fs 以上 -68dB; 调整最内侧抽头使直流增益恰为 1.
+ */
+static const int32_t imu_decimate_hb_coeff[IMU_DECIMATE_HB_SIDE] = {7, -141, 706, -2403, 10023};
+
+bool ImuDecimate_Init(ImuDecimate *d, imu_real_t in_freq, int32_t ratio, uint8_t cic_order, uint8_t hb_stages,
+                      imu_real_t scale)
+{
+    if (!d || in_freq <= IMU_REAL(0.0) || ratio < 1 || hb_stages > IMU_DECIMATE_HB_STAGES_MAX
+        || cic_order > IMU_DECIMATE_CIC_ORDER_MAX || ratio % (1 << hb_stages) != 0)
+    {
+        return false;
+    }
+
+    int32_t cic_ratio = ratio >> hb_stages;
+    int32_t gain = 1;
+    if (cic_ratio == 1)
+    {
+        cic_order = 0;
+    }
+    else if (cic_order == 0 || cic_ratio > IMU_DECIMATE_CIC_GAIN_MAX)
+    {
+        return false;
+    }
+    else
+    {
+        for (uint8_t i = 0; i < cic_order; i++)
+        {
+            gain *= cic_ratio;
+            if (gain > IMU_DECIMATE_CIC_GAIN_MAX)
+            {
+                return false;
+            }
+        }
+    }
+
+    memset((void *)d, 0, sizeof(ImuDecimate));
+    d->in_freq = in_freq;
+    d->ratio = ratio;
+    d->cic_ratio = (uint16_t)cic_ratio;
+    d->cic_order = cic_order;
+    d->hb_stages = hb_stages;
+    d->scale = scale / (imu_real_t)gain;
+    return true;
+}
+
+/**
+ * 按速率选择结构, 实际输出速率为 in_freq / ratio.
+ * bandwidth 为传感器自身的低通截止频率, 不高于输出速率的 1/4 时传感器已完成抗混叠, 只做 1 阶 CIC (块平均);
+ * 否则偶数抽取比的最后一次抽 2 交给半带级, 其余由 CIC 完成, 阶数在增益允许范围内取到 4.
+ * 两级半带在 CIC 比例较小时反而受 CIC 的混叠限制, 800Hz -> 100Hz 实测最差 -55dB, 延迟 69ms;
+ * 一级半带 + 4 阶 CIC 为 -70dB, 延迟 52ms, 需要两级时直接调用 ImuDecimate_Init.
+ * 3200Hz (3 阶 CIC) 与 400Hz (CIC R = 2) 抽到 100Hz 时, 200Hz 附近的混叠只有 -57dB 与 -64dB,
+ * 见 tools/imu_decimate_test.c.
+ */
+bool ImuDecimate_Plan(ImuDecimate *d, imu_real_t in_freq, imu_real_t out_freq, imu_real_t bandwidth, imu_real_t scale)
+{
+    if (in_freq <= IMU_REAL(0.0) || out_freq <= IMU_REAL(0.0))
+    {
+        return false;
+    }
+
+    int32_t ratio = (int32_t)(in_freq / out_freq + IMU_REAL(0.5));
+    if (ratio <= 1)
+    {
+        return ImuDecimate_Init(d, in_freq, 1, 0, 0, scale);
+    }
+    if (bandwidth > IMU_REAL(0.0) && bandwidth <= IMU_REAL(0.25) * out_freq)
+    {
+        return ImuDecimate_Init(d, in_freq, ratio, 1, 0, scale);
+    }
+
+    uint8_t hb_stages = (ratio % 2 == 0) ? 1 : 0;
+    int32_t cic_ratio = ratio >> hb_stages;
+    uint8_t cic_order = 0;
+    if (cic_ratio > 1)
+    {
+        int32_t gain = cic_ratio;
+        cic_order = 1;
+        while (cic_order < IMU_DECIMATE_CIC_ORDER_MAX && gain <= IMU_DECIMATE_CIC_GAIN_MAX / cic_ratio)
+        {
+            gain *= cic_ratio;
+            cic_order++;
+        }
+    }
+    return ImuDecimate_Init(d, in_freq, ratio, cic_order, hb_stages, scale);
+}
+
+#ifdef IMU_USING_ADXL345
+// 输出速率 3200Hz / 2^(15 - rate), 带宽为输出速率的一半
+bool ImuDecimate_InitAdlx345(ImuDecimate *d, Adlx345 *m, imu_real_t out_freq)
+{
+    Adlx345SampleRate rate = Adlx345SampleRate_3600;
+    if (!m)
+    {
+        return false;
+    }
+
+    Adlx345_GetSampleRate(m, &rate);
+    imu_real_t in_freq = IMU_REAL(3200.0) / (imu_real_t)(1u << (15 - rate));
+    return ImuDecimate_Plan(d, in_freq, out_freq, IMU_REAL(0.5) * in_freq, Adlx345_GetScale(m));
+}
+#endif
+
+#ifdef IMU_USING_ITG3205
+// 带宽取 DLPF 设置
+bool ImuDecimate_InitItg3205(ImuDecimate *d, Itg3205 *m, imu_real_t out_freq)
+{
+    static const int16_t dlpf_hz[] = {256, 188, 98, 42, 20, 10, 5};
+    if (!m || (uint32_t)m->lpf >= sizeof(dlpf_hz) / sizeof(dlpf_hz[0]))
+    {
+        return false;
+    }
+
+    return ImuDecimate_Plan(d, (imu_real_t)Itg3205_GetSampleRate(m), out_freq, (imu_real_t)dlpf_hz[m->lpf],
+                            Itg3205_GetScale(m));
+}
+#endif
+
+// 每两个输入产生一个输出, 输入输出都带 CIC 增益
+static bool ImuDecimate_HalfBand(ImuDecimateStage *st, int32_t x[3])
+{
+    st->pos = (uint8_t)(st->pos + 1 == IMU_DECIMATE_HB_TAPS ? 0 : st->pos + 1);
+    for (int32_t a = 0; a < 3; a++)
+    {
+        st->delay[a][st->pos] = x[a];
+        st->delay[a][st->pos + IMU_DECIMATE_HB_TAPS] = x[a];
+    }
+    st->odd = !st->odd;
+    if (st->odd)
+    {
+        return false;
+    }
+
+    for (int32_t a = 0; a < 3; a++)
+    {
+        const int32_t *w = &st->delay[a][st->pos + 1];     // w[0] 最旧, w[TAPS - 1] 最新
+        int64_t acc = (int64_t)w[IMU_DECIMATE_HB_MID] * 16384;
+        for (int32_t j = 0; j < IMU_DECIMATE_HB_SIDE; j++)
+        {
+            acc += (int64_t)imu_decimate_hb_coeff[j] * ((int64_t)w[2 * j] + w[IMU_DECIMATE_HB_TAPS - 1 - 2 * j]);
+        }
+        x[a] = (int32_t)((acc + (1 << 14)) >> 15);
+    }
+    return true;
+}
+
+/**
+ * 输入一个原始样本, 产生输出时写入 out (物理单位) 并返回 true.
+ * CIC 积分器按 32 位无符号数自然回绕, 梳状级相减后得到正确结果, 只要 R^N * 32768 不超过 2^31.
+ */
+bool ImuDecimate_Push(ImuDecimate *d, const int16_t raw[3], ImuAxes *out)
+{
+    int32_t x[3];
+    if (d->cic_order == 0)
+    {
+        x[0] = raw[0];
+        x[1] = raw[1];
+        x[2] = raw[2];
+    }
+    else
+    {
+        for (int32_t a = 0; a < 3; a++)
+        {
+            uint32_t v = (uint32_t)(int32_t)raw[a];
+            for (uint8_t k = 0; k < d->cic_order; k++)
+            {
+                d->integ[k][a] += v;
+                v = d->integ[k][a];
+            }
+        }
+        if (++d->count < d->cic_ratio)
+        {
+            return false;
+        }
+        d->count = 0;
+
+        for (int32_t a = 0; a < 3; a++)
+        {
+            uint32_t v = d->integ[d->cic_order - 1][a];
+            for (uint8_t k = 0; k < d->cic_order; k++)
+            {
+                uint32_t t = v - d->comb[k][a];
+                d->comb[k][a] = v;
+                v = t;
+            }
+            x[a] = (int32_t)v;
+        }
+    }
+
+    for (uint8_t s = 0; s < d->hb_stages; s++)
+    {
+        if (!ImuDecimate_HalfBand(&d->hb[s], x))
+        {
+            return false;
+        }
+    }
+
+    out->x = (imu_real_t)x[0] * d->scale;
+    out->y = (imu_real_t)x[1] * d->scale;
+    out->z = (imu_real_t)x[2] * d->scale;
+    return true;
+}
+
+// 群延迟: CIC 为 N (R - 1) / 2 个输入样本, 第 s 级半带为 (TAPS - 1) / 2 个该级输入样本
+uint32_t ImuDecimate_GetDelayUs(const ImuDecimate *d)
+{
+    imu_real_t samples = IMU_REAL(0.5) * (imu_real_t)(d->cic_order * (d->cic_ratio - 1));
+    for (uint8_t s = 0; s < d->hb_stages; s++)
+    {
+        samples += (imu_real_t)(IMU_DECIMATE_HB_MID * d->cic_ratio * (1 << s));
+    }
+    return (uint32_t)(samples * IMU_REAL(1000000.0) / d->in_freq + IMU_REAL(0.5));
+}
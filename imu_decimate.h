@@ -0,0 +1,65 @@
+/**
+ * @file imu_decimate.h
+ * @author Wyatt Yu
+ * @brief 抗混叠抽取滤波 头文件
+ *
+ * 传感器以高输出速率采样, 融合以较低的 samp_freq 运行时, 直接丢弃样本会把振动混叠到姿态里.
+ * 抽取器放在驱动读取与 Imu_Update 之间, 每轴独立:
+ *   CIC (积分-梳状, 阶数 1~4, 比例 R) -> 0~2 级半带 FIR (每级抽 2)
+ * 全程整数运算: CIC 用 32 位模运算, 增益 R^N 不超过 2^15 以保证 int16 输入不溢出;
+ * 半带 FIR 为 19 抽头 Q15 系数, 64 位累加, 延迟线按两倍长度存放, 内积为连续内存访问.
+ * 输出换算为物理单位时一并除去 CIC 增益.
+ *
+ * 用法: 每读到一个原始样本调用 ImuDecimate_Push, 返回 true 时把输出装入 imu->source,
+ * 加速度计与陀螺仪的抽取器同时产出后调用 Imu_Update. 样本时间戳应减去 ImuDecimate_GetDelayUs.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_DECIMATE_H__
+#define __IMU_DECIMATE_H__
+#include "imu.h"
+#ifdef IMU_USING_ADXL345
+#include "adlx345.h"
+#endif
+#ifdef IMU_USING_ITG3205
+#include "itg3205.h"
+#endif
+
+#define IMU_DECIMATE_CIC_ORDER_MAX  4
+#define IMU_DECIMATE_CIC_GAIN_MAX   32768       // R^N 上限, int16 输入乘增益后仍在 int32 内
+#define IMU_DECIMATE_HB_STAGES_MAX  2
+#define IMU_DECIMATE_HB_TAPS        19
+
+// 半带抽 2, 延迟线存两份, 最近 TAPS 个样本总是连续的
+typedef struct ImuDecimateStage_ {
+    int32_t delay[3][2 * IMU_DECIMATE_HB_TAPS];
+    uint8_t pos;
+    bool odd;                   // 已缓存一个样本, 下一个样本产生输出
+}ImuDecimateStage;
+
+typedef struct ImuDecimate_ {
+    imu_real_t in_freq;         // 输入速率 Hz
+    int32_t ratio;              // 总抽取比 = cic_ratio * 2^hb_stages
+    uint16_t cic_ratio;
+    uint8_t cic_order;          // 0 表示不经过 CIC
+    uint8_t hb_stages;
+    imu_real_t scale;           // 物理单位 per LSB / CIC 增益
+    uint32_t integ[IMU_DECIMATE_CIC_ORDER_MAX][3];
+    uint32_t comb[IMU_DECIMATE_CIC_ORDER_MAX][3];
+    uint16_t count;
+    ImuDecimateStage hb[IMU_DECIMATE_HB_STAGES_MAX];
+}ImuDecimate;
+
+bool ImuDecimate_Init(ImuDecimate *d, imu_real_t in_freq, int32_t ratio, uint8_t cic_order, uint8_t hb_stages,
+                      imu_real_t scale);
+bool ImuDecimate_Plan(ImuDecimate *d, imu_real_t in_freq, imu_real_t out_freq, imu_real_t bandwidth, imu_real_t scale);
+#ifdef IMU_USING_ADXL345
+bool ImuDecimate_InitAdlx345(ImuDecimate *d, Adlx345 *m, imu_real_t out_freq);
+#endif
+#ifdef IMU_USING_ITG3205
+bool ImuDecimate_InitItg3205(ImuDecimate *d, Itg3205 *m, imu_real_t out_freq);
+#endif
+bool ImuDecimate_Push(ImuDecimate *d, const int16_t raw[3], ImuAxes *out);
+uint32_t ImuDecimate_GetDelayUs(const ImuDecimate *d);
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * @file imu_history.c
+ * @author Wyatt Yu
+ * @brief 姿态历史缓存: 缓存内按时间球面插值, 超出最新样本时按当前角速度外推
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "app_common.h"
+#include "imu_history.h"
+
+// 时间戳按 uint32_t 回绕, 差值用有符号数表示
+#define IMU_HISTORY_DT(a, b)    ((int32_t)((uint32_t)(a) - (uint32_t)(b)))
+
+// 顺序锁两侧的内存屏障; 单核 MCU 上只需阻止编译器重排, 多核主机上同时是硬件屏障
+#if defined(__GNUC__) || defined(__clang__)
+#define IMU_HISTORY_FENCE()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#elif defined(__CC_ARM)
+#define IMU_HISTORY_FENCE()     __dmb(0xF)
+#else
+#define IMU_HISTORY_FENCE()
+#endif
+
+typedef enum {
+    ImuHistoryFind_Empty   = 0,
+    ImuHistoryFind_Before  = 1,     // 早于缓存, a 为最旧样本
+    ImuHistoryFind_Between = 2,     // a.t <= t < b.t
+    ImuHistoryFind_After   = 3,     // 不早于最新样本, a 为最新样本
+}ImuHistoryFind;
+
+void ImuHistory_Init(ImuHistory *history, uint32_t max_predict_us)
+{
+    memset(history, 0, sizeof(ImuHistory));
+    history->max_predict_us = max_predict_us;
+}
+
+void ImuHistory_Push(ImuHistory *history, uint32_t t_us, const ImuQuaternion *q, const imu_real_t gyro[3])
+{
+    ImuHistoryEntry *e = &history->entry[history->head];
+    history->seq++;
+    IMU_HISTORY_FENCE();
+    e->t_us = t_us;
+    e->q[0] = q->q0;
+    e->q[1] = q->q1;
+    e->q[2] = q->q2;
+    e->q[3] = q->q3;
+    e->gyro[0] = gyro[0];
+    e->gyro[1] = gyro[1];
+    e->gyro[2] = gyro[2];
+    history->head = (history->head + 1) % IMU_HISTORY_SIZE;
+    if (history->count < IMU_HISTORY_SIZE)
+    {
+        history->count++;
+    }
+    IMU_HISTORY_FENCE();
+    history->seq++;
+}
+
+// i = 0 为最旧的样本
+static ImuHistoryEntry *ImuHistory_At(ImuHistory *history, int32_t i)
+{
+    return &history->entry[(history->head - history->count + i + IMU_HISTORY_SIZE) % IMU_HISTORY_SIZE];
+}
+
+static void ImuHistory_Output(const imu_real_t *v, ImuQuaternion *q)
+{
+    imu_real_t recipNorm = IMU_INVSQRT(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+    q->q0 = v[0] * recipNorm;
+    q->q1 = v[1] * recipNorm;
+    q->q2 = v[2] * recipNorm;
+    q->q3 = v[3] * recipNorm;
+}
+
+static void ImuHistory_Slerp(const imu_real_t *a, const imu_real_t *b, imu_real_t t, ImuQuaternion *q)
+{
+    imu_real_t out[4];
+    imu_real_t sign = IMU_REAL(1.0);
+    imu_real_t wa = IMU_REAL(1.0) - t;
+    imu_real_t wb = t;
+    imu_real_t dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    if (dot < IMU_REAL(0.0))
+    {
+        dot = -dot;
+        sign = -IMU_REAL(1.0);  // 取最短路径
+    }
+    // 相邻样本间转角很小, 绝大多数情况下线性插值后归一化即可, 避免三角函数
+    if (dot < IMU_REAL(0.9995))
+    {
+        imu_real_t theta = IMU_ACOS(dot);
+        imu_real_t recip = IMU_REAL(1.0) / IMU_SIN(theta);
+        wa = IMU_SIN(wa * theta) * recip;
+        wb = IMU_SIN(wb * theta) * recip;
+    }
+    wb *= sign;
+    for (int32_t i = 0; i < 4; i++)
+    {
+        out[i] = wa * a[i] + wb * b[i];
+    }
+    ImuHistory_Output(out, q);
+}
+
+// q ⊗ (1, w * dt / 2), 与 Mahony 积分相同的一阶近似
+static void ImuHistory_Predict(const ImuHistoryEntry *e, imu_real_t dt, ImuQuaternion *q)
+{
+    imu_real_t a = IMU_REAL(0.5) * dt * e->gyro[0];
+    imu_real_t b = IMU_REAL(0.5) * dt * e->gyro[1];
+    imu_real_t c = IMU_REAL(0.5) * dt * e->gyro[2];
+    imu_real_t out[4];
+    out[0] = e->q[0] - e->q[1] * a - e->q[2] * b - e->q[3] * c;
+    out[1] = e->q[0] * a + e->q[1] + e->q[2] * c - e->q[3] * b;
+    out[2] = e->q[0] * b - e->q[1] * c + e->q[2] + e->q[3] * a;
+    out[3] = e->q[0] * c + e->q[1] * b - e->q[2] * a + e->q[3];
+    ImuHistory_Output(out, q);
+}
+
+/**
+ * 在一致的快照中定位 t_us, 把用到的样本拷贝到 a, b. 可能与 Push 同时执行,
+ * head 与 count 各自总在有效范围内, 读到的数据是否可用由调用者按 seq 判断.
+ */
+static ImuHistoryFind ImuHistory_Find(ImuHistory *history, uint32_t t_us, ImuHistoryEntry *a, ImuHistoryEntry *b)
+{
+    int32_t count = history->count;
+    if (count <= 0)
+    {
+        return ImuHistoryFind_Empty;
+    }
+
+    *a = *ImuHistory_At(history, count - 1);
+    if (IMU_HISTORY_DT(t_us, a->t_us) >= 0)
+    {
+        return ImuHistoryFind_After;
+    }
+    *a = *ImuHistory_At(history, 0);
+    if (IMU_HISTORY_DT(t_us, a->t_us) < 0)
+    {
+        return ImuHistoryFind_Before;
+    }
+
+    // 二分查找 entry[lo].t <= t < entry[hi].t
+    int32_t lo = 0;
+    int32_t hi = count - 1;
+    while (hi - lo > 1)
+    {
+        int32_t mid = (lo + hi) / 2;
+        if (IMU_HISTORY_DT(t_us, ImuHistory_At(history, mid)->t_us) >= 0)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *a = *ImuHistory_At(history, lo);
+    *b = *ImuHistory_At(history, hi);
+    return ImuHistoryFind_Between;
+}
+
+/**
+ * 查询 t_us 时刻的姿态. 早于缓存时返回最旧样本; 晚于最新样本时外推, 超过 max_predict_us 按上限外推.
+ * 返回 false 表示结果已被截断 (早于缓存或超出外推范围), q 仍会被填写.
+ * 可以在 Push 之外的线程调用, 与 Push 重叠时重读, 插值与外推在快照上完成.
+ */
+bool ImuHistory_Query(ImuHistory *history, uint32_t t_us, ImuQuaternion *q)
+{
+    ImuHistoryEntry a, b;
+    ImuHistoryFind find;
+    uint32_t seq;
+    if (!history)
+    {
+        return false;
+    }
+
+    do
+    {
+        seq = history->seq;
+        IMU_HISTORY_FENCE();
+        find = (seq & 1u) ? ImuHistoryFind_Empty : ImuHistory_Find(history, t_us, &a, &b);
+        IMU_HISTORY_FENCE();
+    } while ((seq & 1u) || seq != history->seq);
+
+    if (ImuHistoryFind_Empty == find)
+    {
+        return false;
+    }
+    if (ImuHistoryFind_After == find)
+    {
+        int32_t ahead = IMU_HISTORY_DT(t_us, a.t_us);
+        bool ret = (uint32_t)ahead <= history->max_predict_us;
+        ImuHistory_Predict(&a, (ret ? ahead : (int32_t)history->max_predict_us) * 1e-6f, q);
+        return ret;
+    }
+    if (ImuHistoryFind_Before == find)
+    {
+        ImuHistory_Output(a.q, q);
+        return false;
+    }
+
+    int32_t span = IMU_HISTORY_DT(b.t_us, a.t_us);
+    imu_real_t frac = (span > 0) ? (imu_real_t)IMU_HISTORY_DT(t_us, a.t_us) / (imu_real_t)span : IMU_REAL(0.0);
+    ImuHistory_Slerp(a.q, b.q, frac, q);
+    return true;
+}
+
+bool Imu_GetAttitudeAt(Imu *imu, uint32_t t_us, ImuQuaternion *q)
+{
+    return ImuHistory_Query(imu->history, t_us, q);
+}
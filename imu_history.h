@@ -0,0 +1,39 @@
+/**
+ * @file imu_history.h
+ * @author Wyatt Yu
+ * @brief 姿态历史缓存与按时间戳查询 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_HISTORY_H__
+#define __IMU_HISTORY_H__
+#include "imu.h"
+
+#define IMU_HISTORY_SIZE            32          // 200Hz 下约 160ms
+#define IMU_HISTORY_MAX_PREDICT_US  20000       // 默认最多向前外推 20ms
+
+typedef struct ImuHistoryEntry_ {
+    uint32_t t_us;
+    imu_real_t q[4];            // q0, q1, q2, q3
+    imu_real_t gyro[3];         // 扣除零偏后的角速度, rad/s
+}ImuHistoryEntry;
+
+/**
+ * 单写多读: 融合线程 Push, 其他线程 (相机, 执行器) Query, 用顺序锁同步.
+ * 写入前后 seq 各加 1, 奇数表示正在写入; Query 在 seq 为偶数且前后一致时才采用读到的数据, 否则重读.
+ * 写入方不会被读取方阻塞, 多个线程同时 Push 需要调用者自行加锁.
+ */
+struct ImuHistory_ {
+    ImuHistoryEntry entry[IMU_HISTORY_SIZE];
+    int32_t head;               // 下一次写入位置
+    int32_t count;
+    uint32_t max_predict_us;
+    volatile uint32_t seq;
+};
+
+void ImuHistory_Init(ImuHistory *history, uint32_t max_predict_us);
+void ImuHistory_Push(ImuHistory *history, uint32_t t_us, const ImuQuaternion *q, const imu_real_t gyro[3]);
+bool ImuHistory_Query(ImuHistory *history, uint32_t t_us, ImuQuaternion *q);
+bool Imu_GetAttitudeAt(Imu *imu, uint32_t t_us, ImuQuaternion *q);
+
+#endif
@@ -0,0 +1,435 @@
+/**
+ * @file imu_linux.c
+ * @author Wyatt Yu
+ * @brief Linux 用户态 i2c-dev 后端
+ * @copyright Copyright (c) 2025
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "imu_linux.h"
+
+static ImuLinuxI2c *imu_linux_i2c = NULL;
+
+static int ImuLinuxI2c_Ioctl(void *ctx, unsigned long request, void *arg)
+{
+    return ioctl(((ImuLinuxI2c *)ctx)->fd, request, arg);
+}
+
+static int ImuLinuxI2c_Call(ImuLinuxI2c *i2c, unsigned long request, void *arg)
+{
+    i2c->ioctls++;
+    int ret = i2c->ioctl(i2c->ctx, request, arg);
+    if (ret < 0)
+    {
+        i2c->errors++;
+        i2c->last_errno = errno;
+    }
+    return ret;
+}
+
+// 查询控制器功能, 两种方式都不支持时失败
+static bool ImuLinuxI2c_Probe(ImuLinuxI2c *i2c)
+{
+    i2c->slave = -1;
+    if (ImuLinuxI2c_Call(i2c, I2C_FUNCS, &i2c->funcs) < 0)
+    {
+        return false;
+    }
+    i2c->rdwr = (i2c->funcs & I2C_FUNC_I2C) != 0;
+    return i2c->rdwr || (i2c->funcs & I2C_FUNC_SMBUS_I2C_BLOCK) == I2C_FUNC_SMBUS_I2C_BLOCK;
+}
+
+bool ImuLinuxI2c_Open(ImuLinuxI2c *i2c, const char *path)
+{
+    if (!i2c || !path)
+    {
+        return false;
+    }
+
+    memset(i2c, 0, sizeof(ImuLinuxI2c));
+    i2c->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (i2c->fd < 0)
+    {
+        i2c->last_errno = errno;
+        return false;
+    }
+    i2c->ioctl = ImuLinuxI2c_Ioctl;
+    i2c->ctx = i2c;
+    if (!ImuLinuxI2c_Probe(i2c))
+    {
+        ImuLinuxI2c_Close(i2c);
+        return false;
+    }
+    return true;
+}
+
+// 使用调用者提供的 ioctl, 用于模拟器件
+bool ImuLinuxI2c_Attach(ImuLinuxI2c *i2c, ImuLinuxI2c_IoctlFunc ioctl, void *ctx)
+{
+    if (!i2c || !ioctl)
+    {
+        return false;
+    }
+
+    memset(i2c, 0, sizeof(ImuLinuxI2c));
+    i2c->fd = -1;
+    i2c->ioctl = ioctl;
+    i2c->ctx = ctx;
+    return ImuLinuxI2c_Probe(i2c);
+}
+
+void ImuLinuxI2c_Close(ImuLinuxI2c *i2c)
+{
+    if (i2c && i2c->fd >= 0)
+    {
+        close(i2c->fd);
+        i2c->fd = -1;
+    }
+    if (imu_linux_i2c == i2c)
+    {
+        imu_linux_i2c = NULL;
+    }
+}
+
+static bool ImuLinuxI2c_SetSlave(ImuLinuxI2c *i2c, uint8_t addr)
+{
+    if (i2c->slave == addr)
+    {
+        return true;
+    }
+    if (ImuLinuxI2c_Call(i2c, I2C_SLAVE, (void *)(uintptr_t)addr) < 0)
+    {
+        i2c->slave = -1;
+        return false;
+    }
+    i2c->slave = addr;
+    return true;
+}
+
+static bool ImuLinuxI2c_Smbus(ImuLinuxI2c *i2c, uint8_t addr, uint8_t read_write, uint8_t command, uint32_t size,
+                              union i2c_smbus_data *data)
+{
+    struct i2c_smbus_ioctl_data args;
+    args.read_write = read_write;
+    args.command = command;
+    args.size = size;
+    args.data = data;
+    return ImuLinuxI2c_SetSlave(i2c, addr) && ImuLinuxI2c_Call(i2c, I2C_SMBUS, &args) >= 0;
+}
+
+// 寄存器地址之后连续读写, 超过块长度时按地址递增拆分
+static bool ImuLinuxI2c_SmbusBlock(ImuLinuxI2c *i2c, uint8_t addr, uint8_t read_write, uint8_t reg, uint8_t *data,
+                                   uint32_t length)
+{
+    union i2c_smbus_data block;
+    while (length > 0)
+    {
+        uint32_t n = (length > IMU_LINUX_SMBUS_BLOCK) ? IMU_LINUX_SMBUS_BLOCK : length;
+        block.block[0] = (uint8_t)n;
+        if (I2C_SMBUS_WRITE == read_write)
+        {
+            memcpy(&block.block[1], data, n);
+        }
+        if (!ImuLinuxI2c_Smbus(i2c, addr, read_write, reg, I2C_SMBUS_I2C_BLOCK_DATA, &block))
+        {
+            return false;
+        }
+        if (I2C_SMBUS_READ == read_write)
+        {
+            memcpy(data, &block.block[1], n);
+        }
+        reg = (uint8_t)(reg + n);
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+/**
+ * SMBus 只能表达 "写寄存器地址 + 读" 与 "寄存器地址 + 数据" 两种事务, 消息按这两种形式逐条解释,
+ * 不同地址之间不能合并, ImuBus 应保持 combined = false.
+ */
+static bool ImuLinuxI2c_SmbusTransfer(ImuLinuxI2c *i2c, ImuBusMsg *msgs, int32_t count)
+{
+    int32_t i = 0;
+    while (i < count)
+    {
+        ImuBusMsg *m = &msgs[i];
+        if ((m->flags & IMU_BUS_RD) || 0 == m->length)
+        {
+            return false;
+        }
+        if (i + 1 < count && 1 == m->length && (msgs[i + 1].flags & IMU_BUS_RD) && msgs[i + 1].addr == m->addr)
+        {
+            if (!ImuLinuxI2c_SmbusBlock(i2c, m->addr, I2C_SMBUS_READ, m->data[0], msgs[i + 1].data,
+                                        msgs[i + 1].length))
+            {
+                return false;
+            }
+            i += 2;
+        }
+        else if (1 == m->length)
+        {
+            // 只设置寄存器指针
+            if (!ImuLinuxI2c_Smbus(i2c, m->addr, I2C_SMBUS_WRITE, m->data[0], I2C_SMBUS_BYTE, NULL))
+            {
+                return false;
+            }
+            i++;
+        }
+        else
+        {
+            if (!ImuLinuxI2c_SmbusBlock(i2c, m->addr, I2C_SMBUS_WRITE, m->data[0], &m->data[1], m->length - 1u))
+            {
+                return false;
+            }
+            i++;
+        }
+    }
+    return true;
+}
+
+// 按顺序执行 count 条消息, 消息之间为重复起始, I2C_RDWR 时整组只有一次 ioctl
+bool ImuLinuxI2c_Transfer(void *ctx, ImuBusMsg *msgs, int32_t count)
+{
+    ImuLinuxI2c *i2c = (ImuLinuxI2c *)ctx;
+    if (!i2c || !msgs || count <= 0 || count > IMU_LINUX_MAX_MSGS)
+    {
+        return false;
+    }
+    if (!i2c->rdwr)
+    {
+        return ImuLinuxI2c_SmbusTransfer(i2c, msgs, count);
+    }
+
+    struct i2c_msg m[IMU_LINUX_MAX_MSGS];
+    struct i2c_rdwr_ioctl_data args;
+    for (int32_t i = 0; i < count; i++)
+    {
+        m[i].addr = msgs[i].addr;
+        m[i].flags = (msgs[i].flags & IMU_BUS_RD) ? I2C_M_RD : 0;
+        m[i].len = msgs[i].length;
+        m[i].buf = msgs[i].data;
+    }
+    args.msgs = m;
+    args.nmsgs = (uint32_t)count;
+    return ImuLinuxI2c_Call(i2c, I2C_RDWR, &args) == count;
+}
+
+bool ImuLinuxI2c_Read(ImuLinuxI2c *i2c, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    ImuBusMsg msgs[2];
+    if (length > 0xFFFF)
+    {
+        return false;
+    }
+    msgs[0].addr = addr;
+    msgs[0].flags = 0;
+    msgs[0].length = 1;
+    msgs[0].data = &reg;
+    msgs[1].addr = addr;
+    msgs[1].flags = IMU_BUS_RD;
+    msgs[1].length = (uint16_t)length;
+    msgs[1].data = data;
+    return ImuLinuxI2c_Transfer(i2c, msgs, 2);
+}
+
+// 寄存器地址与数据拼成一条消息, 不依赖控制器支持 I2C_M_NOSTART
+bool ImuLinuxI2c_Write(ImuLinuxI2c *i2c, uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t length)
+{
+    uint8_t buf[1 + IMU_LINUX_MAX_WRITE];
+    ImuBusMsg msg;
+    if (length > IMU_LINUX_MAX_WRITE)
+    {
+        return false;
+    }
+    buf[0] = reg;
+    memcpy(&buf[1], data, length);
+    msg.addr = addr;
+    msg.flags = 0;
+    msg.length = (uint16_t)(length + 1u);
+    msg.data = buf;
+    return ImuLinuxI2c_Transfer(i2c, &msg, 1);
+}
+
+// 驱动回调没有上下文, 经由 imu_linux_i2c 转发
+static bool ImuLinux_MemRead(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    return imu_linux_i2c && ImuLinuxI2c_Read(imu_linux_i2c, addr, reg, data, length);
+}
+
+static bool ImuLinux_MemWrite(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    return imu_linux_i2c && ImuLinuxI2c_Write(imu_linux_i2c, addr, reg, data, length);
+}
+
+static bool ImuLinux_Itg3205Read(uint8_t addr, uint8_t reg, uint8_t *data, int32_t length)
+{
+    return length >= 0 && ImuLinux_MemRead(addr, reg, data, (uint32_t)length);
+}
+
+static bool ImuLinux_Itg3205Write(uint8_t addr, uint8_t reg, uint8_t *data, int32_t length)
+{
+    return length >= 0 && ImuLinux_MemWrite(addr, reg, data, (uint32_t)length);
+}
+
+// 只登记回调, 芯片初始化仍由 Xxx_Init 或 ImuStartup 完成, 不使用的芯片传 NULL
+void ImuLinux_Register(ImuLinuxI2c *i2c, Adlx345 *accel, Itg3205 *gyro, Qmc5883l *magic)
+{
+    imu_linux_i2c = i2c;
+    if (accel)
+    {
+        Adlx345_Register(accel, ImuLinux_MemRead, ImuLinux_MemWrite);
+    }
+    if (gyro)
+    {
+        Itg3205_Register(gyro, ImuLinux_Itg3205Read, ImuLinux_Itg3205Write);
+    }
+    if (magic)
+    {
+        Qmc5883l_Register(magic, ImuLinux_MemRead, ImuLinux_MemWrite);
+    }
+}
+
+static uint64_t ImuLinux_NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t ImuLinux_NowUs(void)
+{
+    return (uint32_t)(ImuLinux_NowNs() / 1000u);
+}
+
+/**
+ * I2C_RDWR 本身就能在一次传输中处理不同地址的消息, 支持时打开合并传输.
+ * 内核 i2c 核心在每次 ioctl 内部持有适配器锁, 同一节拍的读取不会被其他进程插入, 不需要额外加锁.
+ */
+void ImuBus_InitLinux(ImuBus *bus, ImuLinuxI2c *i2c)
+{
+    ImuBus_Init(bus, ImuLinuxI2c_Transfer, i2c, ImuLinux_NowUs);
+    if (bus && i2c)
+    {
+        bus->combined = i2c->rdwr;
+    }
+}
+
+static void ImuLinuxSampler_SetTime(struct timespec *ts, uint64_t ns)
+{
+    ts->tv_sec = (time_t)(ns / 1000000000u);
+    ts->tv_nsec = (long)(ns % 1000000000u);
+}
+
+// 按绝对时刻唤醒, 节拍不随回调耗时漂移; 一次读到多个到期计数说明错过了节拍, 不补执行
+static void *ImuLinuxSampler_Thread(void *arg)
+{
+    ImuLinuxSampler *s = (ImuLinuxSampler *)arg;
+    uint64_t expired = 0;
+    uint64_t due = 0;           // 已到期的节拍数, 含错过的
+
+    while (s->running)
+    {
+        if (read(s->timer_fd, &expired, sizeof(expired)) != (ssize_t)sizeof(expired))
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            break;
+        }
+        due += expired;
+        s->overruns += expired - 1u;
+        uint64_t plan = s->start_ns + (due - 1u) * s->period_us * 1000u;
+        uint64_t now = ImuLinux_NowNs();
+        uint32_t latency = (now > plan) ? (uint32_t)((now - plan) / 1000u) : 0;
+        s->latency_sum_us += latency;
+        s->latency_max_us = (latency > s->latency_max_us) ? latency : s->latency_max_us;
+
+        s->func(s->arg);
+        s->ticks++;
+    }
+    return NULL;
+}
+
+/**
+ * 启动采样线程, priority 为 1 ~ 99 时请求 SCHED_FIFO, 创建失败 (通常为 EPERM) 时以普通线程运行.
+ * 第一个节拍在一个周期之后.
+ */
+bool ImuLinuxSampler_Start(ImuLinuxSampler *s, uint32_t rate_hz, int32_t priority, ImuLinuxSampler_Func func,
+                           void *arg)
+{
+    struct itimerspec spec;
+    pthread_attr_t attr;
+    int ret = -1;
+    if (!s || !func || 0 == rate_hz || rate_hz > 1000000u)
+    {
+        return false;
+    }
+
+    memset(s, 0, sizeof(ImuLinuxSampler));
+    s->period_us = 1000000u / rate_hz;
+    s->priority = priority;
+    s->func = func;
+    s->arg = arg;
+    s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (s->timer_fd < 0)
+    {
+        return false;
+    }
+    s->start_ns = ImuLinux_NowNs() + s->period_us * 1000u;
+    ImuLinuxSampler_SetTime(&spec.it_value, s->start_ns);
+    ImuLinuxSampler_SetTime(&spec.it_interval, (uint64_t)s->period_us * 1000u);
+    if (timerfd_settime(s->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0)
+    {
+        close(s->timer_fd);
+        return false;
+    }
+
+    s->running = true;
+    if (priority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+        ret = pthread_create(&s->thread, &attr, ImuLinuxSampler_Thread, s);
+        pthread_attr_destroy(&attr);
+        s->realtime = (0 == ret);
+    }
+    if (0 != ret)
+    {
+        ret = pthread_create(&s->thread, NULL, ImuLinuxSampler_Thread, s);
+    }
+    if (0 != ret)
+    {
+        s->running = false;
+        close(s->timer_fd);
+        return false;
+    }
+    return true;
+}
+
+// 线程在下一个节拍醒来后退出, 最多等待一个周期
+void ImuLinuxSampler_Stop(ImuLinuxSampler *s)
+{
+    if (s && s->running)
+    {
+        s->running = false;
+        pthread_join(s->thread, NULL);
+        close(s->timer_fd);
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file imu_linux.h
+ * @author Wyatt Yu
+ * @brief Linux 用户态 i2c-dev 后端 头文件
+ *
+ * 通过 /dev/i2c-N 访问三个芯片, 与 RT-Thread 下的 imu_sensor.c 地位相同, 不参与 SConscript 构建.
+ * 寄存器读为 "写寄存器地址 + 重复起始 + 读" 的组合传输, 用一次 I2C_RDWR ioctl 完成,
+ * 而不是 write() + read() 两次系统调用, 两次独立的总线事务. ImuBus 合并传输时,
+ * 同一节拍内所有芯片的读取放在同一次 I2C_RDWR 中, 每节拍只有一次系统调用.
+ * 控制器不支持 I2C_FUNC_I2C 时 (如内核 i2c-stub) 退回 SMBus I2C 块读写, 每次寄存器读仍是一次组合传输,
+ * 块长度上限 32 字节, 更长的读写按寄存器地址自动递增拆分.
+ *
+ * 驱动回调没有上下文参数, ImuLinux_Register 把同一个 ImuLinuxI2c 注册给三个驱动, 进程内只支持一条总线.
+ * ioctl 可以替换为用户态模拟器件 (见 tools/imu_i2c_mock.h), 不需要硬件即可运行整条读取链路.
+ *
+ * ImuLinuxSampler 以 timerfd 绝对时刻定时唤醒采样线程, 可选 SCHED_FIFO 优先级,
+ * 没有权限时退回普通调度并清除 realtime 标志. 需要稳定的实时性时调用者还应 mlockall 并隔离 CPU.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_LINUX_H__
+#define __IMU_LINUX_H__
+#include <pthread.h>
+#include "imu.h"
+#include "imu_bus.h"
+
+#define IMU_LINUX_MAX_MSGS          (IMU_BUS_MAX_SLOTS * 2)
+#define IMU_LINUX_MAX_WRITE         64          // 单次寄存器写的数据长度上限
+#define IMU_LINUX_SMBUS_BLOCK       32          // I2C_SMBUS_BLOCK_MAX
+
+// 与 ioctl(fd, request, arg) 语义相同, 失败返回 -1 并设置 errno
+typedef int (*ImuLinuxI2c_IoctlFunc)(void *ctx, unsigned long request, void *arg);
+
+typedef struct ImuLinuxI2c_ {
+    int fd;                     // 使用模拟器件时为 -1
+    unsigned long funcs;        // I2C_FUNCS
+    bool rdwr;                  // 使用 I2C_RDWR, 否则为 SMBus I2C 块读写
+    int32_t slave;              // SMBus 方式下当前 I2C_SLAVE 地址, -1 表示未设置
+    ImuLinuxI2c_IoctlFunc ioctl;
+    void *ctx;
+    uint32_t ioctls;            // 已发出的 ioctl 次数
+    uint32_t errors;
+    int last_errno;
+}ImuLinuxI2c;
+
+typedef void (*ImuLinuxSampler_Func)(void *arg);
+
+typedef struct ImuLinuxSampler_ {
+    pthread_t thread;
+    int timer_fd;
+    uint32_t period_us;
+    int32_t priority;           // 请求的 SCHED_FIFO 优先级, 0 为普通线程
+    bool realtime;              // 实际以 SCHED_FIFO 运行
+    volatile bool running;
+    ImuLinuxSampler_Func func;
+    void *arg;
+    uint64_t start_ns;          // 第一个节拍的计划时刻, CLOCK_MONOTONIC
+    uint64_t ticks;             // 已执行的节拍
+    uint64_t overruns;          // 一次唤醒时 timerfd 已到期多次, 错过的节拍数
+    uint32_t latency_max_us;    // 唤醒时刻相对计划节拍的延迟
+    uint64_t latency_sum_us;
+}ImuLinuxSampler;
+
+bool ImuLinuxI2c_Open(ImuLinuxI2c *i2c, const char *path);
+bool ImuLinuxI2c_Attach(ImuLinuxI2c *i2c, ImuLinuxI2c_IoctlFunc ioctl, void *ctx);
+void ImuLinuxI2c_Close(ImuLinuxI2c *i2c);
+bool ImuLinuxI2c_Transfer(void *ctx, ImuBusMsg *msgs, int32_t count);   // 与 ImuBus_TransferFunc 兼容
+bool ImuLinuxI2c_Read(ImuLinuxI2c *i2c, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length);
+bool ImuLinuxI2c_Write(ImuLinuxI2c *i2c, uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t length);
+
+void ImuLinux_Register(ImuLinuxI2c *i2c, Adlx345 *accel, Itg3205 *gyro, Qmc5883l *magic);
+uint32_t ImuLinux_NowUs(void);      // CLOCK_MONOTONIC, 与 ImuBus_ClockFunc / ImuStartup_ClockFunc 兼容
+void ImuBus_InitLinux(ImuBus *bus, ImuLinuxI2c *i2c);
+
+bool ImuLinuxSampler_Start(ImuLinuxSampler *s, uint32_t rate_hz, int32_t priority, ImuLinuxSampler_Func func,
+                           void *arg);
+void ImuLinuxSampler_Stop(ImuLinuxSampler *s);
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file imu_regcache.c
+ * @author Wyatt Yu
+ * @brief 传感器寄存器影子缓存, 记录器件寄存器的已知值与待写值, 合并相邻寄存器的写操作
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_regcache.h"
+
+#define IMU_REGCACHE_BIT(i)     ((uint64_t)1 << (i))
+
+static bool ImuRegCache_Index(const ImuRegCache *cache, uint8_t reg, uint8_t *index)
+{
+    if (reg >= cache->base && reg - cache->base < cache->count)
+    {
+        *index = reg - cache->base;
+        return true;
+    }
+    return false;
+}
+
+void ImuRegCache_Init(ImuRegCache *cache, uint8_t base, uint8_t count, uint8_t *storage)
+{
+    cache->base = base;
+    cache->count = (count > IMU_REGCACHE_MAX) ? IMU_REGCACHE_MAX : count;
+    cache->value = storage;
+    memset(storage, 0, cache->count);
+    ImuRegCache_Invalidate(cache);
+}
+
+// 器件复位或上电后调用, 之后的每次 Set 都会写入器件
+void ImuRegCache_Invalidate(ImuRegCache *cache)
+{
+    cache->valid = 0;
+    cache->dirty = 0;
+}
+
+bool ImuRegCache_Set(ImuRegCache *cache, uint8_t reg, uint8_t value)
+{
+    uint8_t i;
+    if (!ImuRegCache_Index(cache, reg, &i))
+    {
+        return false;
+    }
+    if ((cache->valid & IMU_REGCACHE_BIT(i)) && cache->value[i] == value)
+    {
+        return false;           // 已是期望值, 不需要写
+    }
+    cache->value[i] = value;
+    cache->valid |= IMU_REGCACHE_BIT(i);
+    cache->dirty |= IMU_REGCACHE_BIT(i);
+    return true;
+}
+
+// 只修改 mask 内的位, 寄存器值未知时其余位按 0 处理
+bool ImuRegCache_Update(ImuRegCache *cache, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t old = 0;
+    ImuRegCache_Get(cache, reg, &old);
+    return ImuRegCache_Set(cache, reg, (old & ~mask) | (value & mask));
+}
+
+bool ImuRegCache_Get(const ImuRegCache *cache, uint8_t reg, uint8_t *value)
+{
+    uint8_t i;
+    if (ImuRegCache_Index(cache, reg, &i) && (cache->valid & IMU_REGCACHE_BIT(i)))
+    {
+        *value = cache->value[i];
+        return true;
+    }
+    return false;
+}
+
+// 找到第一段连续的脏寄存器, 驱动用一次突发写入 [reg, reg + length)
+bool ImuRegCache_NextDirty(const ImuRegCache *cache, uint8_t *reg, uint8_t *length)
+{
+    uint8_t i = 0;
+    uint8_t n = 0;
+    if (0 == cache->dirty)
+    {
+        return false;
+    }
+    while (!(cache->dirty & IMU_REGCACHE_BIT(i)))
+    {
+        i++;
+    }
+    while (i + n < cache->count && (cache->dirty & IMU_REGCACHE_BIT(i + n)))
+    {
+        n++;
+    }
+    *reg = cache->base + i;
+    *length = n;
+    return true;
+}
+
+uint8_t *ImuRegCache_Data(ImuRegCache *cache, uint8_t reg)
+{
+    uint8_t i;
+    return ImuRegCache_Index(cache, reg, &i) ? &cache->value[i] : NULL;
+}
+
+void ImuRegCache_Clean(ImuRegCache *cache, uint8_t reg, uint8_t length)
+{
+    uint8_t i;
+    while (length-- && ImuRegCache_Index(cache, reg++, &i))
+    {
+        cache->dirty &= ~IMU_REGCACHE_BIT(i);
+    }
+}
+
+/**
+ * 用器件读回的数据核对缓存, 返回不一致的寄存器个数.
+ * resync 为 true 时不一致的寄存器标记为脏, 下次同步时写回缓存值;
+ * 否则以器件为准更新缓存. 未缓存过的寄存器直接采用读回值.
+ */
+int32_t ImuRegCache_Fill(ImuRegCache *cache, uint8_t reg, const uint8_t *data, uint8_t length, bool resync)
+{
+    int32_t mismatch = 0;
+    uint8_t i;
+    for (uint8_t k = 0; k < length && ImuRegCache_Index(cache, reg + k, &i); k++)
+    {
+        uint64_t bit = IMU_REGCACHE_BIT(i);
+        if (cache->dirty & bit)
+        {
+            continue;           // 尚未写入, 以缓存为准
+        }
+        if ((cache->valid & bit) && cache->value[i] != data[k])
+        {
+            mismatch++;
+            if (resync)
+            {
+                cache->dirty |= bit;
+                continue;
+            }
+        }
+        cache->value[i] = data[k];
+        cache->valid |= bit;
+    }
+    return mismatch;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file imu_regcache.h
+ * @author Wyatt Yu
+ * @brief 传感器寄存器影子缓存 头文件
+ *
+ * 缓存只记录寄存器值与状态, 不做总线访问, 各驱动用自己的 read/write 完成读写:
+ *   ImuRegCache_Set() 修改期望值, 与已知的器件值相同则不产生写操作
+ *   ImuRegCache_NextDirty() 取出连续的脏寄存器, 驱动一次突发写入后 ImuRegCache_Clean()
+ *   ImuRegCache_Fill() 用器件读回的数据刷新缓存
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_REGCACHE_H__
+#define __IMU_REGCACHE_H__
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMU_REGCACHE_MAX        64
+
+typedef struct ImuRegCache_ {
+    uint8_t base;               // 第一个寄存器地址
+    uint8_t count;              // 寄存器个数, <= IMU_REGCACHE_MAX
+    uint8_t *value;             // 调用者提供的 count 字节存储
+    uint64_t valid;             // bit i: value[i] 与器件一致或即将写入
+    uint64_t dirty;             // bit i: value[i] 尚未写入器件
+}ImuRegCache;
+
+void ImuRegCache_Init(ImuRegCache *cache, uint8_t base, uint8_t count, uint8_t *storage);
+void ImuRegCache_Invalidate(ImuRegCache *cache);
+bool ImuRegCache_Set(ImuRegCache *cache, uint8_t reg, uint8_t value);
+bool ImuRegCache_Update(ImuRegCache *cache, uint8_t reg, uint8_t mask, uint8_t value);
+bool ImuRegCache_Get(const ImuRegCache *cache, uint8_t reg, uint8_t *value);
+bool ImuRegCache_NextDirty(const ImuRegCache *cache, uint8_t *reg, uint8_t *length);
+uint8_t *ImuRegCache_Data(ImuRegCache *cache, uint8_t reg);
+void ImuRegCache_Clean(ImuRegCache *cache, uint8_t reg, uint8_t length);
+int32_t ImuRegCache_Fill(ImuRegCache *cache, uint8_t reg, const uint8_t *data, uint8_t length, bool resync);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
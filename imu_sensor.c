@@ -0,0 +1,179 @@
+/**
+ * @file imu_sensor.c
+ * @author Wyatt Yu
+ * @brief 通过 RT-Thread 传感器框架设备读取 IMU 数据
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_sensor.h"
+
+bool ImuSensor_I2cRead(struct rt_i2c_bus_device *bus, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    struct rt_i2c_msg msgs[2];
+    msgs[0].addr  = addr;
+    msgs[0].flags = RT_I2C_WR;
+    msgs[0].buf   = &reg;
+    msgs[0].len   = 1;
+    msgs[1].addr  = addr;
+    msgs[1].flags = RT_I2C_RD;
+    msgs[1].buf   = data;
+    msgs[1].len   = (rt_uint16_t)length;
+    return bus && 2 == rt_i2c_transfer(bus, msgs, 2);
+}
+
+bool ImuSensor_I2cWrite(struct rt_i2c_bus_device *bus, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    // 寄存器地址与数据在同一次传输中发出, 数据段不再产生起始条件
+    struct rt_i2c_msg msgs[2];
+    msgs[0].addr  = addr;
+    msgs[0].flags = RT_I2C_WR;
+    msgs[0].buf   = &reg;
+    msgs[0].len   = 1;
+    msgs[1].addr  = addr;
+    msgs[1].flags = RT_I2C_WR | RT_I2C_NO_START;
+    msgs[1].buf   = data;
+    msgs[1].len   = (rt_uint16_t)length;
+    return bus && 2 == rt_i2c_transfer(bus, msgs, 2);
+}
+
+rt_err_t ImuSensor_Open(ImuSensor *s, const char *accel, const char *gyro, const char *magic)
+{
+    if (!s || !accel || !gyro)
+    {
+        return -RT_EINVAL;
+    }
+
+    memset(s, 0, sizeof(ImuSensor));
+    s->accel = rt_device_find(accel);
+    s->gyro = rt_device_find(gyro);
+    s->magic = magic ? rt_device_find(magic) : RT_NULL;
+    if (RT_NULL == s->accel || RT_NULL == s->gyro || (magic && RT_NULL == s->magic))
+    {
+        return -RT_ERROR;
+    }
+
+    // 加速度计优先用 FIFO 模式, 设备不支持或没有配置中断引脚时退回轮询
+    if (RT_EOK != rt_device_open(s->accel, RT_DEVICE_FLAG_FIFO_RX) &&
+        RT_EOK != rt_device_open(s->accel, RT_DEVICE_FLAG_RDONLY))
+    {
+        return -RT_EIO;
+    }
+    rt_uint16_t odr = ((rt_sensor_t)s->accel)->config.odr;
+    s->accel_period = (odr > 0) ? 1000u / odr : 0;
+    if (RT_EOK != rt_device_open(s->gyro, RT_DEVICE_FLAG_RDONLY))
+    {
+        rt_device_close(s->accel);
+        return -RT_EIO;
+    }
+    if (s->magic)
+    {
+        if (RT_EOK != rt_device_open(s->magic, RT_DEVICE_FLAG_RDONLY))
+        {
+            rt_device_close(s->accel);
+            rt_device_close(s->gyro);
+            return -RT_EIO;
+        }
+        odr = ((rt_sensor_t)s->magic)->config.odr;
+        s->magic_period = (odr > 0) ? 1000u / odr : 0;
+    }
+    return RT_EOK;
+}
+
+void ImuSensor_Close(ImuSensor *s)
+{
+    if (s)
+    {
+        rt_device_close(s->accel);
+        rt_device_close(s->gyro);
+        if (s->magic)
+        {
+            rt_device_close(s->magic);
+        }
+    }
+}
+
+void ImuSensor_SetClock(ImuSensor *s, ImuSensor_ClockFunc now_us)
+{
+    if (s)
+    {
+        s->now_us = now_us;
+    }
+}
+
+// 上次读到数据的时刻距 now 是否仍在失效时间之内, 单位 ms
+static bool ImuSensor_Alive(bool read, rt_uint32_t time, rt_uint32_t period, rt_uint32_t now)
+{
+    rt_uint32_t limit = IMU_SENSOR_STALE * period;
+    limit = (limit > IMU_SENSOR_STALE_MIN) ? limit : IMU_SENSOR_STALE_MIN;
+    return read && (now - time) <= limit;
+}
+
+bool ImuSensor_Read(void *ctx, ImuSource *source)
+{
+    ImuSensor *s = (ImuSensor *)ctx;
+    struct rt_sensor_data *d = s->buf;
+    rt_size_t n;
+
+    // 陀螺仪决定节拍, 读失败则本节拍无效
+    if (1 != rt_device_read(s->gyro, 0, d, 1))
+    {
+        return false;
+    }
+    s->last.gyro.x = DEGREE2RAD((imu_real_t)d->data.gyro.x * IMU_REAL(0.001));
+    s->last.gyro.y = DEGREE2RAD((imu_real_t)d->data.gyro.y * IMU_REAL(0.001));
+    s->last.gyro.z = DEGREE2RAD((imu_real_t)d->data.gyro.z * IMU_REAL(0.001));
+    rt_uint32_t now = d->timestamp;
+    s->last.timestamp_us = s->now_us ? s->now_us() : now * 1000u;
+
+    // 节拍内积累的加速度计样本取平均, 相当于一次简单的抗混叠抽取
+    n = rt_device_read(s->accel, 0, d, IMU_SENSOR_BATCH);
+    s->accel_batch = (int32_t)n;
+    if (n > 0)
+    {
+        rt_int32_t sum[3] = {0, 0, 0};
+        for (rt_size_t i = 0; i < n; i++)
+        {
+            sum[0] += d[i].data.acce.x;
+            sum[1] += d[i].data.acce.y;
+            sum[2] += d[i].data.acce.z;
+        }
+        imu_real_t k = GRAVITY * IMU_REAL(0.001) / (imu_real_t)n;
+        s->last.accel.x = (imu_real_t)sum[0] * k;
+        s->last.accel.y = (imu_real_t)sum[1] * k;
+        s->last.accel.z = (imu_real_t)sum[2] * k;
+        s->accel_time = now;
+        s->accel_read = true;
+    }
+    else if (!ImuSensor_Alive(s->accel_read, s->accel_time, s->accel_period, now))
+    {
+        // 读错误同样返回 0, 加速度计持续没有数据时清零, 不再用冻结的重力方向修正姿态
+        s->last.accel.x = IMU_REAL(0.0);
+        s->last.accel.y = IMU_REAL(0.0);
+        s->last.accel.z = IMU_REAL(0.0);
+    }
+    else
+    {
+        // do nothing
+    }
+
+    if (s->magic && (!s->magic_read || (now - s->magic_time) >= s->magic_period))
+    {
+        if (1 == rt_device_read(s->magic, 0, d, 1))
+        {
+            s->last.magic.x = (imu_real_t)d->data.mag.x * IMU_REAL(0.001);
+            s->last.magic.y = (imu_real_t)d->data.mag.y * IMU_REAL(0.001);
+            s->last.magic.z = (imu_real_t)d->data.mag.z * IMU_REAL(0.001);
+            s->magic_time = now;
+            s->magic_read = true;
+        }
+    }
+    else
+    {
+        // do nothing
+    }
+    // 每个节拍重新判断: 磁力计读取持续失败时退回 6 轴融合, 恢复后再启用
+    s->last.use_magic = ImuSensor_Alive(s->magic_read, s->magic_time, s->magic_period, now);
+
+    *source = s->last;
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file imu_sensor.h
+ * @author Wyatt Yu
+ * @brief 通过 RT-Thread 传感器框架设备读取 IMU 数据 头文件
+ *
+ * 各芯片的设备注册见 sensor_adlx345.h / sensor_itg3205.h / sensor_qmc5883l.h.
+ * 陀螺仪决定融合节拍, 每个节拍每个设备只调用一次 rt_device_read:
+ * 加速度计以 FIFO 模式打开时一次读出节拍内积累的全部样本并取平均, 磁力计按自身 ODR 到期才读取.
+ * 设备超过 IMU_SENSOR_STALE 个周期读不到数据时: 加速度清零, Imu_Update 跳过加速度计修正只做陀螺积分;
+ * 磁力计 use_magic 置为 false, 退回 6 轴融合. 读取恢复后自动重新启用.
+ * 传感器框架的时间戳单位为 ms, 默认 timestamp_us 只有 1ms 分辨率; 姿态历史查询需要更细的时刻时,
+ * 用 ImuSensor_SetClock 提供微秒时钟 (与 ImuBus_ClockFunc 兼容), 在读到陀螺仪数据后取时刻.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_SENSOR_H__
+#define __IMU_SENSOR_H__
+#include "imu.h"
+#include "sensor.h"
+
+#define IMU_SENSOR_BATCH            32          // 一次从加速度计读取的最大样本数, 与 ADXL345 FIFO 深度一致
+#define IMU_SENSOR_STALE            2u          // 设备超过这么多个周期没有读到数据时视为失效
+#define IMU_SENSOR_STALE_MIN        20u         // ms, 失效时间下限, ODR 未知或很高时按此判断
+
+typedef uint32_t (*ImuSensor_ClockFunc)(void);
+
+typedef struct ImuSensor_ {
+    rt_device_t accel;
+    rt_device_t gyro;
+    rt_device_t magic;                          // 可选, RT_NULL 表示不使用磁力计
+    rt_uint32_t accel_period;                   // ms, 由加速度计 ODR 决定
+    rt_uint32_t accel_time;                     // 上次读到加速度计数据的时刻, ms
+    bool accel_read;                            // 已经读到过加速度计数据
+    rt_uint32_t magic_period;                   // ms, 由磁力计 ODR 决定
+    rt_uint32_t magic_time;                     // 上次读到磁力计数据的时刻, ms
+    bool magic_read;                            // 已经读到过磁力计数据
+    ImuSensor_ClockFunc now_us;                 // 可选, RT_NULL 时用传感器框架的 ms 时间戳
+    int32_t accel_batch;                        // 本节拍从加速度计读到的样本数, 持续为 IMU_SENSOR_BATCH 说明 FIFO 溢出
+    ImuSource last;                             // 设备本节拍没有新数据时沿用上次的值, 失效后见 ImuSensor_Read
+    struct rt_sensor_data buf[IMU_SENSOR_BATCH];
+}ImuSensor;
+
+rt_err_t ImuSensor_Open(ImuSensor *s, const char *accel, const char *gyro, const char *magic);
+void ImuSensor_Close(ImuSensor *s);
+void ImuSensor_SetClock(ImuSensor *s, ImuSensor_ClockFunc now_us);     // 在 ImuSensor_Open 之后调用
+bool ImuSensor_Read(void *ctx, ImuSource *source);     // 与 ImuArray_ReadFunc 兼容, 输出未校准数据
+
+// 各芯片设备共用的寄存器读写, 寄存器地址之后连续读写 length 字节
+bool ImuSensor_I2cRead(struct rt_i2c_bus_device *bus, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length);
+bool ImuSensor_I2cWrite(struct rt_i2c_bus_device *bus, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length);
+
+static inline rt_int32_t ImuSensor_Round(imu_real_t x)
+{
+    return (rt_int32_t)((x >= IMU_REAL(0.0)) ? (x + IMU_REAL(0.5)) : (x - IMU_REAL(0.5)));
+}
+
+// 芯片 FIFO 中的样本没有时间戳, 以读取时刻作为最新样本, 按 ODR 向前推算 age 个周期
+static inline rt_uint32_t ImuSensor_Backdate(rt_uint32_t now, int32_t age, rt_uint16_t odr)
+{
+    return (odr > 0) ? (now - (rt_uint32_t)age * 1000u / odr) : now;
+}
+
+#endif
@@ -0,0 +1,395 @@
+/**
+ * @file imu_startup.c
+ * @author Wyatt Yu
+ * @brief 传感器上电启动状态机
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_startup.h"
+
+static bool ImuStartup_Expired(uint32_t now, uint32_t deadline)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+static void ImuStartup_Enter(ImuStartupSensor *d, ImuStartupState state, uint32_t now, uint32_t wait_us)
+{
+    d->state = state;
+    d->deadline_us = now + wait_us;
+    d->status = 0;
+}
+
+// 总线错误从探测重新开始, ID 不符不重试
+static void ImuStartup_Retry(ImuStartupSensor *d, uint32_t now)
+{
+    if (++d->retries > IMU_STARTUP_RETRIES)
+    {
+        d->state = ImuStartupState_Failed;
+    }
+    else
+    {
+        ImuStartup_Enter(d, ImuStartupState_Probe, now, IMU_STARTUP_RETRY_US);
+    }
+}
+
+static uint32_t ImuStartup_AccelPeriod(const Adlx345 *m)
+{
+    // 输出频率 3200Hz / 2^(15 - rate)
+    return (10000u << (15 - (m->sample_rate & 0x0F))) / 32u;
+}
+
+static uint32_t ImuStartup_MagicPeriod(const Qmc5883l *m)
+{
+    static const uint32_t period[] = {100000u, 20000u, 10000u, 5000u};
+    return period[m->sample_rate & 0x03];
+}
+
+static void ImuStartup_StepAccel(ImuStartup *s, ImuStartupSensor *d, uint32_t now)
+{
+    Adlx345 *m = s->accel;
+    uint8_t value;
+    switch (d->state)
+    {
+        case ImuStartupState_Probe:
+            if (!ImuStartup_Expired(now, d->deadline_us))
+            {
+                break;
+            }
+            if (!m->read(m->addr, ADLX345_REG_DEVID, &d->id, 1))
+            {
+                ImuStartup_Retry(d, now);
+            }
+            else
+            {
+                // 没有软复位, Adlx345_Init 会重写全部配置
+                d->state = (ADLX345_DEVID == d->id) ? ImuStartupState_Config : ImuStartupState_Failed;
+            }
+            break;
+        case ImuStartupState_Config:
+            Adlx345_Init(m);
+            if (m->inited)
+            {
+                ImuStartup_Enter(d, ImuStartupState_Settle, now, IMU_STARTUP_ADXL_SETTLE_US + ImuStartup_AccelPeriod(m));
+            }
+            else
+            {
+                ImuStartup_Retry(d, now);
+            }
+            break;
+        case ImuStartupState_Settle:
+            // DATA_READY 不受 INT_ENABLE 影响, 读数据寄存器时清除
+            if (Adlx345_ReadIntSource(m, &value))
+            {
+                d->status |= value;
+            }
+            if (d->status & ADLX345_INT_DATA_READY)
+            {
+                d->state = ImuStartupState_Ready;
+            }
+            else if (ImuStartup_Expired(now, d->deadline_us))
+            {
+                d->timeout = true;
+                d->state = ImuStartupState_Ready;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void ImuStartup_StepGyro(ImuStartup *s, ImuStartupSensor *d, uint32_t now)
+{
+    Itg3205 *m = s->gyro;
+    uint8_t value;
+    switch (d->state)
+    {
+        case ImuStartupState_Probe:
+            if (!ImuStartup_Expired(now, d->deadline_us))
+            {
+                break;
+            }
+            if (!m->read(m->addr, ITG3205_REG_DEVID, &d->id, 1))
+            {
+                ImuStartup_Retry(d, now);
+            }
+            else
+            {
+                d->state = (ITG3205_WHO_AM_I == (d->id & ITG3205_WHO_AM_I_MASK)) ? ImuStartupState_Reset :
+                           ImuStartupState_Failed;
+            }
+            break;
+        case ImuStartupState_Reset:
+            if (Itg3205_Reset(m))
+            {
+                ImuStartup_Enter(d, ImuStartupState_Config, now, IMU_STARTUP_ITG_RESET_US);
+            }
+            else
+            {
+                ImuStartup_Retry(d, now);
+            }
+            break;
+        case ImuStartupState_Config:
+            if (!ImuStartup_Expired(now, d->deadline_us))
+            {
+                break;
+            }
+            if (Itg3205ClockSource_Internal == m->clock_source)
+            {
+                m->clock_source = Itg3205ClockSource_PllX;
+            }
+            Itg3205_Init(m);
+            // 临时打开 PLL 就绪与数据就绪, 用 INT_STATUS 判断启动完成
+            if (m->inited && Itg3205_SetInterrupt(m, ITG3205_INT_ITG_RDY | ITG3205_INT_RAW_RDY))
+            {
+                ImuStartup_Enter(d, ImuStartupState_Settle, now, IMU_STARTUP_ITG_SETTLE_US);
+            }
+            else
+            {
+                ImuStartup_Retry(d, now);
+            }
+            break;
+        case ImuStartupState_Settle:
+            // 读 INT_STATUS 会清除标志, 两个标志可能在不同的调用中出现
+            if (Itg3205_ReadIntStatus(m, &value))
+            {
+                d->status |= value;
+            }
+            if ((d->status & (ITG3205_INT_ITG_RDY | ITG3205_INT_RAW_RDY)) == (ITG3205_INT_ITG_RDY | ITG3205_INT_RAW_RDY))
+            {
+                d->state = ImuStartupState_Ready;
+            }
+            else if (ImuStartup_Expired(now, d->deadline_us))
+            {
+                d->timeout = true;
+                d->state = ImuStartupState_Ready;
+            }
+            if (ImuStartupState_Ready == d->state)
+            {
+                Itg3205_SetInterrupt(m, s->gyro_int_cfg);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void ImuStartup_StepMagic(ImuStartup *s, ImuStartupSensor *d, uint32_t now)
+{
+    Qmc5883l *m = s->magic;
+    uint8_t value;
+    switch (d->state)
+    {
+        case ImuStartupState_Probe:
+            if (!ImuStartup_Expired(now, d->deadline_us))
+            {
+                break;
+            }
+            if (!Qmc5883l_Set(m, Qmc5883lCmd_ChipId, 0))
+            {
+                ImuStartup_Retry(d, now);
+            }
+            else
+            {
+                d->id = m->reg.chip_id;
+                d->state = (QMC5883L_CHIP_ID == d->id) ? ImuStartupState_Reset : ImuStartupState_Failed;
+            }
+            break;
+        case ImuStartupState_Reset:
+            if (Qmc5883l_Set(m, Qmc5883lCmd_Reset, 1))
+            {
+                ImuStartup_Enter(d, ImuStartupState_Config, now, IMU_STARTUP_QMC_RESET_US);
+            }
+            else
+            {
+                ImuStartup_Retry(d, now);
+            }
+            break;
+        case ImuStartupState_Config:
+            if (!ImuStartup_Expired(now, d->deadline_us))
+            {
+                break;
+            }
+            if (Qmc5883l_Init(m))
+            {
+                ImuStartup_Enter(d, ImuStartupState_Settle, now, IMU_STARTUP_QMC_SETTLE_US + 2 * ImuStartup_MagicPeriod(m));
+            }
+            else
+            {
+                ImuStartup_Retry(d, now);
+            }
+            break;
+        case ImuStartupState_Settle:
+            if (m->read(QMC5883L_ADDR, QMC5883L_REG_STATUS, &value, 1))
+            {
+                d->status |= value;
+            }
+            if (d->status & QMC5883L_STATUS_DRDY)
+            {
+                d->state = ImuStartupState_Ready;
+            }
+            else if (ImuStartup_Expired(now, d->deadline_us))
+            {
+                d->timeout = true;
+                d->state = ImuStartupState_Ready;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void ImuStartup_Init(ImuStartup *s, Adlx345 *accel, Itg3205 *gyro, Qmc5883l *magic, ImuStartup_ClockFunc now_us)
+{
+    memset((void *)s, 0, sizeof(ImuStartup));
+    s->accel = accel;
+    s->gyro = gyro;
+    s->magic = magic;
+    s->now_us = now_us;
+    s->start_us = now_us();
+    for (int32_t i = 0; i < ImuStartupDevice_Count; i++)
+    {
+        s->dev[i].deadline_us = s->start_us;
+    }
+    s->dev[ImuStartupDevice_Accel].state = (accel && accel->read && accel->write) ? ImuStartupState_Probe :
+                                           ImuStartupState_Absent;
+    s->dev[ImuStartupDevice_Gyro].state = (gyro && gyro->read && gyro->write) ? ImuStartupState_Probe :
+                                          ImuStartupState_Absent;
+    // 复位与 Itg3205_Init 都会丢掉中断配置, 先从缓存中取出, Settle 结束后写回
+    if (!gyro || !ImuRegCache_Get(&gyro->cache, ITG3205_REG_INT_CFG, &s->gyro_int_cfg))
+    {
+        s->gyro_int_cfg = 0;
+    }
+    s->dev[ImuStartupDevice_Magic].state = (magic && magic->read && magic->write) ? ImuStartupState_Probe :
+                                           ImuStartupState_Absent;
+}
+
+/**
+ * 推进所有芯片的状态, 不阻塞, 调用间隔决定等待的分辨率, 建议 1ms 左右.
+ * 所有芯片都已就绪或失败时返回 true.
+ */
+bool ImuStartup_Step(ImuStartup *s)
+{
+    bool done = true;
+    for (int32_t i = 0; i < ImuStartupDevice_Count; i++)
+    {
+        ImuStartupSensor *d = &s->dev[i];
+        if (d->state >= ImuStartupState_Ready)
+        {
+            continue;
+        }
+
+        uint32_t now = s->now_us();
+        if (ImuStartupDevice_Accel == i)
+        {
+            ImuStartup_StepAccel(s, d, now);
+        }
+        else if (ImuStartupDevice_Gyro == i)
+        {
+            ImuStartup_StepGyro(s, d, now);
+        }
+        else
+        {
+            ImuStartup_StepMagic(s, d, now);
+        }
+
+        if (ImuStartupState_Ready == d->state)
+        {
+            s->ready_us[i] = s->now_us() - s->start_us;
+        }
+        done = done && d->state >= ImuStartupState_Ready;
+    }
+    return done;
+}
+
+bool ImuStartup_IsReady(const ImuStartup *s, ImuStartupDevice dev)
+{
+    return ImuStartupState_Ready == s->dev[dev].state;
+}
+
+/**
+ * 先推进状态机, 再读取已就绪芯片的数据, 尚未就绪的芯片保持为 0,
+ * 加速度为 0 时 Imu_Update 只做陀螺积分. 没有任何芯片输出新数据时返回 false.
+ */
+bool ImuStartup_Read(void *ctx, ImuSource *source)
+{
+    ImuStartup *s = (ImuStartup *)ctx;
+    int16_t raw[3];
+    bool fresh = false;
+
+    ImuStartup_Step(s);
+    if (ImuStartup_IsReady(s, ImuStartupDevice_Accel) && Adlx345_ReadRaw(s->accel, raw))
+    {
+        imu_real_t k = Adlx345_GetScale(s->accel);
+        s->last.accel.x = raw[0] * k;
+        s->last.accel.y = raw[1] * k;
+        s->last.accel.z = raw[2] * k;
+        fresh = true;
+    }
+    if (ImuStartup_IsReady(s, ImuStartupDevice_Gyro) && Itg3205_ReadRaw(s->gyro, raw))
+    {
+        imu_real_t k = Itg3205_GetScale(s->gyro);
+        s->last.gyro.x = raw[0] * k;
+        s->last.gyro.y = raw[1] * k;
+        s->last.gyro.z = raw[2] * k;
+        s->last.gyro_temperature = Itg3205_RawToTemperature(s->gyro->raw_data[0]);
+        fresh = true;
+    }
+    if (ImuStartup_IsReady(s, ImuStartupDevice_Magic) && Qmc5883l_ReadRaw(s->magic, raw))
+    {
+        imu_real_t k = Qmc5883l_GetScale(s->magic);
+        s->last.magic.x = raw[0] * k;
+        s->last.magic.y = raw[1] * k;
+        s->last.magic.z = raw[2] * k;
+        s->last.use_magic = true;
+        fresh = true;
+    }
+
+    if (!fresh)
+    {
+        return false;
+    }
+    s->last.timestamp_us = s->now_us();
+    if (!s->sampled)
+    {
+        s->sampled = true;
+        s->sample_us = s->last.timestamp_us - s->start_us;
+    }
+    *source = s->last;
+    return true;
+}
+
+/**
+ * 在 ImuStartup_Read 得到的样本装入 imu->source 之后, Imu_Update 之前调用.
+ * 加速度计就绪后第一次调用即由重力对准, 磁力计就绪后再对准一次航向, 之后不再修改姿态.
+ * 已得到有效姿态时返回 true.
+ */
+bool ImuStartup_Align(ImuStartup *s, Imu *imu)
+{
+    bool magic = ImuStartup_IsReady(s, ImuStartupDevice_Magic) && imu->source.use_magic;
+    bool want_heading = s->dev[ImuStartupDevice_Magic].state < ImuStartupState_Failed;
+
+    if (ImuStartup_IsReady(s, ImuStartupDevice_Accel) && (!s->aligned || (!s->headed && magic)))
+    {
+        if (Imu_Align(imu))
+        {
+            uint32_t t = s->now_us() - s->start_us;
+            if (!s->aligned)
+            {
+                s->aligned = true;
+                s->attitude_us = t;
+            }
+            if (magic)
+            {
+                s->headed = true;
+                s->heading_us = t;
+            }
+        }
+    }
+    if (s->aligned && !s->headed && !want_heading)
+    {
+        // 没有磁力计或磁力计启动失败, 航向只能从 0 开始
+        s->headed = true;
+        s->heading_us = s->attitude_us;
+    }
+    return s->aligned;
+}
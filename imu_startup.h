@@ -0,0 +1,88 @@
+/**
+ * @file imu_startup.h
+ * @author Wyatt Yu
+ * @brief 传感器上电启动状态机 头文件
+ *
+ * 三个芯片各自按 探测 ID -> 软复位 -> 等待 -> 写配置 -> 等待首个样本 的顺序推进,
+ * ImuStartup_Step 每次调用只做不需要等待的总线操作, 三个芯片的等待时间互相重叠.
+ * ITG3205 复位后切换到 PLL 时钟, 以 INT_STATUS 的 ITG_RDY/RAW_RDY 判断就绪, 就绪后恢复启动前的中断配置;
+ * ADXL345 没有软复位, 以 INT_SOURCE.DATA_READY 判断就绪; QMC5883L 以状态寄存器 DRDY 判断就绪.
+ * 每个芯片就绪后 ImuStartup_Read 立即开始输出它的未校准数据, ImuStartup_Align 在加速度计
+ * 就绪后直接由重力解出姿态, 磁力计随后就绪时再对准一次航向.
+ *
+ * 记录的时间均相对 ImuStartup_Init, 单位 us:
+ *   ready_us[]     各芯片就绪
+ *   sample_us      第一次输出样本
+ *   attitude_us    首次得到有效姿态 (横滚/俯仰), 即 time-to-first-attitude
+ *   heading_us     航向对准完成, 没有磁力计时与 attitude_us 相同
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_STARTUP_H__
+#define __IMU_STARTUP_H__
+#include "imu.h"
+#include "adlx345.h"
+#include "itg3205.h"
+#include "qmc5883l.h"
+
+#define IMU_STARTUP_RETRIES         3           // 总线错误后重新探测的次数
+#define IMU_STARTUP_RETRY_US        10000u
+#define IMU_STARTUP_ITG_RESET_US    5000u       // ITG3205 复位到可访问寄存器
+#define IMU_STARTUP_ITG_SETTLE_US   50000u      // ITG3205 陀螺启动时间上限
+#define IMU_STARTUP_ADXL_SETTLE_US  1100u       // ADXL345 进入测量到第一个样本, 另加一个采样周期
+#define IMU_STARTUP_QMC_RESET_US    1000u       // QMC5883L 上电复位 350us, 留余量
+#define IMU_STARTUP_QMC_SETTLE_US   2000u       // 另加两个输出周期
+
+typedef enum {
+    ImuStartupDevice_Accel = 0,
+    ImuStartupDevice_Gyro  = 1,
+    ImuStartupDevice_Magic = 2,
+    ImuStartupDevice_Count,
+}ImuStartupDevice;
+
+typedef enum {
+    ImuStartupState_Probe  = 0,     // 读取并核对 ID
+    ImuStartupState_Reset  = 1,     // 软复位
+    ImuStartupState_Config = 2,     // 等待复位完成后写入配置
+    ImuStartupState_Settle = 3,     // 等待第一个有效样本
+    ImuStartupState_Ready  = 4,
+    ImuStartupState_Failed = 5,     // ID 不符, 或总线错误超过重试次数
+    ImuStartupState_Absent = 6,     // 未配置该芯片
+}ImuStartupState;
+
+typedef uint32_t (*ImuStartup_ClockFunc)(void);
+
+typedef struct ImuStartupSensor_ {
+    ImuStartupState state;
+    uint32_t deadline_us;       // 本状态最早执行 (Probe/Config) 或最迟等待 (Settle) 的时刻
+    uint8_t retries;
+    uint8_t id;                 // 读到的 ID, 用于诊断
+    uint8_t status;             // Settle 期间累积的就绪标志
+    bool timeout;               // Settle 超时仍未看到就绪标志, 按数据手册时间放行
+}ImuStartupSensor;
+
+typedef struct ImuStartup_ {
+    Adlx345 *accel;
+    Itg3205 *gyro;
+    Qmc5883l *magic;            // 可选
+    ImuStartup_ClockFunc now_us;
+    ImuStartupSensor dev[ImuStartupDevice_Count];
+    uint8_t gyro_int_cfg;       // 启动前 Itg3205 已设置的 INT_CFG, 就绪后恢复; 未设置过为 0
+    uint32_t start_us;
+    uint32_t ready_us[ImuStartupDevice_Count];
+    uint32_t sample_us;
+    uint32_t attitude_us;
+    uint32_t heading_us;
+    bool sampled;
+    bool aligned;               // 已由重力对准横滚/俯仰
+    bool headed;                // 已由磁场对准航向
+    ImuSource last;
+}ImuStartup;
+
+void ImuStartup_Init(ImuStartup *s, Adlx345 *accel, Itg3205 *gyro, Qmc5883l *magic, ImuStartup_ClockFunc now_us);
+bool ImuStartup_Step(ImuStartup *s);
+bool ImuStartup_IsReady(const ImuStartup *s, ImuStartupDevice dev);
+bool ImuStartup_Read(void *ctx, ImuSource *source);    // 与 ImuArray_ReadFunc 兼容, 输出未校准数据
+bool ImuStartup_Align(ImuStartup *s, Imu *imu);
+
+#endif
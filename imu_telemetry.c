@@ -0,0 +1,348 @@
+/**
+ * @file imu_telemetry.c
+ * @author Wyatt Yu
+ * @brief 二进制遥测帧编码与解码
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_telemetry.h"
+
+#define IMU_TELEMETRY_QUAT32_BITS   10
+#define IMU_TELEMETRY_QUAT48_BITS   15
+#define IMU_TELEMETRY_SQRT1_2       IMU_REAL(0.70710678118654752)
+
+// CRC-16/CCITT-FALSE, 多项式 0x1021, 每次处理 4 位, 表只占 32 字节
+static const uint16_t imu_telemetry_crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static uint16_t ImuTelemetry_Crc16(const uint8_t *data, int32_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (int32_t i = 0; i < length; i++)
+    {
+        crc = (uint16_t)(crc << 4) ^ imu_telemetry_crc_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ imu_telemetry_crc_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+static void ImuTelemetry_Put(uint8_t *p, uint64_t value, int32_t bytes)
+{
+    for (int32_t i = 0; i < bytes; i++)
+    {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t ImuTelemetry_Get(const uint8_t *p, int32_t bytes)
+{
+    uint64_t value = 0;
+    for (int32_t i = bytes - 1; i >= 0; i--)
+    {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static int16_t ImuTelemetry_Int16(imu_real_t v)
+{
+    v += (v >= IMU_REAL(0.0)) ? IMU_REAL(0.5) : -IMU_REAL(0.5);
+    return (v > IMU_REAL(32767.0)) ? 32767 : (v < -IMU_REAL(32768.0)) ? -32768 : (int16_t)v;
+}
+
+/**
+ * smallest-three: 单位四元数中除绝对值最大的分量外, 其余分量都在 [-1/sqrt2, 1/sqrt2] 内.
+ * 返回 2 位最大分量序号在高位, 其后依次为其余三个分量各 bits 位.
+ */
+uint64_t ImuTelemetry_PackQuat(const imu_real_t q[4], int32_t bits)
+{
+    uint32_t max = (1u << bits) - 1;
+    int32_t largest = 0;
+    for (int32_t i = 1; i < 4; i++)
+    {
+        largest = (IMU_FABS(q[i]) > IMU_FABS(q[largest])) ? i : largest;
+    }
+
+    // q 与 -q 表示同一姿态, 翻转符号使最大分量为正, 解码时不必传符号
+    imu_real_t sign = (q[largest] < IMU_REAL(0.0)) ? -IMU_REAL(1.0) : IMU_REAL(1.0);
+    uint64_t packed = (uint64_t)largest;
+    for (int32_t i = 0; i < 4; i++)
+    {
+        if (i != largest)
+        {
+            imu_real_t u = (sign * q[i] * IMU_TELEMETRY_SQRT1_2 + IMU_REAL(0.5)) * (imu_real_t)max + IMU_REAL(0.5);
+            uint32_t c = (u <= IMU_REAL(0.0)) ? 0 : (u >= (imu_real_t)max) ? max : (uint32_t)u;
+            packed = (packed << bits) | c;
+        }
+    }
+    return packed;
+}
+
+void ImuTelemetry_UnpackQuat(uint64_t packed, int32_t bits, imu_real_t q[4])
+{
+    uint32_t max = (1u << bits) - 1;
+    int32_t largest = (int32_t)((packed >> (3 * bits)) & 0x03);
+    imu_real_t sum = IMU_REAL(0.0);
+    for (int32_t i = 3; i >= 0; i--)
+    {
+        if (i != largest)
+        {
+            q[i] = ((imu_real_t)(packed & max) / (imu_real_t)max - IMU_REAL(0.5)) / IMU_TELEMETRY_SQRT1_2;
+            sum += q[i] * q[i];
+            packed >>= bits;
+        }
+    }
+    q[largest] = (sum < IMU_REAL(1.0)) ? IMU_SQRT(IMU_REAL(1.0) - sum) : IMU_REAL(0.0);
+}
+
+// 返回编码后长度, 含结尾的 0x00
+static int32_t ImuTelemetry_Cobs(const uint8_t *in, int32_t length, uint8_t *out)
+{
+    int32_t code_at = 0;
+    int32_t o = 1;
+    uint8_t code = 1;
+    for (int32_t i = 0; i < length; i++)
+    {
+        if (0 == in[i])
+        {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+        else
+        {
+            out[o++] = in[i];
+            if (0xFF == ++code)
+            {
+                out[code_at] = code;
+                code_at = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_at] = code;
+    out[o++] = 0;
+    return o;
+}
+
+// 原地解码, 不含结尾的 0x00, 返回解码后长度, 格式错误返回 -1
+static int32_t ImuTelemetry_Uncobs(uint8_t *buf, int32_t length)
+{
+    int32_t i = 0;
+    int32_t o = 0;
+    while (i < length)
+    {
+        uint8_t code = buf[i++];
+        if (0 == code || i + code - 1 > length)
+        {
+            return -1;
+        }
+        for (int32_t j = 1; j < code; j++)
+        {
+            buf[o++] = buf[i++];
+        }
+        if (0xFF != code && i < length)
+        {
+            buf[o++] = 0;
+        }
+    }
+    return o;
+}
+
+static int32_t ImuTelemetry_FieldSize(uint8_t flags, ImuTelemetryField field)
+{
+    static const uint8_t size[ImuTelemetryField_Count] = {4, 4, 18, IMU_TELEMETRY_PROFILE_COUNT * 4};
+    if (!(flags & (1u << field)))
+    {
+        return 0;
+    }
+    return (ImuTelemetryField_Quat == field && (flags & IMU_TELEMETRY_QUAT48)) ? 6 : size[field];
+}
+
+void ImuTelemetry_Init(ImuTelemetry *t, uint16_t time_div, uint16_t quat_div, uint16_t raw_div, uint16_t profile_div,
+                       bool quat48)
+{
+    memset(t, 0, sizeof(ImuTelemetry));
+    t->divider[ImuTelemetryField_Time] = time_div;
+    t->divider[ImuTelemetryField_Quat] = quat_div;
+    t->divider[ImuTelemetryField_Raw] = raw_div;
+    t->divider[ImuTelemetryField_Profile] = profile_div;
+    for (int32_t f = 0; f < ImuTelemetryField_Count; f++)
+    {
+        t->count[f] = t->divider[f] ? t->divider[f] - 1 : 0;
+    }
+    t->quat48 = quat48;
+}
+
+/**
+ * 各字段分频独立计数, 第一次调用发送所有启用的字段. 没有字段到期时返回 0,
+ * 否则返回写入 frame 的字节数, frame 至少 IMU_TELEMETRY_MAX_FRAME 字节.
+ */
+int32_t ImuTelemetry_Encode(ImuTelemetry *t, const Imu *imu, uint8_t *frame)
+{
+    uint8_t payload[IMU_TELEMETRY_MAX_PAYLOAD];
+    uint8_t flags = 0;
+    int32_t n = 2;
+
+    for (int32_t f = 0; f < ImuTelemetryField_Count; f++)
+    {
+        if (t->divider[f] && ++t->count[f] >= t->divider[f])
+        {
+            t->count[f] = 0;
+            flags |= (uint8_t)(1u << f);
+        }
+    }
+    if (0 == flags)
+    {
+        return 0;
+    }
+
+    if (flags & (1u << ImuTelemetryField_Time))
+    {
+        ImuTelemetry_Put(&payload[n], imu->source.timestamp_us, 4);
+        n += 4;
+    }
+    if (flags & (1u << ImuTelemetryField_Quat))
+    {
+        imu_real_t q[4] = {imu->quaternion.q0, imu->quaternion.q1, imu->quaternion.q2, imu->quaternion.q3};
+        if (t->quat48)
+        {
+            flags |= IMU_TELEMETRY_QUAT48;
+            ImuTelemetry_Put(&payload[n], ImuTelemetry_PackQuat(q, IMU_TELEMETRY_QUAT48_BITS), 6);
+            n += 6;
+        }
+        else
+        {
+            ImuTelemetry_Put(&payload[n], ImuTelemetry_PackQuat(q, IMU_TELEMETRY_QUAT32_BITS), 4);
+            n += 4;
+        }
+    }
+    if (flags & (1u << ImuTelemetryField_Raw))
+    {
+        ImuSource corrected;
+        const ImuSource *s = &corrected;
+        Imu_CorrectSource(imu, &corrected);
+        imu_real_t k[3] = {IMU_REAL(1000.0) / GRAVITY, RAD2DEGREE(IMU_REAL(10.0)), IMU_REAL(1000.0)};
+        imu_real_t v[9] = {s->accel.x, s->accel.y, s->accel.z, s->gyro.x, s->gyro.y, s->gyro.z,
+                           s->magic.x, s->magic.y, s->magic.z};
+        for (int32_t i = 0; i < 9; i++)
+        {
+            ImuTelemetry_Put(&payload[n], (uint16_t)ImuTelemetry_Int16(v[i] * k[i / 3]), 2);
+            n += 2;
+        }
+    }
+    if (flags & (1u << ImuTelemetryField_Profile))
+    {
+        for (int32_t i = 0; i < IMU_TELEMETRY_PROFILE_COUNT; i++)
+        {
+            ImuTelemetry_Put(&payload[n], t->profile[i], 4);
+            n += 4;
+        }
+    }
+
+    payload[0] = flags;
+    payload[1] = t->seq++;
+    ImuTelemetry_Put(&payload[n], ImuTelemetry_Crc16(payload, n), 2);
+    return ImuTelemetry_Cobs(payload, n + 2, frame);
+}
+
+void ImuTelemetry_InitDecoder(ImuTelemetryDecoder *d)
+{
+    memset(d, 0, sizeof(ImuTelemetryDecoder));
+}
+
+static bool ImuTelemetry_Parse(const uint8_t *p, int32_t length, ImuTelemetrySample *sample)
+{
+    uint8_t flags = p[0];
+    int32_t n = 2;
+    for (int32_t f = 0; f < ImuTelemetryField_Count; f++)
+    {
+        n += ImuTelemetry_FieldSize(flags, (ImuTelemetryField)f);
+    }
+    if (n != length)
+    {
+        return false;
+    }
+
+    memset(sample, 0, sizeof(ImuTelemetrySample));
+    sample->flags = flags;
+    sample->seq = p[1];
+    n = 2;
+    if (flags & (1u << ImuTelemetryField_Time))
+    {
+        sample->t_us = (uint32_t)ImuTelemetry_Get(&p[n], 4);
+        n += 4;
+    }
+    if (flags & (1u << ImuTelemetryField_Quat))
+    {
+        int32_t bytes = ImuTelemetry_FieldSize(flags, ImuTelemetryField_Quat);
+        ImuTelemetry_UnpackQuat(ImuTelemetry_Get(&p[n], bytes), (6 == bytes) ? IMU_TELEMETRY_QUAT48_BITS :
+                                IMU_TELEMETRY_QUAT32_BITS, sample->q);
+        n += bytes;
+    }
+    if (flags & (1u << ImuTelemetryField_Raw))
+    {
+        for (int32_t i = 0; i < 3; i++)
+        {
+            sample->accel[i] = (int16_t)ImuTelemetry_Get(&p[n + i * 2], 2);
+            sample->gyro[i] = (int16_t)ImuTelemetry_Get(&p[n + 6 + i * 2], 2);
+            sample->magic[i] = (int16_t)ImuTelemetry_Get(&p[n + 12 + i * 2], 2);
+        }
+        n += 18;
+    }
+    if (flags & (1u << ImuTelemetryField_Profile))
+    {
+        for (int32_t i = 0; i < IMU_TELEMETRY_PROFILE_COUNT; i++)
+        {
+            sample->profile[i] = (uint32_t)ImuTelemetry_Get(&p[n + i * 4], 4);
+        }
+    }
+    return true;
+}
+
+/**
+ * 逐字节输入, 收到完整且校验通过的帧时返回 true 并填写 sample.
+ * 任何错误只丢弃当前帧, 下一个 0x00 之后自动重新同步.
+ */
+bool ImuTelemetry_Decode(ImuTelemetryDecoder *d, uint8_t byte, ImuTelemetrySample *sample)
+{
+    if (0 != byte)
+    {
+        if (d->length < (int32_t)sizeof(d->buf))
+        {
+            d->buf[d->length++] = byte;
+        }
+        else
+        {
+            d->overflow = true;
+        }
+        return false;
+    }
+
+    int32_t n = d->length;
+    bool overflow = d->overflow;
+    d->length = 0;
+    d->overflow = false;
+    if (0 == n)
+    {
+        return false;
+    }
+    n = overflow ? -1 : ImuTelemetry_Uncobs(d->buf, n);
+    if (n < 4 || ImuTelemetry_Crc16(d->buf, n - 2) != (uint16_t)ImuTelemetry_Get(&d->buf[n - 2], 2) ||
+        !ImuTelemetry_Parse(d->buf, n - 2, sample))
+    {
+        d->errors++;
+        return false;
+    }
+
+    if (d->synced && sample->seq != d->next_seq)
+    {
+        d->lost += (uint8_t)(sample->seq - d->next_seq);
+    }
+    d->synced = true;
+    d->next_seq = (uint8_t)(sample->seq + 1);
+    d->frames++;
+    return true;
+}
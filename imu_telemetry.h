@@ -0,0 +1,73 @@
+/**
+ * @file imu_telemetry.h
+ * @author Wyatt Yu
+ * @brief 二进制遥测帧编码与解码 头文件
+ *
+ * 帧格式 (COBS 编码前, 多字节字段均为小端):
+ *   flags(1) seq(1) [time(4)] [quat(4|6)] [raw(18)] [profile(16)] crc16(2)
+ * flags 低 4 位为字段存在位 (1 << ImuTelemetryField_*), IMU_TELEMETRY_QUAT48 表示四元数为 48 位格式.
+ * crc16 为 CRC-16/CCITT-FALSE, 覆盖 flags 到最后一个字段. COBS 编码后以 0x00 结束.
+ * 四元数用 smallest-three 压缩: 2 位最大分量序号 + 其余三个分量各 10 位 (32 位) 或 15 位 (48 位),
+ * 最大分量取正, 解码时由单位长度恢复. raw 为 int16: 加速度 mg, 角速度 0.1deg/s, 磁场 mGauss.
+ * 只发 32 位四元数时一帧连同 COBS 开销与结束符共 10 字节, 115200 波特率 (8N1) 下可以达到 1kHz.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_TELEMETRY_H__
+#define __IMU_TELEMETRY_H__
+#include "imu.h"
+
+#define IMU_TELEMETRY_PROFILE_COUNT     4
+#define IMU_TELEMETRY_MAX_PAYLOAD       (2 + 4 + 6 + 18 + IMU_TELEMETRY_PROFILE_COUNT * 4 + 2)
+#define IMU_TELEMETRY_MAX_FRAME         (IMU_TELEMETRY_MAX_PAYLOAD + IMU_TELEMETRY_MAX_PAYLOAD / 254 + 2)
+#define IMU_TELEMETRY_QUAT48            0x80
+
+typedef enum {
+    ImuTelemetryField_Time    = 0,      // ImuSource.timestamp_us
+    ImuTelemetryField_Quat    = 1,
+    ImuTelemetryField_Raw     = 2,      // 校准后的 accel/gyro/magic
+    ImuTelemetryField_Profile = 3,      // 应用填写的 profile 计数器
+    ImuTelemetryField_Count,
+}ImuTelemetryField;
+
+typedef struct ImuTelemetry_ {
+    uint16_t divider[ImuTelemetryField_Count];  // 0 不发送, n 表示每 n 次 Encode 发送一次
+    uint16_t count[ImuTelemetryField_Count];
+    bool quat48;
+    uint8_t seq;
+    uint32_t profile[IMU_TELEMETRY_PROFILE_COUNT];  // 如每次 Imu_Update 的周期数, 总线占用时间
+}ImuTelemetry;
+
+typedef struct ImuTelemetrySample_ {
+    uint8_t flags;
+    uint8_t seq;
+    uint32_t t_us;
+    imu_real_t q[4];
+    int16_t accel[3];           // mg
+    int16_t gyro[3];            // 0.1deg/s
+    int16_t magic[3];           // mGauss
+    uint32_t profile[IMU_TELEMETRY_PROFILE_COUNT];
+}ImuTelemetrySample;
+
+// 字节流解码器, 按 0x00 分帧, 统计 CRC 错误与序号跳变
+typedef struct ImuTelemetryDecoder_ {
+    uint8_t buf[IMU_TELEMETRY_MAX_FRAME];
+    int32_t length;
+    bool overflow;
+    bool synced;                // 已收到过有效帧, 用于序号连续性判断
+    uint8_t next_seq;
+    uint32_t frames;
+    uint32_t errors;            // CRC 错误, 格式错误或超长
+    uint32_t lost;              // 由序号推算的丢帧数
+}ImuTelemetryDecoder;
+
+void ImuTelemetry_Init(ImuTelemetry *t, uint16_t time_div, uint16_t quat_div, uint16_t raw_div, uint16_t profile_div,
+                       bool quat48);
+int32_t ImuTelemetry_Encode(ImuTelemetry *t, const Imu *imu, uint8_t *frame);
+uint64_t ImuTelemetry_PackQuat(const imu_real_t q[4], int32_t bits);
+void ImuTelemetry_UnpackQuat(uint64_t packed, int32_t bits, imu_real_t q[4]);
+
+void ImuTelemetry_InitDecoder(ImuTelemetryDecoder *d);
+bool ImuTelemetry_Decode(ImuTelemetryDecoder *d, uint8_t byte, ImuTelemetrySample *sample);
+
+#endif
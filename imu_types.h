@@ -0,0 +1,45 @@
+/**
+ * @file imu_types.h
+ * @author Wyatt Yu
+ * @brief IMU 库统一的标量类型与数学函数
+ *
+ * 默认 imu_real_t 为 float, 在带单精度 FPU 的 MCU 上全部走硬件浮点;
+ * 定义 IMU_USING_DOUBLE 后切换为 double, 仅用于主机端分析.
+ * 常量一律用 IMU_REAL() 包装, 数学函数一律用下面的宏, 避免隐式提升为 double.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_TYPES_H__
+#define __IMU_TYPES_H__
+#include <math.h>
+
+#ifdef IMU_USING_DOUBLE
+typedef double imu_real_t;
+#define IMU_REAL(x)             (x)
+#define IMU_SQRT(x)             sqrt(x)
+#define IMU_INVSQRT(x)          (1.0 / sqrt(x))
+#define IMU_ATAN2(y, x)         atan2(y, x)
+#define IMU_ASIN(x)             asin(x)
+#define IMU_ACOS(x)             acos(x)
+#define IMU_SIN(x)              sin(x)
+#define IMU_COS(x)              cos(x)
+#define IMU_FABS(x)             fabs(x)
+#else
+#include "app_common.h"
+typedef float imu_real_t;
+#define IMU_REAL(x)             (x##f)
+#define IMU_SQRT(x)             sqrtf(x)
+#define IMU_INVSQRT(x)          InvSqrt(x)
+#define IMU_ATAN2(y, x)         atan2f(y, x)
+#define IMU_ASIN(x)             asinf(x)
+#define IMU_ACOS(x)             acosf(x)
+#define IMU_SIN(x)              sinf(x)
+#define IMU_COS(x)              cosf(x)
+#define IMU_FABS(x)             fabsf(x)
+#endif
+
+#define IMU_PI                  IMU_REAL(3.14159265358979)
+#define IMU_2PI                 IMU_REAL(6.28318530717959)
+#define IMU_GRAVITY             IMU_REAL(9.81)      // m/s2
+
+#endif
@@ -0,0 +1,353 @@
+/**
+ * @file imu_vibration.c
+ * @author Wyatt Yu
+ * @brief 振动频谱监测
+ * @copyright Copyright (c) 2025
+ */
+#include <string.h>
+#include "imu_vibration.h"
+
+#define IMU_VIBRATION_HALF          (IMU_VIBRATION_FFT_SIZE / 2)
+
+void ImuVibration_Init(ImuVibration *v, imu_real_t samp_freq, imu_real_t scale)
+{
+    memset((void *)v, 0, sizeof(ImuVibration));
+    v->samp_freq = samp_freq;
+    v->scale = scale;
+    v->hop = IMU_VIBRATION_FFT_SIZE / 2;
+    v->axis_mask = 0x07;
+    v->track_window = IMU_REAL(3.0) * samp_freq / IMU_VIBRATION_FFT_SIZE;
+    v->track_ratio = IMU_REAL(0.1);
+
+    for (int32_t i = 0; i < IMU_VIBRATION_FFT_SIZE; i++)
+    {
+        // 周期 Hann 窗, 相邻帧重叠一半时各样本权重之和为常数
+        imu_real_t w = IMU_REAL(0.5) - IMU_REAL(0.5) * IMU_COS(IMU_2PI * (imu_real_t)i / IMU_VIBRATION_FFT_SIZE);
+        v->window[i] = w;
+        v->window_s1 += w;
+        v->window_s2 += w * w;
+    }
+    for (int32_t k = 0; k < IMU_VIBRATION_HALF; k++)
+    {
+        v->twiddle[k][0] = IMU_COS(IMU_2PI * (imu_real_t)k / IMU_VIBRATION_FFT_SIZE);
+        v->twiddle[k][1] = IMU_SIN(IMU_2PI * (imu_real_t)k / IMU_VIBRATION_FFT_SIZE);
+    }
+}
+
+// 输出速率 3200Hz / 2^(15 - rate), 刻度取驱动当前量程
+bool ImuVibration_InitAdlx345(ImuVibration *v, Adlx345 *m)
+{
+    Adlx345SampleRate rate = Adlx345SampleRate_3600;
+    if (!m)
+    {
+        return false;
+    }
+
+    Adlx345_GetSampleRate(m, &rate);
+    ImuVibration_Init(v, IMU_REAL(3200.0) / (imu_real_t)(1u << (15 - rate)), Adlx345_GetScale(m));
+    return true;
+}
+
+bool ImuVibration_SetBand(ImuVibration *v, int32_t index, imu_real_t lo, imu_real_t hi)
+{
+    if (index < 0 || index >= IMU_VIBRATION_BANDS || lo < IMU_REAL(0.0) || hi <= lo)
+    {
+        return false;
+    }
+
+    v->band[index][0] = lo;
+    v->band[index][1] = hi;
+    return true;
+}
+
+// N/2 点复数基 2 FFT, 数据为交错的实部/虚部, 旋转因子取 N 点表的偶数项
+static void ImuVibration_Cfft(const ImuVibration *v, imu_real_t *z)
+{
+    const int32_t m = IMU_VIBRATION_HALF;
+    for (int32_t i = 1, j = 0; i < m; i++)
+    {
+        int32_t bit = m >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            imu_real_t re = z[2 * i], im = z[2 * i + 1];
+            z[2 * i] = z[2 * j];
+            z[2 * i + 1] = z[2 * j + 1];
+            z[2 * j] = re;
+            z[2 * j + 1] = im;
+        }
+    }
+
+    for (int32_t len = 2; len <= m; len <<= 1)
+    {
+        int32_t half = len >> 1;
+        int32_t step = IMU_VIBRATION_FFT_SIZE / len;
+        for (int32_t k = 0; k < half; k++)
+        {
+            imu_real_t wr = v->twiddle[k * step][0];
+            imu_real_t wi = -v->twiddle[k * step][1];
+            for (int32_t i = k; i < m; i += len)
+            {
+                imu_real_t *a = &z[2 * i];
+                imu_real_t *b = &z[2 * (i + half)];
+                imu_real_t tr = wr * b[0] - wi * b[1];
+                imu_real_t ti = wr * b[1] + wi * b[0];
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * N 点实数 FFT, 原地计算, 输出排列与 CMSIS arm_rfft_fast 相同:
+ * data[0] = X[0], data[1] = X[N/2] (均为实数), data[2k], data[2k + 1] = Re/Im X[k], 1 <= k < N/2.
+ * 偶/奇样本组成 N/2 点复数序列 Z, X[k] = E[k] + W^k O[k], E/O 由 Z[k] 与 conj(Z[N/2 - k]) 得到.
+ */
+void ImuVibration_Rfft(const ImuVibration *v, imu_real_t *data)
+{
+    const int32_t m = IMU_VIBRATION_HALF;
+    ImuVibration_Cfft(v, data);
+
+    imu_real_t z0r = data[0], z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = z0r - z0i;
+    for (int32_t k = 1; k < m / 2; k++)
+    {
+        imu_real_t *a = &data[2 * k];
+        imu_real_t *b = &data[2 * (m - k)];
+        imu_real_t er = IMU_REAL(0.5) * (a[0] + b[0]);
+        imu_real_t ei = IMU_REAL(0.5) * (a[1] - b[1]);
+        imu_real_t or_ = IMU_REAL(0.5) * (a[1] + b[1]);
+        imu_real_t oi = -IMU_REAL(0.5) * (a[0] - b[0]);
+        imu_real_t wr = v->twiddle[k][0];
+        imu_real_t wi = -v->twiddle[k][1];
+        imu_real_t tr = wr * or_ - wi * oi;
+        imu_real_t ti = wr * oi + wi * or_;
+        a[0] = er + tr;
+        a[1] = ei + ti;
+        b[0] = er - tr;         // X[N/2 - k] = conj(E[k] - W^k O[k])
+        b[1] = ti - ei;
+    }
+    data[m + 1] = -data[m + 1];  // X[N/4] = conj(Z[N/4])
+}
+
+// 由 |X|^2 相邻三点做抛物线插值, 幅值换算为正弦分量的 RMS
+static void ImuVibration_Interp(const ImuVibration *v, int32_t k, ImuVibrationPeak *peak)
+{
+    imu_real_t a = IMU_SQRT(v->power[k - 1]);
+    imu_real_t b = IMU_SQRT(v->power[k]);
+    imu_real_t c = IMU_SQRT(v->power[k + 1]);
+    imu_real_t den = a - IMU_REAL(2.0) * b + c;
+    imu_real_t delta = (den < IMU_REAL(0.0)) ? IMU_REAL(0.5) * (a - c) / den : IMU_REAL(0.0);
+    peak->freq = ((imu_real_t)k + delta) * v->samp_freq / IMU_VIBRATION_FFT_SIZE;
+    peak->amp = (b - IMU_REAL(0.25) * (a - c) * delta) * IMU_REAL(1.41421356) * v->scale / v->window_s1;
+}
+
+static bool ImuVibration_IsPeak(const ImuVibration *v, int32_t k)
+{
+    return v->power[k] > v->power[k - 1] && v->power[k] >= v->power[k + 1];
+}
+
+static void ImuVibration_FindPeaks(ImuVibration *v)
+{
+    ImuVibrationSummary *s = &v->summary;
+    int32_t bin[IMU_VIBRATION_PEAKS];
+    int32_t found = 0;
+
+    for (int32_t k = 1; k < IMU_VIBRATION_HALF; k++)
+    {
+        if (!ImuVibration_IsPeak(v, k))
+        {
+            continue;
+        }
+        // 插入排序, 只保留最强的几个
+        int32_t i = (found < IMU_VIBRATION_PEAKS) ? found++ : IMU_VIBRATION_PEAKS;
+        for (; i > 0 && v->power[bin[i - 1]] < v->power[k]; i--)
+        {
+            if (i < IMU_VIBRATION_PEAKS)
+            {
+                bin[i] = bin[i - 1];
+            }
+        }
+        if (i < IMU_VIBRATION_PEAKS)
+        {
+            bin[i] = k;
+        }
+    }
+
+    memset(s->peak, 0, sizeof(s->peak));
+    for (int32_t i = 0; i < found; i++)
+    {
+        ImuVibration_Interp(v, bin[i], &s->peak[i]);
+    }
+}
+
+// 在上一帧跟踪频率附近找最强的局部峰, 太弱或找不到时改跟最强峰
+static void ImuVibration_Track(ImuVibration *v)
+{
+    ImuVibrationSummary *s = &v->summary;
+    imu_real_t bin_hz = v->samp_freq / IMU_VIBRATION_FFT_SIZE;
+    int32_t best = 0;
+
+    if (s->track_frames > 0)
+    {
+        int32_t lo = (int32_t)((s->track.freq - v->track_window) / bin_hz);
+        int32_t hi = (int32_t)((s->track.freq + v->track_window) / bin_hz) + 1;
+        lo = (lo < 1) ? 1 : lo;
+        hi = (hi > IMU_VIBRATION_HALF - 1) ? IMU_VIBRATION_HALF - 1 : hi;
+        for (int32_t k = lo; k <= hi; k++)
+        {
+            if (ImuVibration_IsPeak(v, k) && (0 == best || v->power[k] > v->power[best]))
+            {
+                best = k;
+            }
+        }
+    }
+
+    if (best > 0)
+    {
+        ImuVibration_Interp(v, best, &s->track);
+        if (s->track.amp >= v->track_ratio * s->peak[0].amp)
+        {
+            s->track_frames = (s->track_frames < UINT16_MAX) ? s->track_frames + 1 : s->track_frames;
+            return;
+        }
+    }
+
+    s->track = s->peak[0];
+    s->track_frames = (s->peak[0].amp > IMU_REAL(0.0)) ? 1 : 0;
+}
+
+/**
+ * 频谱按原始计数 (LSB) 计算, FFT 是线性的, 刻度只在输出的 RMS 与峰值幅值上乘一次,
+ * 突发中的样本不逐个换算为物理单位.
+ */
+static void ImuVibration_Process(ImuVibration *v)
+{
+    ImuVibrationSummary *s = &v->summary;
+    imu_real_t bin_hz = v->samp_freq / IMU_VIBRATION_FFT_SIZE;
+    imu_real_t norm = v->scale * v->scale / (IMU_VIBRATION_FFT_SIZE * v->window_s2);
+
+    memset(v->power, 0, sizeof(v->power));
+    memset(s->axis, 0, sizeof(s->axis));
+    for (int32_t axis = 0; axis < 3; axis++)
+    {
+        if (!(v->axis_mask & (1u << axis)))
+        {
+            continue;
+        }
+
+        int32_t sum = 0;
+        for (int32_t i = 0; i < IMU_VIBRATION_FFT_SIZE; i++)
+        {
+            sum += v->frame[i][axis];
+        }
+        imu_real_t mean = (imu_real_t)sum / IMU_VIBRATION_FFT_SIZE;
+        imu_real_t var = IMU_REAL(0.0);
+        for (int32_t i = 0; i < IMU_VIBRATION_FFT_SIZE; i++)
+        {
+            imu_real_t x = (imu_real_t)v->frame[i][axis] - mean;
+            var += x * x;
+            v->work[i] = x * v->window[i];
+        }
+        s->axis[axis].rms = IMU_SQRT(var / IMU_VIBRATION_FFT_SIZE) * v->scale;
+
+        ImuVibration_Rfft(v, v->work);
+        v->power[0] += v->work[0] * v->work[0];
+        v->power[IMU_VIBRATION_HALF] += v->work[1] * v->work[1];
+        for (int32_t k = 1; k < IMU_VIBRATION_HALF; k++)
+        {
+            v->power[k] += v->work[2 * k] * v->work[2 * k] + v->work[2 * k + 1] * v->work[2 * k + 1];
+        }
+
+        // 单边谱除 DC 与 Nyquist 外计两次, 频带 RMS^2 = sum(c * |X|^2) / (N * sum(w^2))
+        for (int32_t b = 0; b < IMU_VIBRATION_BANDS; b++)
+        {
+            if (v->band[b][1] <= IMU_REAL(0.0))
+            {
+                continue;
+            }
+            int32_t lo = (int32_t)(v->band[b][0] / bin_hz + IMU_REAL(0.5));
+            int32_t hi = (int32_t)(v->band[b][1] / bin_hz + IMU_REAL(0.5));
+            hi = (hi > IMU_VIBRATION_HALF) ? IMU_VIBRATION_HALF : hi;
+            imu_real_t p = IMU_REAL(0.0);
+            for (int32_t k = lo; k <= hi; k++)
+            {
+                imu_real_t re = (0 == k) ? v->work[0] : (IMU_VIBRATION_HALF == k) ? v->work[1] : v->work[2 * k];
+                imu_real_t im = (0 == k || IMU_VIBRATION_HALF == k) ? IMU_REAL(0.0) : v->work[2 * k + 1];
+                p += ((0 == k || IMU_VIBRATION_HALF == k) ? IMU_REAL(1.0) : IMU_REAL(2.0)) * (re * re + im * im);
+            }
+            s->axis[axis].band_rms[b] = IMU_SQRT(p * norm);
+        }
+    }
+
+    ImuVibration_FindPeaks(v);
+    ImuVibration_Track(v);
+    s->samples = v->samples;
+    s->seq++;
+}
+
+/**
+ * 装入原始样本 (LSB), 每凑满一帧计算一次, 返回本次完成的帧数, 最新结果在 v->summary.
+ * 一次装入多帧时只保留最后一帧的摘要, 调用间隔应小于 hop / samp_freq.
+ */
+int32_t ImuVibration_Push(ImuVibration *v, const int16_t (*raw)[3], int32_t count)
+{
+    int32_t hop = (v->hop >= 1 && v->hop <= IMU_VIBRATION_FFT_SIZE) ? v->hop : IMU_VIBRATION_FFT_SIZE;
+    int32_t frames = 0;
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        v->frame[v->fill][0] = raw[i][0];
+        v->frame[v->fill][1] = raw[i][1];
+        v->frame[v->fill][2] = raw[i][2];
+        v->fill++;
+        v->samples++;
+        if (IMU_VIBRATION_FFT_SIZE == v->fill)
+        {
+            ImuVibration_Process(v);
+            frames++;
+            memmove(v->frame[0], v->frame[hop], sizeof(v->frame[0]) * (size_t)(IMU_VIBRATION_FFT_SIZE - hop));
+            v->fill = IMU_VIBRATION_FFT_SIZE - hop;
+        }
+    }
+    return frames;
+}
+
+/**
+ * 读出 FIFO 中的全部样本 (32 级 FIFO + 数据寄存器, 最多 33 个) 并装入.
+ * mean 非空时输出本次突发的均值 m/s2, FIFO 被振动分析占用时可作为融合的加速度输入.
+ * 返回完成的帧数, 总线错误返回 -1.
+ */
+int32_t ImuVibration_Poll(ImuVibration *v, Adlx345 *m, ImuAxes *mean)
+{
+    int16_t raw[ADLX345_FIFO_DEPTH + 1][3];
+    int32_t n = Adlx345_ReadFifo(m, raw, ADLX345_FIFO_DEPTH + 1);
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    if (mean && n > 0)
+    {
+        int32_t sum[3] = {0, 0, 0};
+        for (int32_t i = 0; i < n; i++)
+        {
+            sum[0] += raw[i][0];
+            sum[1] += raw[i][1];
+            sum[2] += raw[i][2];
+        }
+        imu_real_t k = Adlx345_GetScale(m) / (imu_real_t)n;
+        mean->x = (imu_real_t)sum[0] * k;
+        mean->y = (imu_real_t)sum[1] * k;
+        mean->z = (imu_real_t)sum[2] * k;
+    }
+    return ImuVibration_Push(v, (const int16_t (*)[3])raw, n);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file imu_vibration.h
+ * @author Wyatt Yu
+ * @brief 振动频谱监测 头文件
+ *
+ * ADXL345 以高输出速率 (最高 3200Hz) 写入 FIFO, ImuVibration_Poll 按突发读出后装入帧缓存,
+ * 每凑满 IMU_VIBRATION_FFT_SIZE 个样本 (帧间重叠 size - hop) 计算一次频谱:
+ *   去均值 (去掉重力) -> Hann 窗 -> 实数 FFT (N/2 点复数基 2 FFT + 拆分, 与 CMSIS arm_rfft_fast 相同)
+ * 只发布摘要 ImuVibrationSummary, 不保留原始数据:
+ *   各轴总 RMS 与频带 RMS (Parseval, 已按窗的等效噪声带宽修正), 三轴合成功率谱中
+ *   最强的 IMU_VIBRATION_PEAKS 个峰 (抛物线插值频率与正弦 RMS 幅值), 以及跟踪峰:
+ *   在上一帧频率附近搜索, 失锁后重新取最强峰, 用于跟随转速.
+ *
+ * 3200Hz 下单个样本的 I2C 读 (400kHz, 寄存器地址 + 重复起始 + 6 字节) 约 210us, 约占总线 67%,
+ * 与陀螺/磁力计共用总线时建议 800Hz 以下, 或改用 SPI.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_VIBRATION_H__
+#define __IMU_VIBRATION_H__
+#include "imu.h"
+#include "adlx345.h"
+
+#ifndef IMU_VIBRATION_FFT_SIZE
+#define IMU_VIBRATION_FFT_SIZE      256         // 2 的幂, 3200Hz 下分辨率 12.5Hz, 80ms 一帧
+#endif
+#define IMU_VIBRATION_BANDS         4
+#define IMU_VIBRATION_PEAKS         3
+#define IMU_VIBRATION_BINS          (IMU_VIBRATION_FFT_SIZE / 2 + 1)
+
+typedef struct ImuVibrationPeak_ {
+    imu_real_t freq;            // Hz
+    imu_real_t amp;             // 正弦分量的 RMS 幅值, m/s2
+}ImuVibrationPeak;
+
+typedef struct ImuVibrationAxis_ {
+    imu_real_t rms;             // 去均值后的总 RMS, m/s2
+    imu_real_t band_rms[IMU_VIBRATION_BANDS];
+}ImuVibrationAxis;
+
+typedef struct ImuVibrationSummary_ {
+    uint32_t seq;               // 帧序号
+    uint32_t samples;           // 截至本帧末尾已输入的样本数, 换算时间用
+    ImuVibrationAxis axis[3];
+    ImuVibrationPeak peak[IMU_VIBRATION_PEAKS];     // 按幅值降序, 不足时幅值为 0
+    ImuVibrationPeak track;     // 跟踪峰, 未锁定时为 0
+    uint16_t track_frames;      // 连续锁定的帧数
+}ImuVibrationSummary;
+
+typedef struct ImuVibration_ {
+    imu_real_t samp_freq;       // Hz
+    imu_real_t scale;           // m/s2 per LSB
+    uint16_t hop;               // 帧移, 1 ~ FFT_SIZE
+    uint8_t axis_mask;          // 参与分析的轴, bit0 = x
+    imu_real_t band[IMU_VIBRATION_BANDS][2];    // 频带上下限 Hz, 上限为 0 表示未使用
+    imu_real_t track_window;    // 跟踪搜索半宽 Hz
+    imu_real_t track_ratio;     // 跟踪峰低于最强峰的该比例时失锁
+    int16_t frame[IMU_VIBRATION_FFT_SIZE][3];
+    int32_t fill;
+    uint32_t samples;
+    imu_real_t window[IMU_VIBRATION_FFT_SIZE];
+    imu_real_t window_s1;       // sum(w)
+    imu_real_t window_s2;       // sum(w^2)
+    imu_real_t twiddle[IMU_VIBRATION_FFT_SIZE / 2][2];  // cos, sin (2 pi k / N)
+    imu_real_t work[IMU_VIBRATION_FFT_SIZE];
+    imu_real_t power[IMU_VIBRATION_BINS];           // 三轴合成 |X|^2, LSB^2
+    ImuVibrationSummary summary;
+}ImuVibration;
+
+void ImuVibration_Init(ImuVibration *v, imu_real_t samp_freq, imu_real_t scale);
+bool ImuVibration_InitAdlx345(ImuVibration *v, Adlx345 *m);
+bool ImuVibration_SetBand(ImuVibration *v, int32_t index, imu_real_t lo, imu_real_t hi);
+int32_t ImuVibration_Push(ImuVibration *v, const int16_t (*raw)[3], int32_t count);
+int32_t ImuVibration_Poll(ImuVibration *v, Adlx345 *m, ImuAxes *mean);
+void ImuVibration_Rfft(const ImuVibration *v, imu_real_t *data);
+
+#endif
@@ -7,7 +7,8 @@
 
 #include "itg3205.h"
 
-#define ITG3205_DEGREE2RAD(x) ((x) * 3.1415926535 / 180.0)
+// 14.375 LSB/(deg/s), 数据手册定义
+#define ITG3205_SCALE           (IMU_PI / IMU_REAL(180.0) / IMU_REAL(14.375))
 
 void Itg3205_Register(Itg3205 *m, Itg3205_I2cMemFunc read, Itg3205_I2cMemFunc write)
 {
@@ -18,24 +19,76 @@ void Itg3205_Register(Itg3205 *m, Itg3205_I2cMemFunc read, Itg3205_I2cMemFunc wr
     }
 }
 
+static void Itg3205_UpdateSampleRate(Itg3205 *m)
+{
+    switch(m->lpf)
+    {
+        case Itg3205DlpfBaudrate_256:
+            m->sample_rate = 8000 / (m->sample_div + 1);
+            break;
+        default:
+            m->sample_rate = 1000 / (m->sample_div + 1);
+    }
+}
+
+// 将缓存中的脏寄存器按连续地址分段突发写入
+bool Itg3205_Sync(Itg3205 *m)
+{
+    uint8_t reg, length;
+    while (ImuRegCache_NextDirty(&m->cache, &reg, &length))
+    {
+        if (!m->write(m->addr, reg, ImuRegCache_Data(&m->cache, reg), length))
+        {
+            return false;
+        }
+        ImuRegCache_Clean(&m->cache, reg, length);
+    }
+    return true;
+}
+
+/**
+ * 读回 SMPLRT_DIV/DLPF_FS/INT_CFG 与 PWR_MGM 核对缓存, 返回不一致的个数, 总线错误返回 -1.
+ * resync 为 true 时把缓存值重新写入器件, 否则以器件值为准.
+ */
+int32_t Itg3205_Verify(Itg3205 *m, bool resync)
+{
+    uint8_t block[3];
+    uint8_t power;
+    int32_t mismatch = 0;
+    if (!m || !m->inited)
+    {
+        return -1;
+    }
+    if (!m->read(m->addr, ITG3205_REG_SAMPLE_RATE_DIV, block, 3) ||
+        !m->read(m->addr, ITG3205_REG_PWR, &power, 1))
+    {
+        return -1;
+    }
+    mismatch += ImuRegCache_Fill(&m->cache, ITG3205_REG_SAMPLE_RATE_DIV, block, 3, resync);
+    mismatch += ImuRegCache_Fill(&m->cache, ITG3205_REG_PWR, &power, 1, resync);
+    if (resync && mismatch > 0 && !Itg3205_Sync(m))
+    {
+        return -1;
+    }
+    return mismatch;
+}
+
 void Itg3205_Init(Itg3205 *m)
 {
     if (m && m->read && m->write)
     {
         uint8_t device_id = 0;
-        if (m->read(m->addr, ITG3205_REG_DEVID, &device_id, 1))
+        if (m->read(m->addr, ITG3205_REG_DEVID, &device_id, 1) &&
+            ITG3205_WHO_AM_I == (device_id & ITG3205_WHO_AM_I_MASK))
         {
-            m->write(m->addr, ITG3205_REG_DLPF, &m->lpf, 1);
-            m->write(m->addr, ITG3205_REG_SAMPLE_RATE_DIV, &m->sample_div, 1);
-            switch(m->lpf)
-            {
-                case Itg3205DlpfBaudrate_256:
-                    m->sample_rate = 8000 / (m->sample_div + 1);
-                    break;
-                default:
-                    m->sample_rate = 1000 / (m->sample_div + 1);
-            }
-            m->inited = true;
+            // 器件状态未知, 所有配置都重新写入; SMPLRT_DIV 与 DLPF_FS 相邻, 合并为一次写
+            ImuRegCache_Init(&m->cache, ITG3205_SHADOW_BASE, ITG3205_SHADOW_SIZE, m->shadow);
+            ImuRegCache_Set(&m->cache, ITG3205_REG_SAMPLE_RATE_DIV, m->sample_div);
+            ImuRegCache_Set(&m->cache, ITG3205_REG_DLPF, ITG3205_DLPF_FS_2000 | (m->lpf & 0x07));
+            ImuRegCache_Set(&m->cache, ITG3205_REG_PWR, m->clock_source & ITG3205_PWR_CLK_SEL);
+            Itg3205_UpdateSampleRate(m);
+            m->scale = ITG3205_SCALE;
+            m->inited = Itg3205_Sync(m);
         }
         else
         {
@@ -44,28 +97,128 @@ void Itg3205_Init(Itg3205 *m)
     }
 }
 
-bool Itg3205_Read(Itg3205 *m, float *temperature, Itg3205Axes *axes)
+bool Itg3205_SetDlpf(Itg3205 *m, Itg3205DlpfBaudrate lpf)
+{
+    if (m && m->inited)
+    {
+        m->lpf = lpf;
+        ImuRegCache_Set(&m->cache, ITG3205_REG_DLPF, ITG3205_DLPF_FS_2000 | (lpf & 0x07));
+        Itg3205_UpdateSampleRate(m);
+        return Itg3205_Sync(m);
+    }
+    return false;
+}
+
+bool Itg3205_SetSampleDiv(Itg3205 *m, uint8_t sample_div)
 {
-    bool ret = false;
     if (m && m->inited)
     {
-        uint8_t data[8];
-        m->read(m->addr, ITG3205_REG_DATA, data, 8);
-        m->raw_data[0] = (data[0] << 8) | data[1];
-        m->raw_data[1] = (data[2] << 8) | data[3];
-        m->raw_data[2] = (data[4] << 8) | data[5];
-        m->raw_data[3] = (data[6] << 8) | data[7];
+        m->sample_div = sample_div;
+        ImuRegCache_Set(&m->cache, ITG3205_REG_SAMPLE_RATE_DIV, sample_div);
+        Itg3205_UpdateSampleRate(m);
+        return Itg3205_Sync(m);
+    }
+    return false;
+}
 
-        // 以下常量是数据手册定义的
-        m->temperature = ((data[0] << 8 | data[1]) - 13200) / 280.0 + 35.0;
-        m->axes.x      = ITG3205_DEGREE2RAD(((int16_t)((data[2] << 8) | data[3])) / 14.375);
-        m->axes.y      = ITG3205_DEGREE2RAD(((int16_t)((data[4] << 8) | data[5])) / 14.375);
-        m->axes.z      = ITG3205_DEGREE2RAD(((int16_t)((data[6] << 8) | data[7])) / 14.375);
-        ret = true;
+// int_cfg 为 ITG3205_INT_* 的组合, 0 关闭中断输出
+bool Itg3205_SetInterrupt(Itg3205 *m, uint8_t int_cfg)
+{
+    if (m && m->inited)
+    {
+        ImuRegCache_Set(&m->cache, ITG3205_REG_INT_CFG, int_cfg);
+        return Itg3205_Sync(m);
     }
-    else 
+    return false;
+}
+
+// INT_STATUS 的 ITG_RDY/RAW_RDY, 未设置 ANYRD_2CLEAR 时读取即清除
+bool Itg3205_ReadIntStatus(Itg3205 *m, uint8_t *status)
+{
+    if (m && m->inited && status)
     {
-        ret = false;
+        return m->read(m->addr, ITG3205_REG_INT_STATUS, status, 1);
+    }
+    return false;
+}
+
+// 设置休眠, 各轴待机与时钟源; soft_reset 置位时等同 Itg3205_Reset
+bool Itg3205_SetPower(Itg3205 *m, const Itg3205RegPower *power)
+{
+    if (!m || !m->inited || !power)
+    {
+        return false;
+    }
+    if (power->soft_reset)
+    {
+        return Itg3205_Reset(m);
+    }
+
+    uint8_t value = (power->sleep ? ITG3205_PWR_SLEEP : 0) | (power->stby_x ? ITG3205_PWR_STBY_XG : 0) |
+                    (power->stby_y ? ITG3205_PWR_STBY_YG : 0) | (power->stby_z ? ITG3205_PWR_STBY_ZG : 0) |
+                    (power->clock_source & ITG3205_PWR_CLK_SEL);
+    m->clock_source = (Itg3205ClockSource)power->clock_source;
+    ImuRegCache_Set(&m->cache, ITG3205_REG_PWR, value);
+    return Itg3205_Sync(m);
+}
+
+/**
+ * 软复位, 所有寄存器恢复默认值, 不经过缓存. 复位后需要重新 Itg3205_Init,
+ * 数据手册给出的上电到可访问寄存器的时间为 5ms.
+ */
+bool Itg3205_Reset(Itg3205 *m)
+{
+    uint8_t value = ITG3205_PWR_H_RESET;
+    if (m && m->write && m->write(m->addr, ITG3205_REG_PWR, &value, 1))
+    {
+        m->inited = false;
+        return true;
+    }
+    return false;
+}
+
+void Itg3205_UnpackRaw(const uint8_t *bytes, int16_t raw[4])
+{
+    raw[0] = (int16_t)((bytes[0] << 8) | bytes[1]);     // temperature
+    raw[1] = (int16_t)((bytes[2] << 8) | bytes[3]);
+    raw[2] = (int16_t)((bytes[4] << 8) | bytes[5]);
+    raw[3] = (int16_t)((bytes[6] << 8) | bytes[7]);
+}
+
+// 温度原始值换算为摄氏度, 以下常量是数据手册定义的
+imu_real_t Itg3205_RawToTemperature(int16_t raw)
+{
+    return ((uint16_t)raw - 13200) / IMU_REAL(280.0) + IMU_REAL(35.0);
+}
+
+// 只读取原始计数, 不做浮点换算, 温度原始值保存在 raw_data[0]
+bool Itg3205_ReadRaw(Itg3205 *m, int16_t raw[3])
+{
+    uint8_t data[8];
+    if (m && m->inited && m->read(m->addr, ITG3205_REG_DATA, data, 8))
+    {
+        Itg3205_UnpackRaw(data, m->raw_data);
+        raw[0] = m->raw_data[1];
+        raw[1] = m->raw_data[2];
+        raw[2] = m->raw_data[3];
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool Itg3205_Read(Itg3205 *m, imu_real_t *temperature, Itg3205Axes *axes)
+{
+    int16_t raw[3];
+    bool ret = Itg3205_ReadRaw(m, raw);
+    if (ret)
+    {
+        m->temperature = Itg3205_RawToTemperature(m->raw_data[0]);
+        m->axes.x      = raw[0] * m->scale;
+        m->axes.y      = raw[1] * m->scale;
+        m->axes.z      = raw[2] * m->scale;
     }
     *temperature = m->temperature;
     axes->x      = m->axes.x;
@@ -74,6 +227,11 @@ bool Itg3205_Read(Itg3205 *m, float *temperature, Itg3205Axes *axes)
     return ret;
 }
 
+imu_real_t Itg3205_GetScale(Itg3205 *m)
+{
+    return m->scale;
+}
+
 int32_t Itg3205_GetSampleRate(Itg3205 *m)
 {
     return m->sample_rate;
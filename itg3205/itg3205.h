@@ -10,6 +10,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "imu_types.h"
+#include "imu_regcache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,10 +21,37 @@ extern "C" {
 #define ITG3205_REG_SAMPLE_RATE_DIV         21
 #define ITG3205_REG_DLPF                    22
 #define ITG3205_REG_INT_CFG                 23
-#define ITG3205_REG_INT_STATUS              23
+#define ITG3205_REG_INT_STATUS              26
 #define ITG3205_REG_DATA                    27
 #define ITG3205_REG_PWR                     62
 
+// WHO_AM_I 的 bit6~1 固定为 0x34, bit0 随 AD0 引脚
+#define ITG3205_WHO_AM_I                    0x68
+#define ITG3205_WHO_AM_I_MASK               0x7E
+
+// INT_CFG
+#define ITG3205_INT_ACTL                    0x80    // 低电平有效
+#define ITG3205_INT_OPEN                    0x40    // 开漏输出
+#define ITG3205_INT_LATCH                   0x20    // 保持到清除为止, 否则为 50us 脉冲
+#define ITG3205_INT_ANYRD_2CLEAR            0x10    // 读任意寄存器清除, 否则只有读状态寄存器清除
+#define ITG3205_INT_ITG_RDY                 0x04    // PLL 就绪
+#define ITG3205_INT_RAW_RDY                 0x01    // 新数据就绪, INT_STATUS 中的位置与 INT_CFG 相同
+
+// PWR_MGM
+#define ITG3205_PWR_H_RESET                 0x80    // 软复位, 完成后自动清零
+#define ITG3205_PWR_SLEEP                   0x40
+#define ITG3205_PWR_STBY_XG                 0x20
+#define ITG3205_PWR_STBY_YG                 0x10
+#define ITG3205_PWR_STBY_ZG                 0x08
+#define ITG3205_PWR_CLK_SEL                 0x07
+
+// DLPF_FS 的 FS_SEL 必须为 3 (+-2000 deg/s), 数据手册要求
+#define ITG3205_DLPF_FS_2000                0x18
+
+// 影子缓存覆盖 SMPLRT_DIV(0x15) ~ PWR_MGM(0x3E)
+#define ITG3205_SHADOW_BASE                 ITG3205_REG_SAMPLE_RATE_DIV
+#define ITG3205_SHADOW_SIZE                 (ITG3205_REG_PWR - ITG3205_SHADOW_BASE + 1)
+
 typedef enum {
     Itg3205Addr_Low  = 0x68,                 // AD0 = LOW
     Itg3205Addr_High = 0x69,                 // AD0 = HIGH
@@ -48,9 +77,9 @@ typedef enum {
 } Itg3205ClockSource;
 
 typedef struct Itg3205Axis_ {
-    float x;
-    float y;
-    float z;
+    imu_real_t x;
+    imu_real_t y;
+    imu_real_t z;
 }Itg3205Axes;  // 修正拼写错误
 
 typedef struct Itg3205RegDlpf_ {
@@ -74,20 +103,36 @@ typedef struct Itg3205_ {
     // sample rate = Finternal / (1 + divider), Finternal = 8KHz if dlpf = 0; Finternal = 1KHz if dlpf != 0
     uint8_t sample_div;                
     Itg3205DlpfBaudrate lpf;
+    Itg3205ClockSource clock_source;    // 数据手册建议用陀螺仪 PLL 作为时钟, 比内部振荡器稳定
     Itg3205_I2cMemFunc read;
     Itg3205_I2cMemFunc write;
 
     int32_t sample_rate;
     int16_t raw_data[4];
-    float temperature;
+    imu_real_t temperature;
     Itg3205Axes axes;
     bool inited;
+    imu_real_t scale;                 // rad/s per LSB
+    ImuRegCache cache;                // 配置寄存器影子, 只写与器件不同的寄存器
+    uint8_t shadow[ITG3205_SHADOW_SIZE];
 } Itg3205;
 
 void Itg3205_Register(Itg3205 *m, Itg3205_I2cMemFunc read, Itg3205_I2cMemFunc write);
 void Itg3205_Init(Itg3205 *m);
-bool Itg3205_Read(Itg3205 *m, float *temp, Itg3205Axes *axes);  // 修正拼写错误
+bool Itg3205_Read(Itg3205 *m, imu_real_t *temp, Itg3205Axes *axes);  // 修正拼写错误
+bool Itg3205_ReadRaw(Itg3205 *m, int16_t raw[3]);
+void Itg3205_UnpackRaw(const uint8_t *bytes, int16_t raw[4]);
+imu_real_t Itg3205_RawToTemperature(int16_t raw);
+imu_real_t Itg3205_GetScale(Itg3205 *m);
 int32_t Itg3205_GetSampleRate(Itg3205 *m);
+bool Itg3205_SetDlpf(Itg3205 *m, Itg3205DlpfBaudrate lpf);
+bool Itg3205_SetSampleDiv(Itg3205 *m, uint8_t sample_div);
+bool Itg3205_SetInterrupt(Itg3205 *m, uint8_t int_cfg);
+bool Itg3205_ReadIntStatus(Itg3205 *m, uint8_t *status);
+bool Itg3205_SetPower(Itg3205 *m, const Itg3205RegPower *power);
+bool Itg3205_Reset(Itg3205 *m);
+bool Itg3205_Sync(Itg3205 *m);
+int32_t Itg3205_Verify(Itg3205 *m, bool resync);
 
 #ifdef __cplusplus
 }
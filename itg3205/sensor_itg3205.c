@@ -0,0 +1,141 @@
+/**
+ * @file sensor_itg3205.c
+ * @author Wyatt Yu
+ * @brief ITG3205 的 RT-Thread 传感器框架设备, 支持轮询/中断两种接收模式
+ * @copyright Copyright (c) 2025
+ */
+#include "sensor_itg3205.h"
+#include "imu_sensor.h"
+
+#define ITG3205_SENSOR_RANGE        2000000     // mdps
+// 锁存到任意读取为止, 读数据寄存器即清除, 不需要额外读状态寄存器
+#define ITG3205_SENSOR_INT_CFG      (ITG3205_INT_LATCH | ITG3205_INT_ANYRD_2CLEAR | ITG3205_INT_RAW_RDY)
+
+static struct rt_i2c_bus_device *itg3205_bus = RT_NULL;
+static Itg3205 itg3205_dev;
+
+static bool Itg3205Sensor_I2cRead(uint8_t addr, uint8_t reg, uint8_t *data, int32_t length)
+{
+    return ImuSensor_I2cRead(itg3205_bus, addr, reg, data, (uint32_t)length);
+}
+
+static bool Itg3205Sensor_I2cWrite(uint8_t addr, uint8_t reg, uint8_t *data, int32_t length)
+{
+    return ImuSensor_I2cWrite(itg3205_bus, addr, reg, data, (uint32_t)length);
+}
+
+// sample rate = Finternal / (1 + divider), 取不低于 odr 的最近一档
+static uint8_t Itg3205Sensor_Divider(rt_uint32_t odr)
+{
+    rt_uint32_t internal = (Itg3205DlpfBaudrate_256 == itg3205_dev.lpf) ? 8000u : 1000u;
+    rt_uint32_t div = (odr > 0) ? internal / odr : 1u;
+    div = (div > 0) ? div - 1 : 0;
+    return (div > 0xFF) ? 0xFF : (uint8_t)div;
+}
+
+static rt_size_t Itg3205Sensor_FetchData(struct rt_sensor_device *sensor, void *buf, rt_size_t len)
+{
+    struct rt_sensor_data *data = (struct rt_sensor_data *)buf;
+    imu_real_t k = RAD2DEGREE(Itg3205_GetScale(&itg3205_dev)) * IMU_REAL(1000.0);      // mdps per LSB
+    int16_t raw[3];
+    (void)sensor;
+
+    if (0 == len || !Itg3205_ReadRaw(&itg3205_dev, raw))
+    {
+        return 0;
+    }
+    data->type = RT_SENSOR_CLASS_GYRO;
+    data->timestamp = rt_sensor_get_ts();
+    data->data.gyro.x = ImuSensor_Round(raw[0] * k);
+    data->data.gyro.y = ImuSensor_Round(raw[1] * k);
+    data->data.gyro.z = ImuSensor_Round(raw[2] * k);
+    return 1;
+}
+
+static rt_err_t Itg3205Sensor_Control(struct rt_sensor_device *sensor, int cmd, void *args)
+{
+    rt_err_t ret = RT_EOK;
+    (void)sensor;
+    switch (cmd)
+    {
+        case RT_SENSOR_CTRL_GET_ID:
+            ret = itg3205_dev.read(itg3205_dev.addr, ITG3205_REG_DEVID, (uint8_t *)args, 1) ? RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_RANGE:
+            ret = (ITG3205_SENSOR_RANGE == (rt_int32_t)(rt_base_t)args) ? RT_EOK : -RT_EINVAL;
+            break;
+        case RT_SENSOR_CTRL_SET_ODR:
+            ret = Itg3205_SetSampleDiv(&itg3205_dev, Itg3205Sensor_Divider((rt_uint32_t)(rt_base_t)args & 0xFFFF)) ?
+                  RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_MODE:
+            switch ((rt_uint8_t)(rt_base_t)args)
+            {
+                case RT_SENSOR_MODE_POLLING:
+                    ret = Itg3205_SetInterrupt(&itg3205_dev, 0) ? RT_EOK : -RT_EIO;
+                    break;
+                case RT_SENSOR_MODE_INT:
+                    ret = Itg3205_SetInterrupt(&itg3205_dev, ITG3205_SENSOR_INT_CFG) ? RT_EOK : -RT_EIO;
+                    break;
+                default:
+                    ret = -RT_ENOSYS;
+                    break;
+            }
+            break;
+        default:
+            ret = -RT_ENOSYS;
+            break;
+    }
+    return ret;
+}
+
+static const struct rt_sensor_ops itg3205_ops = {
+    Itg3205Sensor_FetchData,
+    Itg3205Sensor_Control,
+};
+
+int rt_hw_itg3205_init(const char *name, struct rt_sensor_config *cfg)
+{
+    rt_sensor_t sensor;
+    itg3205_bus = rt_i2c_bus_device_find(cfg->intf.dev_name);
+    if (RT_NULL == itg3205_bus)
+    {
+        return -RT_ERROR;
+    }
+
+    itg3205_dev.addr = cfg->intf.user_data ? (Itg3205Addr)(rt_base_t)cfg->intf.user_data : Itg3205Addr_Low;
+    itg3205_dev.lpf = Itg3205DlpfBaudrate_42;
+    itg3205_dev.sample_div = cfg->odr ? Itg3205Sensor_Divider(cfg->odr) : 9;
+    Itg3205_Register(&itg3205_dev, Itg3205Sensor_I2cRead, Itg3205Sensor_I2cWrite);
+    Itg3205_Init(&itg3205_dev);
+    if (!itg3205_dev.inited)
+    {
+        return -RT_EIO;
+    }
+
+    sensor = (rt_sensor_t)rt_calloc(1, sizeof(struct rt_sensor_device));
+    if (RT_NULL == sensor)
+    {
+        return -RT_ENOMEM;
+    }
+    sensor->info.type       = RT_SENSOR_CLASS_GYRO;
+    sensor->info.vendor     = RT_SENSOR_VENDOR_INVENSENSE;
+    sensor->info.model      = "itg3205";
+    sensor->info.unit       = RT_SENSOR_UNIT_MDPS;
+    sensor->info.intf_type  = RT_SENSOR_INTF_I2C;
+    sensor->info.range_max  = ITG3205_SENSOR_RANGE;
+    sensor->info.range_min  = ITG3205_SENSOR_RANGE;
+    sensor->info.period_min = 1;
+    sensor->info.fifo_max   = 0;
+    rt_memcpy(&sensor->config, cfg, sizeof(struct rt_sensor_config));
+    sensor->config.range = ITG3205_SENSOR_RANGE;
+    sensor->config.odr = (rt_uint16_t)Itg3205_GetSampleRate(&itg3205_dev);
+    sensor->ops = &itg3205_ops;
+
+    if (RT_EOK != rt_hw_sensor_register(sensor, name, RT_DEVICE_FLAG_RDONLY | RT_DEVICE_FLAG_INT_RX, RT_NULL))
+    {
+        rt_free(sensor);
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
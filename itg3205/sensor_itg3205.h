@@ -0,0 +1,20 @@
+/**
+ * @file sensor_itg3205.h
+ * @author Wyatt Yu
+ * @brief ITG3205 的 RT-Thread 传感器框架设备 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __SENSOR_ITG3205_H__
+#define __SENSOR_ITG3205_H__
+#include "sensor.h"
+#include "itg3205.h"
+
+/**
+ * cfg->intf.dev_name 为 I2C 总线名, cfg->intf.user_data 为 7 位地址 (0 时取 Itg3205Addr_Low),
+ * cfg->odr 单位 Hz, 为 0 时保持默认 1kHz / (1 + 9) = 100Hz. 量程固定 +-2000 deg/s.
+ * 芯片没有 FIFO, 只支持轮询与数据就绪中断. 驱动回调不带上下文, 只支持一个实例.
+ */
+int rt_hw_itg3205_init(const char *name, struct rt_sensor_config *cfg);
+
+#endif
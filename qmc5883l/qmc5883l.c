@@ -5,8 +5,25 @@
  * @copyright Copyright (c) 2025
  */
 
+#include <string.h>
 #include "qmc5883l.h"
 
+// sensitivity defined in datasheet, LSB/Gauss
+static void Qmc5883l_UpdateScale(Qmc5883l *qmc5883l)
+{
+    switch (qmc5883l->range)
+    {
+        case Qmc5883lRange_8gauss:
+            qmc5883l->scale = IMU_REAL(1.0) / IMU_REAL(3000.0);
+            break;
+        case Qmc5883lRange_2gauss:
+        case Qmc5883lRange_reserve:
+        default:
+            qmc5883l->scale = IMU_REAL(1.0) / IMU_REAL(12000.0);
+            break;
+    }
+}
+
 void Qmc5883l_Register(Qmc5883l *qmc5883l, Qmc5883l_I2cMemFunc read, Qmc5883l_I2cMemFunc write)
 {
     if (qmc5883l && read && write)
@@ -20,22 +37,55 @@ void Qmc5883l_Register(Qmc5883l *qmc5883l, Qmc5883l_I2cMemFunc read, Qmc5883l_I2
     }
 }
 
-bool Qmc5883l_Init(Qmc5883l *qmc5883l)
+// 将缓存中的脏寄存器按连续地址分段突发写入
+bool Qmc5883l_Sync(Qmc5883l *qmc5883l)
 {
-    if (qmc5883l && qmc5883l->read && qmc5883l->write)
+    uint8_t reg, length;
+    while (ImuRegCache_NextDirty(&qmc5883l->cache, &reg, &length))
     {
-        if (Qmc5883l_Set(qmc5883l, Qmc5883lCmd_ChipId, 0))  // chip available
+        if (!qmc5883l->write(QMC5883L_ADDR, reg, ImuRegCache_Data(&qmc5883l->cache, reg), length))
         {
-            Qmc5883l_Set(qmc5883l, Qmc5883lCmd_ResetPeriod, 0x01);   
+            return false;
+        }
+        ImuRegCache_Clean(&qmc5883l->cache, reg, length);
+    }
+    return true;
+}
 
-            uint8_t control1 = (qmc5883l->ov_ratio << 6) | (qmc5883l->range << 4) | \
-                                (qmc5883l->sample_rate << 2) | qmc5883l->mode;
-            qmc5883l->write(QMC5883L_ADDR, 0x09, &control1, 1);
+/**
+ * 读回 CONTROL1/CONTROL2/SET_RESET_PERIOD 与缓存核对, 返回不一致的个数, 总线错误返回 -1.
+ * resync 为 true 时把缓存值重新写入器件, 否则以器件值为准.
+ */
+int32_t Qmc5883l_Verify(Qmc5883l *qmc5883l, bool resync)
+{
+    uint8_t block[QMC5883L_SHADOW_SIZE];
+    if (!qmc5883l || !qmc5883l->inited || !qmc5883l->read(QMC5883L_ADDR, QMC5883L_SHADOW_BASE, block, sizeof(block)))
+    {
+        return -1;
+    }
+    int32_t mismatch = ImuRegCache_Fill(&qmc5883l->cache, QMC5883L_SHADOW_BASE, block, sizeof(block), resync);
+    if (resync && mismatch > 0 && !Qmc5883l_Sync(qmc5883l))
+    {
+        return -1;
+    }
+    return mismatch;
+}
 
-            uint8_t control2 = 0x40;
-            qmc5883l->write(QMC5883L_ADDR, 0x0A, &control2, 1); 
-            qmc5883l->inited = true;
-            return true;
+bool Qmc5883l_Init(Qmc5883l *qmc5883l)
+{
+    if (qmc5883l && qmc5883l->read && qmc5883l->write)
+    {
+        if (Qmc5883l_Set(qmc5883l, Qmc5883lCmd_ChipId, 0) && QMC5883L_CHIP_ID == qmc5883l->reg.chip_id)  // chip available
+        {
+            // 器件状态未知, 所有配置都重新写入, 0x09 ~ 0x0B 合并为一次写
+            ImuRegCache_Init(&qmc5883l->cache, QMC5883L_SHADOW_BASE, QMC5883L_SHADOW_SIZE, qmc5883l->shadow);
+            ImuRegCache_Set(&qmc5883l->cache, QMC5883L_REG_CONTROL1, (qmc5883l->ov_ratio << 6) | (qmc5883l->range << 4) | \
+                                (qmc5883l->sample_rate << 2) | qmc5883l->mode);
+            ImuRegCache_Set(&qmc5883l->cache, QMC5883L_REG_CONTROL2, QMC5883L_CONTROL2_ROL_PNT);
+            ImuRegCache_Set(&qmc5883l->cache, QMC5883L_REG_PERIOD, 0x01);
+            Qmc5883l_UpdateScale(qmc5883l);
+            qmc5883l->inited = Qmc5883l_Sync(qmc5883l);
+            return qmc5883l->inited;
         }
         else 
         {
@@ -48,51 +98,73 @@ bool Qmc5883l_Init(Qmc5883l *qmc5883l)
     }
 }
 
-// something wrong
+static bool Qmc5883l_Update(Qmc5883l *qmc5883l, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    ImuRegCache_Update(&qmc5883l->cache, reg, mask, value);
+    return Qmc5883l_Sync(qmc5883l);
+}
+
+// 配置类命令只在寄存器值变化时产生总线写
 bool Qmc5883l_Set(Qmc5883l *qmc5883l, Qmc5883lCmd cmd, uint8_t data)
 {
     if (qmc5883l->read && qmc5883l->write)
     {
         int32_t ret = false;
+        uint8_t buffer[8];
         switch (cmd)
         {
         case Qmc5883lCmd_Mode:
-            qmc5883l->reg.control.mode = data;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x09, (uint8_t *)&qmc5883l->reg.control, 1);
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_CONTROL1, 0x03, data);
+            qmc5883l->mode = ret ? (Qmc5883lMode)data : qmc5883l->mode;
             break;
         case Qmc5883lCmd_DataRate:
-            qmc5883l->reg.control.odr = data;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x09, (uint8_t *)&qmc5883l->reg.control, 1);
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_CONTROL1, 0x0C, data << 2);
+            qmc5883l->sample_rate = ret ? (Qmc5883lRate)data : qmc5883l->sample_rate;
             break;
         case Qmc5883lCmd_FullScale:
-            qmc5883l->reg.control.rng = data;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x09, (uint8_t *)&qmc5883l->reg.control, 1);
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_CONTROL1, 0x30, data << 4);
+            if (ret)
+            {
+                qmc5883l->range = (Qmc5883lRange)data;
+                Qmc5883l_UpdateScale(qmc5883l);
+            }
             break;
         case Qmc5883lCmd_OverSampleRate:
-            qmc5883l->reg.control.osr = data;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x09, (uint8_t *)&qmc5883l->reg.control, 1);
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_CONTROL1, 0xC0, data << 6);
+            qmc5883l->ov_ratio = ret ? (Qmc5883lOverSampleRatio)data : qmc5883l->ov_ratio;
             break;
         case Qmc5883lCmd_Reset:
-            qmc5883l->reg.control2.soft_reset = data;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x0A, (uint8_t *)&qmc5883l->reg.control2, 1);
+            // 软复位位自动清零且复位所有寄存器, 不经过缓存
+            buffer[0] = data ? QMC5883L_CONTROL2_SOFT_RST : 0;
+            ret = qmc5883l->write(QMC5883L_ADDR, QMC5883L_REG_CONTROL2, buffer, 1);
+            if (ret && data)
+            {
+                ImuRegCache_Invalidate(&qmc5883l->cache);
+            }
             break;
         case Qmc5883lCmd_ResetPeriod:
             qmc5883l->reg.reset_period = data;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x0B, (uint8_t *)&qmc5883l->reg.reset_period, 1);
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_PERIOD, 0xFF, data);
             break;
         case Qmc5883lCmd_RolPnt:
-            qmc5883l->reg.control2.rol_pnt = data ? 1 : 0;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x0A, (uint8_t *)&qmc5883l->reg.control2, 1);
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_CONTROL2, QMC5883L_CONTROL2_ROL_PNT, data ? 0xFF : 0);
             break;
         case Qmc5883lCmd_InterruptEnable:
-            qmc5883l->reg.control2.int_enable = data ? 1 : 0;
-            ret = qmc5883l->write(QMC5883L_ADDR, 0x0A, (uint8_t *)&qmc5883l->reg.control2, 1);
+            // INT_ENB 为 1 时关闭中断引脚
+            ret = Qmc5883l_Update(qmc5883l, QMC5883L_REG_CONTROL2, QMC5883L_CONTROL2_INT_ENB, data ? 0xFF : 0);
             break;
         case Qmc5883lCmd_ChipId:
-            ret = qmc5883l->read(QMC5883L_ADDR, 0x0D, (uint8_t *)&qmc5883l->reg.chip_id, 1);
+            ret = qmc5883l->read(QMC5883L_ADDR, QMC5883L_REG_CHIP_ID, (uint8_t *)&qmc5883l->reg.chip_id, 1);
             break;
         case Qmc5883lCmd_ReadStatus:
-            ret = qmc5883l->read(QMC5883L_ADDR, 0x06, (uint8_t *)&qmc5883l->reg.status, 8);
+            // 0x06 ~ 0x0D, 其中 0x0C 保留, 不能直接读进 reg
+            ret = qmc5883l->read(QMC5883L_ADDR, 0x06, buffer, 8);
+            if (ret)
+            {
+                memcpy(&qmc5883l->reg.status, buffer, 6);
+                qmc5883l->reg.chip_id = buffer[7];
+                ImuRegCache_Fill(&qmc5883l->cache, QMC5883L_SHADOW_BASE, &buffer[3], QMC5883L_SHADOW_SIZE, false);
+            }
             break;
         default:
             ret = false;
@@ -106,43 +178,48 @@ bool Qmc5883l_Set(Qmc5883l *qmc5883l, Qmc5883lCmd cmd, uint8_t data)
     }
 }
 
-bool Qmc5883l_Read(Qmc5883l *qmc5883l, Qmc5883lAxes *axes)
+void Qmc5883l_UnpackRaw(const uint8_t *bytes, int16_t raw[3])
 {
-    bool ret = false;
-    if (qmc5883l && qmc5883l->inited)
-    {
-        uint8_t buffer[6] = {0};
-        qmc5883l->read(QMC5883L_ADDR, 0, buffer, 6);
-        qmc5883l->raw_data[0] = buffer[0] | (buffer[1] << 8);
-        qmc5883l->raw_data[1] = buffer[2] | (buffer[3] << 8);
-        qmc5883l->raw_data[2] = buffer[4] | (buffer[5] << 8);
+    raw[0] = (int16_t)(bytes[0] | (bytes[1] << 8));
+    raw[1] = (int16_t)(bytes[2] | (bytes[3] << 8));
+    raw[2] = (int16_t)(bytes[4] | (bytes[5] << 8));
+}
 
-        float sensitivity = 12000.0;        // sensitivity defined in datasheet
-        switch (qmc5883l->range)
-        {
-            case Qmc5883lRange_2gauss:
-                sensitivity = 12000.0;
-                break;
-            case Qmc5883lRange_8gauss:
-                sensitivity = 3000.0;
-                break;
-            case Qmc5883lRange_reserve:
-                sensitivity = 12000.0;
-                break;
-            default:
-                break;
-        }
-        qmc5883l->axes.x = ((int16_t)(buffer[0] | (buffer[1] << 8))) / sensitivity;
-        qmc5883l->axes.y = ((int16_t)(buffer[2] | (buffer[3] << 8))) / sensitivity;
-        qmc5883l->axes.z = ((int16_t)(buffer[4] | (buffer[5] << 8))) / sensitivity;
-        ret = true;
+// 只读取原始计数, 不做浮点换算
+bool Qmc5883l_ReadRaw(Qmc5883l *qmc5883l, int16_t raw[3])
+{
+    uint8_t buffer[6] = {0};
+    if (qmc5883l && qmc5883l->inited && qmc5883l->read(QMC5883L_ADDR, QMC5883L_REG_DATA, buffer, 6))
+    {
+        Qmc5883l_UnpackRaw(buffer, qmc5883l->raw_data);
+        raw[0] = qmc5883l->raw_data[0];
+        raw[1] = qmc5883l->raw_data[1];
+        raw[2] = qmc5883l->raw_data[2];
+        return true;
     }
     else
     {
-        ret = false;
+        return false;
+    }
+}
+
+bool Qmc5883l_Read(Qmc5883l *qmc5883l, Qmc5883lAxes *axes)
+{
+    int16_t raw[3];
+    bool ret = Qmc5883l_ReadRaw(qmc5883l, raw);
+    if (ret)
+    {
+        qmc5883l->axes.x = raw[0] * qmc5883l->scale;
+        qmc5883l->axes.y = raw[1] * qmc5883l->scale;
+        qmc5883l->axes.z = raw[2] * qmc5883l->scale;
     }
     axes->x = qmc5883l->axes.x;
     axes->y = qmc5883l->axes.y;
     axes->z = qmc5883l->axes.z;
     return ret;
 }
+
+imu_real_t Qmc5883l_GetScale(Qmc5883l *qmc5883l)
+{
+    return qmc5883l->scale;
+}
@@ -10,6 +10,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "imu_types.h"
+#include "imu_regcache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +19,24 @@ extern "C" {
 
 #define QMC5883L_ADDR   0x0D
 
+#define QMC5883L_REG_DATA               0x00
+#define QMC5883L_REG_STATUS             0x06
+#define QMC5883L_REG_CONTROL1           0x09
+#define QMC5883L_REG_CONTROL2           0x0A
+#define QMC5883L_REG_PERIOD             0x0B
+#define QMC5883L_REG_CHIP_ID            0x0D
+
+#define QMC5883L_CHIP_ID                0xFF
+#define QMC5883L_STATUS_DRDY            0x01
+
+#define QMC5883L_CONTROL2_SOFT_RST      0x80
+#define QMC5883L_CONTROL2_ROL_PNT       0x40
+#define QMC5883L_CONTROL2_INT_ENB       0x01
+
+// 影子缓存覆盖 CONTROL1(0x09) ~ SET_RESET_PERIOD(0x0B)
+#define QMC5883L_SHADOW_BASE            QMC5883L_REG_CONTROL1
+#define QMC5883L_SHADOW_SIZE            3
+
 typedef enum {
     Qmc5883lMode_Standby    = 0,
     Qmc5883lMode_Continuous = 1,
@@ -84,9 +104,9 @@ typedef struct Qmc5883lReg_ {
 #pragma pack(pop)
 
 typedef struct Qmc5883lAxis_ {
-    float x;
-    float y;
-    float z;
+    imu_real_t x;
+    imu_real_t y;
+    imu_real_t z;
 }Qmc5883lAxes;
 
 typedef bool (*Qmc5883l_I2cMemFunc)(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length);
@@ -102,14 +122,22 @@ typedef struct Qmc5883l_ {
 
     int16_t raw_data[3];
     Qmc5883lAxes axes;
-    float temperature;
+    imu_real_t temperature;
     bool inited;
+    imu_real_t scale;               // Gauss per LSB, 由 range 在初始化时确定
+    ImuRegCache cache;              // 配置寄存器影子, 只写与器件不同的寄存器
+    uint8_t shadow[QMC5883L_SHADOW_SIZE];
 }Qmc5883l;
 
 void Qmc5883l_Register(Qmc5883l *qmc5883l, Qmc5883l_I2cMemFunc read, Qmc5883l_I2cMemFunc write);
 bool Qmc5883l_Init(Qmc5883l *qmc5883l);
 bool Qmc5883l_Set(Qmc5883l *qmc5883l, Qmc5883lCmd cmd, uint8_t data);
 bool Qmc5883l_Read(Qmc5883l *qmc5883l, Qmc5883lAxes *axes);
+bool Qmc5883l_ReadRaw(Qmc5883l *qmc5883l, int16_t raw[3]);
+void Qmc5883l_UnpackRaw(const uint8_t *bytes, int16_t raw[3]);
+imu_real_t Qmc5883l_GetScale(Qmc5883l *qmc5883l);
+bool Qmc5883l_Sync(Qmc5883l *qmc5883l);
+int32_t Qmc5883l_Verify(Qmc5883l *qmc5883l, bool resync);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,161 @@
+/**
+ * @file sensor_qmc5883l.c
+ * @author Wyatt Yu
+ * @brief QMC5883L 的 RT-Thread 传感器框架设备, 支持轮询/中断两种接收模式
+ * @copyright Copyright (c) 2025
+ */
+#include "sensor_qmc5883l.h"
+#include "imu_sensor.h"
+
+static struct rt_i2c_bus_device *qmc5883l_bus = RT_NULL;
+static Qmc5883l qmc5883l_dev;
+
+static bool Qmc5883lSensor_I2cRead(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    return ImuSensor_I2cRead(qmc5883l_bus, addr, reg, data, length);
+}
+
+static bool Qmc5883lSensor_I2cWrite(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t length)
+{
+    return ImuSensor_I2cWrite(qmc5883l_bus, addr, reg, data, length);
+}
+
+static Qmc5883lRate Qmc5883lSensor_Rate(rt_uint32_t odr)
+{
+    return (odr <= 10) ? Qmc5883lRate_10hz : (odr <= 50) ? Qmc5883lRate_50hz :
+           (odr <= 100) ? Qmc5883lRate_100hz : Qmc5883lRate_200hz;
+}
+
+static rt_uint16_t Qmc5883lSensor_Odr(Qmc5883lRate rate)
+{
+    static const rt_uint16_t odr[] = {10, 50, 100, 200};
+    return odr[rate & 0x03];
+}
+
+static Qmc5883lRange Qmc5883lSensor_Range(rt_int32_t range)
+{
+    return (range <= 2000) ? Qmc5883lRange_2gauss : Qmc5883lRange_8gauss;
+}
+
+static rt_size_t Qmc5883lSensor_FetchData(struct rt_sensor_device *sensor, void *buf, rt_size_t len)
+{
+    struct rt_sensor_data *data = (struct rt_sensor_data *)buf;
+    imu_real_t k = Qmc5883l_GetScale(&qmc5883l_dev) * IMU_REAL(1000.0);   // mGauss per LSB
+    int16_t raw[3];
+    (void)sensor;
+
+    if (0 == len || !Qmc5883l_ReadRaw(&qmc5883l_dev, raw))
+    {
+        return 0;
+    }
+    data->type = RT_SENSOR_CLASS_MAG;
+    data->timestamp = rt_sensor_get_ts();
+    data->data.mag.x = ImuSensor_Round(raw[0] * k);
+    data->data.mag.y = ImuSensor_Round(raw[1] * k);
+    data->data.mag.z = ImuSensor_Round(raw[2] * k);
+    return 1;
+}
+
+static rt_err_t Qmc5883lSensor_Control(struct rt_sensor_device *sensor, int cmd, void *args)
+{
+    rt_err_t ret = RT_EOK;
+    (void)sensor;
+    switch (cmd)
+    {
+        case RT_SENSOR_CTRL_GET_ID:
+            ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_ChipId, 0) ? RT_EOK : -RT_EIO;
+            *(rt_uint8_t *)args = qmc5883l_dev.reg.chip_id;
+            break;
+        case RT_SENSOR_CTRL_SET_RANGE:
+            ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_FullScale, Qmc5883lSensor_Range((rt_int32_t)(rt_base_t)args)) ?
+                  RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_ODR:
+            ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_DataRate,
+                               Qmc5883lSensor_Rate((rt_uint32_t)(rt_base_t)args & 0xFFFF)) ? RT_EOK : -RT_EIO;
+            break;
+        case RT_SENSOR_CTRL_SET_MODE:
+            // INT_ENB 为 1 时关闭中断引脚
+            switch ((rt_uint8_t)(rt_base_t)args)
+            {
+                case RT_SENSOR_MODE_POLLING:
+                    ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_InterruptEnable, 1) ? RT_EOK : -RT_EIO;
+                    break;
+                case RT_SENSOR_MODE_INT:
+                    ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_InterruptEnable, 0) ? RT_EOK : -RT_EIO;
+                    break;
+                default:
+                    ret = -RT_ENOSYS;
+                    break;
+            }
+            break;
+        case RT_SENSOR_CTRL_SET_POWER:
+            switch ((rt_uint8_t)(rt_base_t)args)
+            {
+                case RT_SENSOR_POWER_DOWN:
+                    ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_Mode, Qmc5883lMode_Standby) ? RT_EOK : -RT_EIO;
+                    break;
+                case RT_SENSOR_POWER_NORMAL:
+                    ret = Qmc5883l_Set(&qmc5883l_dev, Qmc5883lCmd_Mode, Qmc5883lMode_Continuous) ? RT_EOK : -RT_EIO;
+                    break;
+                default:
+                    ret = -RT_ENOSYS;
+                    break;
+            }
+            break;
+        default:
+            ret = -RT_ENOSYS;
+            break;
+    }
+    return ret;
+}
+
+static const struct rt_sensor_ops qmc5883l_ops = {
+    Qmc5883lSensor_FetchData,
+    Qmc5883lSensor_Control,
+};
+
+int rt_hw_qmc5883l_init(const char *name, struct rt_sensor_config *cfg)
+{
+    rt_sensor_t sensor;
+    qmc5883l_bus = rt_i2c_bus_device_find(cfg->intf.dev_name);
+    if (RT_NULL == qmc5883l_bus)
+    {
+        return -RT_ERROR;
+    }
+
+    qmc5883l_dev.mode = Qmc5883lMode_Continuous;
+    qmc5883l_dev.ov_ratio = Qmc5883lOsr_512;
+    qmc5883l_dev.range = cfg->range ? Qmc5883lSensor_Range(cfg->range) : Qmc5883lRange_8gauss;
+    qmc5883l_dev.sample_rate = cfg->odr ? Qmc5883lSensor_Rate(cfg->odr) : Qmc5883lRate_100hz;
+    Qmc5883l_Register(&qmc5883l_dev, Qmc5883lSensor_I2cRead, Qmc5883lSensor_I2cWrite);
+    if (!Qmc5883l_Init(&qmc5883l_dev))
+    {
+        return -RT_EIO;
+    }
+
+    sensor = (rt_sensor_t)rt_calloc(1, sizeof(struct rt_sensor_device));
+    if (RT_NULL == sensor)
+    {
+        return -RT_ENOMEM;
+    }
+    sensor->info.type       = RT_SENSOR_CLASS_MAG;
+    sensor->info.vendor     = RT_SENSOR_VENDOR_UNKNOWN;
+    sensor->info.model      = "qmc5883l";
+    sensor->info.unit       = RT_SENSOR_UNIT_MGAUSS;
+    sensor->info.intf_type  = RT_SENSOR_INTF_I2C;
+    sensor->info.range_max  = 8000;
+    sensor->info.range_min  = 2000;
+    sensor->info.period_min = 5;
+    sensor->info.fifo_max   = 0;
+    rt_memcpy(&sensor->config, cfg, sizeof(struct rt_sensor_config));
+    sensor->config.odr = Qmc5883lSensor_Odr(qmc5883l_dev.sample_rate);
+    sensor->ops = &qmc5883l_ops;
+
+    if (RT_EOK != rt_hw_sensor_register(sensor, name, RT_DEVICE_FLAG_RDONLY | RT_DEVICE_FLAG_INT_RX, RT_NULL))
+    {
+        rt_free(sensor);
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file sensor_qmc5883l.h
+ * @author Wyatt Yu
+ * @brief QMC5883L 的 RT-Thread 传感器框架设备 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __SENSOR_QMC5883L_H__
+#define __SENSOR_QMC5883L_H__
+#include "sensor.h"
+#include "qmc5883l.h"
+
+/**
+ * cfg->intf.dev_name 为 I2C 总线名, 地址固定为 QMC5883L_ADDR.
+ * cfg->range 单位 mGauss, cfg->odr 单位 Hz, 为 0 时保持默认 8Gauss / 100Hz.
+ * 芯片没有 FIFO, 只支持轮询与 DRDY 中断. 驱动回调不带上下文, 只支持一个实例.
+ */
+int rt_hw_qmc5883l_init(const char *name, struct rt_sensor_config *cfg);
+
+#endif
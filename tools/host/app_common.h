@@ -0,0 +1,20 @@
+/**
+ * @file app_common.h
+ * @author Wyatt Yu
+ * @brief 主机端工具使用的 app_common.h 替代, 只提供 IMU 库用到的定义
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __APP_COMMON_H__
+#define __APP_COMMON_H__
+#include <math.h>
+
+#define MATH_PI                 3.14159265358979f
+#define MATH_2PI                6.28318530717959f
+
+static inline float InvSqrt(float x)
+{
+    return 1.0f / sqrtf(x);
+}
+
+#endif
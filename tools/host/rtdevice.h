@@ -0,0 +1,11 @@
+/**
+ * @file rtdevice.h
+ * @author Wyatt Yu
+ * @brief 主机端工具使用的 rtdevice.h 替代, IMU 融合部分不依赖 RT-Thread
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __RTDEVICE_H__
+#define __RTDEVICE_H__
+
+#endif
@@ -0,0 +1,343 @@
+/**
+ * @file imu_allan.c
+ * @author Wyatt Yu
+ * @brief 长时间静止记录的 Allan 方差分析, 单遍流式计算, 内存 O(log n)
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Itools tools/imu_allan.c tools/imu_pool.c tools/imu_log.c -lm -lpthread -o imu_allan
+ * 用法:
+ *   imu_allan [-j threads] [-f samp_freq] [-o curves.csv] log1.csv [log2.csv ...]
+ * 记录文件格式见 imu_log.h, 传感器需在整个记录期间保持静止, "-" 表示从标准输入读取.
+ *
+ * 按 tau = 2^k * tau0 的倍频程计算重叠 Allan 方差: 第 k 级保存长度为 2^k 的不重叠块均值,
+ * 每得到一个新块, 用最近 4 个块构成相邻的两个长度 2^(k+1), 起点错开半个块长的平均值并累加差值平方,
+ * 即 50% 重叠估计. 每个轴只保存每级的 3 个历史块与求和量, 可以处理放不进内存的多小时记录.
+ * 从曲线中提取:
+ *   N (角度/速度随机游走): 斜率 -1/2 段上 sigma * sqrt(tau)
+ *   B (零偏不稳定性): 曲线最低点 sigma / 0.664
+ *   K (角速率/加速度随机游走): 斜率 +1/2 段上 sigma * sqrt(3 / tau)
+ * 文件数少于线程数时, 每个文件再按 accel/gyro/magic 拆成三个任务.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include "imu_log.h"
+#include "imu_pool.h"
+
+#define IMU_ALLAN_LEVELS        48
+#define IMU_ALLAN_AXES          9           // accel xyz, gyro xyz, magic xyz
+#define IMU_ALLAN_CHUNK         4096
+#define IMU_ALLAN_MIN_COUNT     4           // 差值个数少于此值的 tau 不输出
+#define IMU_ALLAN_PI            3.14159265358979
+
+typedef struct ImuAllanLevel_ {
+    double hist[3];             // 最近 3 个长度 2^k 的块均值, hist[2] 最新
+    int32_t filled;
+    double pending;             // 等待配对合成下一级的块
+    bool has_pending;
+}ImuAllanLevel;
+
+typedef struct ImuAllanAxis_ {
+    ImuAllanLevel level[IMU_ALLAN_LEVELS];
+    double sum2[IMU_ALLAN_LEVELS + 1];     // tau = 2^k * tau0 的差值平方和
+    int64_t count[IMU_ALLAN_LEVELS + 1];
+}ImuAllanAxis;
+
+typedef struct ImuAllanResult_ {
+    double tau0;
+    int64_t samples;
+    double adev[IMU_ALLAN_AXES][IMU_ALLAN_LEVELS + 1];
+    int64_t count[IMU_ALLAN_AXES][IMU_ALLAN_LEVELS + 1];
+    bool ok;
+}ImuAllanResult;
+
+typedef struct ImuAllan_ {
+    char **paths;
+    int32_t file_count;
+    int32_t split;              // 每个文件的任务数, 1 或 3
+    double samp_freq;           // 0 表示由时间戳估计
+    ImuAllanResult *result;
+}ImuAllan;
+
+static const char *imu_allan_axis_names[IMU_ALLAN_AXES] = {
+    "accel.x", "accel.y", "accel.z", "gyro.x", "gyro.y", "gyro.z", "magic.x", "magic.y", "magic.z",
+};
+
+static void ImuAllan_Push(ImuAllanAxis *a, int32_t k, double h)
+{
+    while (k < IMU_ALLAN_LEVELS)
+    {
+        ImuAllanLevel *l = &a->level[k];
+        if (0 == k && l->filled >= 1)
+        {
+            // tau0: 相邻样本
+            double d = h - l->hist[2];
+            a->sum2[0] += d * d;
+            a->count[0]++;
+        }
+        if (l->filled >= 3)
+        {
+            // tau = 2^(k+1): 起点错开 2^k 的两个相邻块
+            double d = 0.5 * ((l->hist[2] + h) - (l->hist[0] + l->hist[1]));
+            a->sum2[k + 1] += d * d;
+            a->count[k + 1]++;
+        }
+        l->hist[0] = l->hist[1];
+        l->hist[1] = l->hist[2];
+        l->hist[2] = h;
+        l->filled += (l->filled < 3) ? 1 : 0;
+
+        if (!l->has_pending)
+        {
+            l->pending = h;
+            l->has_pending = true;
+            return;
+        }
+        h = 0.5 * (l->pending + h);
+        l->has_pending = false;
+        k++;
+    }
+}
+
+static void ImuAllan_Job(void *arg, int32_t job, int32_t worker)
+{
+    ImuAllan *al = (ImuAllan *)arg;
+    int32_t file = job / al->split;
+    int32_t first = (al->split > 1) ? (job % al->split) * 3 : 0;
+    int32_t last = (al->split > 1) ? first + 3 : IMU_ALLAN_AXES;
+    ImuAllanResult *r = &al->result[file];
+    ImuAllanAxis *axis = calloc(IMU_ALLAN_AXES, sizeof(ImuAllanAxis));
+    ImuLogSample *samples = malloc(sizeof(ImuLogSample) * IMU_ALLAN_CHUNK);
+    int64_t t_first = 0, t_last = 0, n_total = 0;
+    ImuLog log;
+    int32_t n;
+    (void)worker;
+
+    if (!ImuLog_Open(&log, al->paths[file]))
+    {
+        fprintf(stderr, "imu_allan: cannot open %s\n", al->paths[file]);
+        free(axis);
+        free(samples);
+        return;
+    }
+    while ((n = ImuLog_Read(&log, samples, IMU_ALLAN_CHUNK)) > 0)
+    {
+        if (0 == n_total)
+        {
+            t_first = samples[0].t_us;
+        }
+        t_last = samples[n - 1].t_us;
+        for (int32_t i = 0; i < n; i++)
+        {
+            const ImuLogSample *s = &samples[i];
+            for (int32_t a = first; a < last; a++)
+            {
+                double v = (a < 3) ? s->accel[a] : (a < 6) ? s->gyro[a - 3] : s->magic[a - 6];
+                ImuAllan_Push(&axis[a], 0, v);
+            }
+        }
+        n_total += n;
+    }
+    ImuLog_Close(&log);
+
+    // 各拆分任务写入结果的不同轴, 公共字段写入相同的值
+    r->samples = n_total;
+    r->tau0 = (al->samp_freq > 0) ? 1.0 / al->samp_freq :
+              (n_total > 1) ? (t_last - t_first) * 1e-6 / (n_total - 1) : 0.0;
+    r->ok = n_total > 1 && r->tau0 > 0.0;
+    for (int32_t a = first; a < last; a++)
+    {
+        for (int32_t k = 0; k <= IMU_ALLAN_LEVELS; k++)
+        {
+            r->count[a][k] = axis[a].count[k];
+            r->adev[a][k] = axis[a].count[k] ? sqrt(axis[a].sum2[k] / (2.0 * axis[a].count[k])) : 0.0;
+        }
+    }
+    free(axis);
+    free(samples);
+}
+
+typedef struct ImuAllanNoise_ {
+    double n;                   // 随机游走系数, 单位/sqrt(s) * s
+    double b;                   // 零偏不稳定性
+    double b_tau;
+    double k;                   // 速率随机游走
+    bool has_n, has_k;
+}ImuAllanNoise;
+
+static void ImuAllan_Extract(const ImuAllanResult *r, int32_t a, ImuAllanNoise *noise)
+{
+    double tau[IMU_ALLAN_LEVELS + 1], sig[IMU_ALLAN_LEVELS + 1];
+    int32_t m = 0;
+    double n_sum = 0.0, k_sum = 0.0;
+    int32_t n_cnt = 0, k_cnt = 0;
+
+    memset(noise, 0, sizeof(ImuAllanNoise));
+    for (int32_t k = 0; k <= IMU_ALLAN_LEVELS; k++)
+    {
+        if (r->count[a][k] >= IMU_ALLAN_MIN_COUNT && r->adev[a][k] > 0.0)
+        {
+            tau[m] = r->tau0 * ldexp(1.0, k);
+            sig[m] = r->adev[a][k];
+            m++;
+        }
+    }
+    if (0 == m)
+    {
+        return;
+    }
+
+    noise->b = sig[0];
+    noise->b_tau = tau[0];
+    for (int32_t i = 0; i < m; i++)
+    {
+        if (sig[i] < noise->b)
+        {
+            noise->b = sig[i];
+            noise->b_tau = tau[i];
+        }
+        // 局部斜率取相邻两点的中心差分
+        int32_t lo = (i > 0) ? i - 1 : i;
+        int32_t hi = (i < m - 1) ? i + 1 : i;
+        if (hi == lo)
+        {
+            continue;
+        }
+        double slope = log(sig[hi] / sig[lo]) / log(tau[hi] / tau[lo]);
+        if (slope > -0.75 && slope < -0.25)
+        {
+            n_sum += log(sig[i] * sqrt(tau[i]));
+            n_cnt++;
+        }
+        else if (slope > 0.25 && slope < 0.75)
+        {
+            k_sum += log(sig[i] * sqrt(3.0 / tau[i]));
+            k_cnt++;
+        }
+    }
+    noise->b /= 0.664;
+    // 没有明显的 -1/2 段时, 最短 tau 处白噪声占主导
+    noise->n = n_cnt ? exp(n_sum / n_cnt) : sig[0] * sqrt(tau[0]);
+    noise->has_n = true;
+    noise->k = k_cnt ? exp(k_sum / k_cnt) : 0.0;
+    noise->has_k = k_cnt > 0;
+}
+
+static void ImuAllan_Report(const ImuAllan *al, const char *out)
+{
+    FILE *fp = out ? fopen(out, "w") : NULL;
+    if (out && !fp)
+    {
+        fprintf(stderr, "imu_allan: cannot write %s\n", out);
+    }
+    if (fp)
+    {
+        fprintf(fp, "file,axis,tau_s,adev,count\n");
+    }
+
+    for (int32_t f = 0; f < al->file_count; f++)
+    {
+        const ImuAllanResult *r = &al->result[f];
+        if (!r->ok)
+        {
+            printf("%s: no data\n", al->paths[f]);
+            continue;
+        }
+        printf("%s: %lld samples, tau0 %.6g s, %.2f h\n", al->paths[f], (long long)r->samples, r->tau0,
+               r->samples * r->tau0 / 3600.0);
+        printf("  %-8s %16s %16s %10s %16s\n", "axis", "N", "B", "B tau(s)", "K");
+        for (int32_t a = 0; a < IMU_ALLAN_AXES; a++)
+        {
+            ImuAllanNoise noise;
+            ImuAllan_Extract(r, a, &noise);
+            if (!noise.has_n)
+            {
+                continue;
+            }
+            if (a >= 3 && a < 6)
+            {
+                // 陀螺: ARW deg/sqrt(h), 零偏不稳定性 deg/h, RRW deg/h/sqrt(h)
+                double deg = 180.0 / IMU_ALLAN_PI;
+                printf("  %-8s %10.4g dg/rh  %9.4g dg/h %10.4g %10.4g dg/h/rh%s\n", imu_allan_axis_names[a],
+                       noise.n * deg * 60.0, noise.b * deg * 3600.0, noise.b_tau, noise.k * deg * 3600.0 * 60.0,
+                       noise.has_k ? "" : " (n/a)");
+            }
+            else if (a < 3)
+            {
+                // 加速度计: VRW m/s/sqrt(h), 零偏不稳定性 mg, 加速度随机游走 m/s2/sqrt(s)
+                printf("  %-8s %10.4g m/s/rh %9.4g mg   %10.4g %10.4g m/s2/rs%s\n", imu_allan_axis_names[a],
+                       noise.n * 60.0, noise.b / 9.81 * 1000.0, noise.b_tau, noise.k, noise.has_k ? "" : " (n/a)");
+            }
+            else
+            {
+                // 磁力计: Gauss 为单位, 时间为 s
+                printf("  %-8s %10.4g G*rs   %9.4g G    %10.4g %10.4g G/rs%s\n", imu_allan_axis_names[a],
+                       noise.n, noise.b, noise.b_tau, noise.k, noise.has_k ? "" : " (n/a)");
+            }
+            if (fp)
+            {
+                for (int32_t k = 0; k <= IMU_ALLAN_LEVELS; k++)
+                {
+                    if (r->count[a][k] >= IMU_ALLAN_MIN_COUNT)
+                    {
+                        fprintf(fp, "%s,%s,%.9g,%.9g,%lld\n", al->paths[f], imu_allan_axis_names[a],
+                                r->tau0 * ldexp(1.0, k), r->adev[a][k], (long long)r->count[a][k]);
+                    }
+                }
+            }
+        }
+    }
+    if (fp)
+    {
+        fclose(fp);
+    }
+}
+
+static void ImuAllan_Usage(void)
+{
+    fprintf(stderr, "usage: imu_allan [-j threads] [-f samp_freq] [-o curves.csv] log.csv ...\n");
+}
+
+int main(int argc, char **argv)
+{
+    ImuAllan al = {0};
+    int32_t threads = 0;
+    const char *out = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:f:o:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j': threads = atoi(optarg); break;
+            case 'f': al.samp_freq = atof(optarg); break;
+            case 'o': out = optarg; break;
+            default: ImuAllan_Usage(); return 1;
+        }
+    }
+    al.paths = &argv[optind];
+    al.file_count = argc - optind;
+    if (al.file_count <= 0)
+    {
+        ImuAllan_Usage();
+        return 1;
+    }
+    if (threads <= 0)
+    {
+        threads = ImuPool_DefaultWorkers();
+    }
+
+    // 标准输入只能读一次, 不拆分
+    al.split = (al.file_count < threads) ? 3 : 1;
+    for (int32_t i = 0; i < al.file_count; i++)
+    {
+        al.split = (0 == strcmp(al.paths[i], "-")) ? 1 : al.split;
+    }
+    al.result = calloc(al.file_count, sizeof(ImuAllanResult));
+    ImuPool_Run(threads, al.file_count * al.split, ImuAllan_Job, &al);
+    ImuAllan_Report(&al, out);
+    return 0;
+}
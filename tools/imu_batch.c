@@ -0,0 +1,297 @@
+/**
+ * @file imu_batch.c
+ * @author Wyatt Yu
+ * @brief 离线批量重放记录文件, 多核并行统计姿态精度与耗时
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Itools tools/imu_batch.c tools/imu_pool.c tools/imu_log.c \
+ *       imu.c imu_history.c algorithm/imu_madgwick.c algorithm/imu_mahony.c algorithm/imu_complementary_filter.c \
+ *       -lm -lpthread -o imu_batch
+ * 用法:
+ *   imu_batch [-j threads] [-m madgwick|mahony|comple] [-f samp_freq] [-p kp] [-i ki] [-a alpha]
+ *             [-s settle] [-o result.csv] (-l list.txt | log1.csv log2.csv ...)
+ * 每个会话独立初始化滤波器, 每个工作线程持有自己的 Imu 实例.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "imu.h"
+#include "imu_log.h"
+#include "imu_pool.h"
+
+#define IMU_BATCH_CHUNK     1024
+
+typedef struct ImuBatchResult_ {
+    int64_t samples;
+    int64_t scored;             // 有真值且已过收敛期的样本数
+    double err2_sum;            // deg^2
+    double err_max;             // deg
+    double update_ns;           // Imu_Update 累计耗时
+    bool ok;
+}ImuBatchResult;
+
+typedef struct ImuBatchWorker_ {
+    Imu *imu;
+    ImuLogSample *samples;
+    ImuQuaternion *estimate;
+}ImuBatchWorker;
+
+typedef struct ImuBatch_ {
+    char **paths;
+    int32_t count;
+    ImuMethod method;
+    int32_t samp_freq;
+    float kp_gain;
+    float ki_gain;
+    float alpha;
+    int64_t settle;
+    ImuBatchWorker *worker;
+    ImuBatchResult *result;
+}ImuBatch;
+
+static double ImuBatch_Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static double ImuBatch_AngleDeg(const ImuQuaternion *q, const float *truth)
+{
+    double dot = q->q0 * truth[0] + q->q1 * truth[1] + q->q2 * truth[2] + q->q3 * truth[3];
+    dot = (dot < 0) ? -dot : dot;
+    dot = (dot > 1.0) ? 1.0 : dot;
+    return 2.0 * acos(dot) * 180.0 / MATH_PI;
+}
+
+static void ImuBatch_Reset(ImuBatch *b, Imu *imu, const ImuLogSample *first)
+{
+    Imu_Init(imu, imu->ctx);
+    Imu_InitCalibrate(imu);     // 记录文件为已校准数据, 只用来清零偏置
+    imu->state = ImuStateRuning;
+    imu->method = b->method;
+    imu->samp_freq = b->samp_freq;
+    imu->kp_gain = b->kp_gain;
+    imu->ki_gain = b->ki_gain;
+    imu->comple_filter_alpha = b->alpha;
+    imu->quaternion.q0 = first->has_truth ? first->truth[0] : 1.0f;
+    imu->quaternion.q1 = first->has_truth ? first->truth[1] : 0.0f;
+    imu->quaternion.q2 = first->has_truth ? first->truth[2] : 0.0f;
+    imu->quaternion.q3 = first->has_truth ? first->truth[3] : 0.0f;
+}
+
+static void ImuBatch_Job(void *arg, int32_t job, int32_t worker)
+{
+    ImuBatch *b = (ImuBatch *)arg;
+    ImuBatchWorker *w = &b->worker[worker];
+    ImuBatchResult *r = &b->result[job];
+    ImuLog log;
+    int32_t n;
+    bool first = true;
+
+    memset(r, 0, sizeof(ImuBatchResult));
+    if (!ImuLog_Open(&log, b->paths[job]))
+    {
+        fprintf(stderr, "imu_batch: cannot open %s\n", b->paths[job]);
+        return;
+    }
+
+    while ((n = ImuLog_Read(&log, w->samples, IMU_BATCH_CHUNK)) > 0)
+    {
+        Imu *imu = w->imu;
+        if (first)
+        {
+            ImuBatch_Reset(b, imu, &w->samples[0]);
+            first = false;
+        }
+
+        // 只对滤波本身计时, 解析与误差统计不计入
+        double t0 = ImuBatch_Now();
+        for (int32_t i = 0; i < n; i++)
+        {
+            const ImuLogSample *s = &w->samples[i];
+            imu->source.accel.x = s->accel[0];
+            imu->source.accel.y = s->accel[1];
+            imu->source.accel.z = s->accel[2];
+            imu->source.gyro.x  = s->gyro[0];
+            imu->source.gyro.y  = s->gyro[1];
+            imu->source.gyro.z  = s->gyro[2];
+            imu->source.magic.x = s->magic[0];
+            imu->source.magic.y = s->magic[1];
+            imu->source.magic.z = s->magic[2];
+            imu->source.timestamp_us = (uint32_t)s->t_us;
+            imu->source.use_magic = (s->magic[0] != 0.0f || s->magic[1] != 0.0f || s->magic[2] != 0.0f);
+            Imu_Update(imu);
+            w->estimate[i] = imu->quaternion;
+        }
+        r->update_ns += ImuBatch_Now() - t0;
+
+        for (int32_t i = 0; i < n; i++)
+        {
+            const ImuLogSample *s = &w->samples[i];
+            if (s->has_truth && r->samples + i >= b->settle)
+            {
+                double e = ImuBatch_AngleDeg(&w->estimate[i], s->truth);
+                r->err2_sum += e * e;
+                r->err_max = (e > r->err_max) ? e : r->err_max;
+                r->scored++;
+            }
+        }
+        r->samples += n;
+    }
+    ImuLog_Close(&log);
+    r->ok = r->samples > 0;
+}
+
+static ImuMethod ImuBatch_ParseMethod(const char *name)
+{
+    if (0 == strcmp(name, "mahony"))
+    {
+        return ImuMahony;
+    }
+    else if (0 == strcmp(name, "comple"))
+    {
+        return ImuComplementaryFilter;
+    }
+    return ImuMadgwick;
+}
+
+static int32_t ImuBatch_LoadList(const char *list, char ***paths)
+{
+    FILE *fp = fopen(list, "r");
+    char line[1024];
+    int32_t n = 0, cap = 0;
+    if (!fp)
+    {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp))
+    {
+        line[strcspn(line, "\r\n")] = 0;
+        if (0 == line[0] || '#' == line[0])
+        {
+            continue;
+        }
+        if (n == cap)
+        {
+            cap = cap ? cap * 2 : 256;
+            *paths = realloc(*paths, sizeof(char *) * cap);
+        }
+        (*paths)[n++] = strdup(line);
+    }
+    fclose(fp);
+    return n;
+}
+
+static void ImuBatch_Usage(void)
+{
+    fprintf(stderr, "usage: imu_batch [-j threads] [-m madgwick|mahony|comple] [-f samp_freq] [-p kp] [-i ki]\n"
+                    "                 [-a alpha] [-s settle] [-o result.csv] (-l list.txt | log.csv ...)\n");
+}
+
+int main(int argc, char **argv)
+{
+    ImuBatch b = {0};
+    int32_t threads = 0;
+    const char *out = NULL;
+    const char *list = NULL;
+    int opt;
+
+    b.method = ImuMadgwick;
+    b.samp_freq = 200;
+    b.kp_gain = 2.0f;
+    b.ki_gain = 0.1f;
+    b.alpha = 0.98f;
+    while ((opt = getopt(argc, argv, "j:m:f:p:i:a:s:o:l:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j': threads = atoi(optarg); break;
+            case 'm': b.method = ImuBatch_ParseMethod(optarg); break;
+            case 'f': b.samp_freq = atoi(optarg); break;
+            case 'p': b.kp_gain = strtof(optarg, NULL); break;
+            case 'i': b.ki_gain = strtof(optarg, NULL); break;
+            case 'a': b.alpha = strtof(optarg, NULL); break;
+            case 's': b.settle = atoll(optarg); break;
+            case 'o': out = optarg; break;
+            case 'l': list = optarg; break;
+            default: ImuBatch_Usage(); return 1;
+        }
+    }
+
+    if (list)
+    {
+        b.count = ImuBatch_LoadList(list, &b.paths);
+    }
+    else
+    {
+        b.paths = &argv[optind];
+        b.count = argc - optind;
+    }
+    if (b.count <= 0)
+    {
+        ImuBatch_Usage();
+        return 1;
+    }
+
+    if (threads <= 0)
+    {
+        threads = ImuPool_DefaultWorkers();
+    }
+    b.result = calloc(b.count, sizeof(ImuBatchResult));
+    b.worker = calloc(threads, sizeof(ImuBatchWorker));
+    // 各线程的 Imu 连续排列, 按缓存行对齐, 互不共享缓存行
+    ImuArena arena;
+    ImuArena_Init(&arena, malloc(IMU_ARENA_SIZE(threads)), IMU_ARENA_SIZE(threads));
+    Imu *imu = Imu_CreateArray(&arena, threads);
+    for (int32_t i = 0; i < threads; i++)
+    {
+        b.worker[i].imu = &imu[i];
+        b.worker[i].samples = malloc(sizeof(ImuLogSample) * IMU_BATCH_CHUNK);
+        b.worker[i].estimate = malloc(sizeof(ImuQuaternion) * IMU_BATCH_CHUNK);
+    }
+
+    double t0 = ImuBatch_Now();
+    int32_t used = ImuPool_Run(threads, b.count, ImuBatch_Job, &b);
+    double wall = ImuBatch_Now() - t0;
+
+    FILE *fp = out ? fopen(out, "w") : NULL;
+    if (fp)
+    {
+        fprintf(fp, "session,samples,rms_deg,max_deg,ns_per_update\n");
+    }
+    int64_t samples = 0, scored = 0;
+    int32_t failed = 0;
+    double err2 = 0.0, worst = 0.0, update_ns = 0.0;
+    for (int32_t i = 0; i < b.count; i++)
+    {
+        ImuBatchResult *r = &b.result[i];
+        double rms = r->scored ? sqrt(r->err2_sum / r->scored) : 0.0;
+        failed += r->ok ? 0 : 1;
+        samples += r->samples;
+        scored += r->scored;
+        err2 += r->err2_sum;
+        update_ns += r->update_ns;
+        worst = (rms > worst) ? rms : worst;
+        if (fp)
+        {
+            fprintf(fp, "%s,%lld,%.4f,%.4f,%.1f\n", b.paths[i], (long long)r->samples, rms, r->err_max,
+                    r->samples ? r->update_ns / r->samples : 0.0);
+        }
+    }
+    if (fp)
+    {
+        fclose(fp);
+    }
+
+    printf("sessions        %d (%d failed)\n", b.count, failed);
+    printf("threads         %d\n", used);
+    printf("samples         %lld\n", (long long)samples);
+    printf("rms error       %.4f deg (worst session %.4f deg)\n", scored ? sqrt(err2 / scored) : 0.0, worst);
+    printf("update cost     %.1f ns/update\n", samples ? update_ns / samples : 0.0);
+    printf("wall time       %.3f s, %.0f samples/s\n", wall * 1e-9, samples / (wall * 1e-9));
+    return failed ? 2 : 0;
+}
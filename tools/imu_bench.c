@@ -0,0 +1,601 @@
+/**
+ * @file imu_bench.c
+ * @author Wyatt Yu
+ * @brief 在仿真场景上比较各滤波方法的姿态精度与耗时, 并与基线比较做回归检查
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Itools tools/imu_bench.c tools/imu_sim.c tools/imu_pool.c tools/imu_log.c \
+ *       tools/imu_madgwick_ref.c imu.c imu_history.c algorithm/imu_madgwick.c algorithm/imu_mahony.c \
+ *       algorithm/imu_complementary_filter.c -lm -lpthread -o imu_bench
+ * 用法:
+ *   imu_bench [-j threads] [-s scenario] [-m method] [-S settle_s] [-w baseline.csv] [-b baseline.csv]
+ *             [-e err_tol] [-t time_tol] [-d dump_dir] [-g accel[,magic[,dip]]] [-k steps]
+ * -w 记录当前结果为基线; -b 与基线比较, 误差或耗时超出容差时返回 1.
+ * 默认容差: 误差 +10% (另加 0.02deg), 耗时 +50%; 在空闲机器上可以用 -t 收紧耗时容差.
+ * -d 把各场景的仿真数据写成记录文件, 可直接交给 imu_batch 重放.
+ * -g 设置 Imu 的 accel_gate / magic_gate / dip_gate, 结果中给出各融合路径所占比例.
+ * -k 对比当前 Madgwick 内核与消除公共子表达式之前的内核 (tools/imu_madgwick_ref.c): 9 轴与 6 轴各 steps 个随机状态,
+ *    两者从相同状态各走一步, 四元数分量之差超过 IMU_BENCH_KERNEL_TOL 时返回 1; 同时给出每次调用的耗时.
+ * 互补滤波与 Mahony / Madgwick 的对比: imu_bench -s comple -S 10 (9 轴), imu_bench -s comple6 -S 10 (6 轴).
+ * 每个 (场景, 方法) 组合为一个任务, 先用开头静止段做陀螺零偏校准, 再从运动开始 settle 秒后计分.
+ * 耗时取各完整数据块多次重复中的最小值, 并按固定参考负载的耗时换算后再与基线比较,
+ * 以减小 CPU 频率变化的影响; 基线仍应在同一台机器上生成.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <float.h>
+#include <getopt.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define IMU_BENCH_CYCLES()      ((double)__rdtsc())
+#else
+#define IMU_BENCH_CYCLES()      0.0
+#endif
+#include "imu.h"
+#include "imu_log.h"
+#include "imu_madgwick_ref.h"
+#include "imu_pool.h"
+#include "imu_sim.h"
+
+#define IMU_BENCH_CHUNK         1024
+#define IMU_BENCH_METHODS       3
+#define IMU_BENCH_ERR_SLACK     0.02        // deg, 基线误差很小时的绝对容差
+#define IMU_BENCH_REPEAT        5           // 每个数据块额外重复计时的次数
+#define IMU_BENCH_KERNEL_TOL    (4.0 * FLT_EPSILON)     // 单步四元数分量的允许差, 即 1.0 附近 4 ULP
+
+typedef struct ImuBenchGain_ {
+    ImuMethod method;
+    const char *name;
+    float kp_gain;
+    float ki_gain;              // Madgwick 时为 beta
+    float alpha;
+}ImuBenchGain;
+
+typedef struct ImuBenchResult_ {
+    const char *scenario;
+    const char *method;
+    int64_t samples;
+    int64_t scored;
+    double err2_sum;            // deg^2
+    double err_max;             // deg
+    double update_ns;           // 各数据块中最小的单次耗时, 抑制调度与中断带来的抖动
+    ImuPathStats path;
+}ImuBenchResult;
+
+typedef struct ImuBench_ {
+    double reference_ns;        // 参考负载耗时, 用于在不同负载/频率下归一化耗时基线
+    const ImuSimConfig *scenario[16];
+    int32_t scenario_count;
+    const ImuBenchGain *gain[IMU_BENCH_METHODS];
+    int32_t method_count;
+    double settle;              // s
+    float gate[3];              // accel, magic, dip
+    ImuBenchResult *result;
+}ImuBench;
+
+static const ImuBenchGain imu_bench_gains[IMU_BENCH_METHODS] = {
+    {ImuMadgwick, "madgwick", 0.0f, 0.1f, 0.0f},
+    {ImuMahony, "mahony", 1.0f, 0.02f, 0.0f},
+    {ImuComplementaryFilter, "comple", 0.0f, 0.0f, 0.98f},
+};
+
+static double ImuBench_Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static double ImuBench_AngleDeg(const ImuQuaternion *q, const float *truth)
+{
+    double dot = q->q0 * truth[0] + q->q1 * truth[1] + q->q2 * truth[2] + q->q3 * truth[3];
+    dot = (dot < 0) ? -dot : dot;
+    dot = (dot > 1.0) ? 1.0 : dot;
+    return 2.0 * acos(dot) * 180.0 / 3.14159265358979;
+}
+
+static void ImuBench_Load(Imu *imu, const ImuLogSample *s)
+{
+    imu->source.accel.x = s->accel[0];
+    imu->source.accel.y = s->accel[1];
+    imu->source.accel.z = s->accel[2];
+    imu->source.gyro.x  = s->gyro[0];
+    imu->source.gyro.y  = s->gyro[1];
+    imu->source.gyro.z  = s->gyro[2];
+    imu->source.magic.x = s->magic[0];
+    imu->source.magic.y = s->magic[1];
+    imu->source.magic.z = s->magic[2];
+    imu->source.timestamp_us = (uint32_t)s->t_us;
+    imu->source.use_magic = (s->magic[0] != 0.0f || s->magic[1] != 0.0f || s->magic[2] != 0.0f);
+}
+
+static void ImuBench_Job(void *arg, int32_t job, int32_t worker)
+{
+    ImuBench *b = (ImuBench *)arg;
+    const ImuSimConfig *cfg = b->scenario[job / b->method_count];
+    const ImuBenchGain *g = b->gain[job % b->method_count];
+    ImuBenchResult *r = &b->result[job];
+    ImuLogSample *samples = malloc(sizeof(ImuLogSample) * IMU_BENCH_CHUNK);
+    ImuQuaternion *estimate = malloc(sizeof(ImuQuaternion) * IMU_BENCH_CHUNK);
+    void *arena_mem = malloc(IMU_ARENA_SIZE(1));
+    ImuArena arena;
+    ImuArena_Init(&arena, arena_mem, IMU_ARENA_SIZE(1));
+    Imu *imu = Imu_Create(&arena);
+    ImuSim sim;
+    int64_t index = 0;
+    (void)worker;
+
+    memset(r, 0, sizeof(ImuBenchResult));
+    r->scenario = cfg->name;
+    r->method = g->name;
+    ImuSim_Init(&sim, cfg);
+    int64_t settle = ImuSim_StaticCount(&sim) + (int64_t)(b->settle * cfg->samp_freq);
+
+    Imu_InitCalibrate(imu);
+    imu->method = g->method;
+    imu->samp_freq = cfg->samp_freq;
+    imu->kp_gain = g->kp_gain;
+    imu->ki_gain = g->ki_gain;
+    imu->comple_filter_alpha = g->alpha;
+    imu->accel_gate = b->gate[0];
+    imu->magic_gate = b->gate[1];
+    imu->dip_gate = b->gate[2];
+    imu->quaternion.q0 = 1.0f;
+
+    for (;;)
+    {
+        int32_t n = 0;
+        while (n < IMU_BENCH_CHUNK && ImuSim_Next(&sim, &samples[n]))
+        {
+            n++;
+        }
+        if (0 == n)
+        {
+            break;
+        }
+
+        // 校准段不计时
+        int32_t i = 0;
+        for (; i < n && ImuStateCalib == imu->state; i++)
+        {
+            ImuBench_Load(imu, &samples[i]);
+            Imu_Calibrate(imu);
+            estimate[i] = imu->quaternion;
+        }
+        imu->state = ImuStateRuning;
+        int32_t first = i;
+        memset(&imu->path, 0, sizeof(imu->path));
+        Imu saved = *imu;
+        ImuContext saved_ctx = *imu->ctx;
+        double t0 = ImuBench_Now();
+        for (; i < n; i++)
+        {
+            ImuBench_Load(imu, &samples[i]);
+            Imu_Update(imu);
+            estimate[i] = imu->quaternion;
+        }
+        double best = ImuBench_Now() - t0;
+        r->samples += n - first;
+
+        // 只对完整的数据块计时, 从相同状态重复运行取最小值
+        if (n - first == IMU_BENCH_CHUNK)
+        {
+            Imu end = *imu;
+            ImuContext end_ctx = *imu->ctx;
+            for (int32_t k = 0; k < IMU_BENCH_REPEAT; k++)
+            {
+                *imu = saved;
+                *imu->ctx = saved_ctx;
+                t0 = ImuBench_Now();
+                for (int32_t j = first; j < n; j++)
+                {
+                    ImuBench_Load(imu, &samples[j]);
+                    Imu_Update(imu);
+                }
+                double t = ImuBench_Now() - t0;
+                best = (t < best) ? t : best;
+            }
+            *imu = end;
+            *imu->ctx = end_ctx;
+            best /= IMU_BENCH_CHUNK;
+            r->update_ns = (0.0 == r->update_ns || best < r->update_ns) ? best : r->update_ns;
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            if (index + i >= settle)
+            {
+                double e = ImuBench_AngleDeg(&estimate[i], samples[i].truth);
+                r->err2_sum += e * e;
+                r->err_max = (e > r->err_max) ? e : r->err_max;
+                r->scored++;
+            }
+        }
+        r->path.full += imu->path.full;
+        r->path.accel_only += imu->path.accel_only;
+        r->path.gyro_only += imu->path.gyro_only;
+        index += n;
+    }
+    free(samples);
+    free(estimate);
+    free(arena_mem);
+}
+
+// 固定的单精度依赖链, 与滤波器的运算类型相近, 取多次中的最小值
+static double ImuBench_Reference(void)
+{
+    double best = 0.0;
+    for (int32_t k = 0; k < IMU_BENCH_REPEAT * 4; k++)
+    {
+        volatile float seed = 0.5f;
+        float x = seed;
+        double t0 = ImuBench_Now();
+        for (int32_t i = 0; i < 100000; i++)
+        {
+            x = sqrtf(x * 0.75f + 0.5f) * 0.9f + 0.1f;
+        }
+        double t = (ImuBench_Now() - t0) / 100000;
+        seed = x;
+        best = (0 == k || t < best) ? t : best;
+    }
+    return best;
+}
+
+static uint32_t ImuBench_Rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// 均匀分布 [-amp, amp]
+static float ImuBench_Uniform(uint32_t *state, float amp)
+{
+    return amp * ((float)(ImuBench_Rand(state) >> 8) / 8388608.0f - 1.0f);
+}
+
+// 随机单位四元数与量程内的随机样本, 加速度与磁场不为零
+static void ImuBench_KernelCase(uint32_t *state, bool use_magic, ImuQuaternion *q, ImuSource *source)
+{
+    float v[4];
+    float n2;
+    do
+    {
+        n2 = 0.0f;
+        for (int32_t i = 0; i < 4; i++)
+        {
+            v[i] = ImuBench_Uniform(state, 1.0f);
+            n2 += v[i] * v[i];
+        }
+    } while (n2 < 0.01f);
+    n2 = 1.0f / sqrtf(n2);
+    q->q0 = v[0] * n2;
+    q->q1 = v[1] * n2;
+    q->q2 = v[2] * n2;
+    q->q3 = v[3] * n2;
+
+    memset(source, 0, sizeof(ImuSource));
+    source->gyro.x = ImuBench_Uniform(state, 4.0f);
+    source->gyro.y = ImuBench_Uniform(state, 4.0f);
+    source->gyro.z = ImuBench_Uniform(state, 4.0f);
+    source->accel.x = ImuBench_Uniform(state, 12.0f);
+    source->accel.y = ImuBench_Uniform(state, 12.0f);
+    source->accel.z = ImuBench_Uniform(state, 12.0f) + 0.1f;
+    source->magic.x = ImuBench_Uniform(state, 0.6f);
+    source->magic.y = ImuBench_Uniform(state, 0.6f);
+    source->magic.z = ImuBench_Uniform(state, 0.6f) - 0.01f;
+    source->use_magic = use_magic;
+}
+
+// 连续调用 count 次的单次耗时 ns 与 TSC 周期, 取多次重复中的最小值
+static void ImuBench_KernelTime(Imu *imu, bool ref, ImuSource *source, int32_t count, double *ns, double *cycles)
+{
+    *ns = 0.0;
+    *cycles = 0.0;
+    for (int32_t k = 0; k < IMU_BENCH_REPEAT * 4; k++)
+    {
+        imu->quaternion.q0 = 1.0f;
+        imu->quaternion.q1 = 0.0f;
+        imu->quaternion.q2 = 0.0f;
+        imu->quaternion.q3 = 0.0f;
+        double t0 = ImuBench_Now();
+        double c0 = IMU_BENCH_CYCLES();
+        for (int32_t i = 0; i < count; i++)
+        {
+            if (ref)
+            {
+                ImuMadgwickRef_AlgorithmUpdate(imu, &source[i]);
+            }
+            else
+            {
+                ImuMadgwick_AlgorithmUpdate(imu, &source[i]);
+            }
+        }
+        double c = (IMU_BENCH_CYCLES() - c0) / count;
+        double t = (ImuBench_Now() - t0) / count;
+        *ns = (0 == k || t < *ns) ? t : *ns;
+        *cycles = (0 == k || c < *cycles) ? c : *cycles;
+    }
+}
+
+/**
+ * 当前 Madgwick 内核与消除公共子表达式之前内核的等价性检查: 每一步从相同的随机状态出发, 两个内核各走一步后比较四元数.
+ * 之前的内核会原地归一化样本, 传给它的是副本. 返回超出容差的路径数.
+ */
+static int32_t ImuBench_Kernel(int32_t steps)
+{
+    static const char *path_name[2] = {"6dof", "9dof"};
+    void *arena_mem = malloc(IMU_ARENA_SIZE(1));
+    ImuSource *batch = malloc(sizeof(ImuSource) * IMU_BENCH_CHUNK);
+    ImuArena arena;
+    int32_t fail = 0;
+
+    ImuArena_Init(&arena, arena_mem, IMU_ARENA_SIZE(1));
+    Imu *imu = Imu_Create(&arena);
+    imu->samp_freq = 200;
+    imu->ki_gain = 0.1f;
+    imu->accel_valid = true;
+
+    printf("madgwick kernel check: %d random steps per path, tolerance %.2e\n", steps, IMU_BENCH_KERNEL_TOL);
+    for (int32_t path = 0; path < 2; path++)
+    {
+        uint32_t state = 0x2545F491u + (uint32_t)path;
+        double diff_max = 0.0;
+        ImuQuaternion q;
+        ImuSource source, copy;
+
+        imu->magic_valid = (1 == path);
+        for (int32_t n = 0; n < steps; n++)
+        {
+            ImuBench_KernelCase(&state, 1 == path, &q, &source);
+            imu->quaternion = q;
+            ImuMadgwick_AlgorithmUpdate(imu, &source);
+            ImuQuaternion cur = imu->quaternion;
+
+            imu->quaternion = q;
+            copy = source;
+            ImuMadgwickRef_AlgorithmUpdate(imu, &copy);
+            double d[4] = {cur.q0 - imu->quaternion.q0, cur.q1 - imu->quaternion.q1,
+                           cur.q2 - imu->quaternion.q2, cur.q3 - imu->quaternion.q3};
+            for (int32_t i = 0; i < 4; i++)
+            {
+                d[i] = (d[i] < 0.0) ? -d[i] : d[i];
+                diff_max = (d[i] > diff_max) ? d[i] : diff_max;
+            }
+        }
+
+        for (int32_t i = 0; i < IMU_BENCH_CHUNK; i++)
+        {
+            ImuBench_KernelCase(&state, 1 == path, &q, &batch[i]);
+        }
+        double new_ns, new_cycles, old_ns, old_cycles;
+        ImuBench_KernelTime(imu, false, batch, IMU_BENCH_CHUNK, &new_ns, &new_cycles);
+        ImuBench_KernelTime(imu, true, batch, IMU_BENCH_CHUNK, &old_ns, &old_cycles);
+
+        bool ok = (diff_max <= IMU_BENCH_KERNEL_TOL);
+        fail += ok ? 0 : 1;
+        printf("%s  max |dq| %.2e %s  new %6.1f ns %6.0f cycles  old %6.1f ns %6.0f cycles  %+.1f%%\n",
+               path_name[path], diff_max, ok ? "ok  " : "FAIL", new_ns, new_cycles, old_ns, old_cycles,
+               (old_ns > 0.0) ? (new_ns / old_ns - 1.0) * 100.0 : 0.0);
+    }
+    free(batch);
+    free(arena_mem);
+    return fail;
+}
+
+static double ImuBench_Rms(const ImuBenchResult *r)
+{
+    return r->scored ? sqrt(r->err2_sum / r->scored) : 0.0;
+}
+
+static double ImuBench_Ns(const ImuBenchResult *r)
+{
+    return r->update_ns;
+}
+
+static bool ImuBench_Dump(const char *dir)
+{
+    char path[1024];
+    for (int32_t i = 0; i < ImuSim_PresetCount(); i++)
+    {
+        const ImuSimConfig *cfg = ImuSim_Preset(i);
+        ImuLogSample s;
+        ImuSim sim;
+        snprintf(path, sizeof(path), "%s/%s.csv", dir, cfg->name);
+        FILE *fp = fopen(path, "w");
+        if (!fp)
+        {
+            fprintf(stderr, "imu_bench: cannot write %s\n", path);
+            return false;
+        }
+        fprintf(fp, "# imu_sim %s, %d Hz, static %.1f s\n", cfg->name, cfg->samp_freq, cfg->static_time);
+        ImuSim_Init(&sim, cfg);
+        while (ImuSim_Next(&sim, &s))
+        {
+            ImuLog_Write(fp, &s);
+        }
+        fclose(fp);
+    }
+    return true;
+}
+
+static bool ImuBench_WriteBaseline(const ImuBench *b, const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        return false;
+    }
+    fprintf(fp, "scenario,method,rms_deg,ns_per_update\n");
+    fprintf(fp, "reference,-,0,%.3f\n", b->reference_ns);
+    for (int32_t i = 0; i < b->scenario_count * b->method_count; i++)
+    {
+        const ImuBenchResult *r = &b->result[i];
+        fprintf(fp, "%s,%s,%.4f,%.1f\n", r->scenario, r->method, ImuBench_Rms(r), ImuBench_Ns(r));
+    }
+    fclose(fp);
+    return true;
+}
+
+// 返回回归项数, 基线中没有的组合不比较
+static int32_t ImuBench_Compare(const ImuBench *b, const char *path, double err_tol, double time_tol)
+{
+    FILE *fp = fopen(path, "r");
+    char line[256];
+    int32_t regress = 0;
+    double time_scale = 1.0;
+    if (!fp)
+    {
+        fprintf(stderr, "imu_bench: cannot open baseline %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp))
+    {
+        char scenario[64], method[64];
+        double rms, ns;
+        if (4 != sscanf(line, "%63[^,],%63[^,],%lf,%lf", scenario, method, &rms, &ns))
+        {
+            continue;
+        }
+        if (0 == strcmp(scenario, "reference"))
+        {
+            // 耗时按参考负载的比值换算到当前机器状态
+            time_scale = (ns > 0.0) ? b->reference_ns / ns : 1.0;
+            continue;
+        }
+        ns *= time_scale;
+        for (int32_t i = 0; i < b->scenario_count * b->method_count; i++)
+        {
+            const ImuBenchResult *r = &b->result[i];
+            if (strcmp(r->scenario, scenario) || strcmp(r->method, method))
+            {
+                continue;
+            }
+            double cur_rms = ImuBench_Rms(r);
+            double cur_ns = ImuBench_Ns(r);
+            if (cur_rms > rms * (1.0 + err_tol) + IMU_BENCH_ERR_SLACK)
+            {
+                printf("REGRESSION %s/%s: rms %.4f deg, baseline %.4f deg\n", scenario, method, cur_rms, rms);
+                regress++;
+            }
+            if (cur_ns > ns * (1.0 + time_tol))
+            {
+                printf("REGRESSION %s/%s: %.1f ns/update, baseline %.1f ns/update\n", scenario, method, cur_ns, ns);
+                regress++;
+            }
+        }
+    }
+    fclose(fp);
+    return regress;
+}
+
+static void ImuBench_Usage(void)
+{
+    fprintf(stderr, "usage: imu_bench [-j threads] [-s scenario] [-m madgwick|mahony|comple] [-S settle_s]\n"
+                    "                 [-w baseline.csv] [-b baseline.csv] [-e err_tol] [-t time_tol] [-d dump_dir]\n"
+                    "                 [-g accel[,magic[,dip]]] [-k steps]\n");
+}
+
+int main(int argc, char **argv)
+{
+    ImuBench b = {0};
+    int32_t threads = 0;
+    const char *scenario = NULL;
+    const char *method = NULL;
+    const char *write = NULL;
+    const char *base = NULL;
+    const char *dump = NULL;
+    int32_t kernel_steps = 0;
+    double err_tol = 0.10;
+    double time_tol = 0.50;
+    int opt;
+
+    b.settle = 5.0;
+    while ((opt = getopt(argc, argv, "j:s:m:S:w:b:e:t:d:g:k:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j': threads = atoi(optarg); break;
+            case 's': scenario = optarg; break;
+            case 'm': method = optarg; break;
+            case 'S': b.settle = atof(optarg); break;
+            case 'w': write = optarg; break;
+            case 'b': base = optarg; break;
+            case 'e': err_tol = atof(optarg); break;
+            case 't': time_tol = atof(optarg); break;
+            case 'd': dump = optarg; break;
+            case 'g': sscanf(optarg, "%f,%f,%f", &b.gate[0], &b.gate[1], &b.gate[2]); break;
+            case 'k': kernel_steps = atoi(optarg); break;
+            default: ImuBench_Usage(); return 1;
+        }
+    }
+
+    if (dump)
+    {
+        return ImuBench_Dump(dump) ? 0 : 1;
+    }
+    if (kernel_steps > 0)
+    {
+        return (0 == ImuBench_Kernel(kernel_steps)) ? 0 : 1;
+    }
+
+    for (int32_t i = 0; i < ImuSim_PresetCount(); i++)
+    {
+        const ImuSimConfig *cfg = ImuSim_Preset(i);
+        if (!scenario || 0 == strcmp(scenario, cfg->name))
+        {
+            b.scenario[b.scenario_count++] = cfg;
+        }
+    }
+    for (int32_t i = 0; i < IMU_BENCH_METHODS; i++)
+    {
+        if (!method || 0 == strcmp(method, imu_bench_gains[i].name))
+        {
+            b.gain[b.method_count++] = &imu_bench_gains[i];
+        }
+    }
+    if (0 == b.scenario_count || 0 == b.method_count)
+    {
+        ImuBench_Usage();
+        return 1;
+    }
+
+    int32_t jobs = b.scenario_count * b.method_count;
+    b.result = calloc(jobs, sizeof(ImuBenchResult));
+    b.reference_ns = ImuBench_Reference();
+    ImuPool_Run(threads, jobs, ImuBench_Job, &b);
+
+    printf("reference load  %.3f ns/iter\n", b.reference_ns);
+    printf("%-10s %-10s %10s %10s %12s %7s %7s %7s\n", "scenario", "method", "rms_deg", "max_deg", "ns/update",
+           "full%", "6dof%", "gyro%");
+    for (int32_t i = 0; i < jobs; i++)
+    {
+        const ImuBenchResult *r = &b.result[i];
+        double paths = (double)r->path.full + r->path.accel_only + r->path.gyro_only;
+        paths = (paths > 0.0) ? 100.0 / paths : 0.0;
+        printf("%-10s %-10s %10.4f %10.4f %12.1f %7.1f %7.1f %7.1f\n", r->scenario, r->method, ImuBench_Rms(r),
+               r->err_max, ImuBench_Ns(r), r->path.full * paths, r->path.accel_only * paths, r->path.gyro_only * paths);
+    }
+
+    if (write && !ImuBench_WriteBaseline(&b, write))
+    {
+        fprintf(stderr, "imu_bench: cannot write baseline %s\n", write);
+        return 1;
+    }
+    if (base)
+    {
+        int32_t regress = ImuBench_Compare(&b, base, err_tol, time_tol);
+        if (regress != 0)
+        {
+            return 1;
+        }
+        printf("no regression against %s\n", base);
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file imu_decimate_test.c
+ * @author Wyatt Yu
+ * @brief 抗混叠抽取滤波的主机端测试: 结构选择, 满量程直流, 混叠单音的阻带抑制, 群延迟
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Iadlx345 -Iitg3205 tools/imu_decimate_test.c imu_decimate.c \
+ *       adlx345/adlx345.c itg3205/itg3205.c imu_regcache.c -lm -o imu_decimate_test
+ * 用法:
+ *   imu_decimate_test
+ * 全部通过返回 0. 各用例都抽取到 100Hz, scale 取 1, 输出以 LSB 计.
+ * 单音幅值与相位由输出序列对输出时刻 (触发输出的输入样本时刻) 做正交相关求得.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "imu_decimate.h"
+
+#define IMU_DECIMATE_TEST_OUT           100.0
+#define IMU_DECIMATE_TEST_AMP           20000.0     // LSB, 单音峰值
+#define IMU_DECIMATE_TEST_SECONDS       6.0         // 单音测量时长, 不含建立时间
+#define IMU_DECIMATE_TEST_SETTLE        0.5         // s, 丢弃的建立时间
+#define IMU_DECIMATE_TEST_DC_TOL        1e-6        // 相对, 只剩输出换算为 imu_real_t 的舍入
+#define IMU_DECIMATE_TEST_PASS_DB       0.5         // 10Hz 通带单音的增益偏差
+
+typedef struct ImuDecimateTestCase_ {
+    double in_freq;
+    double bandwidth;           // 传感器自身低通 Hz
+    int32_t ratio;
+    uint16_t cic_ratio;
+    uint8_t cic_order;
+    uint8_t hb_stages;
+    double stop_db;             // 混叠到 0 ~ out/4 的单音的最差抑制, 0 表示不检查
+}ImuDecimateTestCase;
+
+/**
+ * 800Hz: ADXL345 带宽为速率一半, 一级半带 + 4 阶 CIC (R = 4);
+ * 3200Hz: CIC R = 16, 4 阶增益超过 2^15, 取 3 阶;
+ * 1000Hz: ITG3205 DLPF 42Hz 需要抽取器抗混叠, DLPF 20Hz 时只做块平均;
+ * 400Hz: CIC R = 2, 4 阶.
+ * 3200Hz 与 400Hz 的最差抑制由 CIC 第一零点 (200Hz) 附近 +-25Hz 的混叠决定, 低于半带的 -68dB.
+ */
+static const ImuDecimateTestCase imu_decimate_test_case[] = {
+    {800.0, 400.0, 8, 4, 4, 1, -70.0},
+    {3200.0, 1600.0, 32, 16, 3, 1, -55.0},
+    {1000.0, 42.0, 10, 5, 4, 1, -70.0},
+    {1000.0, 20.0, 10, 10, 1, 0, 0.0},
+    {400.0, 200.0, 4, 2, 4, 1, -60.0},
+};
+
+#define IMU_DECIMATE_TEST_CASES (sizeof(imu_decimate_test_case) / sizeof(imu_decimate_test_case[0]))
+
+static int32_t imu_decimate_test_fail = 0;
+
+static void ImuDecimateTest_Check(const char *name, bool cond)
+{
+    printf("%-52s %s\n", name, cond ? "ok" : "FAIL");
+    imu_decimate_test_fail += cond ? 0 : 1;
+}
+
+static bool ImuDecimateTest_Plan(ImuDecimate *d, const ImuDecimateTestCase *c)
+{
+    return ImuDecimate_Plan(d, (imu_real_t)c->in_freq, IMU_REAL(100.0), (imu_real_t)c->bandwidth, IMU_REAL(1.0));
+}
+
+/**
+ * x 轴输入 freq Hz 单音, 建立后对输出做正交相关, 返回幅值 (LSB) 与相对输入的延迟 (s).
+ * 测量时长为 1/freq 的整数倍, 避免频谱泄漏.
+ */
+static double ImuDecimateTest_Tone(ImuDecimate *d, double in_freq, double freq, double *delay)
+{
+    uint32_t settle = (uint32_t)(IMU_DECIMATE_TEST_SETTLE * in_freq);
+    double cycles = floor(IMU_DECIMATE_TEST_SECONDS * freq);
+    uint32_t total = settle + (uint32_t)(cycles / freq * in_freq);
+    double si = 0.0, co = 0.0;
+    uint32_t outputs = 0;
+    ImuAxes out;
+
+    for (uint32_t n = 0; n < total; n++)
+    {
+        double t = (double)n / in_freq;
+        double x = IMU_DECIMATE_TEST_AMP * sin(2.0 * M_PI * freq * t);
+        int16_t raw[3] = {(int16_t)lrint(x), 0, 0};
+        if (!ImuDecimate_Push(d, raw, &out) || n < settle)
+        {
+            continue;
+        }
+        si += (double)out.x * sin(2.0 * M_PI * freq * t);
+        co += (double)out.x * cos(2.0 * M_PI * freq * t);
+        outputs++;
+    }
+    // 输出按 out = A sin(w (t - delay)) 拟合
+    if (delay)
+    {
+        *delay = -atan2(co, si) / (2.0 * M_PI * freq);
+    }
+    return 2.0 * hypot(si, co) / (double)outputs;
+}
+
+static void ImuDecimateTest_PlanChoice(void)
+{
+    ImuDecimate d;
+    bool ok = true;
+    for (uint32_t i = 0; i < IMU_DECIMATE_TEST_CASES; i++)
+    {
+        const ImuDecimateTestCase *c = &imu_decimate_test_case[i];
+        bool plan = ImuDecimateTest_Plan(&d, c);
+        printf("plan %6.0f Hz bw %6.1f: ratio %2d = CIC %2u (order %u) + %u half-band\n", c->in_freq, c->bandwidth,
+               (int)d.ratio, (unsigned)d.cic_ratio, (unsigned)d.cic_order, (unsigned)d.hb_stages);
+        ok = ok && plan && d.ratio == c->ratio && d.cic_ratio == c->cic_ratio && d.cic_order == c->cic_order
+             && d.hb_stages == c->hb_stages;
+    }
+    ImuDecimateTest_Check("plan for 800/3200/1000/400 Hz -> 100 Hz", ok);
+}
+
+// 积分器在数千个样本内就会回绕, 每个输出都应精确等于输入
+static void ImuDecimateTest_Dc(void)
+{
+    static const int16_t raw[3] = {32767, -32768, -32767};
+    ImuDecimate d;
+    double err = 0.0;
+    bool ok = true;
+    ImuAxes out;
+
+    for (uint32_t i = 0; i < IMU_DECIMATE_TEST_CASES; i++)
+    {
+        const ImuDecimateTestCase *c = &imu_decimate_test_case[i];
+        uint32_t settle = (uint32_t)(IMU_DECIMATE_TEST_SETTLE * c->in_freq);
+        ok = ok && ImuDecimateTest_Plan(&d, c);
+        for (uint32_t n = 0; n < 200000u; n++)
+        {
+            if (!ImuDecimate_Push(&d, raw, &out) || n < settle)
+            {
+                continue;
+            }
+            double e[3] = {(double)out.x - raw[0], (double)out.y - raw[1], (double)out.z - raw[2]};
+            for (int32_t a = 0; a < 3; a++)
+            {
+                err = (fabs(e[a]) > err) ? fabs(e[a]) : err;
+            }
+        }
+    }
+    printf("dc: max |out - in| %.2e LSB\n", err);
+    ImuDecimateTest_Check("full-scale dc passes unchanged", ok && err <= IMU_DECIMATE_TEST_DC_TOL * 32768.0);
+}
+
+/**
+ * 混叠到输出 0 ~ 25Hz (即半带通带) 的单音: k * 100 +- {2, 10, 20} Hz, 直到输入 Nyquist.
+ * 只做块平均的结构依赖传感器低通, 不在此检查.
+ */
+static void ImuDecimateTest_StopBand(void)
+{
+    static const double offset[] = {2.0, 10.0, 20.0};
+    ImuDecimate d;
+    bool ok = true;
+
+    for (uint32_t i = 0; i < IMU_DECIMATE_TEST_CASES; i++)
+    {
+        const ImuDecimateTestCase *c = &imu_decimate_test_case[i];
+        if (c->stop_db >= 0.0)
+        {
+            continue;
+        }
+        double worst = -200.0, worst_freq = 0.0;
+        for (int32_t k = 1; k * IMU_DECIMATE_TEST_OUT < 0.5 * c->in_freq + 20.0; k++)
+        {
+            for (int32_t j = -3; j < 3; j++)
+            {
+                double f = k * IMU_DECIMATE_TEST_OUT + ((j < 0) ? -offset[-j - 1] : offset[j]);
+                if (f >= 0.5 * c->in_freq)
+                {
+                    continue;
+                }
+                ImuDecimateTest_Plan(&d, c);
+                double db = 20.0 * log10(ImuDecimateTest_Tone(&d, c->in_freq, f, NULL) / IMU_DECIMATE_TEST_AMP);
+                if (db > worst)
+                {
+                    worst = db;
+                    worst_freq = f;
+                }
+            }
+        }
+        ImuDecimateTest_Plan(&d, c);
+        double pass = 20.0 * log10(ImuDecimateTest_Tone(&d, c->in_freq, 10.0, NULL) / IMU_DECIMATE_TEST_AMP);
+        printf("%6.0f Hz: worst alias %6.1f dB at %6.1f Hz (limit %.0f dB), 10 Hz gain %+.3f dB\n", c->in_freq, worst,
+               worst_freq, c->stop_db, pass);
+        ok = ok && worst < c->stop_db && fabs(pass) < IMU_DECIMATE_TEST_PASS_DB;
+    }
+    ImuDecimateTest_Check("aliasing tones rejected, passband kept", ok);
+}
+
+// 线性相位, 低频单音的相位延迟即群延迟; 容差为半个输入样本
+static void ImuDecimateTest_Delay(void)
+{
+    ImuDecimate d;
+    bool ok = true;
+
+    for (uint32_t i = 0; i < IMU_DECIMATE_TEST_CASES; i++)
+    {
+        const ImuDecimateTestCase *c = &imu_decimate_test_case[i];
+        double delay = 0.0;
+        ok = ok && ImuDecimateTest_Plan(&d, c);
+        ImuDecimateTest_Tone(&d, c->in_freq, 3.0, &delay);
+        double expect = (double)ImuDecimate_GetDelayUs(&d);
+        printf("%6.0f Hz bw %6.1f: measured %8.1f us, ImuDecimate_GetDelayUs %6.0f us\n", c->in_freq, c->bandwidth,
+               delay * 1e6, expect);
+        ok = ok && fabs(delay * 1e6 - expect) <= 0.5e6 / c->in_freq;
+    }
+    ImuDecimateTest_Check("ImuDecimate_GetDelayUs matches measured delay", ok);
+}
+
+int main(void)
+{
+    ImuDecimateTest_PlanChoice();
+    ImuDecimateTest_Dc();
+    ImuDecimateTest_StopBand();
+    ImuDecimateTest_Delay();
+    printf("%s\n", imu_decimate_test_fail ? "FAILED" : "all passed");
+    return imu_decimate_test_fail ? 1 : 0;
+}
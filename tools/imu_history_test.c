@@ -0,0 +1,248 @@
+/**
+ * @file imu_history_test.c
+ * @author Wyatt Yu
+ * @brief 姿态历史缓存的主机端测试: 回绕, 端点插值, 超范围外推, 并发写入与查询
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. tools/imu_history_test.c imu_history.c -lm -lpthread -o imu_history_test
+ * 用法:
+ *   imu_history_test [-j reader_threads] [-t seconds]
+ * 全部通过返回 0. 历史中的姿态为绕 z 轴匀速转动, 每个样本转 IMU_HISTORY_TEST_STEP,
+ * 时间戳从 uint32_t 回绕点之前开始; 并发测试中读取到撕裂的样本时误差与步长同量级, 远大于容差.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "imu_history.h"
+
+#define IMU_HISTORY_TEST_DT_US      5000u                       // 200Hz
+#define IMU_HISTORY_TEST_STEP       0.05                        // rad per sample
+#define IMU_HISTORY_TEST_T0         (0xFFFFFFFFu - 20u * IMU_HISTORY_TEST_DT_US)
+#define IMU_HISTORY_TEST_TOL        1e-4                        // rad, 插值与存储的样本
+#define IMU_HISTORY_TEST_PRED_TOL   1e-3                        // rad, 一阶外推的近似误差
+#define IMU_HISTORY_TEST_MAX_THREADS 16
+
+typedef struct ImuHistoryTest_ {
+    ImuHistory history;
+    volatile uint32_t latest;   // 最近一次 Push 的样本序号 + 1, 0 表示还没有
+    volatile int32_t stop;
+    uint64_t queries[IMU_HISTORY_TEST_MAX_THREADS];
+    uint64_t errors[IMU_HISTORY_TEST_MAX_THREADS];
+    double err_max[IMU_HISTORY_TEST_MAX_THREADS];
+}ImuHistoryTest;
+
+static int32_t imu_history_test_fail = 0;
+
+static uint32_t ImuHistoryTest_Time(uint32_t k)
+{
+    return IMU_HISTORY_TEST_T0 + k * IMU_HISTORY_TEST_DT_US;
+}
+
+// 第 k 个样本 (k 可为小数) 的真值: 绕 z 轴转 k * STEP
+static double ImuHistoryTest_Angle(double k)
+{
+    return k * IMU_HISTORY_TEST_STEP;
+}
+
+static void ImuHistoryTest_Push(ImuHistory *h, uint32_t k)
+{
+    double angle = ImuHistoryTest_Angle((double)k);
+    imu_real_t gyro[3] = {IMU_REAL(0.0), IMU_REAL(0.0),
+                          (imu_real_t)(IMU_HISTORY_TEST_STEP * 1e6 / IMU_HISTORY_TEST_DT_US)};
+    ImuQuaternion q;
+    q.q0 = (imu_real_t)cos(0.5 * angle);
+    q.q1 = IMU_REAL(0.0);
+    q.q2 = IMU_REAL(0.0);
+    q.q3 = (imu_real_t)sin(0.5 * angle);
+    ImuHistory_Push(h, ImuHistoryTest_Time(k), &q, gyro);
+}
+
+// q 与绕 z 轴 angle 的转角之差, rad; 由相对四元数 conj(truth) * q 的 atan2 求出, 小角度时不损失精度
+static double ImuHistoryTest_Error(const ImuQuaternion *q, double angle)
+{
+    double c = cos(0.5 * angle), s = sin(0.5 * angle);
+    double w = c * q->q0 + s * q->q3;
+    double x = c * q->q1 + s * q->q2;
+    double y = c * q->q2 - s * q->q1;
+    double z = c * q->q3 - s * q->q0;
+    return 2.0 * atan2(sqrt(x * x + y * y + z * z), fabs(w));
+}
+
+static void ImuHistoryTest_Check(const char *name, bool cond)
+{
+    printf("%-44s %s\n", name, cond ? "ok" : "FAIL");
+    imu_history_test_fail += cond ? 0 : 1;
+}
+
+static void ImuHistoryTest_Sequential(void)
+{
+    static ImuHistory h;
+    ImuQuaternion q;
+    uint32_t total = IMU_HISTORY_SIZE + 10u;
+    uint32_t oldest = total - IMU_HISTORY_SIZE;
+    uint32_t newest = total - 1u;
+    uint32_t max_predict = IMU_HISTORY_MAX_PREDICT_US;
+
+    ImuHistory_Init(&h, max_predict);
+    ImuHistoryTest_Check("empty history returns false", !ImuHistory_Query(&h, ImuHistoryTest_Time(0), &q));
+
+    for (uint32_t k = 0; k < total; k++)
+    {
+        ImuHistoryTest_Push(&h, k);
+    }
+    ImuHistoryTest_Check("wrap-around keeps SIZE entries", IMU_HISTORY_SIZE == h.count);
+    ImuHistoryTest_Check("timestamps cross the uint32 wrap",
+                         ImuHistoryTest_Time(newest) < ImuHistoryTest_Time(oldest));
+
+    bool ok = ImuHistory_Query(&h, ImuHistoryTest_Time(oldest), &q);
+    ImuHistoryTest_Check("query at oldest entry is exact",
+                         ok && ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(oldest)) < IMU_HISTORY_TEST_TOL);
+    ok = ImuHistory_Query(&h, ImuHistoryTest_Time(newest), &q);
+    ImuHistoryTest_Check("query at newest entry is exact",
+                         ok && ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(newest)) < IMU_HISTORY_TEST_TOL);
+
+    ok = ImuHistory_Query(&h, ImuHistoryTest_Time(oldest) - 1u, &q);
+    ImuHistoryTest_Check("before oldest clamps to oldest, returns false",
+                         !ok && ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(oldest)) < IMU_HISTORY_TEST_TOL);
+
+    // 跨过时间戳回绕点的区间内插
+    bool mid_ok = true;
+    for (uint32_t k = oldest; k < newest; k++)
+    {
+        for (uint32_t f = 1; f < 4; f++)
+        {
+            uint32_t t = ImuHistoryTest_Time(k) + f * IMU_HISTORY_TEST_DT_US / 4u;
+            ok = ImuHistory_Query(&h, t, &q);
+            mid_ok = mid_ok && ok &&
+                     ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(k + f / 4.0)) < IMU_HISTORY_TEST_TOL;
+        }
+    }
+    ImuHistoryTest_Check("interpolation between all stored entries", mid_ok);
+
+    uint32_t ahead = max_predict / 2u;
+    ok = ImuHistory_Query(&h, ImuHistoryTest_Time(newest) + ahead, &q);
+    ImuHistoryTest_Check("prediction inside max_predict_us",
+                         ok && ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(newest + (double)ahead /
+                               IMU_HISTORY_TEST_DT_US)) < IMU_HISTORY_TEST_PRED_TOL);
+    ok = ImuHistory_Query(&h, ImuHistoryTest_Time(newest) + 3u * max_predict, &q);
+    ImuHistoryTest_Check("prediction beyond max_predict_us is clamped",
+                         !ok && ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(newest + (double)max_predict /
+                                IMU_HISTORY_TEST_DT_US)) < IMU_HISTORY_TEST_PRED_TOL);
+}
+
+static void *ImuHistoryTest_Writer(void *arg)
+{
+    ImuHistoryTest *t = (ImuHistoryTest *)arg;
+    uint32_t k = 0;
+    while (!t->stop)
+    {
+        ImuHistoryTest_Push(&t->history, k);
+        __atomic_store_n(&t->latest, k + 1u, __ATOMIC_RELEASE);
+        k++;
+    }
+    return NULL;
+}
+
+typedef struct ImuHistoryTestReader_ {
+    ImuHistoryTest *test;
+    int32_t index;
+}ImuHistoryTestReader;
+
+/**
+ * 查询时刻取在最近发布的半个缓存内, 只检查返回 true 的结果;
+ * 写入方很快, 选定时刻在查询时可能已经移出缓存, 这时返回 false, 不计入.
+ */
+static void *ImuHistoryTest_Reader(void *arg)
+{
+    ImuHistoryTestReader *r = (ImuHistoryTestReader *)arg;
+    ImuHistoryTest *t = r->test;
+    uint32_t rng = 0x9E3779B9u * (uint32_t)(r->index + 1);
+    while (!t->stop)
+    {
+        uint32_t latest = __atomic_load_n(&t->latest, __ATOMIC_ACQUIRE);
+        if (latest < IMU_HISTORY_SIZE)
+        {
+            continue;
+        }
+        rng = rng * 1664525u + 1013904223u;
+        double k = (double)latest - 1.0 - (double)(rng >> 8) / 16777216.0 * (IMU_HISTORY_SIZE / 2);
+        ImuQuaternion q;
+        if (!ImuHistory_Query(&t->history, ImuHistoryTest_Time(0) + (uint32_t)(k * IMU_HISTORY_TEST_DT_US), &q))
+        {
+            continue;
+        }
+        // 查询时刻按整数微秒截断, 真值取同一时刻
+        double e = ImuHistoryTest_Error(&q, ImuHistoryTest_Angle(floor(k * IMU_HISTORY_TEST_DT_US) /
+                                                                 IMU_HISTORY_TEST_DT_US));
+        t->queries[r->index]++;
+        t->err_max[r->index] = (e > t->err_max[r->index]) ? e : t->err_max[r->index];
+        t->errors[r->index] += (e > IMU_HISTORY_TEST_TOL) ? 1u : 0u;
+    }
+    return NULL;
+}
+
+static void ImuHistoryTest_Concurrent(int32_t readers, double seconds)
+{
+    static ImuHistoryTest t;
+    static ImuHistoryTestReader reader[IMU_HISTORY_TEST_MAX_THREADS];
+    pthread_t writer, thread[IMU_HISTORY_TEST_MAX_THREADS];
+    struct timespec ts;
+    uint64_t queries = 0, errors = 0;
+    double err_max = 0.0;
+
+    memset(&t, 0, sizeof(t));
+    ImuHistory_Init(&t.history, IMU_HISTORY_MAX_PREDICT_US);
+    pthread_create(&writer, NULL, ImuHistoryTest_Writer, &t);
+    for (int32_t i = 0; i < readers; i++)
+    {
+        reader[i].test = &t;
+        reader[i].index = i;
+        pthread_create(&thread[i], NULL, ImuHistoryTest_Reader, &reader[i]);
+    }
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+    t.stop = 1;
+    pthread_join(writer, NULL);
+    for (int32_t i = 0; i < readers; i++)
+    {
+        pthread_join(thread[i], NULL);
+        queries += t.queries[i];
+        errors += t.errors[i];
+        err_max = (t.err_max[i] > err_max) ? t.err_max[i] : err_max;
+    }
+
+    printf("concurrent: %u pushes, %d readers, %llu checked queries, %llu torn, max error %.2e rad\n",
+           t.latest, readers, (unsigned long long)queries, (unsigned long long)errors, err_max);
+    ImuHistoryTest_Check("concurrent push/query never returns a torn entry", queries > 0 && 0 == errors);
+}
+
+int main(int argc, char **argv)
+{
+    int32_t readers = 3;
+    double seconds = 2.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j': readers = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            default:
+                fprintf(stderr, "usage: imu_history_test [-j reader_threads] [-t seconds]\n");
+                return 1;
+        }
+    }
+    readers = (readers < 1) ? 1 : (readers > IMU_HISTORY_TEST_MAX_THREADS) ? IMU_HISTORY_TEST_MAX_THREADS : readers;
+
+    ImuHistoryTest_Sequential();
+    ImuHistoryTest_Concurrent(readers, seconds);
+    printf("%s\n", imu_history_test_fail ? "FAILED" : "all passed");
+    return imu_history_test_fail ? 1 : 0;
+}
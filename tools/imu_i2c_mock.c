@@ -0,0 +1,266 @@
+/**
+ * @file imu_i2c_mock.c
+ * @author Wyatt Yu
+ * @brief 主机端工具的 i2c-dev 模拟器件
+ * @copyright Copyright (c) 2025
+ */
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "imu_i2c_mock.h"
+#include "adlx345.h"
+#include "itg3205.h"
+#include "qmc5883l.h"
+
+#define IMU_I2C_MOCK_G              9.80665
+#define IMU_I2C_MOCK_ITG_LSB        14.375      // LSB per deg/s
+#define IMU_I2C_MOCK_MAG_X          0.20        // 地理系磁场, Gauss
+#define IMU_I2C_MOCK_MAG_Z          (-0.40)
+
+void ImuI2cMock_Init(ImuI2cMock *mock, bool smbus_only)
+{
+    memset(mock, 0, sizeof(ImuI2cMock));
+    mock->smbus_only = smbus_only;
+    mock->slave = -1;
+    mock->roll = 10.0 * M_PI / 180.0;
+    mock->pitch = -5.0 * M_PI / 180.0;
+    mock->gyro_bias[0] = 0.01;
+    mock->gyro_bias[1] = -0.005;
+    mock->gyro_bias[2] = 0.002;
+    mock->rng = 1;
+
+    mock->dev[0].addr = Adlx345Addr_Low;
+    mock->dev[0].reg[ADLX345_REG_DEVID] = ADLX345_DEVID;
+    mock->dev[0].reg[ADLX345_REG_INT_SOURCE] = ADLX345_INT_DATA_READY;
+    mock->dev[1].addr = Itg3205Addr_Low;
+    mock->dev[1].reg[ITG3205_REG_DEVID] = Itg3205Addr_Low;
+    mock->dev[1].reg[ITG3205_REG_INT_STATUS] = ITG3205_INT_ITG_RDY | ITG3205_INT_RAW_RDY;
+    mock->dev[2].addr = QMC5883L_ADDR;
+    mock->dev[2].reg[QMC5883L_REG_CHIP_ID] = QMC5883L_CHIP_ID;
+    mock->dev[2].reg[QMC5883L_REG_STATUS] = QMC5883L_STATUS_DRDY;
+}
+
+static ImuI2cMockDevice *ImuI2cMock_Find(ImuI2cMock *mock, int32_t addr)
+{
+    for (int32_t i = 0; i < IMU_I2C_MOCK_DEVICES; i++)
+    {
+        if (mock->dev[i].addr == addr)
+        {
+            return &mock->dev[i];
+        }
+    }
+    errno = ENXIO;
+    return NULL;
+}
+
+// 地理系向量转到机体系, v_body = Rx(roll)^T Ry(pitch)^T Rz(yaw)^T v
+static void ImuI2cMock_ToBody(const ImuI2cMock *mock, const double v[3], double out[3])
+{
+    double cr = cos(mock->roll), sr = sin(mock->roll);
+    double cp = cos(mock->pitch), sp = sin(mock->pitch);
+    double cy = cos(mock->yaw), sy = sin(mock->yaw);
+    double a = cy * v[0] + sy * v[1];
+    double b = -sy * v[0] + cy * v[1];
+    double c = v[2];
+    double d = cp * a - sp * c;
+    double e = sp * a + cp * c;
+    out[0] = d;
+    out[1] = cr * b + sr * e;
+    out[2] = -sr * b + cr * e;
+}
+
+// 均匀噪声 [-amp, amp]
+static double ImuI2cMock_Noise(ImuI2cMock *mock, double amp)
+{
+    mock->rng = mock->rng * 1664525u + 1013904223u;
+    return amp * ((double)(mock->rng >> 8) / 8388608.0 - 1.0);
+}
+
+static int16_t ImuI2cMock_Count(double v)
+{
+    v = (v >= 0.0) ? v + 0.5 : v - 0.5;
+    return (int16_t)((v > 32767.0) ? 32767.0 : ((v < -32768.0) ? -32768.0 : v));
+}
+
+static void ImuI2cMock_Refresh(ImuI2cMock *mock, ImuI2cMockDevice *dev)
+{
+    static const double up[3] = {0.0, 0.0, 1.0};
+    static const double field[3] = {IMU_I2C_MOCK_MAG_X, 0.0, IMU_I2C_MOCK_MAG_Z};
+    double v[3];
+    int16_t raw;
+
+    if (dev == &mock->dev[0])
+    {
+        // 左对齐, 量程满刻度对应 32768
+        double k = 32768.0 / (2 << (dev->reg[ADLX345_REG_DATAFORMAT] & 0x03));
+        ImuI2cMock_ToBody(mock, up, v);
+        for (int32_t i = 0; i < 3; i++)
+        {
+            raw = ImuI2cMock_Count(v[i] * k + ImuI2cMock_Noise(mock, 2.0));
+            dev->reg[ADLX345_REG_DATA + 2 * i] = (uint8_t)raw;
+            dev->reg[ADLX345_REG_DATA + 2 * i + 1] = (uint8_t)((uint16_t)raw >> 8);
+        }
+    }
+    else if (dev == &mock->dev[1])
+    {
+        raw = ImuI2cMock_Count((25.0 - 35.0) * 280.0 + 13200.0);
+        dev->reg[ITG3205_REG_DATA] = (uint8_t)((uint16_t)raw >> 8);
+        dev->reg[ITG3205_REG_DATA + 1] = (uint8_t)raw;
+        for (int32_t i = 0; i < 3; i++)
+        {
+            raw = ImuI2cMock_Count(mock->gyro_bias[i] * 180.0 / M_PI * IMU_I2C_MOCK_ITG_LSB +
+                                   ImuI2cMock_Noise(mock, 2.0));
+            dev->reg[ITG3205_REG_DATA + 2 + 2 * i] = (uint8_t)((uint16_t)raw >> 8);
+            dev->reg[ITG3205_REG_DATA + 3 + 2 * i] = (uint8_t)raw;
+        }
+    }
+    else
+    {
+        // 量程 2G: 12000 LSB/G, 8G: 3000 LSB/G
+        double k = ((dev->reg[QMC5883L_REG_CONTROL1] >> 4) & 0x03) ? 3000.0 : 12000.0;
+        ImuI2cMock_ToBody(mock, field, v);
+        for (int32_t i = 0; i < 3; i++)
+        {
+            raw = ImuI2cMock_Count(v[i] * k + ImuI2cMock_Noise(mock, 4.0));
+            dev->reg[QMC5883L_REG_DATA + 2 * i] = (uint8_t)raw;
+            dev->reg[QMC5883L_REG_DATA + 2 * i + 1] = (uint8_t)((uint16_t)raw >> 8);
+        }
+    }
+}
+
+static void ImuI2cMock_Read(ImuI2cMock *mock, ImuI2cMockDevice *dev, uint8_t *data, uint32_t length)
+{
+    ImuI2cMock_Refresh(mock, dev);
+    for (uint32_t i = 0; i < length; i++)
+    {
+        data[i] = dev->reg[dev->pointer++];
+    }
+}
+
+static void ImuI2cMock_Write(ImuI2cMockDevice *dev, const uint8_t *data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint8_t reg = dev->pointer++;
+        dev->reg[reg] = data[i];
+        // 复位位写入后自动清零
+        if (Itg3205Addr_Low == dev->addr && ITG3205_REG_PWR == reg)
+        {
+            dev->reg[reg] &= (uint8_t)~ITG3205_PWR_H_RESET;
+        }
+        else if (QMC5883L_ADDR == dev->addr && QMC5883L_REG_CONTROL2 == reg)
+        {
+            dev->reg[reg] &= (uint8_t)~QMC5883L_CONTROL2_SOFT_RST;
+        }
+    }
+}
+
+static int ImuI2cMock_Rdwr(ImuI2cMock *mock, struct i2c_rdwr_ioctl_data *args)
+{
+    if (mock->smbus_only)
+    {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    for (uint32_t i = 0; i < args->nmsgs; i++)
+    {
+        struct i2c_msg *m = &args->msgs[i];
+        ImuI2cMockDevice *dev = ImuI2cMock_Find(mock, m->addr);
+        if (!dev)
+        {
+            return -1;
+        }
+        mock->messages++;
+        if (m->flags & I2C_M_RD)
+        {
+            ImuI2cMock_Read(mock, dev, m->buf, m->len);
+        }
+        else if (m->len > 0)
+        {
+            dev->pointer = m->buf[0];
+            ImuI2cMock_Write(dev, &m->buf[1], m->len - 1u);
+        }
+    }
+    return (int)args->nmsgs;
+}
+
+static int ImuI2cMock_Smbus(ImuI2cMock *mock, struct i2c_smbus_ioctl_data *args)
+{
+    ImuI2cMockDevice *dev = ImuI2cMock_Find(mock, mock->slave);
+    bool read = (I2C_SMBUS_READ == args->read_write);
+    if (!dev)
+    {
+        return -1;
+    }
+
+    mock->messages++;
+    switch (args->size)
+    {
+        case I2C_SMBUS_BYTE:
+            if (read)
+            {
+                ImuI2cMock_Read(mock, dev, &args->data->byte, 1);
+            }
+            else
+            {
+                dev->pointer = args->command;
+            }
+            return 0;
+        case I2C_SMBUS_BYTE_DATA:
+            dev->pointer = args->command;
+            if (read)
+            {
+                ImuI2cMock_Read(mock, dev, &args->data->byte, 1);
+            }
+            else
+            {
+                ImuI2cMock_Write(dev, &args->data->byte, 1);
+            }
+            return 0;
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+        {
+            uint32_t n = args->data->block[0];
+            n = (n > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : n;
+            dev->pointer = args->command;
+            if (read)
+            {
+                ImuI2cMock_Read(mock, dev, &args->data->block[1], n);
+            }
+            else
+            {
+                ImuI2cMock_Write(dev, &args->data->block[1], n);
+            }
+            return 0;
+        }
+        default:
+            errno = EOPNOTSUPP;
+            return -1;
+    }
+}
+
+int ImuI2cMock_Ioctl(void *ctx, unsigned long request, void *arg)
+{
+    ImuI2cMock *mock = (ImuI2cMock *)ctx;
+    mock->ioctls++;
+    switch (request)
+    {
+        case I2C_FUNCS:
+            *(unsigned long *)arg = mock->smbus_only ?
+                (I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_BYTE | I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_WORD_DATA |
+                 I2C_FUNC_SMBUS_I2C_BLOCK) : (I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL);
+            return 0;
+        case I2C_SLAVE:
+        case I2C_SLAVE_FORCE:
+            mock->slave = (int32_t)(uintptr_t)arg;
+            return 0;
+        case I2C_RDWR:
+            return ImuI2cMock_Rdwr(mock, (struct i2c_rdwr_ioctl_data *)arg);
+        case I2C_SMBUS:
+            return ImuI2cMock_Smbus(mock, (struct i2c_smbus_ioctl_data *)arg);
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+}
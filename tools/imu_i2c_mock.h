@@ -0,0 +1,43 @@
+/**
+ * @file imu_i2c_mock.h
+ * @author Wyatt Yu
+ * @brief 主机端工具的 i2c-dev 模拟器件 头文件
+ *
+ * 在用户态模拟 ADXL345 (0x53), ITG3205 (0x68), QMC5883L (0x0D) 的寄存器文件, 实现 i2c-dev 的
+ * I2C_FUNCS / I2C_SLAVE / I2C_RDWR / I2C_SMBUS 四种 ioctl, 经 ImuLinuxI2c_Attach 接入后端.
+ * 寄存器按地址自动递增; ID 与就绪标志固定为有效值, ITG3205 的复位位写入后自动清零.
+ * 每次读到数据寄存器时按当前量程重新生成一组静止姿态的数据 (带少量噪声), 便于核对换算与融合结果.
+ * smbus_only 模拟内核 i2c-stub: 只报告 SMBus 功能, I2C_RDWR 返回 EOPNOTSUPP.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_I2C_MOCK_H__
+#define __IMU_I2C_MOCK_H__
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IMU_I2C_MOCK_DEVICES        3
+
+typedef struct ImuI2cMockDevice_ {
+    uint8_t addr;
+    uint8_t pointer;            // 当前寄存器地址
+    uint8_t reg[256];
+}ImuI2cMockDevice;
+
+typedef struct ImuI2cMock_ {
+    ImuI2cMockDevice dev[IMU_I2C_MOCK_DEVICES];
+    bool smbus_only;
+    int32_t slave;              // I2C_SLAVE 设置的地址
+    double roll;                // 静止姿态, rad
+    double pitch;
+    double yaw;
+    double gyro_bias[3];        // rad/s
+    uint32_t rng;
+    uint32_t ioctls;
+    uint32_t messages;          // I2C_RDWR 中的消息数与 SMBus 事务数之和
+}ImuI2cMock;
+
+void ImuI2cMock_Init(ImuI2cMock *mock, bool smbus_only);
+int ImuI2cMock_Ioctl(void *ctx, unsigned long request, void *arg);     // 与 ImuLinuxI2c_IoctlFunc 兼容
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * @file imu_linux_read.c
+ * @author Wyatt Yu
+ * @brief 通过 Linux i2c-dev 后端读取三个芯片并运行融合, 统计节拍抖动与每节拍的系统调用数
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Itools -Iadlx345 -Iitg3205 -Iqmc5883l tools/imu_linux_read.c \
+ *       tools/imu_i2c_mock.c imu_linux.c imu_bus.c imu_startup.c imu.c imu_history.c imu_regcache.c \
+ *       adlx345/adlx345.c itg3205/itg3205.c qmc5883l/qmc5883l.c \
+ *       algorithm/imu_madgwick.c algorithm/imu_mahony.c algorithm/imu_complementary_filter.c \
+ *       -lm -lpthread -o imu_linux_read
+ * 用法:
+ *   imu_linux_read [-d /dev/i2c-N | -m | -M] [-S] [-N] [-r rate_hz] [-P fifo_priority] [-t seconds]
+ *     -m  用户态模拟器件, 支持 I2C_RDWR;  -M  模拟器件只支持 SMBus, 与 i2c-stub 相同
+ *     -S  即使控制器支持 I2C_RDWR 也走 SMBus, 用于对比;  -N  不使用磁力计
+ * 使用内核 i2c-stub 时先装载寄存器 ID, 使启动状态机的探测通过:
+ *   modprobe i2c-stub chip_addr=0x53,0x68,0x0d
+ *   i2cset -y N 0x53 0x00 0xe5; i2cset -y N 0x68 0x00 0x68; i2cset -y N 0x0d 0x0d 0xff
+ * i2c-stub 的数据寄存器不会变化, 只用于验证传输路径.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "imu.h"
+#include "imu_bus.h"
+#include "imu_startup.h"
+#include "imu_linux.h"
+#include "imu_i2c_mock.h"
+
+#define IMU_LINUX_READ_STARTUP_US   1000000u
+
+typedef struct ImuLinuxRead_ {
+    ImuBus bus;
+    ImuBusSource source;
+    Imu *imu;
+    uint32_t fresh;             // 读到新陀螺数据的节拍数
+    uint32_t stale;
+}ImuLinuxRead;
+
+static void ImuLinuxRead_Tick(void *arg)
+{
+    ImuLinuxRead *r = (ImuLinuxRead *)arg;
+    if (ImuBusSource_Read(&r->source, &r->imu->source))
+    {
+        Imu_Update(r->imu);
+        r->fresh++;
+    }
+    else
+    {
+        r->stale++;
+    }
+}
+
+static void ImuLinuxRead_Usage(void)
+{
+    fprintf(stderr, "usage: imu_linux_read [-d /dev/i2c-N | -m | -M] [-S] [-N] [-r rate_hz] [-P fifo_priority] "
+                    "[-t seconds]\n");
+}
+
+int main(int argc, char **argv)
+{
+    static const char *state_name[] = {"probe", "reset", "config", "settle", "ready", "failed", "absent"};
+    static const char *dev_name[] = {"adxl345", "itg3205", "qmc5883l"};
+    const char *path = "/dev/i2c-1";
+    int32_t mock_mode = 0;      // 1: I2C_RDWR, 2: SMBus only
+    bool force_smbus = false;
+    bool use_magic = true;
+    uint32_t rate = 200;
+    int32_t priority = 0;
+    double seconds = 5.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:mMSNr:P:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': path = optarg; break;
+            case 'm': mock_mode = 1; break;
+            case 'M': mock_mode = 2; break;
+            case 'S': force_smbus = true; break;
+            case 'N': use_magic = false; break;
+            case 'r': rate = (uint32_t)atoi(optarg); break;
+            case 'P': priority = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            default: ImuLinuxRead_Usage(); return 1;
+        }
+    }
+    if (0 == rate || seconds <= 0.0)
+    {
+        ImuLinuxRead_Usage();
+        return 1;
+    }
+
+    ImuLinuxI2c i2c;
+    ImuI2cMock mock;
+    bool ok;
+    if (mock_mode)
+    {
+        ImuI2cMock_Init(&mock, 2 == mock_mode);
+        ok = ImuLinuxI2c_Attach(&i2c, ImuI2cMock_Ioctl, &mock);
+        path = (2 == mock_mode) ? "mock (smbus)" : "mock (i2c)";
+    }
+    else
+    {
+        ok = ImuLinuxI2c_Open(&i2c, path);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "open %s failed: %s\n", path, strerror(i2c.last_errno));
+        return 1;
+    }
+    i2c.rdwr = i2c.rdwr && !force_smbus;
+    printf("bus %s: funcs 0x%08lx, %s\n", path, i2c.funcs, i2c.rdwr ? "I2C_RDWR" : "SMBus i2c block");
+
+    Adlx345 accel;
+    Itg3205 gyro;
+    Qmc5883l magic;
+    memset(&accel, 0, sizeof(accel));
+    memset(&gyro, 0, sizeof(gyro));
+    memset(&magic, 0, sizeof(magic));
+    accel.addr = Adlx345Addr_Low;
+    accel.range = Adlx345Range_16g;
+    accel.sample_rate = Adlx345SampleRate_800;
+    gyro.addr = Itg3205Addr_Low;
+    gyro.lpf = Itg3205DlpfBaudrate_42;
+    gyro.sample_div = 0;
+    magic.sample_rate = Qmc5883lRate_200hz;
+    magic.range = Qmc5883lRange_8gauss;
+    magic.mode = Qmc5883lMode_Continuous;
+    ImuLinux_Register(&i2c, &accel, &gyro, use_magic ? &magic : NULL);
+
+    // 启动状态机, 各芯片的等待互相重叠
+    ImuStartup st;
+    ImuStartup_Init(&st, &accel, &gyro, use_magic ? &magic : NULL, ImuLinux_NowUs);
+    while (!ImuStartup_Step(&st) && ImuLinux_NowUs() - st.start_us < IMU_LINUX_READ_STARTUP_US)
+    {
+        usleep(1000);
+    }
+    for (int32_t i = 0; i < ImuStartupDevice_Count; i++)
+    {
+        printf("%-9s %-7s id 0x%02x ready %6u us%s\n", dev_name[i], state_name[st.dev[i].state], st.dev[i].id,
+               st.ready_us[i], st.dev[i].timeout ? " (timeout)" : "");
+    }
+    if (!ImuStartup_IsReady(&st, ImuStartupDevice_Accel) || !ImuStartup_IsReady(&st, ImuStartupDevice_Gyro))
+    {
+        return 1;
+    }
+
+    static uint8_t arena_mem[IMU_ARENA_SIZE(1)];
+    static ImuLinuxRead r;
+    ImuArena arena;
+    ImuArena_Init(&arena, arena_mem, sizeof(arena_mem));
+    r.imu = Imu_Create(&arena);
+    r.imu->method = ImuMahony;
+    r.imu->samp_freq = (int32_t)rate;
+    r.imu->kp_gain = IMU_REAL(2.0);
+    r.imu->ki_gain = IMU_REAL(0.05);
+    ImuStartup_Read(&st, &r.imu->source);
+    ImuStartup_Align(&st, r.imu);
+    r.imu->state = ImuStateRuning;
+
+    ImuBus_InitLinux(&r.bus, &i2c);
+    if (!ImuBusSource_Init(&r.source, &r.bus, &accel, 0, &gyro, ImuStartup_IsReady(&st, ImuStartupDevice_Magic) ?
+                           &magic : NULL, 100))
+    {
+        fprintf(stderr, "bus slots failed\n");
+        return 1;
+    }
+
+    ImuLinuxSampler sampler;
+    uint32_t ioctls = i2c.ioctls;
+    uint32_t errors = i2c.errors;
+    if (!ImuLinuxSampler_Start(&sampler, rate, priority, ImuLinuxRead_Tick, &r))
+    {
+        fprintf(stderr, "sampler start failed\n");
+        return 1;
+    }
+    usleep((useconds_t)(seconds * 1e6));
+    ImuLinuxSampler_Stop(&sampler);
+    ioctls = i2c.ioctls - ioctls;
+    errors = i2c.errors - errors;
+
+    uint64_t ticks = sampler.ticks ? sampler.ticks : 1;
+    printf("sampler %u Hz, %s, ticks %llu, overruns %llu, wake latency avg %.1f us max %u us\n", rate,
+           sampler.realtime ? "SCHED_FIFO" : "SCHED_OTHER", (unsigned long long)sampler.ticks,
+           (unsigned long long)sampler.overruns, (double)sampler.latency_sum_us / ticks, sampler.latency_max_us);
+    printf("bus: %.2f ioctl/tick, %u errors, %u stale ticks, last poll %u us\n", (double)ioctls / ticks, errors,
+           r.stale, r.bus.busy_us);
+    Imu_UpdateEuler(r.imu);
+    printf("euler: roll %.2f pitch %.2f yaw %.2f deg\n", (double)r.imu->ctx->raw_euler_degree.roll,
+           (double)r.imu->ctx->raw_euler_degree.pitch, (double)r.imu->ctx->raw_euler_degree.yaw);
+    ImuLinuxI2c_Close(&i2c);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file imu_log.c
+ * @author Wyatt Yu
+ * @brief 主机端工具的记录文件读写
+ * @copyright Copyright (c) 2025
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "imu_log.h"
+
+bool ImuLog_Open(ImuLog *log, const char *path)
+{
+    log->line = 0;
+    log->fp = (0 == strcmp(path, "-")) ? stdin : fopen(path, "r");
+    return NULL != log->fp;
+}
+
+void ImuLog_Close(ImuLog *log)
+{
+    if (log->fp && log->fp != stdin)
+    {
+        fclose(log->fp);
+    }
+    log->fp = NULL;
+}
+
+static bool ImuLog_Parse(char *line, ImuLogSample *s)
+{
+    float v[13];
+    char *p = line;
+    char *end;
+    int32_t n = 0;
+
+    s->t_us = strtoll(p, &end, 10);
+    if (end == p)
+    {
+        return false;
+    }
+    p = end;
+    while (n < 13)
+    {
+        while (*p == ',' || *p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        v[n] = strtof(p, &end);
+        if (end == p)
+        {
+            break;
+        }
+        p = end;
+        n++;
+    }
+    if (n != 9 && n != 13)
+    {
+        return false;
+    }
+
+    memcpy(s->accel, &v[0], sizeof(s->accel));
+    memcpy(s->gyro, &v[3], sizeof(s->gyro));
+    memcpy(s->magic, &v[6], sizeof(s->magic));
+    s->has_truth = (13 == n);
+    if (s->has_truth)
+    {
+        memcpy(s->truth, &v[9], sizeof(s->truth));
+    }
+    return true;
+}
+
+int32_t ImuLog_Read(ImuLog *log, ImuLogSample *samples, int32_t max)
+{
+    char line[512];
+    int32_t n = 0;
+    while (n < max && fgets(line, sizeof(line), log->fp))
+    {
+        log->line++;
+        if ('#' == line[0] || '\n' == line[0] || '\r' == line[0])
+        {
+            continue;
+        }
+        if (ImuLog_Parse(line, &samples[n]))
+        {
+            n++;
+        }
+        else
+        {
+            fprintf(stderr, "imu_log: skip malformed line %lld\n", (long long)log->line);
+        }
+    }
+    return n;
+}
+
+void ImuLog_Write(FILE *fp, const ImuLogSample *s)
+{
+    fprintf(fp, "%lld,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g", (long long)s->t_us,
+            s->accel[0], s->accel[1], s->accel[2], s->gyro[0], s->gyro[1], s->gyro[2],
+            s->magic[0], s->magic[1], s->magic[2]);
+    if (s->has_truth)
+    {
+        fprintf(fp, ",%.7g,%.7g,%.7g,%.7g", s->truth[0], s->truth[1], s->truth[2], s->truth[3]);
+    }
+    fputc('\n', fp);
+}
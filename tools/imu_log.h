@@ -0,0 +1,37 @@
+/**
+ * @file imu_log.h
+ * @author Wyatt Yu
+ * @brief 主机端工具的记录文件读写 头文件
+ *
+ * 文本格式, 每行一个样本, '#' 开头为注释:
+ *   t_us, ax, ay, az, gx, gy, gz, mx, my, mz [, q0, q1, q2, q3]
+ * 单位与 ImuSource 一致 (m/s2, rad/s, Gauss), 末尾四元数为可选的真值.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_LOG_H__
+#define __IMU_LOG_H__
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct ImuLogSample_ {
+    int64_t t_us;
+    float accel[3];
+    float gyro[3];
+    float magic[3];
+    float truth[4];             // q0, q1, q2, q3
+    bool has_truth;
+}ImuLogSample;
+
+typedef struct ImuLog_ {
+    FILE *fp;
+    int64_t line;
+}ImuLog;
+
+bool ImuLog_Open(ImuLog *log, const char *path);
+int32_t ImuLog_Read(ImuLog *log, ImuLogSample *samples, int32_t max);
+void ImuLog_Close(ImuLog *log);
+void ImuLog_Write(FILE *fp, const ImuLogSample *sample);
+
+#endif
@@ -0,0 +1,15 @@
+/**
+ * @file imu_madgwick_ref.h
+ * @author Wyatt Yu
+ * @brief 公共子表达式消除之前的 Madgwick 内核 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_MADGWICK_REF_H__
+#define __IMU_MADGWICK_REF_H__
+#include "imu.h"
+
+// src->use_magic 选择 9 轴/6 轴分支, src 的加速度与磁场会被原地归一化
+void ImuMadgwickRef_AlgorithmUpdate(Imu *imu, ImuSource *src);
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file imu_pool.c
+ * @author Wyatt Yu
+ * @brief 主机端工具的 work-stealing 线程池
+ *
+ * 任务预先轮询分配到每个线程的队列, 线程从自己队列尾部取任务, 队列空后从其他线程队列头部窃取.
+ * 任务粒度是一个完整的会话/文件, 每个队列一把锁的开销可以忽略.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include "imu_pool.h"
+
+typedef struct ImuPoolWorker_ {
+    ImuPool *pool;
+    int32_t id;
+}ImuPoolWorker;
+
+int32_t ImuPool_DefaultWorkers(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int32_t)n : 1;
+}
+
+static int32_t ImuPool_PopLocal(ImuPoolQueue *q)
+{
+    int32_t job = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->tail > q->head)
+    {
+        job = q->jobs[--q->tail];
+    }
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+static int32_t ImuPool_Steal(ImuPoolQueue *q)
+{
+    int32_t job = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->tail > q->head)
+    {
+        job = q->jobs[q->head++];
+    }
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+static void *ImuPool_Thread(void *param)
+{
+    ImuPoolWorker *w = (ImuPoolWorker *)param;
+    ImuPool *pool = w->pool;
+    uint32_t seed = (uint32_t)w->id * 2654435761u + 1;
+
+    for (;;)
+    {
+        int32_t job = ImuPool_PopLocal(&pool->queue[w->id]);
+        // 本地队列为空, 从随机位置开始依次尝试窃取
+        for (int32_t i = 0; job < 0 && i < pool->workers; i++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            int32_t victim = (int32_t)((seed >> 8) % (uint32_t)pool->workers);
+            for (int32_t k = 0; job < 0 && k < pool->workers; k++)
+            {
+                int32_t v = (victim + k) % pool->workers;
+                if (v != w->id)
+                {
+                    job = ImuPool_Steal(&pool->queue[v]);
+                }
+            }
+        }
+        if (job < 0)
+        {
+            break;      // 任务不会再产生, 所有队列都空即结束
+        }
+        pool->func(pool->arg, job, w->id);
+    }
+    return NULL;
+}
+
+int32_t ImuPool_Run(int32_t workers, int32_t count, ImuPool_JobFunc func, void *arg)
+{
+    if (count <= 0)
+    {
+        return 0;
+    }
+    if (workers <= 0)
+    {
+        workers = ImuPool_DefaultWorkers();
+    }
+    if (workers > count)
+    {
+        workers = count;
+    }
+
+    ImuPool pool = {0};
+    pool.workers = workers;
+    pool.func = func;
+    pool.arg = arg;
+    pool.queue = calloc(workers, sizeof(ImuPoolQueue));
+    pthread_t *threads = calloc(workers, sizeof(pthread_t));
+    ImuPoolWorker *ctx = calloc(workers, sizeof(ImuPoolWorker));
+    if (!pool.queue || !threads || !ctx)
+    {
+        free(pool.queue);
+        free(threads);
+        free(ctx);
+        return -1;
+    }
+
+    for (int32_t i = 0; i < workers; i++)
+    {
+        ImuPoolQueue *q = &pool.queue[i];
+        pthread_mutex_init(&q->lock, NULL);
+        q->jobs = malloc(sizeof(int32_t) * (count / workers + 1));
+        // 轮询分配, 尾部出队时先执行序号小的任务
+        for (int32_t job = count - 1 - ((count - 1 - i) % workers); job >= 0; job -= workers)
+        {
+            q->jobs[q->tail++] = job;
+        }
+    }
+
+    for (int32_t i = 0; i < workers; i++)
+    {
+        ctx[i].pool = &pool;
+        ctx[i].id = i;
+        pthread_create(&threads[i], NULL, ImuPool_Thread, &ctx[i]);
+    }
+    for (int32_t i = 0; i < workers; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int32_t i = 0; i < workers; i++)
+    {
+        pthread_mutex_destroy(&pool.queue[i].lock);
+        free(pool.queue[i].jobs);
+    }
+    free(pool.queue);
+    free(threads);
+    free(ctx);
+    return workers;
+}
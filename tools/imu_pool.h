@@ -0,0 +1,33 @@
+/**
+ * @file imu_pool.h
+ * @author Wyatt Yu
+ * @brief 主机端工具的 work-stealing 线程池 头文件
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_POOL_H__
+#define __IMU_POOL_H__
+#include <stdint.h>
+#include <pthread.h>
+
+// job 为任务序号 [0, count), worker 为执行线程序号, 用于索引线程私有状态
+typedef void (*ImuPool_JobFunc)(void *arg, int32_t job, int32_t worker);
+
+typedef struct ImuPoolQueue_ {
+    pthread_mutex_t lock;
+    int32_t *jobs;
+    int32_t head;               // 被窃取端
+    int32_t tail;               // 本线程取任务端
+}ImuPoolQueue;
+
+typedef struct ImuPool_ {
+    ImuPoolQueue *queue;
+    int32_t workers;
+    ImuPool_JobFunc func;
+    void *arg;
+}ImuPool;
+
+int32_t ImuPool_DefaultWorkers(void);
+int32_t ImuPool_Run(int32_t workers, int32_t count, ImuPool_JobFunc func, void *arg);
+
+#endif
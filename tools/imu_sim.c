@@ -0,0 +1,253 @@
+/**
+ * @file imu_sim.c
+ * @author Wyatt Yu
+ * @brief 主机端工具的轨迹与传感器信号仿真
+ *
+ * 坐标系: 地理系 x 指向磁北, z 轴向上, 欧拉角按 z-y-x (yaw-pitch-roll) 顺序,
+ * 与 Imu_ConvertQuatToEuler 一致. 地磁场取 (0.3, 0, -0.4) Gauss.
+ * @copyright Copyright (c) 2025
+ */
+#include <math.h>
+#include <string.h>
+#include "imu_sim.h"
+
+#define IMU_SIM_PI          3.14159265358979323846
+#define IMU_SIM_G           9.81
+#define IMU_SIM_MAG_X       0.3
+#define IMU_SIM_MAG_Z       (-0.4)
+
+// 传感器默认参数, 量程与分辨率按各驱动的初始化配置
+#define IMU_SIM_ADXL345     { {0.08, -0.06, 0.1}, {0.01, -0.008, 0.012}, 0.04, 16.0 * IMU_SIM_G, 0.0039 * IMU_SIM_G }
+#define IMU_SIM_ITG3205     { {0.02, -0.015, 0.01}, {0.005, 0.004, -0.006}, 0.004, 2000.0 * IMU_SIM_PI / 180.0, IMU_SIM_PI / 180.0 / 14.375 }
+#define IMU_SIM_QMC5883L    { {0.0, 0.0, 0.0}, {0.01, -0.01, 0.005}, 0.002, 8.0, 1.0 / 3000.0 }
+
+static const ImuSimConfig imu_sim_presets[] = {
+    {
+        .name = "static", .samp_freq = 200, .static_time = 2.6, .duration = 30.0, .seed = 1,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = true,
+    },
+    {
+        .name = "slow", .samp_freq = 200, .static_time = 2.6, .duration = 60.0, .seed = 2,
+        .roll_amp = 0.5, .roll_freq = 0.11, .pitch_amp = 0.35, .pitch_freq = 0.07,
+        .yaw_amp = 1.5, .yaw_freq = 0.03,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = true,
+    },
+    {
+        .name = "slow6", .samp_freq = 200, .static_time = 2.6, .duration = 60.0, .seed = 3,
+        .roll_amp = 0.5, .roll_freq = 0.11, .pitch_amp = 0.35, .pitch_freq = 0.07,
+        .yaw_amp = 1.5, .yaw_freq = 0.03,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = false,
+    },
+    {
+        .name = "fast", .samp_freq = 200, .static_time = 2.6, .duration = 60.0, .seed = 4,
+        .roll_amp = 1.0, .roll_freq = 0.6, .pitch_amp = 0.6, .pitch_freq = 0.45,
+        .yaw_amp = 2.5, .yaw_freq = 0.2, .lin_amp = 3.0, .lin_freq = 1.3,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = true,
+    },
+    {
+        .name = "magdist", .samp_freq = 200, .static_time = 2.6, .duration = 60.0, .seed = 5,
+        .roll_amp = 0.4, .roll_freq = 0.13, .pitch_amp = 0.3, .pitch_freq = 0.09,
+        .yaw_amp = 1.0, .yaw_freq = 0.04,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .mag_disturb = 0.25, .mag_disturb_start = 20.0, .mag_disturb_time = 10.0,
+        .use_magic = true,
+    },
+    {
+        // 互补滤波与 Mahony / Madgwick 的对比轨迹: roll +-29deg, pitch +-17deg, yaw +-57deg
+        .name = "comple", .samp_freq = 200, .static_time = 2.6, .duration = 120.0, .seed = 7,
+        .roll_amp = 0.5, .roll_freq = 0.1, .pitch_amp = 0.3, .pitch_freq = 0.07,
+        .yaw_amp = 1.0, .yaw_freq = 0.03,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = true,
+    },
+    {
+        .name = "comple6", .samp_freq = 200, .static_time = 2.6, .duration = 120.0, .seed = 8,
+        .roll_amp = 0.5, .roll_freq = 0.1, .pitch_amp = 0.3, .pitch_freq = 0.07,
+        .yaw_amp = 1.0, .yaw_freq = 0.03,
+        .accel = IMU_SIM_ADXL345, .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = false,
+    },
+    {
+        // 超出 ITG3205 2000deg/s 的旋转与超出 +-2g 的冲击
+        .name = "saturate", .samp_freq = 200, .static_time = 2.6, .duration = 40.0, .seed = 6,
+        .roll_amp = 0.3, .roll_freq = 0.2, .pitch_amp = 0.2, .pitch_freq = 0.15,
+        .spin_rate = 40.0, .spin_start = 15.0, .spin_time = 0.4, .lin_amp = 25.0, .lin_freq = 2.0,
+        .accel = { {0.08, -0.06, 0.1}, {0.01, -0.008, 0.012}, 0.04, 2.0 * IMU_SIM_G, 0.0039 * IMU_SIM_G },
+        .gyro = IMU_SIM_ITG3205, .magic = IMU_SIM_QMC5883L,
+        .gyro_walk = 1e-4, .use_magic = true,
+    },
+};
+
+int32_t ImuSim_PresetCount(void)
+{
+    return (int32_t)(sizeof(imu_sim_presets) / sizeof(imu_sim_presets[0]));
+}
+
+const ImuSimConfig *ImuSim_Preset(int32_t index)
+{
+    return (index >= 0 && index < ImuSim_PresetCount()) ? &imu_sim_presets[index] : NULL;
+}
+
+const ImuSimConfig *ImuSim_FindPreset(const char *name)
+{
+    for (int32_t i = 0; i < ImuSim_PresetCount(); i++)
+    {
+        if (0 == strcmp(imu_sim_presets[i].name, name))
+        {
+            return &imu_sim_presets[i];
+        }
+    }
+    return NULL;
+}
+
+// xorshift64*, 每个会话独立的随机序列, 多线程下结果可复现
+static double ImuSim_Uniform(ImuSim *sim)
+{
+    sim->rng ^= sim->rng >> 12;
+    sim->rng ^= sim->rng << 25;
+    sim->rng ^= sim->rng >> 27;
+    return ((sim->rng * 2685821657736338717ull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double ImuSim_Gauss(ImuSim *sim)
+{
+    if (sim->has_spare)
+    {
+        sim->has_spare = false;
+        return sim->spare;
+    }
+    double u, v, s;
+    do
+    {
+        u = 2.0 * ImuSim_Uniform(sim) - 1.0;
+        v = 2.0 * ImuSim_Uniform(sim) - 1.0;
+        s = u * u + v * v;
+    } while (s >= 1.0 || s == 0.0);
+    s = sqrt(-2.0 * log(s) / s);
+    sim->spare = v * s;
+    sim->has_spare = true;
+    return u * s;
+}
+
+void ImuSim_Init(ImuSim *sim, const ImuSimConfig *cfg)
+{
+    memset(sim, 0, sizeof(ImuSim));
+    sim->cfg = *cfg;
+    sim->rng = 0x9E3779B97F4A7C15ull ^ ((uint64_t)cfg->seed * 0xD1B54A32D192ED03ull);
+    sim->static_count = (int64_t)(cfg->static_time * cfg->samp_freq);
+    sim->count = sim->static_count + (int64_t)(cfg->duration * cfg->samp_freq);
+    memcpy(sim->gyro_bias, cfg->gyro.bias, sizeof(sim->gyro_bias));
+}
+
+int64_t ImuSim_StaticCount(const ImuSim *sim)
+{
+    return sim->static_count;
+}
+
+// 正弦轨迹及其导数
+static void ImuSim_Wave(double amp, double freq, double t, double *angle, double *rate)
+{
+    double w = 2.0 * IMU_SIM_PI * freq;
+    *angle = amp * sin(w * t);
+    *rate = amp * w * cos(w * t);
+}
+
+// b = R^T e, R 为机体系到地理系
+static void ImuSim_ToBody(const double r[3][3], const double e[3], double b[3])
+{
+    for (int32_t i = 0; i < 3; i++)
+    {
+        b[i] = r[0][i] * e[0] + r[1][i] * e[1] + r[2][i] * e[2];
+    }
+}
+
+static float ImuSim_Measure(ImuSim *sim, const ImuSimSensor *s, const double *bias, double truth, int32_t axis)
+{
+    double v = (1.0 + s->scale[axis]) * truth + bias[axis] + s->noise * ImuSim_Gauss(sim);
+    v = (v > s->range) ? s->range : (v < -s->range) ? -s->range : v;
+    if (s->lsb > 0.0)
+    {
+        v = floor(v / s->lsb + 0.5) * s->lsb;
+    }
+    return (float)v;
+}
+
+bool ImuSim_Next(ImuSim *sim, ImuLogSample *sample)
+{
+    const ImuSimConfig *c = &sim->cfg;
+    if (sim->index >= sim->count)
+    {
+        return false;
+    }
+
+    double dt = 1.0 / c->samp_freq;
+    double t = (sim->index - sim->static_count) * dt;     // 运动段从 0 开始
+    double roll = 0.0, pitch = 0.0, yaw = 0.0;
+    double droll = 0.0, dpitch = 0.0, dyaw = 0.0;
+    double lin[3] = {0.0, 0.0, 0.0};
+    if (t >= 0.0)
+    {
+        ImuSim_Wave(c->roll_amp, c->roll_freq, t, &roll, &droll);
+        ImuSim_Wave(c->pitch_amp, c->pitch_freq, t, &pitch, &dpitch);
+        ImuSim_Wave(c->yaw_amp, c->yaw_freq, t, &yaw, &dyaw);
+        if (c->spin_time > 0.0 && t > c->spin_start)
+        {
+            double spin = (t < c->spin_start + c->spin_time) ? t - c->spin_start : c->spin_time;
+            yaw += c->spin_rate * spin;
+            dyaw += (t < c->spin_start + c->spin_time) ? c->spin_rate : 0.0;
+            yaw = fmod(yaw + IMU_SIM_PI, 2.0 * IMU_SIM_PI);
+            yaw += (yaw < 0.0) ? IMU_SIM_PI : -IMU_SIM_PI;
+        }
+        double w = 2.0 * IMU_SIM_PI * c->lin_freq;
+        lin[0] = c->lin_amp * sin(w * t);
+        lin[1] = c->lin_amp * cos(1.3 * w * t) * 0.5;
+    }
+
+    double cr = cos(roll), sr = sin(roll);
+    double cp = cos(pitch), sp = sin(pitch);
+    double cy = cos(yaw), sy = sin(yaw);
+    double r[3][3] = {
+        {cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr},
+        {sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr},
+        {-sp,     cp * sr,                cp * cr},
+    };
+
+    // 欧拉角速率转机体角速度
+    double gyro[3] = {
+        droll - sp * dyaw,
+        cr * dpitch + sr * cp * dyaw,
+        -sr * dpitch + cr * cp * dyaw,
+    };
+    double accel_e[3] = {lin[0], lin[1], lin[2] + IMU_SIM_G};
+    double magic_e[3] = {IMU_SIM_MAG_X, 0.0, IMU_SIM_MAG_Z};
+    if (c->mag_disturb_time > 0.0 && t >= c->mag_disturb_start && t < c->mag_disturb_start + c->mag_disturb_time)
+    {
+        magic_e[1] += c->mag_disturb;
+    }
+    double accel[3], magic[3];
+    ImuSim_ToBody(r, accel_e, accel);
+    ImuSim_ToBody(r, magic_e, magic);
+
+    for (int32_t i = 0; i < 3; i++)
+    {
+        sim->gyro_bias[i] += c->gyro_walk * sqrt(dt) * ImuSim_Gauss(sim);
+        sample->accel[i] = ImuSim_Measure(sim, &c->accel, c->accel.bias, accel[i], i);
+        sample->gyro[i] = ImuSim_Measure(sim, &c->gyro, sim->gyro_bias, gyro[i], i);
+        sample->magic[i] = c->use_magic ? ImuSim_Measure(sim, &c->magic, c->magic.bias, magic[i], i) : 0.0f;
+    }
+
+    double hr = 0.5 * roll, hp = 0.5 * pitch, hy = 0.5 * yaw;
+    double chr = cos(hr), shr = sin(hr), chp = cos(hp), shp = sin(hp), chy = cos(hy), shy = sin(hy);
+    sample->truth[0] = (float)(chr * chp * chy + shr * shp * shy);
+    sample->truth[1] = (float)(shr * chp * chy - chr * shp * shy);
+    sample->truth[2] = (float)(chr * shp * chy + shr * chp * shy);
+    sample->truth[3] = (float)(chr * chp * shy - shr * shp * chy);
+    sample->has_truth = true;
+    sample->t_us = (int64_t)(sim->index * 1000000LL / c->samp_freq);
+    sim->index++;
+    return true;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file imu_sim.h
+ * @author Wyatt Yu
+ * @brief 主机端工具的轨迹与传感器信号仿真 头文件
+ *
+ * 由解析的欧拉角轨迹生成真值四元数, 再按 ADXL345/ITG3205/QMC5883L 的量程与分辨率
+ * 生成带零偏, 刻度误差, 噪声, 磁干扰, 饱和与量化的传感器数据, 输出格式与记录文件相同.
+ * 每段数据开头有一段水平静止, 供陀螺零偏校准使用.
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef __IMU_SIM_H__
+#define __IMU_SIM_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include "imu_log.h"
+
+typedef struct ImuSimSensor_ {
+    double bias[3];
+    double scale[3];            // 刻度误差, 0.01 表示 +1%
+    double noise;               // 白噪声标准差
+    double range;               // 满量程, 超出后饱和
+    double lsb;                 // 量化步长
+}ImuSimSensor;
+
+typedef struct ImuSimConfig_ {
+    const char *name;
+    int32_t samp_freq;
+    double static_time;         // s, 开头水平静止时长
+    double duration;            // s, 运动段时长
+    uint32_t seed;
+
+    // 欧拉角轨迹 angle = amp * sin(2 * pi * freq * t + phase), rad / Hz
+    double roll_amp, roll_freq;
+    double pitch_amp, pitch_freq;
+    double yaw_amp, yaw_freq;
+    double spin_rate;           // 绕 z 轴的附加角速度脉冲, rad/s
+    double spin_start, spin_time;
+    double lin_amp, lin_freq;   // 地理系水平线性加速度, m/s2
+
+    ImuSimSensor accel;         // m/s2
+    ImuSimSensor gyro;          // rad/s
+    ImuSimSensor magic;         // Gauss
+    double gyro_walk;           // 陀螺零偏随机游走, rad/s/sqrt(s)
+    double mag_disturb;         // 沿地理系 y 轴的附加磁场, Gauss
+    double mag_disturb_start, mag_disturb_time;
+    bool use_magic;
+}ImuSimConfig;
+
+typedef struct ImuSim_ {
+    ImuSimConfig cfg;
+    uint64_t rng;
+    int64_t index;
+    int64_t count;
+    int64_t static_count;
+    double gyro_bias[3];        // 含随机游走后的当前零偏
+    double spare;               // Box-Muller 的第二个样本
+    bool has_spare;
+}ImuSim;
+
+int32_t ImuSim_PresetCount(void);
+const ImuSimConfig *ImuSim_Preset(int32_t index);
+const ImuSimConfig *ImuSim_FindPreset(const char *name);
+void ImuSim_Init(ImuSim *sim, const ImuSimConfig *cfg);
+bool ImuSim_Next(ImuSim *sim, ImuLogSample *sample);
+int64_t ImuSim_StaticCount(const ImuSim *sim);
+
+#endif
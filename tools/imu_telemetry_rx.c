@@ -0,0 +1,410 @@
+/**
+ * @file imu_telemetry_rx.c
+ * @author Wyatt Yu
+ * @brief 二进制遥测流的主机端接收与回环自测
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Itools tools/imu_telemetry_rx.c tools/imu_sim.c tools/imu_log.c imu_telemetry.c -lm -lpthread -o imu_telemetry_rx
+ * 用法:
+ *   imu_telemetry_rx [-b baud] [-n frames] [-o out.csv] device|-
+ *   imu_telemetry_rx -l [-b baud] [-r rate] [-t seconds] [-s scenario] [-d time,quat,raw,profile] [-q 32|48] [-c N]
+ * 第一种形式从串口 (或标准输入) 读取并解码, 每帧输出一行 CSV, 结束时打印统计.
+ * -l 为回环自测: 在伪终端上按 rate 帧/秒发送仿真轨迹的真值姿态, 发送节奏同时受 baud 限制
+ * (每字节 10 位), 接收端解码后与真值比较, 报告帧长, 链路占用, 实际帧率, 四元数压缩误差,
+ * 以及 -c 每 N 帧注入一个错误字节后的 CRC 错误与丢帧统计.
+ * @copyright Copyright (c) 2025
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <termios.h>
+#include "imu_telemetry.h"
+#include "imu_sim.h"
+
+typedef struct ImuTelemetryRx_ {
+    int32_t baud;
+    int32_t rate;
+    double seconds;
+    const ImuSimConfig *scenario;
+    uint16_t divider[ImuTelemetryField_Count];
+    bool quat48;
+    int32_t corrupt;            // 每 N 帧翻转一个字节, 0 不注入
+
+    int tx;                     // 回环发送端, 伪终端主设备
+    int64_t frames;             // 计划发送帧数
+    float *truth;               // 每帧的真值四元数
+    int64_t sent;
+    int64_t bytes;
+    volatile bool done;
+}ImuTelemetryRx;
+
+static double ImuTelemetryRx_Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void ImuTelemetryRx_SleepUntil(double t)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)t;
+    ts.tv_nsec = (long)((t - (double)ts.tv_sec) * 1e9);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static speed_t ImuTelemetryRx_Speed(int32_t baud)
+{
+    switch (baud)
+    {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default: return B0;
+    }
+}
+
+static bool ImuTelemetryRx_SetRaw(int fd, int32_t baud)
+{
+    struct termios tio;
+    if (!isatty(fd))
+    {
+        return true;
+    }
+    if (tcgetattr(fd, &tio) < 0)
+    {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    speed_t speed = ImuTelemetryRx_Speed(baud);
+    if (B0 != speed)
+    {
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    return 0 == tcsetattr(fd, TCSANOW, &tio);
+}
+
+static double ImuTelemetryRx_AngleDeg(const imu_real_t *q, const float *truth)
+{
+    double dot = q[0] * (double)truth[0] + q[1] * (double)truth[1] + q[2] * (double)truth[2] + q[3] * (double)truth[3];
+    dot = (dot < 0) ? -dot : dot;
+    dot = (dot > 1.0) ? 1.0 : dot;
+    return 2.0 * acos(dot) * 180.0 / 3.14159265358979;
+}
+
+static bool ImuTelemetryRx_ParseDivider(const char *arg, uint16_t *divider)
+{
+    int v[ImuTelemetryField_Count];
+    if (ImuTelemetryField_Count != sscanf(arg, "%d,%d,%d,%d", &v[0], &v[1], &v[2], &v[3]))
+    {
+        return false;
+    }
+    for (int32_t f = 0; f < ImuTelemetryField_Count; f++)
+    {
+        if (v[f] < 0 || v[f] > 65535)
+        {
+            return false;
+        }
+        divider[f] = (uint16_t)v[f];
+    }
+    return true;
+}
+
+// 模拟固件端: 真值姿态与传感器数据装入 Imu 后编码, 按帧率与波特率两者中较慢的节奏写出
+static void *ImuTelemetryRx_Writer(void *arg)
+{
+    ImuTelemetryRx *rx = (ImuTelemetryRx *)arg;
+    ImuSimConfig cfg = *rx->scenario;
+    ImuSim sim;
+    ImuLogSample s;
+    ImuTelemetry t;
+    uint8_t frame[IMU_TELEMETRY_MAX_FRAME];
+    Imu state;                  // 只作为编码输入, 不做融合, 不需要 ImuContext
+    Imu *imu = &state;
+    int64_t k = 0;
+
+    memset((void *)imu, 0, sizeof(Imu));
+    cfg.samp_freq = rx->rate;
+    cfg.static_time = 0.0;
+    cfg.duration = rx->seconds + 1.0;
+    ImuSim_Init(&sim, &cfg);
+    ImuTelemetry_Init(&t, rx->divider[0], rx->divider[1], rx->divider[2], rx->divider[3], rx->quat48);
+
+    double start = ImuTelemetryRx_Now();
+    while (k < rx->frames && ImuSim_Next(&sim, &s))
+    {
+        imu->source.accel.x = s.accel[0];
+        imu->source.accel.y = s.accel[1];
+        imu->source.accel.z = s.accel[2];
+        imu->source.gyro.x  = s.gyro[0];
+        imu->source.gyro.y  = s.gyro[1];
+        imu->source.gyro.z  = s.gyro[2];
+        imu->source.magic.x = s.magic[0];
+        imu->source.magic.y = s.magic[1];
+        imu->source.magic.z = s.magic[2];
+        imu->source.timestamp_us = (uint32_t)s.t_us;
+        imu->quaternion.q0 = s.truth[0];
+        imu->quaternion.q1 = s.truth[1];
+        imu->quaternion.q2 = s.truth[2];
+        imu->quaternion.q3 = s.truth[3];
+        memcpy(&rx->truth[k * 4], s.truth, sizeof(s.truth));
+        t.profile[0] = (uint32_t)k;
+        t.profile[1] = (uint32_t)rx->bytes;
+
+        int32_t n = ImuTelemetry_Encode(&t, imu, frame);
+        if (rx->corrupt > 0 && rx->corrupt - 1 == k % rx->corrupt && n > 2)
+        {
+            // 只改数据字节, 不制造或吞掉分隔符
+            frame[n / 2] ^= (0x01 == frame[n / 2]) ? 0x02 : 0x01;
+        }
+
+        double due = start + (double)k / rx->rate;
+        double line = start + (double)rx->bytes * 10.0 / rx->baud;
+        ImuTelemetryRx_SleepUntil((due > line) ? due : line);
+        for (int32_t off = 0; off < n;)
+        {
+            ssize_t w = write(rx->tx, &frame[off], (size_t)(n - off));
+            if (w <= 0)
+            {
+                k = rx->frames;
+                break;
+            }
+            off += (int32_t)w;
+        }
+        rx->bytes += n;
+        rx->sent = ++k;
+    }
+    rx->done = true;
+    return NULL;
+}
+
+static void ImuTelemetryRx_Stats(const ImuTelemetryDecoder *d, int64_t bytes, double seconds)
+{
+    fprintf(stderr, "frames %u  errors %u  lost %u  bytes %lld  %.1f frames/s  %.1f bytes/frame\n",
+            d->frames, d->errors, d->lost, (long long)bytes, seconds > 0 ? d->frames / seconds : 0.0,
+            d->frames ? (double)bytes / d->frames : 0.0);
+}
+
+static int ImuTelemetryRx_Loopback(ImuTelemetryRx *rx)
+{
+    ImuTelemetryDecoder d;
+    ImuTelemetrySample sample;
+    pthread_t writer;
+    uint8_t buf[4096];
+    int64_t index = -1;
+    uint8_t last_seq = 0;
+    int64_t compared = 0;
+    double err_max = 0.0;
+    double err_sum2 = 0.0;
+    int64_t received = 0;
+    double last = 0.0;
+
+    rx->tx = posix_openpt(O_RDWR | O_NOCTTY);
+    if (rx->tx < 0 || grantpt(rx->tx) < 0 || unlockpt(rx->tx) < 0)
+    {
+        perror("posix_openpt");
+        return 1;
+    }
+    int fd = open(ptsname(rx->tx), O_RDWR | O_NOCTTY);
+    if (fd < 0 || !ImuTelemetryRx_SetRaw(fd, rx->baud) || !ImuTelemetryRx_SetRaw(rx->tx, rx->baud))
+    {
+        perror("pty");
+        return 1;
+    }
+
+    rx->frames = (int64_t)(rx->seconds * rx->rate);
+    rx->truth = malloc(sizeof(float) * 4 * (size_t)rx->frames);
+    ImuTelemetry_InitDecoder(&d);
+    double start = ImuTelemetryRx_Now();
+    pthread_create(&writer, NULL, ImuTelemetryRx_Writer, rx);
+
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (true)
+    {
+        // 发送结束后再等一个超时, 读完伪终端里剩余的字节
+        if (poll(&pfd, 1, 200) <= 0)
+        {
+            if (rx->done)
+            {
+                break;
+            }
+            continue;
+        }
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            break;
+        }
+        received += n;
+        last = ImuTelemetryRx_Now();
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (!ImuTelemetry_Decode(&d, buf[i], &sample))
+            {
+                continue;
+            }
+            // 序号只有 8 位, 按与上一帧的差值展开成帧序号
+            index = (index < 0) ? sample.seq : index + (uint8_t)(sample.seq - last_seq);
+            last_seq = sample.seq;
+            if ((sample.flags & (1u << ImuTelemetryField_Quat)) && index < rx->sent)
+            {
+                double e = ImuTelemetryRx_AngleDeg(sample.q, &rx->truth[index * 4]);
+                err_max = (e > err_max) ? e : err_max;
+                err_sum2 += e * e;
+                compared++;
+            }
+        }
+    }
+    double elapsed = last - start;
+    pthread_join(writer, NULL);
+
+    double per_frame = rx->sent ? (double)rx->bytes / rx->sent : 0.0;
+    printf("sent %lld frames in %.2f s, %.2f bytes/frame, %.1f frames/s, link load %.1f%% of %d baud\n",
+           (long long)rx->sent, elapsed, per_frame, rx->sent / elapsed,
+           100.0 * rx->bytes * 10.0 / elapsed / rx->baud, rx->baud);
+    printf("decoded %u  crc/format errors %u  lost %u  quat err max %.4f deg  rms %.4f deg\n",
+           d.frames, d.errors, d.lost, err_max, compared ? sqrt(err_sum2 / compared) : 0.0);
+    ImuTelemetryRx_Stats(&d, received, elapsed);
+
+    close(fd);
+    close(rx->tx);
+    free(rx->truth);
+    return (d.frames + d.lost == (uint32_t)rx->sent || rx->corrupt > 0) ? 0 : 1;
+}
+
+static int ImuTelemetryRx_Receive(const char *path, int32_t baud, int64_t max, const char *out)
+{
+    ImuTelemetryDecoder d;
+    ImuTelemetrySample s;
+    uint8_t buf[4096];
+    int64_t bytes = 0;
+    FILE *fp = out ? fopen(out, "w") : stdout;
+    int fd = strcmp(path, "-") ? open(path, O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+
+    if (fd < 0 || !fp || !ImuTelemetryRx_SetRaw(fd, baud))
+    {
+        perror(fd < 0 ? path : out);
+        return 1;
+    }
+    ImuTelemetry_InitDecoder(&d);
+    fprintf(fp, "# flags, seq, t_us, q0, q1, q2, q3, roll, pitch, yaw, ax, ay, az, gx, gy, gz, mx, my, mz, p0, p1, p2, p3\n");
+    double start = ImuTelemetryRx_Now();
+    while (max <= 0 || d.frames < max)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            break;
+        }
+        bytes += n;
+        for (ssize_t i = 0; i < n && (max <= 0 || d.frames < max); i++)
+        {
+            if (!ImuTelemetry_Decode(&d, buf[i], &s))
+            {
+                continue;
+            }
+            double q0 = s.q[0], q1 = s.q[1], q2 = s.q[2], q3 = s.q[3];
+            double roll = atan2(2.0 * (q0 * q1 + q2 * q3), 1.0 - 2.0 * (q1 * q1 + q2 * q2));
+            double sp = 2.0 * (q0 * q2 - q1 * q3);
+            double pitch = asin((sp > 1.0) ? 1.0 : (sp < -1.0) ? -1.0 : sp);
+            double yaw = atan2(2.0 * (q0 * q3 + q1 * q2), 1.0 - 2.0 * (q2 * q2 + q3 * q3));
+            const double k = 180.0 / 3.14159265358979;
+            fprintf(fp, "0x%02x, %u, %u, %.5f, %.5f, %.5f, %.5f, %.3f, %.3f, %.3f",
+                    s.flags, s.seq, s.t_us, q0, q1, q2, q3, roll * k, pitch * k, yaw * k);
+            fprintf(fp, ", %d, %d, %d, %d, %d, %d, %d, %d, %d, %u, %u, %u, %u\n",
+                    s.accel[0], s.accel[1], s.accel[2], s.gyro[0], s.gyro[1], s.gyro[2],
+                    s.magic[0], s.magic[1], s.magic[2], s.profile[0], s.profile[1], s.profile[2], s.profile[3]);
+        }
+    }
+    ImuTelemetryRx_Stats(&d, bytes, ImuTelemetryRx_Now() - start);
+    if (out)
+    {
+        fclose(fp);
+    }
+    if (fd != STDIN_FILENO)
+    {
+        close(fd);
+    }
+    return 0;
+}
+
+static void ImuTelemetryRx_Usage(void)
+{
+    fprintf(stderr, "usage: imu_telemetry_rx [-b baud] [-n frames] [-o out.csv] device|-\n"
+                    "       imu_telemetry_rx -l [-b baud] [-r rate] [-t seconds] [-s scenario]"
+                    " [-d time,quat,raw,profile] [-q 32|48] [-c N]\n");
+}
+
+int main(int argc, char **argv)
+{
+    ImuTelemetryRx rx = {0};
+    bool loopback = false;
+    int64_t max = 0;
+    const char *out = NULL;
+    int opt;
+
+    rx.baud = 115200;
+    rx.rate = 1000;
+    rx.seconds = 5.0;
+    rx.scenario = ImuSim_FindPreset("fast");
+    rx.divider[ImuTelemetryField_Time] = 10;
+    rx.divider[ImuTelemetryField_Quat] = 1;
+    while ((opt = getopt(argc, argv, "lb:r:t:s:d:q:c:n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'l': loopback = true; break;
+            case 'b': rx.baud = atoi(optarg); break;
+            case 'r': rx.rate = atoi(optarg); break;
+            case 't': rx.seconds = atof(optarg); break;
+            case 's': rx.scenario = ImuSim_FindPreset(optarg); break;
+            case 'd':
+                if (!ImuTelemetryRx_ParseDivider(optarg, rx.divider))
+                {
+                    ImuTelemetryRx_Usage();
+                    return 1;
+                }
+                break;
+            case 'q': rx.quat48 = (48 == atoi(optarg)); break;
+            case 'c': rx.corrupt = atoi(optarg); break;
+            case 'n': max = atoll(optarg); break;
+            case 'o': out = optarg; break;
+            default: ImuTelemetryRx_Usage(); return 1;
+        }
+    }
+    if (rx.baud <= 0 || rx.rate <= 0 || !rx.scenario)
+    {
+        ImuTelemetryRx_Usage();
+        return 1;
+    }
+
+    if (loopback)
+    {
+        return ImuTelemetryRx_Loopback(&rx);
+    }
+    if (optind >= argc)
+    {
+        ImuTelemetryRx_Usage();
+        return 1;
+    }
+    return ImuTelemetryRx_Receive(argv[optind], rx.baud, max, out);
+}
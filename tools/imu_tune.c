@@ -0,0 +1,585 @@
+/**
+ * @file imu_tune.c
+ * @author Wyatt Yu
+ * @brief 并行搜索 kp/ki(beta)/alpha, 使仿真或记录数据上的姿态误差最小
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Itools tools/imu_tune.c tools/imu_sim.c tools/imu_pool.c tools/imu_log.c \
+ *       imu.c imu_history.c algorithm/imu_madgwick.c algorithm/imu_mahony.c algorithm/imu_complementary_filter.c \
+ *       -lm -lpthread -o imu_tune
+ * 用法:
+ *   imu_tune [-j threads] [-m madgwick|mahony|comple] [-f 100,200,400] [-s static,slow,...] [-S settle_s]
+ *            [-E init_err_deg] [-g grid] [-n nm_starts] [-o gains.h] [log.csv ...]
+ * 不给记录文件时使用仿真场景 (默认除 saturate 外的全部场景), 每个采样率单独生成一次;
+ * 给出记录文件时只按 -f 的第一个采样率调参, 记录文件必须带真值, 滤波器从首个真值开始.
+ *
+ * 搜索分两步: 先在对数坐标的网格上并行评估, 再从最好的几个网格点并行启动 Nelder-Mead.
+ * 目标函数为各会话 RMS 误差 (deg) 的平均值. 滤波器从偏离真值 init_err (默认 20deg) 的姿态开始,
+ * settle 之后仍未收敛的部分计入误差, 避免只按稳态精度选出收敛过慢的增益.
+ * 结果以宏的形式输出, 可直接包含进工程.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include "imu.h"
+#include "imu_log.h"
+#include "imu_pool.h"
+#include "imu_sim.h"
+
+#define IMU_TUNE_MAX_DIM        2
+#define IMU_TUNE_MAX_RATES      8
+#define IMU_TUNE_MAX_SESSIONS   64
+#define IMU_TUNE_NM_EVALS       60          // 每个起点的最大评估次数
+#define IMU_TUNE_NM_TOL         1e-4        // deg, 单纯形函数值极差小于此值时结束
+
+typedef struct ImuTuneSession_ {
+    const char *name;
+    ImuLogSample *samples;
+    int64_t count;
+    int64_t calib;              // 开头静止校准段的样本数, 记录文件为 0
+    int64_t settle;             // 从此样本开始计分
+}ImuTuneSession;
+
+// 参数在对数坐标下搜索, alpha 以 1 - alpha 的对数表示
+typedef struct ImuTuneSpace_ {
+    ImuMethod method;
+    const char *name;
+    const char *macro;
+    int32_t dim;
+    double lo[IMU_TUNE_MAX_DIM];
+    double hi[IMU_TUNE_MAX_DIM];
+}ImuTuneSpace;
+
+typedef struct ImuTunePoint_ {
+    double x[IMU_TUNE_MAX_DIM];
+    double cost;
+}ImuTunePoint;
+
+typedef struct ImuTune_ {
+    const ImuTuneSpace *space;
+    int32_t samp_freq;
+    ImuTuneSession *session;
+    int32_t session_count;
+    ImuTunePoint *point;        // 网格点或 Nelder-Mead 起点/结果
+    int32_t point_count;
+    int64_t evals;
+    double init_err;            // rad, 滤波器初始姿态相对真值的偏差, 迫使增益兼顾收敛速度
+}ImuTune;
+
+static const ImuTuneSpace imu_tune_spaces[] = {
+    {ImuMadgwick, "madgwick", "MADGWICK", 1, {-9.0}, {0.0}},                // beta 1.2e-4 ~ 1
+    {ImuMahony, "mahony", "MAHONY", 2, {-7.0, -11.0}, {2.5, -0.7}},         // kp 9e-4 ~ 12, ki 1.7e-5 ~ 0.5
+    {ImuComplementaryFilter, "comple", "COMPLE", 1, {-11.0}, {-1.6}},       // 1 - alpha 1.7e-5 ~ 0.2
+};
+
+static void ImuTune_Gains(const ImuTuneSpace *space, const double *x, float *kp, float *ki, float *alpha)
+{
+    *kp = 0.0f;
+    *ki = 0.0f;
+    *alpha = 0.0f;
+    if (ImuMadgwick == space->method)
+    {
+        *ki = (float)exp(x[0]);
+    }
+    else if (ImuMahony == space->method)
+    {
+        *kp = (float)exp(x[0]);
+        *ki = (float)exp(x[1]);
+    }
+    else
+    {
+        *alpha = (float)(1.0 - exp(x[0]));
+    }
+}
+
+static void ImuTune_Load(Imu *imu, const ImuLogSample *s)
+{
+    imu->source.accel.x = s->accel[0];
+    imu->source.accel.y = s->accel[1];
+    imu->source.accel.z = s->accel[2];
+    imu->source.gyro.x  = s->gyro[0];
+    imu->source.gyro.y  = s->gyro[1];
+    imu->source.gyro.z  = s->gyro[2];
+    imu->source.magic.x = s->magic[0];
+    imu->source.magic.y = s->magic[1];
+    imu->source.magic.z = s->magic[2];
+    imu->source.timestamp_us = (uint32_t)s->t_us;
+    imu->source.use_magic = (s->magic[0] != 0.0f || s->magic[1] != 0.0f || s->magic[2] != 0.0f);
+}
+
+static double ImuTune_Session(const ImuTune *t, const ImuTuneSession *s, const double *x, Imu *imu)
+{
+    float kp, ki, alpha;
+    double err2 = 0.0;
+    int64_t scored = 0;
+
+    ImuTune_Gains(t->space, x, &kp, &ki, &alpha);
+    Imu_Init(imu, imu->ctx);
+    Imu_InitCalibrate(imu);
+    imu->method = t->space->method;
+    imu->samp_freq = t->samp_freq;
+    imu->kp_gain = kp;
+    imu->ki_gain = ki;
+    imu->comple_filter_alpha = alpha;
+    // 初始姿态 = 首个真值 * 绕机体 (1, 1, 0) 轴旋转 init_err, 只引入倾角误差, 无磁力计时也能收敛
+    const float *q = s->samples[0].has_truth ? s->samples[0].truth : (const float[4]){1.0f, 0.0f, 0.0f, 0.0f};
+    double c = cos(0.5 * t->init_err);
+    double v = sin(0.5 * t->init_err) / sqrt(2.0);
+    imu->quaternion.q0 = (float)(q[0] * c - (q[1] + q[2]) * v);
+    imu->quaternion.q1 = (float)(q[1] * c + (q[0] - q[3]) * v);
+    imu->quaternion.q2 = (float)(q[2] * c + (q[0] + q[3]) * v);
+    imu->quaternion.q3 = (float)(q[3] * c + (q[1] - q[2]) * v);
+    if (0 == s->calib)
+    {
+        imu->state = ImuStateRuning;
+    }
+
+    for (int64_t i = 0; i < s->count; i++)
+    {
+        const ImuLogSample *p = &s->samples[i];
+        ImuTune_Load(imu, p);
+        if (ImuStateCalib == imu->state)
+        {
+            Imu_Calibrate(imu);
+            continue;
+        }
+        imu->state = ImuStateRuning;
+        Imu_Update(imu);
+        if (i >= s->settle && p->has_truth)
+        {
+            double dot = imu->quaternion.q0 * p->truth[0] + imu->quaternion.q1 * p->truth[1] +
+                         imu->quaternion.q2 * p->truth[2] + imu->quaternion.q3 * p->truth[3];
+            dot = (dot < 0) ? -dot : dot;
+            dot = (dot > 1.0) ? 1.0 : dot;
+            double e = 2.0 * acos(dot) * 180.0 / 3.14159265358979;
+            err2 += e * e;
+            scored++;
+        }
+    }
+    return scored ? sqrt(err2 / scored) : 0.0;
+}
+
+static double ImuTune_Cost(ImuTune *t, const double *x, Imu *imu)
+{
+    double sum = 0.0;
+    for (int32_t i = 0; i < t->space->dim; i++)
+    {
+        if (x[i] < t->space->lo[i] || x[i] > t->space->hi[i])
+        {
+            return 1e9;         // 超出搜索范围
+        }
+    }
+    for (int32_t i = 0; i < t->session_count; i++)
+    {
+        double rms = ImuTune_Session(t, &t->session[i], x, imu);
+        sum += isfinite(rms) ? rms : 1e6;
+    }
+    __atomic_add_fetch(&t->evals, 1, __ATOMIC_RELAXED);
+    return sum / t->session_count;
+}
+
+static void ImuTune_GridJob(void *arg, int32_t job, int32_t worker)
+{
+    ImuTune *t = (ImuTune *)arg;
+    void *arena_mem = malloc(IMU_ARENA_SIZE(1));
+    ImuArena arena;
+    ImuArena_Init(&arena, arena_mem, IMU_ARENA_SIZE(1));
+    Imu *imu = Imu_Create(&arena);
+    (void)worker;
+    t->point[job].cost = ImuTune_Cost(t, t->point[job].x, imu);
+    free(arena_mem);
+}
+
+// 每个起点独立运行一次 Nelder-Mead, 结果写回起点
+static void ImuTune_NelderMeadJob(void *arg, int32_t job, int32_t worker)
+{
+    ImuTune *t = (ImuTune *)arg;
+    ImuTunePoint *start = &t->point[job];
+    int32_t n = t->space->dim;
+    ImuTunePoint simplex[IMU_TUNE_MAX_DIM + 1];
+    void *arena_mem = malloc(IMU_ARENA_SIZE(1));
+    ImuArena arena;
+    ImuArena_Init(&arena, arena_mem, IMU_ARENA_SIZE(1));
+    Imu *imu = Imu_Create(&arena);
+    int32_t evals = 0;
+    (void)worker;
+
+    for (int32_t i = 0; i <= n; i++)
+    {
+        simplex[i] = *start;
+        if (i > 0)
+        {
+            simplex[i].x[i - 1] += 0.1 * (t->space->hi[i - 1] - t->space->lo[i - 1]);
+            simplex[i].cost = ImuTune_Cost(t, simplex[i].x, imu);
+            evals++;
+        }
+    }
+
+    while (evals < IMU_TUNE_NM_EVALS)
+    {
+        // 排序, simplex[0] 最好, simplex[n] 最差
+        for (int32_t i = 1; i <= n; i++)
+        {
+            for (int32_t j = i; j > 0 && simplex[j].cost < simplex[j - 1].cost; j--)
+            {
+                ImuTunePoint tmp = simplex[j];
+                simplex[j] = simplex[j - 1];
+                simplex[j - 1] = tmp;
+            }
+        }
+        if (simplex[n].cost - simplex[0].cost < IMU_TUNE_NM_TOL)
+        {
+            break;
+        }
+
+        double c[IMU_TUNE_MAX_DIM] = {0};
+        for (int32_t i = 0; i < n; i++)
+        {
+            for (int32_t k = 0; k < n; k++)
+            {
+                c[k] += simplex[i].x[k] / n;
+            }
+        }
+        ImuTunePoint r, e, k;
+        for (int32_t d = 0; d < n; d++)
+        {
+            r.x[d] = c[d] + (c[d] - simplex[n].x[d]);
+        }
+        r.cost = ImuTune_Cost(t, r.x, imu);
+        evals++;
+        if (r.cost < simplex[0].cost)
+        {
+            for (int32_t d = 0; d < n; d++)
+            {
+                e.x[d] = c[d] + 2.0 * (c[d] - simplex[n].x[d]);
+            }
+            e.cost = ImuTune_Cost(t, e.x, imu);
+            evals++;
+            simplex[n] = (e.cost < r.cost) ? e : r;
+        }
+        else if (r.cost < simplex[n - 1].cost)
+        {
+            simplex[n] = r;
+        }
+        else
+        {
+            for (int32_t d = 0; d < n; d++)
+            {
+                k.x[d] = c[d] + 0.5 * (simplex[n].x[d] - c[d]);
+            }
+            k.cost = ImuTune_Cost(t, k.x, imu);
+            evals++;
+            if (k.cost < simplex[n].cost)
+            {
+                simplex[n] = k;
+            }
+            else
+            {
+                // 整体向最好点收缩
+                for (int32_t i = 1; i <= n; i++)
+                {
+                    for (int32_t d = 0; d < n; d++)
+                    {
+                        simplex[i].x[d] = simplex[0].x[d] + 0.5 * (simplex[i].x[d] - simplex[0].x[d]);
+                    }
+                    simplex[i].cost = ImuTune_Cost(t, simplex[i].x, imu);
+                    evals++;
+                }
+            }
+        }
+    }
+
+    for (int32_t i = 1; i <= n; i++)
+    {
+        if (simplex[i].cost < simplex[0].cost)
+        {
+            simplex[0] = simplex[i];
+        }
+    }
+    *start = simplex[0];
+    free(arena_mem);
+}
+
+static int ImuTune_ComparePoint(const void *a, const void *b)
+{
+    double d = ((const ImuTunePoint *)a)->cost - ((const ImuTunePoint *)b)->cost;
+    return (d < 0) ? -1 : (d > 0) ? 1 : 0;
+}
+
+static ImuTunePoint ImuTune_Search(ImuTune *t, int32_t threads, int32_t grid, int32_t starts)
+{
+    const ImuTuneSpace *space = t->space;
+    int32_t count = 1;
+    for (int32_t i = 0; i < space->dim; i++)
+    {
+        count *= grid;
+    }
+
+    t->point = calloc(count, sizeof(ImuTunePoint));
+    t->point_count = count;
+    for (int32_t p = 0; p < count; p++)
+    {
+        int32_t idx = p;
+        for (int32_t i = 0; i < space->dim; i++)
+        {
+            int32_t g = idx % grid;
+            idx /= grid;
+            t->point[p].x[i] = space->lo[i] + (space->hi[i] - space->lo[i]) * (g + 0.5) / grid;
+        }
+    }
+    ImuPool_Run(threads, count, ImuTune_GridJob, t);
+    qsort(t->point, count, sizeof(ImuTunePoint), ImuTune_ComparePoint);
+
+    // 网格结果已排序, 前 starts 个点作为 Nelder-Mead 起点
+    starts = (starts > count) ? count : starts;
+    if (starts > 0)
+    {
+        ImuPool_Run(threads, starts, ImuTune_NelderMeadJob, t);
+        qsort(t->point, starts, sizeof(ImuTunePoint), ImuTune_ComparePoint);
+    }
+    ImuTunePoint best = t->point[0];
+    free(t->point);
+    t->point = NULL;
+    return best;
+}
+
+static int32_t ImuTune_LoadLog(const char *path, ImuTuneSession *s, double settle, int32_t samp_freq)
+{
+    ImuLog log;
+    int64_t cap = 0;
+    int32_t n;
+    if (!ImuLog_Open(&log, path))
+    {
+        return -1;
+    }
+    memset(s, 0, sizeof(ImuTuneSession));
+    s->name = path;
+    do
+    {
+        if (s->count + 1024 > cap)
+        {
+            cap = cap ? cap * 2 : 65536;
+            s->samples = realloc(s->samples, sizeof(ImuLogSample) * cap);
+        }
+        n = ImuLog_Read(&log, &s->samples[s->count], 1024);
+        s->count += (n > 0) ? n : 0;
+    } while (n > 0);
+    ImuLog_Close(&log);
+    s->settle = (int64_t)(settle * samp_freq);
+    return (s->count > 0 && s->samples[0].has_truth) ? 0 : -1;
+}
+
+static void ImuTune_Simulate(const ImuSimConfig *preset, int32_t samp_freq, double settle, ImuTuneSession *s)
+{
+    ImuSimConfig cfg = *preset;
+    ImuSim sim;
+    cfg.samp_freq = samp_freq;
+    // 静止段至少要覆盖一次完整的陀螺零偏校准
+    if (cfg.static_time * samp_freq < IMU_CALIBRATE_TIMES + 20)
+    {
+        cfg.static_time = (IMU_CALIBRATE_TIMES + 20.0) / samp_freq;
+    }
+    ImuSim_Init(&sim, &cfg);
+    memset(s, 0, sizeof(ImuTuneSession));
+    s->name = preset->name;
+    s->samples = malloc(sizeof(ImuLogSample) * (size_t)(cfg.duration * samp_freq + cfg.static_time * samp_freq + 1));
+    while (ImuSim_Next(&sim, &s->samples[s->count]))
+    {
+        s->count++;
+    }
+    s->calib = ImuSim_StaticCount(&sim);
+    s->settle = s->calib + (int64_t)(settle * samp_freq);
+}
+
+static bool ImuTune_InList(const char *list, const char *name)
+{
+    size_t len = strlen(name);
+    for (const char *p = list; p && *p; )
+    {
+        const char *end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && 0 == strncmp(p, name, len))
+        {
+            return true;
+        }
+        p = end ? end + 1 : NULL;
+    }
+    return false;
+}
+
+static void ImuTune_Define(FILE *fp, const char *method, int32_t samp_freq, const char *gain, float value)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "IMU_GAIN_%s_%dHZ_%s", method, (int)samp_freq, gain);
+    fprintf(fp, "#define %-36s%#.6gf\n", name, value);
+}
+
+// 最优点落在搜索边界上时提示, 此时应扩大范围或检查数据
+static bool ImuTune_AtBound(const ImuTuneSpace *space, const double *x)
+{
+    for (int32_t i = 0; i < space->dim; i++)
+    {
+        double margin = 0.02 * (space->hi[i] - space->lo[i]);
+        if (x[i] < space->lo[i] + margin || x[i] > space->hi[i] - margin)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ImuTune_Usage(void)
+{
+    fprintf(stderr, "usage: imu_tune [-j threads] [-m madgwick|mahony|comple] [-f 100,200,400] [-s scenario,...]\n"
+                    "                [-S settle_s] [-E init_err_deg] [-g grid] [-n nm_starts] [-o gains.h] [log.csv ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    int32_t threads = 0;
+    int32_t grid = 0;
+    int32_t starts = 0;
+    const char *method = NULL;
+    const char *rates = "200";
+    const char *scenarios = "static,slow,slow6,fast,magdist";
+    const char *out = NULL;
+    double settle = 5.0;
+    double init_err = 20.0;
+    int32_t rate[IMU_TUNE_MAX_RATES];
+    int32_t rate_count = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:m:f:s:S:E:g:n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j': threads = atoi(optarg); break;
+            case 'm': method = optarg; break;
+            case 'f': rates = optarg; break;
+            case 's': scenarios = optarg; break;
+            case 'S': settle = atof(optarg); break;
+            case 'E': init_err = atof(optarg); break;
+            case 'g': grid = atoi(optarg); break;
+            case 'n': starts = atoi(optarg); break;
+            case 'o': out = optarg; break;
+            default: ImuTune_Usage(); return 1;
+        }
+    }
+    for (const char *p = rates; p && *p && rate_count < IMU_TUNE_MAX_RATES; )
+    {
+        rate[rate_count++] = atoi(p);
+        p = strchr(p, ',');
+        p = p ? p + 1 : NULL;
+    }
+    if (0 == rate_count || rate[0] <= 0)
+    {
+        ImuTune_Usage();
+        return 1;
+    }
+    if (threads <= 0)
+    {
+        threads = ImuPool_DefaultWorkers();
+    }
+    starts = (starts > 0) ? starts : (threads < 4 ? 4 : threads);
+
+    bool recorded = optind < argc;
+    if (recorded)
+    {
+        rate_count = 1;         // 记录文件的采样率是固定的
+    }
+
+    FILE *fp = out ? fopen(out, "w") : NULL;
+    if (out && !fp)
+    {
+        fprintf(stderr, "imu_tune: cannot write %s\n", out);
+        return 1;
+    }
+    if (fp)
+    {
+        fprintf(fp, "/* generated by imu_tune, objective: mean RMS attitude error (deg) */\n");
+        fprintf(fp, "#ifndef __IMU_GAINS_H__\n#define __IMU_GAINS_H__\n\n");
+    }
+
+    for (int32_t r = 0; r < rate_count; r++)
+    {
+        ImuTune t = {0};
+        t.samp_freq = rate[r];
+        t.init_err = init_err * 3.14159265358979 / 180.0;
+        t.session = calloc(IMU_TUNE_MAX_SESSIONS, sizeof(ImuTuneSession));
+        if (recorded)
+        {
+            for (int32_t i = optind; i < argc && t.session_count < IMU_TUNE_MAX_SESSIONS; i++)
+            {
+                if (0 == ImuTune_LoadLog(argv[i], &t.session[t.session_count], settle, t.samp_freq))
+                {
+                    t.session_count++;
+                }
+                else
+                {
+                    fprintf(stderr, "imu_tune: skip %s (unreadable or no truth)\n", argv[i]);
+                }
+            }
+        }
+        else
+        {
+            for (int32_t i = 0; i < ImuSim_PresetCount() && t.session_count < IMU_TUNE_MAX_SESSIONS; i++)
+            {
+                const ImuSimConfig *cfg = ImuSim_Preset(i);
+                if (ImuTune_InList(scenarios, cfg->name))
+                {
+                    ImuTune_Simulate(cfg, t.samp_freq, settle, &t.session[t.session_count++]);
+                }
+            }
+        }
+        if (0 == t.session_count)
+        {
+            fprintf(stderr, "imu_tune: no usable session\n");
+            return 1;
+        }
+
+        for (size_t m = 0; m < sizeof(imu_tune_spaces) / sizeof(imu_tune_spaces[0]); m++)
+        {
+            const ImuTuneSpace *space = &imu_tune_spaces[m];
+            float kp, ki, alpha;
+            if (method && strcmp(method, space->name))
+            {
+                continue;
+            }
+            t.space = space;
+            t.evals = 0;
+            ImuTunePoint best = ImuTune_Search(&t, threads, grid > 0 ? grid : (1 == space->dim ? 32 : 12), starts);
+            ImuTune_Gains(space, best.x, &kp, &ki, &alpha);
+            printf("%-9s %4d Hz  rms %.4f deg  kp %.5g  ki/beta %.5g  alpha %.6g  (%lld evals, %d sessions)\n",
+                   space->name, t.samp_freq, best.cost, kp, ki, alpha, (long long)t.evals, t.session_count);
+            if (ImuTune_AtBound(space, best.x))
+            {
+                printf("          warning: optimum is at the edge of the search range\n");
+            }
+            if (fp)
+            {
+                fprintf(fp, "/* %s %d Hz: mean rms %.4f deg over %d sessions */\n", space->name, t.samp_freq,
+                        best.cost, t.session_count);
+                ImuTune_Define(fp, space->macro, t.samp_freq, "KP", kp);
+                ImuTune_Define(fp, space->macro, t.samp_freq, "KI", ki);
+                ImuTune_Define(fp, space->macro, t.samp_freq, "ALPHA", alpha);
+                fprintf(fp, "\n");
+            }
+        }
+
+        for (int32_t i = 0; i < t.session_count; i++)
+        {
+            free(t.session[i].samples);
+        }
+        free(t.session);
+    }
+
+    if (fp)
+    {
+        fprintf(fp, "#endif\n");
+        fclose(fp);
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file imu_vibration_test.c
+ * @author Wyatt Yu
+ * @brief 振动频谱监测的主机端测试: 实数 FFT, 单音峰值频率与幅值, 频带 RMS, 扫频跟踪
+ *
+ * 编译 (在仓库根目录):
+ *   gcc -O2 -std=gnu99 -Itools/host -I. -Iadlx345 tools/imu_vibration_test.c imu_vibration.c \
+ *       adlx345/adlx345.c imu_regcache.c -lm -o imu_vibration_test
+ * 用法:
+ *   imu_vibration_test
+ * 全部通过返回 0. 信号以原始计数 (LSB) 合成后经 ImuVibration_Push 输入, 采样率 3200Hz,
+ * 刻度取 ADXL345 全分辨率 3.9mg/LSB; 真值按双精度解析计算.
+ * @copyright Copyright (c) 2025
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "imu_vibration.h"
+
+#define IMU_VIBRATION_TEST_FS           3200.0
+#define IMU_VIBRATION_TEST_SCALE        (0.0039 * 9.80665)     // m/s2 per LSB
+#define IMU_VIBRATION_TEST_N            IMU_VIBRATION_FFT_SIZE
+#define IMU_VIBRATION_TEST_BIN          (IMU_VIBRATION_TEST_FS / IMU_VIBRATION_TEST_N)
+#define IMU_VIBRATION_TEST_FFT_TOL      1e-5        // 相对最大谱线幅值
+#define IMU_VIBRATION_TEST_FREQ_TOL     0.2         // Hz, 抛物线插值的频率误差
+#define IMU_VIBRATION_TEST_AMP_TOL      0.02        // 相对, Hann 窗抛物线插值后的残余扇贝损失
+#define IMU_VIBRATION_TEST_RMS_TOL      0.005       // 相对, 频带 RMS 与总 RMS
+#define IMU_VIBRATION_TEST_BLOCK        32          // 每次装入的样本数, 与 FIFO 突发相当
+
+typedef struct ImuVibrationTestTone_ {
+    double freq;                // Hz
+    double amp;                 // LSB, 峰值
+}ImuVibrationTestTone;
+
+static ImuVibration imu_vibration_test_v;
+static int32_t imu_vibration_test_fail = 0;
+
+static void ImuVibrationTest_Check(const char *name, bool cond)
+{
+    printf("%-48s %s\n", name, cond ? "ok" : "FAIL");
+    imu_vibration_test_fail += cond ? 0 : 1;
+}
+
+static int16_t ImuVibrationTest_Count(double x)
+{
+    x = (x >= 0.0) ? x + 0.5 : x - 0.5;
+    return (int16_t)((x > 32767.0) ? 32767.0 : ((x < -32768.0) ? -32768.0 : x));
+}
+
+// 各轴为若干单音之和加常量偏置 (重力), 从第 start 个样本起装入 count 个
+static void ImuVibrationTest_PushTones(ImuVibration *v, const ImuVibrationTestTone tones[3][3], const double offset[3],
+                                       uint32_t start, uint32_t count)
+{
+    int16_t raw[IMU_VIBRATION_TEST_BLOCK][3];
+    for (uint32_t i = 0; i < count; i += IMU_VIBRATION_TEST_BLOCK)
+    {
+        uint32_t n = (count - i < IMU_VIBRATION_TEST_BLOCK) ? count - i : IMU_VIBRATION_TEST_BLOCK;
+        for (uint32_t j = 0; j < n; j++)
+        {
+            double t = (double)(start + i + j) / IMU_VIBRATION_TEST_FS;
+            for (int32_t axis = 0; axis < 3; axis++)
+            {
+                double x = offset[axis];
+                for (int32_t k = 0; k < 3; k++)
+                {
+                    x += tones[axis][k].amp * sin(2.0 * M_PI * tones[axis][k].freq * t);
+                }
+                raw[j][axis] = ImuVibrationTest_Count(x);
+            }
+        }
+        ImuVibration_Push(v, (const int16_t (*)[3])raw, (int32_t)n);
+    }
+}
+
+static void ImuVibrationTest_Rfft(void)
+{
+    static imu_real_t data[IMU_VIBRATION_TEST_N];
+    static double x[IMU_VIBRATION_TEST_N];
+    ImuVibration *v = &imu_vibration_test_v;
+    uint32_t rng = 12345u;
+    double err = 0.0, peak = 0.0;
+
+    ImuVibration_Init(v, (imu_real_t)IMU_VIBRATION_TEST_FS, (imu_real_t)IMU_VIBRATION_TEST_SCALE);
+    for (int32_t i = 0; i < IMU_VIBRATION_TEST_N; i++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        x[i] = (double)(rng >> 8) / 8388608.0 - 1.0 + 0.3 * cos(2.0 * M_PI * 17.0 * i / IMU_VIBRATION_TEST_N);
+        data[i] = (imu_real_t)x[i];
+    }
+    ImuVibration_Rfft(v, data);
+
+    // 与直接计算的 DFT 逐项比较, 输出排列见 ImuVibration_Rfft
+    for (int32_t k = 0; k <= IMU_VIBRATION_TEST_N / 2; k++)
+    {
+        double re = 0.0, im = 0.0;
+        for (int32_t i = 0; i < IMU_VIBRATION_TEST_N; i++)
+        {
+            double a = 2.0 * M_PI * (double)k * i / IMU_VIBRATION_TEST_N;
+            re += x[i] * cos(a);
+            im -= x[i] * sin(a);
+        }
+        double fr, fi;
+        if (0 == k)
+        {
+            fr = data[0];
+            fi = 0.0;
+        }
+        else if (IMU_VIBRATION_TEST_N / 2 == k)
+        {
+            fr = data[1];
+            fi = 0.0;
+        }
+        else
+        {
+            fr = data[2 * k];
+            fi = data[2 * k + 1];
+        }
+        double d = hypot(fr - re, fi - im);
+        err = (d > err) ? d : err;
+        peak = (hypot(re, im) > peak) ? hypot(re, im) : peak;
+    }
+    printf("rfft: max |X - DFT| %.2e, max |X| %.2e\n", err, peak);
+    ImuVibrationTest_Check("rfft matches a direct DFT", err < IMU_VIBRATION_TEST_FFT_TOL * peak);
+}
+
+/**
+ * x 轴 137.3Hz 与 400Hz 两个单音, y 轴 250Hz, z 轴 90Hz 的小幅单音加 1g 偏置.
+ * 三轴合成谱中最强的三个峰按幅值排列应为 137.3, 250, 400Hz; 频带 [50, 200]Hz 只包含 x 轴的 137.3Hz.
+ */
+static void ImuVibrationTest_Tones(void)
+{
+    static const ImuVibrationTestTone tones[3][3] = {
+        {{137.3, 1000.0}, {400.0, 300.0}, {0.0, 0.0}},
+        {{250.0, 600.0}, {0.0, 0.0}, {0.0, 0.0}},
+        {{90.0, 50.0}, {0.0, 0.0}, {0.0, 0.0}},
+    };
+    static const double offset[3] = {3.0, -5.0, 256.0};
+    static const double expect_freq[3] = {137.3, 250.0, 400.0};
+    static const double expect_amp[3] = {1000.0, 600.0, 300.0};
+    ImuVibration *v = &imu_vibration_test_v;
+
+    ImuVibration_Init(v, (imu_real_t)IMU_VIBRATION_TEST_FS, (imu_real_t)IMU_VIBRATION_TEST_SCALE);
+    ImuVibration_SetBand(v, 0, IMU_REAL(50.0), IMU_REAL(200.0));
+    ImuVibration_SetBand(v, 1, IMU_REAL(300.0), IMU_REAL(500.0));
+    ImuVibrationTest_PushTones(v, tones, offset, 0, 4u * IMU_VIBRATION_TEST_N);
+    const ImuVibrationSummary *s = &v->summary;
+
+    bool peaks_ok = true;
+    for (int32_t i = 0; i < IMU_VIBRATION_PEAKS; i++)
+    {
+        double amp = expect_amp[i] / sqrt(2.0) * IMU_VIBRATION_TEST_SCALE;
+        double ferr = fabs((double)s->peak[i].freq - expect_freq[i]);
+        double aerr = fabs((double)s->peak[i].amp - amp) / amp;
+        printf("peak %d: %8.3f Hz (expect %6.1f), amp %.4f m/s2 rms (expect %.4f, %+.2f%%)\n", (int)i,
+               (double)s->peak[i].freq, expect_freq[i], (double)s->peak[i].amp, amp,
+               100.0 * ((double)s->peak[i].amp - amp) / amp);
+        peaks_ok = peaks_ok && ferr < IMU_VIBRATION_TEST_FREQ_TOL && aerr < IMU_VIBRATION_TEST_AMP_TOL;
+    }
+    ImuVibrationTest_Check("three strongest peaks: frequency and amplitude", peaks_ok);
+
+    // 正弦的 RMS 为峰值 / sqrt(2), 多个单音按功率相加
+    double rms_x = sqrt(1000.0 * 1000.0 + 300.0 * 300.0) / sqrt(2.0) * IMU_VIBRATION_TEST_SCALE;
+    double rms_y = 600.0 / sqrt(2.0) * IMU_VIBRATION_TEST_SCALE;
+    double band0 = 1000.0 / sqrt(2.0) * IMU_VIBRATION_TEST_SCALE;
+    double band1 = 300.0 / sqrt(2.0) * IMU_VIBRATION_TEST_SCALE;
+    printf("rms x %.4f (expect %.4f), y %.4f (expect %.4f); band x [50,200] %.4f (expect %.4f), "
+           "[300,500] %.4f (expect %.4f), y [50,200] %.5f\n", (double)s->axis[0].rms, rms_x,
+           (double)s->axis[1].rms, rms_y, (double)s->axis[0].band_rms[0], band0, (double)s->axis[0].band_rms[1],
+           band1, (double)s->axis[1].band_rms[0]);
+    ImuVibrationTest_Check("axis rms with the gravity offset removed",
+                           fabs((double)s->axis[0].rms - rms_x) < IMU_VIBRATION_TEST_RMS_TOL * rms_x &&
+                           fabs((double)s->axis[1].rms - rms_y) < IMU_VIBRATION_TEST_RMS_TOL * rms_y);
+    ImuVibrationTest_Check("band rms of tones inside the band",
+                           fabs((double)s->axis[0].band_rms[0] - band0) < IMU_VIBRATION_TEST_RMS_TOL * band0 &&
+                           fabs((double)s->axis[0].band_rms[1] - band1) < IMU_VIBRATION_TEST_RMS_TOL * band1);
+    ImuVibrationTest_Check("band rms without tones in the band is small",
+                           (double)s->axis[1].band_rms[0] < 0.01 * rms_y);
+}
+
+/**
+ * x 轴单音从 100Hz 线性扫到 700Hz (2s), 0.5s 后 y 轴出现更强的 900Hz 固定单音.
+ * 跟踪峰应一直跟随扫频, 不被更强的峰抢走: 每帧与帧中心时刻的瞬时频率之差小于一个频点.
+ */
+static void ImuVibrationTest_Sweep(void)
+{
+    const double f0 = 100.0, f1 = 700.0, duration = 2.0;
+    const double rate = (f1 - f0) / duration;
+    const uint32_t total = (uint32_t)(duration * IMU_VIBRATION_TEST_FS);
+    ImuVibration *v = &imu_vibration_test_v;
+    int16_t raw[IMU_VIBRATION_TEST_BLOCK][3];
+    uint32_t frames = 0, lost = 0, seq = 0;
+    double err_max = 0.0;
+
+    ImuVibration_Init(v, (imu_real_t)IMU_VIBRATION_TEST_FS, (imu_real_t)IMU_VIBRATION_TEST_SCALE);
+    for (uint32_t i = 0; i < total; i += IMU_VIBRATION_TEST_BLOCK)
+    {
+        for (uint32_t j = 0; j < IMU_VIBRATION_TEST_BLOCK; j++)
+        {
+            double t = (double)(i + j) / IMU_VIBRATION_TEST_FS;
+            raw[j][0] = ImuVibrationTest_Count(800.0 * sin(2.0 * M_PI * (f0 * t + 0.5 * rate * t * t)));
+            raw[j][1] = ImuVibrationTest_Count((t >= 0.5) ? 2000.0 * sin(2.0 * M_PI * 900.0 * t) : 0.0);
+            raw[j][2] = 256;
+        }
+        ImuVibration_Push(v, (const int16_t (*)[3])raw, IMU_VIBRATION_TEST_BLOCK);
+        if (v->summary.seq == seq)
+        {
+            continue;
+        }
+        seq = v->summary.seq;
+        frames++;
+        double tc = ((double)v->summary.samples - IMU_VIBRATION_TEST_N / 2) / IMU_VIBRATION_TEST_FS;
+        double err = fabs((double)v->summary.track.freq - (f0 + rate * tc));
+        err_max = (err > err_max) ? err : err_max;
+        lost += (err > IMU_VIBRATION_TEST_BIN) ? 1u : 0u;
+    }
+    printf("sweep: %u frames, track error max %.2f Hz, %u frames off the sweep, locked %u frames, "
+           "strongest peak %.1f Hz\n", frames, err_max, lost, (unsigned)v->summary.track_frames,
+           (double)v->summary.peak[0].freq);
+    ImuVibrationTest_Check("track follows the sweep past a stronger tone",
+                           frames > 0 && 0 == lost && v->summary.track_frames == frames &&
+                           fabs((double)v->summary.peak[0].freq - 900.0) < IMU_VIBRATION_TEST_BIN);
+}
+
+int main(void)
+{
+    ImuVibrationTest_Rfft();
+    ImuVibrationTest_Tones();
+    ImuVibrationTest_Sweep();
+    printf("%s\n", imu_vibration_test_fail ? "FAILED" : "all passed");
+    return imu_vibration_test_fail ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+@file size_report.py
+@author Wyatt Yu
+@brief 按 Kconfig 功能统计 flash/RAM 占用
+
+用法 (在仓库根目录):
+  python3 tools/size_report.py [--cc arm-none-eabi-gcc] [--cflags "..."] [--preset name]
+默认优先使用 arm-none-eabi-gcc (Cortex-M4F), 找不到时退回主机 gcc, 结果只用于相对比较.
+每个源文件按所选功能的宏单独编译 (-Os -ffunction-sections -fdata-sections), 用 size 统计
+text/data/bss; flash = text + data, RAM = data + bss, 另外单独给出每个实例的
+sizeof(Imu) + sizeof(ImuContext).
+统计的是目标文件之和, 链接时 --gc-sections 还会去掉未调用的函数, 实际占用只会更小.
+功能的边际开销 = 全功能配置 - 去掉该功能 (以及依赖它的功能) 后的配置.
+源文件选择规则与 SConscript 相同, 传感器框架设备依赖 RT-Thread 头文件, 不在统计之内.
+@copyright Copyright (c) 2025
+"""
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# (宏, 说明, 依赖的宏)
+FEATURES = [
+    ('IMU_USING_ADXL345', 'ADXL345 driver', []),
+    ('IMU_USING_ITG3205', 'ITG3205 driver', []),
+    ('IMU_USING_QMC5883L', 'QMC5883L driver', []),
+    ('IMU_USING_MAHONY', 'Mahony', []),
+    ('IMU_USING_MADGWICK', 'Madgwick', []),
+    ('IMU_USING_COMPLEMENTARY', 'complementary filter', []),
+    ('IMU_USING_MAGIC', '9DOF magnetometer correction', []),
+    ('IMU_USING_ACCEL_CALIB', 'accel calibration', []),
+    ('IMU_USING_PROFILING', 'path counters', []),
+    ('IMU_USING_HISTORY', 'attitude history', []),
+    ('IMU_USING_ARRAY', 'sensor array voting', []),
+    ('IMU_USING_BUS', 'shared bus scheduler', ['IMU_USING_ADXL345', 'IMU_USING_ITG3205', 'IMU_USING_QMC5883L']),
+    ('IMU_USING_STARTUP', 'start-up state machine', ['IMU_USING_ADXL345', 'IMU_USING_ITG3205', 'IMU_USING_QMC5883L']),
+    ('IMU_USING_TELEMETRY', 'telemetry encoder', []),
+    ('IMU_USING_VIBRATION', 'vibration spectrum', ['IMU_USING_ADXL345']),
+    ('IMU_USING_DECIMATE', 'anti-aliasing decimation', []),
+]
+
+PRESETS = {
+    'full': [f[0] for f in FEATURES],
+    'mahony6dof': ['IMU_USING_ADXL345', 'IMU_USING_ITG3205', 'IMU_USING_MAHONY'],
+}
+
+
+def sources(enabled):
+    """与 SConscript 的源文件选择一致"""
+    src = ['imu.c']
+    table = [
+        ('IMU_USING_MAHONY', 'algorithm/imu_mahony.c'),
+        ('IMU_USING_MADGWICK', 'algorithm/imu_madgwick.c'),
+        ('IMU_USING_COMPLEMENTARY', 'algorithm/imu_complementary_filter.c'),
+        ('IMU_USING_ADXL345', 'adlx345/adlx345.c'),
+        ('IMU_USING_ITG3205', 'itg3205/itg3205.c'),
+        ('IMU_USING_QMC5883L', 'qmc5883l/qmc5883l.c'),
+    ]
+    for macro, path in table:
+        if macro in enabled:
+            src.append(path)
+    if enabled & {'IMU_USING_ADXL345', 'IMU_USING_ITG3205', 'IMU_USING_QMC5883L'}:
+        src += ['imu_regcache.c', 'imu_convert.c']
+    table = [
+        ('IMU_USING_HISTORY', 'imu_history.c'),
+        ('IMU_USING_ARRAY', 'imu_array.c'),
+        ('IMU_USING_BUS', 'imu_bus.c'),
+        ('IMU_USING_STARTUP', 'imu_startup.c'),
+        ('IMU_USING_TELEMETRY', 'imu_telemetry.c'),
+        ('IMU_USING_VIBRATION', 'imu_vibration.c'),
+        ('IMU_USING_DECIMATE', 'imu_decimate.c'),
+    ]
+    for macro, path in table:
+        if macro in enabled:
+            src.append(path)
+    return src
+
+
+def closure_without(feature):
+    """去掉 feature 以及依赖它的功能"""
+    removed = {feature}
+    changed = True
+    while changed:
+        changed = False
+        for macro, _, deps in FEATURES:
+            if macro not in removed and removed & set(deps):
+                removed.add(macro)
+                changed = True
+    return set(PRESETS['full']) - removed
+
+
+class Builder:
+    def __init__(self, cc, cflags, workdir):
+        self.cc = cc
+        self.cflags = cflags
+        self.workdir = workdir
+        self.size = self._tool('size')
+        self.nm = self._tool('nm')
+        self.cache = {}
+
+    def _tool(self, name):
+        # arm-none-eabi-gcc -> arm-none-eabi-size
+        base = os.path.basename(self.cc)
+        if base.endswith('gcc') and base != 'gcc':
+            tool = os.path.join(os.path.dirname(self.cc), base[:-3] + name)
+            if shutil.which(tool):
+                return tool
+        return name
+
+    def _compile(self, path, enabled):
+        key = (path, frozenset(enabled))
+        if key in self.cache:
+            return self.cache[key]
+        obj = os.path.join(self.workdir, '%d.o' % len(self.cache))
+        cmd = [self.cc, '-c', '-std=gnu99', '-Os', '-ffunction-sections', '-fdata-sections']
+        cmd += self.cflags
+        cmd += ['-I' + os.path.join(ROOT, d) for d in ['tools/host', '.', 'adlx345', 'itg3205', 'qmc5883l']]
+        cmd += ['-DPKG_USING_IMU_SENSOR'] + ['-D' + m for m in sorted(enabled)]
+        cmd += [path if os.path.isabs(path) else os.path.join(ROOT, path), '-o', obj]
+        subprocess.run(cmd, check=True)
+        self.cache[key] = obj
+        return obj
+
+    def measure(self, enabled):
+        """返回 (flash, ram, 每个实例的字节数, {源文件: (text, data, bss)})"""
+        detail = {}
+        for path in sources(enabled):
+            out = subprocess.run([self.size, self._compile(path, enabled)], check=True,
+                                 capture_output=True, text=True).stdout.splitlines()
+            text, data, bss = (int(v) for v in out[1].split()[:3])
+            detail[path] = (text, data, bss)
+        flash = sum(t + d for t, d, _ in detail.values())
+        ram = sum(d + b for _, d, b in detail.values())
+        return flash, ram, self.instance_size(enabled), detail
+
+    def instance_size(self, enabled):
+        probe = os.path.join(self.workdir, 'probe.c')
+        with open(probe, 'w') as fp:
+            fp.write('#include "imu.h"\nchar imu_size_probe[sizeof(Imu) + sizeof(ImuContext)];\n')
+        obj = self._compile(probe, enabled)
+        del self.cache[(probe, frozenset(enabled))]
+        out = subprocess.run([self.nm, '-S', '--defined-only', obj], check=True,
+                             capture_output=True, text=True).stdout
+        for line in out.splitlines():
+            parts = line.split()
+            if len(parts) == 4 and parts[3] == 'imu_size_probe':
+                return int(parts[1], 16)
+        return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='flash/RAM per imu_sensor feature')
+    parser.add_argument('--cc', default=None, help='compiler, default arm-none-eabi-gcc or gcc')
+    parser.add_argument('--cflags', default=None, help='extra target flags')
+    parser.add_argument('--preset', default=None, choices=sorted(PRESETS), help='only print one preset')
+    args = parser.parse_args()
+
+    cc = args.cc
+    cflags = args.cflags
+    if cc is None:
+        cc = 'arm-none-eabi-gcc' if shutil.which('arm-none-eabi-gcc') else 'gcc'
+    if cflags is None:
+        cflags = '-mcpu=cortex-m4 -mthumb -mfloat-abi=hard -mfpu=fpv4-sp-d16' if 'arm-none-eabi' in cc else ''
+    print('compiler: %s %s' % (cc, cflags))
+
+    with tempfile.TemporaryDirectory() as workdir:
+        b = Builder(cc, cflags.split(), workdir)
+        full = b.measure(set(PRESETS['full']))
+
+        if args.preset is None:
+            print('\n%-26s %-32s %8s %8s %8s' % ('feature', '', 'flash', 'ram', 'Imu'))
+            for macro, desc, _ in FEATURES:
+                rest = b.measure(closure_without(macro))
+                print('%-26s %-32s %8d %8d %8d' % (macro, desc, full[0] - rest[0], full[1] - rest[1],
+                                                   full[2] - rest[2]))
+
+        for name in sorted(PRESETS):
+            if args.preset and name != args.preset:
+                continue
+            flash, ram, imu, detail = b.measure(set(PRESETS[name]))
+            print('\npreset %s: flash %d, static ram %d, per instance %d' % (name, flash, ram, imu))
+            for path in sorted(detail):
+                text, data, bss = detail[path]
+                print('  %-40s text %6d  data %5d  bss %5d' % (path, text, data, bss))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())